@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "st/Alogorithm.h"
+#include "ST/ThreadPool.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Function>
+void run(const char* name, Function&& f)
+{
+  auto start = Clock::now();
+  auto checksum = f();
+  auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  fmt::print("  {:<32} {:>10.2f} ms  ({})\n", name, elapsed, checksum);
+}
+
+} // namespace
+
+
+// 并行算法和串行std算法对比，用法: bench-algorithm [元素数，默认10^8]
+int main(int argc, char* argv[])
+{
+  std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+
+  auto& pool = ST::ThreadPool::global();
+  std::mt19937_64 engine{ 42 };
+
+  std::vector<std::int64_t> values(size);
+  for (auto& value: values)
+    value = static_cast<std::int64_t>(engine() % 2001) - 1000;
+  std::vector<std::int64_t> out(size);
+
+  fmt::print("{} int64_t, {} workers\n", size, pool.size());
+
+  run("std::reduce", [&] { return std::reduce(values.begin(), values.end(), std::int64_t{ 0 }); });
+  run("st::parallel_reduce", [&] { return st::parallel_reduce(pool, values.begin(), values.end(), std::int64_t{ 0 }); });
+
+  run("std::inclusive_scan", [&] {
+    std::inclusive_scan(values.begin(), values.end(), out.begin());
+    return out.back();
+  });
+  run("st::parallel_inclusive_scan", [&] {
+    st::parallel_inclusive_scan(pool, values.begin(), values.end(), out.begin());
+    return out.back();
+  });
+
+  auto negative = [] (std::int64_t value) { return value < 0; };
+  run("std::stable_partition", [&] {
+    out = values;
+    return std::stable_partition(out.begin(), out.end(), negative) - out.begin();
+  });
+  run("st::parallel_stable_partition", [&] {
+    out = values;
+    return st::parallel_stable_partition(pool, out.begin(), out.end(), negative) - out.begin();
+  });
+
+  run("std::partial_sort_copy top 100", [&] {
+    std::vector<std::int64_t> top(100);
+    std::partial_sort_copy(values.begin(), values.end(), top.begin(), top.end(), std::greater<>{});
+    return top.back();
+  });
+  run("st::parallel_top_k top 100", [&] {
+    return st::parallel_top_k(pool, values.begin(), values.end(), 100, std::greater<>{}).back();
+  });
+
+  // 64路归并，对比两两归并
+  constexpr std::size_t RUNS = 64;
+  auto sorted = values;
+  auto run_size = size / RUNS;
+  std::vector<std::pair<std::vector<std::int64_t>::iterator, std::vector<std::int64_t>::iterator>> runs{};
+  for (std::size_t i = 0; i < RUNS; ++i) {
+    auto first = sorted.begin() + static_cast<std::ptrdiff_t>(i * run_size);
+    auto last = i + 1 == RUNS ? sorted.end() : first + static_cast<std::ptrdiff_t>(run_size);
+    std::sort(first, last);
+    runs.emplace_back(first, last);
+  }
+
+  run("std::inplace_merge x63", [&] {
+    out = sorted;
+    for (std::size_t i = 1; i < RUNS; ++i)
+      std::inplace_merge(out.begin(), out.begin() + (runs[i].first - sorted.begin()), out.begin() + (runs[i].second - sorted.begin()));
+    return out[size / 2];
+  });
+  run("st::kway_merge 64 runs", [&] {
+    st::kway_merge(runs, out.begin());
+    return out[size / 2];
+  });
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "st/Cast.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Integer>
+void run(const char* name, std::size_t count, std::size_t rounds)
+{
+  std::vector<Integer> host(count);
+  std::iota(host.begin(), host.end(), Integer{ 1 });
+  std::vector<Integer> net(count);
+
+  for (auto level: { st::detail::SimdLevel::Scalar, st::detail::SimdLevel::SSSE3, st::detail::SimdLevel::AVX2 }) {
+    if (level > st::detail::simd_level())
+      break;
+
+    auto start = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round)
+      st::detail::byteswap(host.data(), net.data(), count, level);
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    auto bytes = static_cast<double>(count * sizeof(Integer) * rounds);
+    fmt::print("{:<10} level {} {:>8.2f} GB/s\n", name, static_cast<int>(level), bytes / elapsed / 1e9);
+  }
+}
+
+} // namespace
+
+
+// 批量字节序转换在不同指令集下的吞吐，数组大小默认16K个元素(常驻L1/L2)
+int main(int argc, char* argv[])
+{
+  std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16384;
+  std::size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+
+  run<std::uint16_t>("uint16_t", count, rounds);
+  run<std::uint32_t>("uint32_t", count, rounds);
+  run<std::uint64_t>("uint64_t", count, rounds);
+
+  return EXIT_SUCCESS;
+}
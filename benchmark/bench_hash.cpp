@@ -0,0 +1,105 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "st/Hash.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 对同一块数据反复计算，结果累加防止被优化掉
+template<typename Function>
+void throughput(const char* name, std::span<const std::byte> data, std::size_t rounds, Function&& function)
+{
+  std::uint64_t sink = 0;
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < rounds; ++i) {
+    // 编译器屏障，阻止把循环不变的计算提到循环外
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    sink += function(data);
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  auto bytes = static_cast<double>(data.size() * rounds);
+  fmt::print("  {:<28} {:>8.2f} GB/s  (sink {:x})\n", name, bytes / elapsed / 1e9, sink & 0xF);
+}
+
+// 哈希表key长度的短字符串
+template<typename Function>
+void short_keys(const char* name, const std::vector<std::string>& keys, std::size_t rounds, Function&& function)
+{
+  std::uint64_t sink = 0;
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < rounds; ++i)
+    for (auto& key: keys)
+      sink += function(key);
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  fmt::print("  {:<28} {:>8.2f} ns/key  (sink {:x})\n", name, elapsed / static_cast<double>(keys.size() * rounds), sink & 0xF);
+}
+
+} // namespace
+
+
+// 用法: bench-hash [缓冲区字节数，默认为1MiB] [轮数，默认为1000]
+int main(int argc, char* argv[])
+{
+  std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024 * 1024;
+  std::size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+
+  std::mt19937_64 engine{ 42 };
+  std::vector<std::byte> buffer(size);
+  for (auto& byte: buffer)
+    byte = static_cast<std::byte>(engine());
+
+  using st::hash::detail::CrcLevel;
+  using st::hash::detail::XxhLevel;
+  auto crc_level = st::hash::detail::crc_level();
+  auto xxh3_level = st::hash::detail::xxh3_level();
+
+  fmt::print("crc32c, {} bytes\n", size);
+  auto crc = [] (CrcLevel level) {
+    return [level] (std::span<const std::byte> data) {
+      return ~st::hash::detail::crc32c(~0U, data.data(), data.size(), level);
+    };
+  };
+  throughput("software (slicing-by-8)", buffer, rounds / 10 + 1, crc(CrcLevel::Software));
+  if (crc_level >= CrcLevel::SSE42)
+    throughput("sse4.2", buffer, rounds, crc(CrcLevel::SSE42));
+  if (crc_level >= CrcLevel::PCLMUL)
+    throughput("sse4.2 + pclmul, 3-way", buffer, rounds, crc(CrcLevel::PCLMUL));
+
+  fmt::print("xxhash, {} bytes\n", size);
+  throughput("xxh64", buffer, rounds, [] (std::span<const std::byte> data) { return st::hash::xxh64(data); });
+  auto xxh3 = [] (XxhLevel level) {
+    return [level] (std::span<const std::byte> data) {
+      return st::hash::detail::xxh3(data.data(), data.size(), 0, level);
+    };
+  };
+  throughput("xxh3 scalar", buffer, rounds, xxh3(XxhLevel::Scalar));
+  if (xxh3_level >= XxhLevel::SSE2)
+    throughput("xxh3 sse2", buffer, rounds, xxh3(XxhLevel::SSE2));
+  if (xxh3_level >= XxhLevel::AVX2)
+    throughput("xxh3 avx2", buffer, rounds, xxh3(XxhLevel::AVX2));
+
+  std::vector<std::string> keys{};
+  for (std::size_t i = 0; i < 10000; ++i)
+    keys.push_back(fmt::format("user:{}:session", engine() % 1000000));
+
+  fmt::print("short string keys\n");
+  short_keys("std::hash<std::string_view>", keys, 100, [] (std::string_view key) { return std::hash<std::string_view>{}(key); });
+  short_keys("st::hash::StringHash", keys, 100, st::hash::StringHash{});
+
+  return EXIT_SUCCESS;
+}
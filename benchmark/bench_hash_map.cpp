@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "st/HashMap.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Function>
+void measure(const char* name, std::size_t count, Function&& function)
+{
+  auto start = Clock::now();
+  function();
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  fmt::print("  {:<28} {:>8.1f} ns/op\n", name, elapsed / static_cast<double>(count));
+}
+
+// 插入、命中查找、未命中查找、删除一半再查找
+template<typename Map, typename Key>
+void run(const char* title, const std::vector<Key>& keys, const std::vector<Key>& missing)
+{
+  fmt::print("{}\n", title);
+
+  Map map{};
+  std::size_t n = keys.size();
+  measure("insert", n, [&] {
+    for (std::size_t i = 0; i < n; ++i)
+      map.emplace(keys[i], i);
+  });
+
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), std::mt19937_64{ 1 });
+
+  std::size_t sum = 0;
+  measure("find hit", n, [&] {
+    for (auto i: order)
+      sum += map.find(keys[i])->second;
+  });
+
+  std::size_t found = 0;
+  measure("find miss", missing.size(), [&] {
+    for (auto& key: missing)
+      found += map.count(key);
+  });
+
+  measure("erase half", n / 2, [&] {
+    for (std::size_t i = 0; i < n / 2; ++i)
+      map.erase(keys[order[i]]);
+  });
+
+  measure("find after erase", n, [&] {
+    for (auto i: order)
+      found += map.count(keys[i]);
+  });
+
+  fmt::print("  checksum {} {}\n", sum, found);
+}
+
+// 每个线程访问自己的一段key，90%查找10%插入或删除
+void run_concurrent(std::size_t n, std::size_t max_threads)
+{
+  fmt::print("st::ConcurrentFlatHashMap, 90% find, 10% insert/erase\n");
+
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    st::ConcurrentFlatHashMap<std::uint64_t, std::uint64_t> map{};
+    map.reserve(n);
+    for (std::uint64_t i = 0; i < n; ++i)
+      map.try_emplace(i, i);
+
+    std::size_t operations = n;
+    auto start = Clock::now();
+    std::vector<std::thread> workers{};
+    for (std::size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&map, t, operations] {
+        std::mt19937_64 engine{ t };
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < operations; ++i) {
+          auto key = engine() % (2 * operations);
+          auto op = engine() % 20;
+          if (op == 0)
+            map.try_emplace(key, key);
+          else if (op == 1)
+            map.erase(key);
+          else
+            found += map.contains(key);
+        }
+        if (found == static_cast<std::size_t>(-1))
+          fmt::print("unreachable\n");
+      });
+    }
+    for (auto& worker: workers)
+      worker.join();
+
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    fmt::print("  {} threads {:>8.1f} ns/op\n", threads, elapsed / static_cast<double>(operations * threads));
+  }
+}
+
+} // namespace
+
+
+// 用法: bench-hash-map [元素数，默认为10000000] [最大线程数，默认为CPU数]
+int main(int argc, char* argv[])
+{
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+  std::size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+  max_threads = std::max<std::size_t>(max_threads, 1);
+
+  std::mt19937_64 engine{ 2022 };
+  std::vector<std::uint64_t> keys(n);
+  std::vector<std::uint64_t> missing(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    // 最低位区分命中和未命中的key
+    keys[i] = engine() | 1;
+    missing[i] = engine() & ~std::uint64_t{ 1 };
+  }
+
+  fmt::print("{} uint64 keys\n", n);
+  run<std::unordered_map<std::uint64_t, std::size_t>>("std::unordered_map", keys, missing);
+  run<st::FlatHashMap<std::uint64_t, std::size_t>>("st::FlatHashMap", keys, missing);
+
+  // 字符串较慢，只用十分之一
+  std::vector<std::string> string_keys(n / 10);
+  std::vector<std::string> string_missing(n / 10);
+  for (std::size_t i = 0; i < n / 10; ++i) {
+    string_keys[i] = fmt::format("session-{:016x}", keys[i]);
+    string_missing[i] = fmt::format("session-{:016x}", missing[i]);
+  }
+
+  fmt::print("\n{} string keys\n", n / 10);
+  run<std::unordered_map<std::string, std::size_t>>("std::unordered_map", string_keys, string_missing);
+  run<st::FlatHashMap<std::string, std::size_t>>("st::FlatHashMap", string_keys, string_missing);
+
+  fmt::print("\n");
+  run_concurrent(n / 10, max_threads);
+
+  return EXIT_SUCCESS;
+}
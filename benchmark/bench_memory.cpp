@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "ST/Memory.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t OPERATIONS = 2000000;
+// 每个线程同时存活的对象数
+constexpr std::size_t LIVE = 1024;
+
+struct Block {
+  void* p = nullptr;
+  std::size_t size = 0;
+};
+
+// 16到1024字节的随机大小，随机替换一个存活对象
+void churn(std::pmr::memory_resource& resource, unsigned seed)
+{
+  std::mt19937 engine{ seed };
+  std::vector<Block> live(LIVE);
+
+  for (std::size_t i = 0; i < OPERATIONS; ++i) {
+    auto& block = live[engine() % LIVE];
+    if (block.p != nullptr)
+      resource.deallocate(block.p, block.size);
+
+    block.size = 16 + engine() % 1009;
+    block.p = resource.allocate(block.size);
+    *static_cast<std::byte*>(block.p) = std::byte{ 1 };
+  }
+
+  for (auto& block: live)
+    if (block.p != nullptr)
+      resource.deallocate(block.p, block.size);
+}
+
+void run_threads(const char* name, std::pmr::memory_resource& resource, std::size_t threads)
+{
+  auto start = Clock::now();
+
+  std::vector<std::thread> workers{};
+  for (std::size_t t = 0; t < threads; ++t)
+    workers.emplace_back([&resource, t] { churn(resource, static_cast<unsigned>(t)); });
+  for (auto& worker: workers)
+    worker.join();
+
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  fmt::print("  {:<36} {:>8.1f} ns/op\n", name, elapsed / static_cast<double>(OPERATIONS * threads));
+}
+
+// 每个请求分配一批小对象，请求结束时全部释放
+template<typename Reset>
+void run_requests(const char* name, std::pmr::memory_resource& resource, Reset&& reset)
+{
+  constexpr std::size_t REQUESTS = 100000;
+  constexpr std::size_t OBJECTS = 32;
+
+  std::mt19937 engine{ 7 };
+  Block blocks[OBJECTS];
+
+  auto start = Clock::now();
+  for (std::size_t request = 0; request < REQUESTS; ++request) {
+    for (auto& block: blocks) {
+      block.size = 16 + engine() % 241;
+      block.p = resource.allocate(block.size);
+      *static_cast<std::byte*>(block.p) = std::byte{ 1 };
+    }
+
+    for (auto& block: blocks)
+      resource.deallocate(block.p, block.size);
+    reset();
+  }
+
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  fmt::print("  {:<36} {:>8.1f} ns/object\n", name, elapsed / static_cast<double>(REQUESTS * OBJECTS));
+}
+
+} // namespace
+
+
+// 和glibc malloc对比，用法: bench-memory [最大线程数，默认为CPU数]
+int main(int argc, char* argv[])
+{
+  std::size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+  max_threads = std::max<std::size_t>(max_threads, 1);
+
+  auto& malloc_resource = *std::pmr::new_delete_resource();
+  std::pmr::synchronized_pool_resource synchronized{};
+  auto& thread_caching = ST::ThreadCachingResource::global();
+
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    fmt::print("{} threads, {} live objects per thread\n", threads, LIVE);
+    run_threads("malloc", malloc_resource, threads);
+    run_threads("std::pmr::synchronized_pool_resource", synchronized, threads);
+    run_threads("ST::ThreadCachingResource", thread_caching, threads);
+  }
+
+  fmt::print("single thread\n");
+  std::pmr::unsynchronized_pool_resource unsynchronized{};
+  ST::SlabPool slab{};
+  run_threads("malloc", malloc_resource, 1);
+  run_threads("std::pmr::unsynchronized_pool_resource", unsynchronized, 1);
+  run_threads("ST::SlabPool", slab, 1);
+
+  fmt::print("per request, 32 objects\n");
+  std::pmr::monotonic_buffer_resource monotonic{};
+  ST::MonotonicArena arena{};
+  run_requests("malloc", malloc_resource, [] {});
+  run_requests("std::pmr::monotonic_buffer_resource", monotonic, [&monotonic] { monotonic.release(); });
+  run_requests("ST::MonotonicArena", arena, [&arena] { arena.reset(); });
+
+  return EXIT_SUCCESS;
+}
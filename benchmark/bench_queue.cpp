@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "ST/Queue.h"
+#include "ST/WakeupQueue.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t CAPACITY = 1024;
+
+// 对照组: 互斥锁保护的std::deque
+class LockedQueue {
+public:
+  using value_type = std::uint64_t;
+
+  explicit LockedQueue(std::size_t capacity) : capacity_{ capacity } {}
+
+  bool try_push(std::uint64_t value)
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (queue_.size() == capacity_)
+      return false;
+
+    queue_.push_back(value);
+    return true;
+  }
+
+  std::optional<std::uint64_t> try_pop()
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (queue_.empty())
+      return std::nullopt;
+
+    auto value = queue_.front();
+    queue_.pop_front();
+    return value;
+  }
+
+private:
+  std::size_t capacity_;
+  std::mutex mutex_;
+  std::deque<std::uint64_t> queue_;
+};
+
+// threads个生产者和threads个消费者，每个生产者写count个元素
+template<typename Queue>
+void throughput(const char* name, std::size_t threads, std::size_t count)
+{
+  Queue queue{ CAPACITY };
+  std::vector<std::thread> workers{};
+
+  auto start = Clock::now();
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&queue, count] {
+      for (std::uint64_t i = 0; i < count; ++i)
+        while (!queue.try_push(i))
+          std::this_thread::yield();
+    });
+    workers.emplace_back([&queue, count] {
+      for (std::size_t received = 0; received < count; ) {
+        if (queue.try_pop())
+          ++received;
+        else
+          std::this_thread::yield();
+      }
+    });
+  }
+  for (auto& worker: workers)
+    worker.join();
+
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  fmt::print("  {:<24} {:>8.1f} ns/element\n", name, elapsed / static_cast<double>(count * threads));
+}
+
+// 两个线程轮流把一个值交给对方，等待时睡眠，测一次交接的延迟
+void ping_pong_wakeup(std::size_t rounds)
+{
+  ST::WakeupQueue<ST::SPSCQueue<std::uint64_t>> ping{ CAPACITY };
+  ST::WakeupQueue<ST::SPSCQueue<std::uint64_t>> pong{ CAPACITY };
+
+  auto start = Clock::now();
+  std::thread other{ [&] {
+    for (std::size_t i = 0; i < rounds; ++i)
+      pong.try_push(*ping.pop() + 1);
+  } };
+  for (std::uint64_t i = 0; i < rounds; ++i) {
+    ping.try_push(i);
+    pong.pop();
+  }
+  other.join();
+
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  fmt::print("  {:<24} {:>8.1f} ns/handoff\n", "WakeupQueue<SPSCQueue>", elapsed / static_cast<double>(rounds * 2));
+}
+
+void ping_pong_condition_variable(std::size_t rounds)
+{
+  struct Channel {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::uint64_t> queue;
+
+    void push(std::uint64_t value)
+    {
+      {
+        std::lock_guard<std::mutex> lock{ mutex };
+        queue.push_back(value);
+      }
+      ready.notify_one();
+    }
+
+    std::uint64_t pop()
+    {
+      std::unique_lock<std::mutex> lock{ mutex };
+      ready.wait(lock, [this] { return !queue.empty(); });
+      auto value = queue.front();
+      queue.pop_front();
+      return value;
+    }
+  };
+
+  Channel ping{};
+  Channel pong{};
+
+  auto start = Clock::now();
+  std::thread other{ [&] {
+    for (std::size_t i = 0; i < rounds; ++i)
+      pong.push(ping.pop() + 1);
+  } };
+  for (std::uint64_t i = 0; i < rounds; ++i) {
+    ping.push(i);
+    pong.pop();
+  }
+  other.join();
+
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  fmt::print("  {:<24} {:>8.1f} ns/handoff\n", "mutex + condvar", elapsed / static_cast<double>(rounds * 2));
+}
+
+} // namespace
+
+
+// 用法: bench-queue [每个生产者的元素数，默认为1000000] [最大生产者数，默认为CPU数的一半]
+int main(int argc, char* argv[])
+{
+  std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  std::size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::thread::hardware_concurrency() / 2;
+  max_threads = std::max<std::size_t>(max_threads, 1);
+
+  fmt::print("1 producer, 1 consumer\n");
+  throughput<LockedQueue>("mutex + std::deque", 1, count);
+  throughput<ST::MPMCQueue<std::uint64_t>>("ST::MPMCQueue", 1, count);
+  throughput<ST::SPSCQueue<std::uint64_t>>("ST::SPSCQueue", 1, count);
+
+  for (std::size_t threads = 2; threads <= max_threads; threads *= 2) {
+    fmt::print("{} producers, {} consumers\n", threads, threads);
+    throughput<LockedQueue>("mutex + std::deque", threads, count);
+    throughput<ST::MPMCQueue<std::uint64_t>>("ST::MPMCQueue", threads, count);
+  }
+
+  fmt::print("ping-pong between two threads\n");
+  ping_pong_condition_variable(count / 10);
+  ping_pong_wakeup(count / 10);
+
+  return EXIT_SUCCESS;
+}
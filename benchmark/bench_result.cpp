@@ -0,0 +1,88 @@
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <system_error>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include "ST/FileSystem/File.h"
+#include "ST/Net/Socket.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Function>
+void run(const char* name, std::size_t iterations, Function&& f)
+{
+  std::size_t errors = 0;
+
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    errors += f();
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+  fmt::print("{:<36} {:>10.1f} ns/op  ({} errors)\n",
+             name, static_cast<double>(elapsed) / static_cast<double>(iterations), errors);
+}
+
+} // namespace
+
+
+// 每次调用都失败时，比较抛异常和返回st::Result的开销，两者的系统调用和埋点完全相同
+int main(int argc, char* argv[])
+{
+  std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+  // 只比较错误路径本身，不比较日志
+  spdlog::set_level(spdlog::level::off);
+  signal(SIGPIPE, SIG_IGN);
+
+  // 从管道的写端读: EBADF
+  int fds[2];
+  if (::pipe(fds) == -1)
+    return EXIT_FAILURE;
+  ST::FileSystem::File write_end{ "pipe", fds[1] };
+  char buffer[64];
+
+  run("File::read throwing (EBADF)", iterations, [&] {
+    try {
+      write_end.read(buffer, sizeof(buffer));
+      return 0;
+    }
+    catch (const std::system_error&) {
+      return 1;
+    }
+  });
+
+  run("File::read nothrow (EBADF)", iterations, [&] {
+    return write_end.read(buffer, sizeof(buffer), std::nothrow) ? 0 : 1;
+  });
+
+  // 对端已关闭: EPIPE，对应高连接数下常见的ECONNRESET/EPIPE
+  auto [writer, reader] = ST::Net::Socket::pair();
+  reader.close();
+
+  run("Socket::write throwing (EPIPE)", iterations, [&] {
+    try {
+      writer.write(buffer, sizeof(buffer));
+      return 0;
+    }
+    catch (const std::system_error&) {
+      return 1;
+    }
+  });
+
+  run("Socket::write nothrow (EPIPE)", iterations, [&] {
+    return writer.write(buffer, sizeof(buffer), std::nothrow) ? 0 : 1;
+  });
+
+  write_end.close();
+  ::close(fds[0]);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#include "st/Serialize.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Level {
+  std::int64_t price;
+  std::uint32_t quantity;
+};
+
+struct Quote {
+  st::Varint<std::uint64_t> sequence;
+  std::string_view symbol;
+  double ratio;
+  std::vector<Level> levels;
+  std::vector<std::uint32_t> ids;
+};
+
+template<typename Function>
+void run(const char* name, std::size_t iterations, Function&& f)
+{
+  std::size_t bytes = 0;
+
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    bytes += f();
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+  fmt::print("{:<28} {:>10.1f} ns/op  {:>6} bytes/op\n",
+             name, static_cast<double>(elapsed) / static_cast<double>(iterations), bytes / iterations);
+}
+
+} // namespace
+
+
+// 同一条消息用st::serialize和nlohmann_json编解码的开销
+int main(int argc, char* argv[])
+{
+  std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+
+  Quote quote{ 123456, "AAPL", 0.25, {}, {} };
+  for (std::uint32_t i = 0; i < 16; ++i) {
+    quote.levels.push_back({ 10000 + i, i * 100 });
+    quote.ids.push_back(i * 7919);
+  }
+
+  std::vector<std::byte> buffer(st::serialized_size(quote));
+  run("st::serialize", iterations, [&] {
+    return st::serialize(quote, std::span{ buffer }).value_or(0);
+  });
+
+  run("st::deserialize", iterations, [&] {
+    auto decoded = st::deserialize<Quote>(buffer);
+    return decoded ? buffer.size() : 0;
+  });
+
+  auto to_json = [&quote] {
+    nlohmann::json json;
+    json["sequence"] = quote.sequence.value;
+    json["symbol"] = quote.symbol;
+    json["ratio"] = quote.ratio;
+    for (auto& level: quote.levels)
+      json["levels"].push_back({ { "price", level.price }, { "quantity", level.quantity } });
+    json["ids"] = quote.ids;
+    return json.dump();
+  };
+
+  run("nlohmann::json::dump", iterations, [&] {
+    return to_json().size();
+  });
+
+  auto text = to_json();
+  run("nlohmann::json::parse", iterations, [&] {
+    auto json = nlohmann::json::parse(text);
+    Quote decoded{ json["sequence"].get<std::uint64_t>(), {}, json["ratio"].get<double>(), {}, {} };
+    for (auto& level: json["levels"])
+      decoded.levels.push_back({ level["price"].get<std::int64_t>(), level["quantity"].get<std::uint32_t>() });
+    decoded.ids = json["ids"].get<std::vector<std::uint32_t>>();
+    return text.size();
+  });
+
+  return EXIT_SUCCESS;
+}
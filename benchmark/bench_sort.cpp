@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "st/Sort.h"
+#include "ST/ThreadPool.h"
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename T, typename Function>
+void run(const char* name, const std::vector<T>& input, Function&& f)
+{
+  auto data = input;
+
+  auto start = Clock::now();
+  f(data);
+  auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  if (!std::is_sorted(data.begin(), data.end()))
+    fmt::print("{} produced unsorted output\n", name);
+
+  fmt::print("  {:<24} {:>10.1f} ms\n", name, elapsed);
+}
+
+} // namespace
+
+
+// 和std::sort对比，用法: bench-sort [最大元素数，默认10^8]，从10^6开始每次乘10
+int main(int argc, char* argv[])
+{
+  std::size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+
+  ST::ThreadPool pool{};
+  std::mt19937_64 engine{ 42 };
+
+  for (std::size_t size = 1000000; size <= max_size; size *= 10) {
+    std::vector<std::uint64_t> integers(size);
+    for (auto& value: integers)
+      value = engine();
+
+    fmt::print("{} uint64_t\n", size);
+    run("std::sort", integers, [] (auto& data) { std::sort(data.begin(), data.end()); });
+    run("st::sort", integers, [] (auto& data) { st::sort(data); });
+    run("st::radix_sort", integers, [] (auto& data) { st::radix_sort(data); });
+    run("st::parallel_sort", integers, [&pool] (auto& data) { st::parallel_sort(pool, data.begin(), data.end()); });
+
+    std::vector<std::uint32_t> keys(size);
+    for (auto& value: keys)
+      value = static_cast<std::uint32_t>(engine());
+
+    fmt::print("{} uint32_t\n", size);
+    run("std::sort", keys, [] (auto& data) { std::sort(data.begin(), data.end()); });
+    run("st::sort", keys, [] (auto& data) { st::sort(data); });
+    run("st::radix_sort", keys, [] (auto& data) { st::radix_sort(data); });
+    run("st::parallel_sort", keys, [&pool] (auto& data) { st::parallel_sort(pool, data.begin(), data.end()); });
+
+    // 字符串只测到10^7，再大内存不够
+    if (size > 10000000)
+      continue;
+
+    std::vector<std::string> strings(size);
+    for (auto& value: strings)
+      value = fmt::format("user/{:016x}", engine() % (size * 4));
+
+    fmt::print("{} std::string\n", size);
+    run("std::sort", strings, [] (auto& data) { std::sort(data.begin(), data.end()); });
+    run("st::sort", strings, [] (auto& data) { st::sort(data); });
+    run("st::radix_sort", strings, [] (auto& data) { st::radix_sort(data); });
+    run("st::parallel_sort", strings, [&pool] (auto& data) { st::parallel_sort(pool, data.begin(), data.end()); });
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -36,9 +36,18 @@ static constexpr int CREATE_FILE_FLAG = O_WRONLY | O_CREAT | O_TRUNC;
  */
 void daemonize(const char* cmd);
 
-ssize_t readn(int fd, char* buf, size_t nbytes);
+/**
+ * @brief 读n个字节，被信号打断时重试，新代码用ST/IO.h中的read_exact
+ *
+ * @return ssize_t 读到的字节数，遇到EOF时小于nbytes，一个字节都没读到就出错时为-1
+ */
+ssize_t readn(int fd, void* buf, size_t nbytes);
 
-ssize_t writen(int fd, char* buf, size_t nbytes);
+/**
+ * @brief 写n个字节，被信号打断时重试，新代码用ST/IO.h中的write_all
+ *
+ */
+ssize_t writen(int fd, const void* buf, size_t nbytes);
 
 void err_ret(const char* fmt, ...);
 
@@ -0,0 +1,121 @@
+/**
+ * @file Daemon.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 守护进程化、PID文件和systemd就绪通知
+ * @version 0.1
+ * @date 2022-07-18
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_DAEMON_H
+#define STUDY_TOUR_DAEMON_H
+
+#include <sys/types.h>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ST/FileSystem/File.h"
+
+
+namespace ST {
+
+/**
+ * @brief 如何成为守护进程
+ *
+ */
+enum class DaemonMode {
+  // 传统的两次fork + setsid
+  Fork,
+  // 不fork，由systemd等supervisor管理进程(Type=simple/notify)
+  Foreground,
+  // 由systemd启动(存在NOTIFY_SOCKET或INVOCATION_ID)时为Foreground，否则为Fork
+  Auto
+};
+
+/**
+ * @brief 守护进程
+ *
+ * @details start()的步骤：
+ * 1. Fork模式下fork -> setsid -> fork，脱离控制终端，不再是进程组组长
+ * 2. umask、切换工作目录
+ * 3. 用close_range一次关闭keep_fds以外的所有fd(不支持时遍历/proc/self/fd)，不受RLIMIT_NOFILE大小影响
+ * 4. 标准输入输出重定向到/dev/null
+ * 5. 创建并用File::write_lock锁住PID文件，已有实例在运行时抛出异常
+ *
+ * 就绪后调用ready()，通过NOTIFY_SOCKET通知systemd(sd_notify协议)，不在systemd下时什么都不做
+ */
+class Daemon {
+public:
+  explicit Daemon(std::string name);
+
+  Daemon(const Daemon& other) = delete;
+  Daemon& operator=(const Daemon& other) = delete;
+
+  // 被移动的对象不再持有PID文件，析构时不会删除它
+  Daemon(Daemon&& other) noexcept;
+  Daemon& operator=(Daemon&& other) noexcept = delete;
+
+  // 删除PID文件
+  ~Daemon();
+
+  Daemon& mode(DaemonMode mode);
+  Daemon& pid_file(std::string path);
+  Daemon& working_directory(std::string path);
+  Daemon& file_mode_mask(mode_t mask);
+  // 不被关闭的fd，比如start()之前创建的监听socket
+  Daemon& keep_fds(std::vector<int> fds);
+
+  /**
+   * @brief 成为守护进程，Fork模式下只有最终的守护进程从这里返回
+   *
+   */
+  void start();
+
+  // 通知supervisor已经就绪，Type=notify的服务在此之前处于activating状态
+  static void ready();
+  static void reloading();
+  static void stopping();
+  static void status(std::string_view message);
+
+  /**
+   * @brief 按sd_notify协议向NOTIFY_SOCKET发送状态
+   *
+   * @param state 比如"READY=1"，多个状态用换行分隔
+   * @return true  已发送
+   * @return false 不在systemd下(没有NOTIFY_SOCKET)
+   */
+  static bool notify(std::string_view state);
+
+  /**
+   * @brief 关闭所有不小于first且不在keep中的fd
+   *
+   * @param first
+   * @param keep
+   */
+  static void close_fds(int first, std::span<const int> keep = {});
+
+  const std::string& name() const noexcept { return name_; }
+  bool is_foreground() const noexcept { return mode_ == DaemonMode::Foreground; }
+
+private:
+  std::string name_;
+  DaemonMode mode_;
+  std::optional<std::string> pid_file_;
+  std::string working_directory_;
+  mode_t mask_;
+  std::vector<int> keep_fds_;
+  std::optional<FileSystem::File> locked_pid_file_;
+
+  void fork_and_detach();
+  void redirect_standard_streams();
+  void lock_pid_file();
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_DAEMON_H
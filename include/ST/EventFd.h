@@ -0,0 +1,79 @@
+/**
+ * @file EventFd.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief eventfd的封装，用于跨线程唤醒事件循环
+ * @version 0.1
+ * @date 2022-07-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_EVENT_FD_H
+#define STUDY_TOUR_EVENT_FD_H
+
+#include <sys/eventfd.h>
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace ST {
+
+/**
+ * @brief eventfd的RAII封装
+ *
+ * @details 内核维护一个64位计数器，notify()加上n，计数器不为0时fd可读(EPOLLIN)，
+ * consume()读出并清零，所以多次notify只会唤醒一次<br/>
+ * 默认非阻塞，可以注册到Poller上
+ */
+class EventFd {
+public:
+  /**
+   * @brief
+   *
+   * @param initial 计数器初始值
+   * @param flags   EFD_NONBLOCK/EFD_CLOEXEC/EFD_SEMAPHORE
+   */
+  explicit EventFd(unsigned int initial = 0, int flags = EFD_NONBLOCK | EFD_CLOEXEC);
+
+  EventFd(const EventFd& other) = delete;
+  EventFd& operator=(const EventFd& other) = delete;
+
+  EventFd(EventFd&& other) noexcept;
+  EventFd& operator=(EventFd&& other) noexcept;
+
+  ~EventFd();
+
+  int fd() const noexcept { return fd_; }
+
+  /**
+   * @brief 计数器加上count，唤醒等待的线程
+   *
+   * @param count
+   * @details 计数器将要溢出时非阻塞的eventfd返回EAGAIN，此时已经有未处理的通知，直接忽略
+   */
+  void notify(std::uint64_t count = 1);
+
+  /**
+   * @brief 读出计数器并清零(EFD_SEMAPHORE时减1)
+   *
+   * @return std::uint64_t 计数器为0时返回0，阻塞的eventfd会等待
+   */
+  std::uint64_t consume();
+
+  /**
+   * @brief 等待fd可读，不读取计数器
+   *
+   * @param timeout 负数表示一直等待
+   * @return true   可读
+   * @return false  超时或被信号中断
+   */
+  bool wait(std::chrono::milliseconds timeout = std::chrono::milliseconds{ -1 });
+
+private:
+  int fd_;
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_EVENT_FD_H
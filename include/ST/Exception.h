@@ -39,7 +39,7 @@ public:
  * @brief 未定义的family
  *
  */
-class UndefinedFamilyException: std::logic_error {
+class UndefinedFamilyException: public std::logic_error {
 public:
   template<typename... T>
   UndefinedFamilyException(fmt::format_string<T...> fmt, T&&... args)
@@ -51,7 +51,7 @@ public:
  * @brief 未定义的Type
  *
  */
-class UndefinedTypeException: std::logic_error {
+class UndefinedTypeException: public std::logic_error {
 public:
   template<typename... T>
   UndefinedTypeException(fmt::format_string<T...> fmt, T&&... args)
@@ -83,6 +83,66 @@ public:
   {}
 };
 
+/**
+ * @brief 向已经被移动或已经回收的进程发送信号，pid可能已经属于其他进程
+ *
+ */
+class InvalidProcessKillException: public std::logic_error {
+public:
+  template<typename... T>
+  InvalidProcessKillException(fmt::format_string<T...> fmt, T&&... args)
+    : std::logic_error{ fmt::format(fmt, std::forward<T>(args)...) }
+  {}
+};
+
+/**
+ * @brief 帧长度超过codec允许的上限
+ *
+ */
+class FrameTooLongException: public std::length_error {
+public:
+  template<typename... T>
+  FrameTooLongException(fmt::format_string<T...> fmt, T&&... args)
+    : std::length_error{ fmt::format(fmt, std::forward<T>(args)...) }
+  {}
+};
+
+/**
+ * @brief 帧负载的校验和与帧头中的不一致
+ *
+ */
+class FrameChecksumException: public std::runtime_error {
+public:
+  template<typename... T>
+  FrameChecksumException(fmt::format_string<T...> fmt, T&&... args)
+    : std::runtime_error{ fmt::format(fmt, std::forward<T>(args)...) }
+  {}
+};
+
+/**
+ * @brief 同名的metric已经以其他类型注册
+ *
+ */
+class MetricTypeMismatchException: public std::logic_error {
+public:
+  template<typename... T>
+  MetricTypeMismatchException(fmt::format_string<T...> fmt, T&&... args)
+    : std::logic_error{ fmt::format(fmt, std::forward<T>(args)...) }
+  {}
+};
+
+/**
+ * @brief 文件大小不是记录大小的整数倍
+ *
+ */
+class TruncatedRecordException: public std::length_error {
+public:
+  template<typename... T>
+  TruncatedRecordException(fmt::format_string<T...> fmt, T&&... args)
+    : std::length_error{ fmt::format(fmt, std::forward<T>(args)...) }
+  {}
+};
+
 } // namespace ST
 
 #endif // STUDY_TOUR_EXCEPTION_H
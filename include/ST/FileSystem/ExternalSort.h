@@ -0,0 +1,497 @@
+/**
+ * @file ExternalSort.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 外部排序，排序比内存大得多的定长记录文件
+ * @version 0.1
+ * @date 2022-07-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_FILE_SYSTEM_EXTERNAL_SORT_H
+#define STUDY_TOUR_FILE_SYSTEM_EXTERNAL_SORT_H
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "st/Alogorithm.h"
+#include "st/Sort.h"
+#include "ST/Exception.h"
+#include "ST/FileSystem/File.h"
+#include "ST/ThreadPool.h"
+
+
+namespace ST::FileSystem {
+
+struct ExternalSortOptions {
+  // 排序时最多使用的内存，包括排序缓冲区和parallel_sort的临时空间；
+  // 有pool时两个run缓冲区加上parallel_sort的临时空间各占三分之一
+  std::size_t memory = std::size_t{ 1 } << 30;
+  // 归并时每个run的读缓冲区
+  std::size_t read_buffer = std::size_t{ 4 } << 20;
+  // 归并输出的写缓冲区
+  std::size_t write_buffer = std::size_t{ 16 } << 20;
+  // 一次最多归并的run数，为0时为memory / (2 * read_buffer)；run更多时先归并成更大的中间run
+  std::size_t fan_in = 0;
+  // 临时文件所在的目录，创建后立即unlink，进程退出后不会残留
+  std::string temporary_directory = "/tmp";
+  // 不为空时: 用parallel_sort生成run，写run和读下一块重叠，归并时异步预读和写出
+  ThreadPool* pool = nullptr;
+  // 归并时mmap读run，代替pread到缓冲区
+  bool mmap = false;
+};
+
+struct ExternalSortStats {
+  std::size_t records = 0;
+  // 第一轮生成的run数
+  std::size_t runs = 0;
+  // 归并的轮数，全部在内存中排序时为0
+  std::size_t merge_passes = 0;
+};
+
+namespace detail {
+
+// 文件的实际大小(fstat)
+std::size_t file_size(const File& file);
+
+/**
+ * @brief 从offset读满n_bytes，被信号中断时重试
+ *
+ * @exception std::system_error 读取失败或文件提前结束(EIO)
+ */
+void read_exactly(const File& file, void* buffer, std::size_t n_bytes, off_t offset);
+
+// 写满n_bytes，被信号中断时重试
+void write_exactly(File& file, const void* buffer, std::size_t n_bytes, off_t offset);
+
+/**
+ * @brief 已经unlink的临时文件，析构时关闭
+ *
+ */
+class TemporaryFile {
+public:
+  explicit TemporaryFile(const std::string& directory);
+
+  TemporaryFile(const TemporaryFile& other) = delete;
+  TemporaryFile& operator=(const TemporaryFile& other) = delete;
+
+  TemporaryFile(TemporaryFile&& other) noexcept = default;
+  TemporaryFile& operator=(TemporaryFile&& other) noexcept;
+
+  ~TemporaryFile();
+
+  File& file() noexcept { return file_; }
+
+private:
+  File file_;
+
+  void release() noexcept;
+};
+
+/**
+ * @brief 只读映射整个文件，析构时munmap
+ *
+ */
+class MappedFile {
+public:
+  MappedFile(const File& file, std::size_t size);
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  ~MappedFile();
+
+  const std::byte* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+
+  // 提示内核预读[offset, offset + length)
+  void will_need(std::size_t offset, std::size_t length) const noexcept;
+
+  // 已经读完的[offset, offset + length)不再需要，释放对应的页
+  void discard(std::size_t offset, std::size_t length) const noexcept;
+
+private:
+  std::byte* data_;
+  std::size_t size_;
+
+  void release() noexcept;
+};
+
+// 已排序的run，记录从文件开头连续存放
+struct Run {
+  TemporaryFile file;
+  std::size_t records;
+};
+
+/**
+ * @brief 按块顺序读一个run
+ *
+ * @details pread模式: 有pool时双缓冲，当前块被消费时下一块已经在后台读取；
+ * mmap模式: 每次前进一块，提示内核预读下一块并释放上一块的页，常驻内存不超过两块
+ */
+template<typename Record>
+class RunReader {
+public:
+  RunReader(const File& file, std::size_t records, std::size_t block, ThreadPool* pool, bool mmap)
+    : file_{ &file },
+      records_{ records },
+      block_{ std::max<std::size_t>(block, 1) },
+      loaded_{ 0 },
+      position_{ nullptr },
+      end_{ nullptr },
+      pool_{ pool }
+  {
+    if (records_ == 0)
+      return;
+
+    if (mmap) {
+      mapped_.emplace_back(file, records_ * sizeof(Record));
+      mapped_.front().will_need(0, std::min(records_, 2 * block_) * sizeof(Record));
+    }
+    else {
+      front_.resize(std::min(records_, block_));
+      if (pool_ != nullptr && records_ > block_)
+        back_.resize(std::min(records_ - block_, block_));
+    }
+
+    refill();
+  }
+
+  RunReader(const RunReader& other) = delete;
+  RunReader& operator=(const RunReader& other) = delete;
+
+  RunReader(RunReader&& other) noexcept = default;
+  RunReader& operator=(RunReader&& other) noexcept = delete;
+
+  ~RunReader()
+  {
+    // 后台读取还在写back_
+    if (prefetch_.valid())
+      prefetch_.wait();
+  }
+
+  bool exhausted() const noexcept { return position_ == end_; }
+
+  const Record& head() const noexcept { return *position_; }
+
+  void next()
+  {
+    if (++position_ == end_)
+      refill();
+  }
+
+private:
+  const File* file_;
+  std::size_t records_;
+  std::size_t block_;
+  // 已经读入缓冲区或映射窗口的记录数
+  std::size_t loaded_;
+  const Record* position_;
+  const Record* end_;
+  ThreadPool* pool_;
+  std::vector<Record> front_{};
+  std::vector<Record> back_{};
+  std::future<void> prefetch_{};
+  // 最多一个，vector只是为了不要求MappedFile可以默认构造
+  std::vector<MappedFile> mapped_{};
+
+  void refill()
+  {
+    if (loaded_ == records_) {
+      position_ = end_ = nullptr;
+      return;
+    }
+
+    auto count = std::min(block_, records_ - loaded_);
+
+    if (!mapped_.empty()) {
+      auto& mapped = mapped_.front();
+      if (loaded_ != 0)
+        mapped.discard((loaded_ - block_) * sizeof(Record), block_ * sizeof(Record));
+      mapped.will_need((loaded_ + count) * sizeof(Record), std::min(block_, records_ - loaded_ - count) * sizeof(Record));
+
+      position_ = reinterpret_cast<const Record*>(mapped.data()) + loaded_;
+    }
+    else {
+      if (prefetch_.valid()) {
+        prefetch_.get();
+        std::swap(front_, back_);
+      }
+      else {
+        read_exactly(*file_, front_.data(), count * sizeof(Record), static_cast<off_t>(loaded_ * sizeof(Record)));
+      }
+
+      auto next = loaded_ + count;
+      if (pool_ != nullptr && next < records_) {
+        auto bytes = std::min(block_, records_ - next) * sizeof(Record);
+        prefetch_ = pool_->submit([file = file_, buffer = back_.data(), bytes, offset = next * sizeof(Record)] {
+          read_exactly(*file, buffer, bytes, static_cast<off_t>(offset));
+        });
+      }
+
+      position_ = front_.data();
+    }
+
+    end_ = position_ + count;
+    loaded_ += count;
+  }
+};
+
+/**
+ * @brief 带缓冲的顺序写，有pool时双缓冲，写出一块的同时填充另一块
+ *
+ */
+template<typename Record>
+class RunWriter {
+public:
+  RunWriter(File& file, std::size_t block, ThreadPool* pool)
+    : file_{ &file },
+      block_{ std::max<std::size_t>(block, 1) },
+      written_{ 0 },
+      pool_{ pool }
+  {
+    front_.reserve(block_);
+    if (pool_ != nullptr)
+      back_.reserve(block_);
+  }
+
+  RunWriter(const RunWriter& other) = delete;
+  RunWriter& operator=(const RunWriter& other) = delete;
+
+  ~RunWriter()
+  {
+    if (pending_.valid())
+      pending_.wait();
+  }
+
+  void push(const Record& record)
+  {
+    front_.push_back(record);
+    if (front_.size() == block_)
+      flush();
+  }
+
+  // 写出剩余的数据并等待全部完成
+  void finish()
+  {
+    flush();
+    if (pending_.valid())
+      pending_.get();
+  }
+
+private:
+  File* file_;
+  std::size_t block_;
+  std::size_t written_;
+  ThreadPool* pool_;
+  std::vector<Record> front_{};
+  std::vector<Record> back_{};
+  std::future<void> pending_{};
+
+  void flush()
+  {
+    if (front_.empty())
+      return;
+
+    auto bytes = front_.size() * sizeof(Record);
+    auto offset = static_cast<off_t>(written_ * sizeof(Record));
+    written_ += front_.size();
+
+    if (pool_ == nullptr) {
+      write_exactly(*file_, front_.data(), bytes, offset);
+      front_.clear();
+      return;
+    }
+
+    if (pending_.valid())
+      pending_.get();
+
+    std::swap(front_, back_);
+    front_.clear();
+    pending_ = pool_->submit([file = file_, buffer = back_.data(), bytes, offset] {
+      write_exactly(*file, buffer, bytes, offset);
+    });
+  }
+};
+
+template<typename Record, typename Compare>
+void merge_runs(std::span<Run> runs, File& output, Compare& comp, const ExternalSortOptions& options)
+{
+  std::vector<RunReader<Record>> readers{};
+  readers.reserve(runs.size());
+  for (auto& run: runs)
+    readers.emplace_back(run.file.file(), run.records, options.read_buffer / sizeof(Record), options.pool, options.mmap);
+
+  RunWriter<Record> writer{ output, options.write_buffer / sizeof(Record), options.pool };
+
+  st::LoserTree tree{
+    readers.size(),
+    [&readers, &comp] (std::size_t i, std::size_t j) { return static_cast<bool>(comp(readers[i].head(), readers[j].head())); },
+    [&readers] (std::size_t i) { return readers[i].exhausted(); }
+  };
+
+  for (; !tree.empty(); tree.replay()) {
+    auto& reader = readers[tree.top()];
+    writer.push(reader.head());
+    reader.next();
+  }
+
+  writer.finish();
+}
+
+// 异常退出时等待后台任务，它还在使用栈上的缓冲区
+struct WaitOnExit {
+  std::future<void>& future;
+
+  ~WaitOnExit()
+  {
+    if (future.valid())
+      future.wait();
+  }
+};
+
+} // namespace detail
+
+
+/**
+ * @brief 外部排序: 按内存大小切块排序后写入临时文件(run)，再用败者树多路归并
+ * @example
+ * ST::ThreadPool pool{};
+ * ST::FileSystem::external_sort<Entry>(input, output, by_key, { .memory = 48ull << 30, .pool = &pool });
+ *
+ * @details 输入能放进options.memory时直接在内存中排序；run数超过fan_in时分多轮归并，
+ * 每轮读写整个数据集一次。相等的记录之间不保证稳定<br/>
+ * 生成run和内存排序的峰值内存不超过options.memory；归并时为fan_in个读缓冲区(有pool时双缓冲)加上写缓冲区
+ * @tparam Record 定长记录，必须可以直接按字节读写并默认构造
+ * @param input 已打开的输入文件，大小必须是sizeof(Record)的整数倍
+ * @param output 已打开的可写文件，可以和input是同一个文件，大小会被截断为input的大小
+ * @exception TruncatedRecordException input大小不是sizeof(Record)的整数倍
+ */
+template<typename Record, typename Compare = std::less<>>
+  requires std::is_trivially_copyable_v<Record> && std::default_initializable<Record>
+ExternalSortStats external_sort(const File& input, File& output, Compare comp = {}, const ExternalSortOptions& options = {})
+{
+  SPDLOG_INFO("external sorting {} into {}, {} bytes memory", input.file_name(), output.file_name(), options.memory);
+
+  auto bytes = detail::file_size(input);
+  if (bytes % sizeof(Record) != 0) {
+    SPDLOG_ERROR("{} has {} bytes, not a multiple of record size {}", input.file_name(), bytes, sizeof(Record));
+    throw TruncatedRecordException{ "{} is not a multiple of record size {}", input.file_name(), sizeof(Record) };
+  }
+
+  ExternalSortStats stats{};
+  stats.records = bytes / sizeof(Record);
+
+  auto sort = [&options, &comp] (std::vector<Record>& records) {
+    if (options.pool != nullptr)
+      st::parallel_sort(*options.pool, records.begin(), records.end(), comp);
+    else
+      st::sort(records, comp);
+  };
+
+  // parallel_sort需要和数据一样大的临时空间，st::sort原地排序
+  auto sort_memory = options.pool != nullptr ? options.memory / 2 : options.memory;
+
+  // 内存放得下时不需要临时文件
+  if (bytes <= sort_memory) {
+    std::vector<Record> records(stats.records);
+    detail::read_exactly(input, records.data(), bytes, 0);
+    sort(records);
+    output.resize(static_cast<off_t>(bytes));
+    detail::write_exactly(output, records.data(), bytes, 0);
+
+    stats.runs = stats.records == 0 ? 0 : 1;
+    SPDLOG_INFO("external sorted {} records in memory", stats.records);
+    return stats;
+  }
+
+  // 有pool时一个缓冲区在排序(加上同样大的临时空间)，另一个在写出
+  auto run_records = std::max<std::size_t>(options.memory / sizeof(Record) / (options.pool != nullptr ? 3 : 1), 1);
+  std::vector<detail::Run> runs{};
+  runs.reserve((stats.records + run_records - 1) / run_records);
+
+  {
+    // 有pool时写出上一个run的同时读取和排序下一个
+    std::vector<Record> buffers[2]{};
+    std::future<void> writing{};
+    detail::WaitOnExit wait{ writing };
+
+    for (std::size_t offset = 0; offset < stats.records; offset += run_records) {
+      auto& buffer = buffers[runs.size() % 2];
+      buffer.resize(std::min(run_records, stats.records - offset));
+      detail::read_exactly(input, buffer.data(), buffer.size() * sizeof(Record), static_cast<off_t>(offset * sizeof(Record)));
+      sort(buffer);
+
+      auto& run = runs.emplace_back(detail::Run{ detail::TemporaryFile{ options.temporary_directory }, buffer.size() });
+      if (options.pool == nullptr) {
+        detail::write_exactly(run.file.file(), buffer.data(), buffer.size() * sizeof(Record), 0);
+        continue;
+      }
+
+      if (writing.valid())
+        writing.get();
+      writing = options.pool->submit([&file = run.file.file(), &buffer] {
+        detail::write_exactly(file, buffer.data(), buffer.size() * sizeof(Record), 0);
+      });
+    }
+
+    if (writing.valid())
+      writing.get();
+  }
+
+  stats.runs = runs.size();
+  SPDLOG_INFO("external sort generated {} runs of at most {} records", runs.size(), run_records);
+
+  auto fan_in = options.fan_in != 0 ? options.fan_in : options.memory / (2 * std::max<std::size_t>(options.read_buffer, 1));
+  fan_in = std::max<std::size_t>(fan_in, 2);
+
+  while (runs.size() > fan_in) {
+    ++stats.merge_passes;
+    SPDLOG_INFO("external sort merge pass {}, {} runs", stats.merge_passes, runs.size());
+
+    std::vector<detail::Run> merged{};
+    merged.reserve((runs.size() + fan_in - 1) / fan_in);
+    for (std::size_t first = 0; first < runs.size(); first += fan_in) {
+      auto group = std::span{ runs }.subspan(first, std::min(fan_in, runs.size() - first));
+      if (group.size() == 1) {
+        merged.push_back(std::move(group.front()));
+        continue;
+      }
+
+      std::size_t records = 0;
+      for (auto& run: group)
+        records += run.records;
+
+      auto& run = merged.emplace_back(detail::Run{ detail::TemporaryFile{ options.temporary_directory }, records });
+      detail::merge_runs<Record>(group, run.file.file(), comp, options);
+    }
+
+    runs = std::move(merged);
+  }
+
+  ++stats.merge_passes;
+  output.resize(static_cast<off_t>(bytes));
+  detail::merge_runs<Record>(runs, output, comp, options);
+
+  SPDLOG_INFO("external sorted {} records, {} runs, {} merge passes", stats.records, stats.runs, stats.merge_passes);
+  return stats;
+}
+
+} // namespace ST::FileSystem
+
+#endif // STUDY_TOUR_FILE_SYSTEM_EXTERNAL_SORT_H
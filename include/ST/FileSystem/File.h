@@ -15,9 +15,11 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include <new>
 #include <string>
 #include <utility>
 
+#include "st/Result.h"
 #include "ST/Exception.h"
 
 
@@ -116,6 +118,13 @@ public:
    */
   constexpr bool opened() const { return fd_ != -1; }
 
+  /**
+   * @brief 底层的fd，未打开时为-1
+   *
+   * @return int
+   */
+  constexpr int fd() const noexcept { return fd_; }
+
   /**
    * @brief 已打开/将要打开的文件的文件名
    *
@@ -195,6 +204,16 @@ public:
    */
   ssize_t pwrite(const void* buffer, size_t n_bytes, off_t offset);
 
+  /**
+   * @brief 不抛异常、不写日志的读写，未打开时为EBADF
+   *
+   * @return st::Result<std::size_t> 实际读写的字节数，失败时为errno
+   */
+  st::Result<std::size_t> read(void* buffer, size_t n_bytes, std::nothrow_t) const noexcept;
+  st::Result<std::size_t> write(const void* buffer, size_t n_bytes, std::nothrow_t) noexcept;
+  st::Result<std::size_t> pread(void* buffer, size_t n_bytes, off_t offset, std::nothrow_t) const noexcept;
+  st::Result<std::size_t> pwrite(const void* buffer, size_t n_bytes, off_t offset, std::nothrow_t) noexcept;
+
   /**
    * @brief 将系统缓冲区的数据同步到实际的文件里
    *
@@ -20,9 +20,11 @@ namespace ST::Net {
 
 enum class Family {
   IPv4,
-  IPv6
+  IPv6,
+  Unix
 };
 
+// Unix域socket中TCP即SOCK_STREAM，UDP即SOCK_DGRAM
 enum class Type {
   TCP,
   UDP
@@ -0,0 +1,103 @@
+/**
+ * @file IO.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 读满/写完指定字节数，处理EINTR、EAGAIN和部分读写
+ * @version 0.1
+ * @date 2022-07-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_IO_H
+#define STUDY_TOUR_IO_H
+
+#include <sys/uio.h>
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+
+namespace ST {
+
+/**
+ * @brief 有fd()的类型，比如FileSystem::File、Net::Socket
+ *
+ */
+template<typename T>
+concept Descriptor = requires(const T& t) {
+  { t.fd() } -> std::convertible_to<int>;
+};
+
+/**
+ * @brief 一直读到填满buffer或者EOF
+ *
+ * @details 被信号打断(EINTR)时重试；非阻塞fd返回EAGAIN时poll等待可读，
+ * 所以对非阻塞fd也是阻塞语义
+ * @return std::size_t 读到的字节数，只有遇到EOF时才小于buffer.size()
+ */
+std::size_t read_exact(int fd, std::span<std::byte> buffer);
+
+/**
+ * @brief 写完buffer中的所有数据
+ *
+ * @details 被信号打断(EINTR)时重试；非阻塞fd返回EAGAIN时poll等待可写。
+ * 对socket使用MSG_NOSIGNAL，对端关闭时抛出EPIPE而不是触发SIGPIPE；
+ * 管道没有这个标志，写已关闭的管道仍然需要调用方忽略SIGPIPE
+ * @return std::size_t 总是buffer.size()，出错时抛出异常
+ */
+std::size_t write_all(int fd, std::span<const std::byte> buffer);
+
+/**
+ * @brief 用readv一直读到填满所有buffer或者EOF
+ *
+ * @details buffers会被原地修改：完全读满的iovec长度变为0，部分读入的iovec前移，
+ * 返回时剩余的部分就是没有读到的部分
+ * @return std::size_t 读到的总字节数
+ */
+std::size_t read_exact(int fd, std::span<iovec> buffers);
+
+/**
+ * @brief 用writev写完所有buffer，一次系统调用最多IOV_MAX个
+ *
+ * @details buffers会被原地修改，同read_exact；SIGPIPE的处理同上
+ * @return std::size_t 写出的总字节数
+ */
+std::size_t write_all(int fd, std::span<iovec> buffers);
+
+
+// 任意trivially copyable元素的span，按字节读写
+template<typename T, std::size_t Extent>
+  requires std::is_trivially_copyable_v<T> && (!std::is_same_v<std::remove_const_t<T>, iovec>)
+std::size_t read_exact(int fd, std::span<T, Extent> buffer)
+{
+  return read_exact(fd, std::span<std::byte>{ std::as_writable_bytes(buffer) });
+}
+
+template<typename T, std::size_t Extent>
+  requires std::is_trivially_copyable_v<T> && (!std::is_same_v<std::remove_const_t<T>, iovec>)
+std::size_t write_all(int fd, std::span<T, Extent> buffer)
+{
+  return write_all(fd, std::span<const std::byte>{ std::as_bytes(buffer) });
+}
+
+// File、Socket等直接转发给fd版本，buffer可以是上面任意一种span
+template<Descriptor D, typename Buffer>
+auto read_exact(D& descriptor, Buffer&& buffer)
+  -> decltype(read_exact(descriptor.fd(), std::forward<Buffer>(buffer)))
+{
+  return read_exact(descriptor.fd(), std::forward<Buffer>(buffer));
+}
+
+template<Descriptor D, typename Buffer>
+auto write_all(D& descriptor, Buffer&& buffer)
+  -> decltype(write_all(descriptor.fd(), std::forward<Buffer>(buffer)))
+{
+  return write_all(descriptor.fd(), std::forward<Buffer>(buffer));
+}
+
+} // namespace ST
+
+#endif // STUDY_TOUR_IO_H
@@ -0,0 +1,352 @@
+/**
+ * @file Logger.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 异步日志，调用线程只做二进制拷贝，格式化和写文件在后台线程
+ * @version 0.1
+ * @date 2022-07-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_LOGGER_H
+#define STUDY_TOUR_LOGGER_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "ST/FileSystem/File.h"
+
+
+namespace spdlog {
+class logger;
+} // namespace spdlog
+
+
+namespace ST {
+
+// 每个线程的环形缓冲区大小，必须是2的幂
+constexpr static std::size_t DEFAULT_LOG_RING_SIZE = 256 * 1024;
+// 后台线程攒够这么多字节就写一次文件
+constexpr static std::size_t LOG_BATCH_SIZE = 64 * 1024;
+// 后台线程没有日志可写时的轮询间隔，调用线程从不唤醒后台线程
+constexpr static std::chrono::milliseconds LOG_IDLE_INTERVAL{ 10 };
+
+enum class LogLevel : std::uint8_t {
+  Trace,
+  Debug,
+  Info,
+  Warn,
+  Error,
+  Critical,
+  Off
+};
+
+std::string_view to_string(LogLevel level) noexcept;
+
+/**
+ * @brief 异步日志
+ *
+ * @details 每个线程第一次写日志时创建自己的SPSC环形缓冲区，写日志只是把格式串指针、
+ * 时间戳和参数的二进制拷贝追加到缓冲区，不加锁、不格式化、不做系统调用；
+ * 后台线程轮询所有缓冲区，格式化后攒成批用一次File::write写出<br/>
+ * 参数的保存方式：
+ * - 字符串(const char*、std::string、std::string_view等)拷贝内容
+ * - trivially copyable的类型(整数、浮点、枚举、指针等)按字节拷贝，在后台线程格式化
+ * - 其他类型在调用线程先格式化成字符串
+ *
+ * 缓冲区满时丢弃日志并计数，不会阻塞调用线程
+ * @warning 格式串必须是编译期常量(fmt::format_string保证了这一点)，后台线程只保存它的指针
+ */
+class Logger {
+public:
+  /**
+   * @brief
+   *
+   * @param sink      日志写入的文件，必须已经打开，Logger析构时不会close
+   * @param ring_size 每个线程的缓冲区大小，向上取整为2的幂
+   */
+  explicit Logger(FileSystem::File sink = FileSystem::File{ "stderr", STDERR_FILENO },
+                  std::size_t ring_size = DEFAULT_LOG_RING_SIZE);
+
+  Logger(const Logger& other) = delete;
+  Logger& operator=(const Logger& other) = delete;
+
+  Logger(Logger&& other) noexcept = delete;
+  Logger& operator=(Logger&& other) noexcept = delete;
+
+  // 写出所有已提交的日志
+  ~Logger();
+
+  /**
+   * @brief 写到stderr的全局Logger
+   *
+   */
+  static Logger& instance();
+
+  template<typename... Args>
+  void log(LogLevel level, fmt::format_string<Args...> format, Args&&... args)
+  {
+    if (!should_log(level) || in_backend_)
+      return;
+
+    push(level, fmt::string_view{ format }, capture(args)...);
+  }
+
+  template<typename... Args>
+  void trace(fmt::format_string<Args...> format, Args&&... args) { log(LogLevel::Trace, format, std::forward<Args>(args)...); }
+
+  template<typename... Args>
+  void debug(fmt::format_string<Args...> format, Args&&... args) { log(LogLevel::Debug, format, std::forward<Args>(args)...); }
+
+  template<typename... Args>
+  void info(fmt::format_string<Args...> format, Args&&... args) { log(LogLevel::Info, format, std::forward<Args>(args)...); }
+
+  template<typename... Args>
+  void warn(fmt::format_string<Args...> format, Args&&... args) { log(LogLevel::Warn, format, std::forward<Args>(args)...); }
+
+  template<typename... Args>
+  void error(fmt::format_string<Args...> format, Args&&... args) { log(LogLevel::Error, format, std::forward<Args>(args)...); }
+
+  template<typename... Args>
+  void critical(fmt::format_string<Args...> format, Args&&... args) { log(LogLevel::Critical, format, std::forward<Args>(args)...); }
+
+  /**
+   * @brief 写一条已经格式化好的日志，内容会被拷贝
+   *
+   */
+  void write(LogLevel level, std::string_view message) { log(level, "{}", message); }
+
+  /**
+   * @brief 等待调用之前所有线程提交的日志都写入文件
+   *
+   */
+  void flush();
+
+  /**
+   * @brief 把spdlog的默认logger换成写到本Logger的logger，库里的SPDLOG_XXX不再在调用线程写文件
+   *
+   * @details 析构时恢复原来的默认logger
+   */
+  void install_spdlog();
+
+  void level(LogLevel level) noexcept { level_.store(level, std::memory_order_relaxed); }
+  LogLevel level() const noexcept { return level_.load(std::memory_order_relaxed); }
+
+  bool should_log(LogLevel level) const noexcept
+  {
+    return level >= level_.load(std::memory_order_relaxed) && level != LogLevel::Off;
+  }
+
+  // 缓冲区满被丢弃的日志数
+  std::uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  using Decoder = void (*)(std::string_view format, const std::byte* arguments, fmt::memory_buffer& out);
+
+  struct Record {
+    // 整条记录的字节数，包括Record本身，8字节对齐
+    std::uint32_t size;
+    LogLevel level;
+    // 为nullptr时是填充，跳到缓冲区开头
+    Decoder decode;
+    const char* format;
+    std::size_t format_size;
+    std::chrono::system_clock::time_point time;
+  };
+
+  constexpr static std::size_t RECORD_ALIGNMENT = alignof(Record);
+
+  /**
+   * @brief 单生产者(所属线程)单消费者(后台线程)的变长记录环形缓冲区
+   *
+   */
+  class Ring {
+  public:
+    explicit Ring(std::size_t capacity);
+
+    /**
+     * @brief 预留size字节的连续空间，到缓冲区末尾不够时先写填充
+     *
+     * @return std::byte* 空间不足时为nullptr
+     */
+    std::byte* reserve(std::size_t size) noexcept;
+    void commit() noexcept { head_.store(pending_, std::memory_order_release); }
+
+    /**
+     * @brief 消费所有已提交的记录
+     *
+     * @return std::size_t 消费的记录数
+     */
+    template<typename Function>
+    std::size_t consume(Function&& f);
+
+    pid_t tid() const noexcept { return tid_; }
+    void retire() noexcept { retired_.store(true, std::memory_order_release); }
+    bool retired() const noexcept { return retired_.load(std::memory_order_acquire); }
+
+  private:
+    std::unique_ptr<std::byte[]> buffer_;
+    std::size_t capacity_;
+    pid_t tid_;
+    std::atomic<bool> retired_;
+    // 生产者独占
+    alignas(64) std::atomic<std::size_t> head_;
+    std::size_t pending_;
+    std::size_t cached_tail_;
+    // 消费者独占
+    alignas(64) std::atomic<std::size_t> tail_;
+  };
+
+  // 线程退出时通知所有Logger回收它的缓冲区
+  struct ThreadRings {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<Ring>>> rings;
+
+    ~ThreadRings();
+  };
+
+  std::uint64_t id_;
+  FileSystem::File sink_;
+  std::size_t ring_size_;
+  std::atomic<LogLevel> level_;
+  std::atomic<std::uint64_t> dropped_;
+  std::mutex mutex_;
+  std::condition_variable_any wakeup_;
+  std::condition_variable flushed_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  std::uint64_t flush_requested_;
+  std::uint64_t flush_completed_;
+  std::shared_ptr<spdlog::logger> previous_spdlog_;
+  std::jthread backend_;
+
+  static thread_local ThreadRings thread_rings_;
+  static thread_local bool in_backend_;
+
+  // 参数在缓冲区中的保存类型
+  // 只有算术类型、枚举和void*推迟到后台线程格式化，字符串复制内容，
+  // 其余类型(可能带有指针或引用语义)在调用线程立即格式化
+  template<typename T>
+  static auto capture(const T& value)
+  {
+    if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>)
+      return value == nullptr ? std::string_view{ "(null)" } : std::string_view{ value };
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+      return std::string_view{ value };
+    else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                       std::is_same_v<T, void*> || std::is_same_v<T, const void*>)
+      return value;
+    else
+      return fmt::format("{}", value);
+  }
+
+  template<typename T>
+  using Decoded = std::conditional_t<std::is_same_v<T, std::string>, std::string_view, T>;
+
+  template<typename T>
+  static std::size_t encoded_size(const T& value) noexcept
+  {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>)
+      return sizeof(std::uint32_t) + std::string_view{ value }.size();
+    else
+      return sizeof(T);
+  }
+
+  template<typename T>
+  static std::byte* encode(std::byte* out, const T& value) noexcept
+  {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+      std::string_view string{ value };
+      auto size = static_cast<std::uint32_t>(string.size());
+      std::memcpy(out, &size, sizeof(size));
+      std::memcpy(out + sizeof(size), string.data(), size);
+      return out + sizeof(size) + size;
+    }
+    else {
+      std::memcpy(out, &value, sizeof(T));
+      return out + sizeof(T);
+    }
+  }
+
+  template<typename T>
+  static T decode_argument(const std::byte*& in) noexcept
+  {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+      std::uint32_t size;
+      std::memcpy(&size, in, sizeof(size));
+      std::string_view string{ reinterpret_cast<const char*>(in + sizeof(size)), size };
+      in += sizeof(size) + size;
+      return string;
+    }
+    else {
+      // 缓冲区中没有对齐，不能直接reinterpret_cast
+      T value;
+      std::memcpy(&value, in, sizeof(T));
+      in += sizeof(T);
+      return value;
+    }
+  }
+
+  template<typename... Ts>
+  static void decode(std::string_view format, [[maybe_unused]] const std::byte* arguments,
+                     fmt::memory_buffer& out)
+  {
+    // 花括号初始化保证从左到右求值
+    std::tuple<Ts...> values{ decode_argument<Ts>(arguments)... };
+    std::apply([&] (auto&... values) {
+      fmt::vformat_to(fmt::appender{ out }, format, fmt::make_format_args(values...));
+    }, values);
+  }
+
+  template<typename... Captured>
+  void push(LogLevel level, fmt::string_view format, const Captured&... arguments)
+  {
+    auto size = sizeof(Record) + (std::size_t{ 0 } + ... + encoded_size(arguments));
+    size = (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+
+    auto& ring = local_ring();
+    auto data = ring.reserve(size);
+    if (data == nullptr) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    auto record = new (data) Record{
+      static_cast<std::uint32_t>(size),
+      level,
+      &decode<Decoded<Captured>...>,
+      format.data(),
+      format.size(),
+      std::chrono::system_clock::now()
+    };
+    [[maybe_unused]] auto out = data + sizeof(*record);
+    ((out = encode(out, arguments)), ...);
+
+    ring.commit();
+  }
+
+  Ring& local_ring();
+  void run(std::stop_token token);
+  std::size_t drain(fmt::memory_buffer& batch);
+  void write_batch(fmt::memory_buffer& batch) noexcept;
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_LOGGER_H
@@ -0,0 +1,237 @@
+/**
+ * @file Memory.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 按生命周期分配内存的std::pmr::memory_resource：arena、slab和线程缓存
+ * @version 0.1
+ * @date 2022-07-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_MEMORY_H
+#define STUDY_TOUR_MEMORY_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <vector>
+
+
+namespace ST {
+
+// 小对象的最大大小，更大的直接交给上游
+constexpr static std::size_t MAX_SMALL_SIZE = 4096;
+// 小对象保证的对齐，更高的对齐要求直接交给上游
+constexpr static std::size_t SMALL_ALIGNMENT = alignof(std::max_align_t);
+// slab和线程缓存每次向上游申请的大小
+constexpr static std::size_t SLAB_SIZE = 64 * 1024;
+// MonotonicArena默认的第一块大小
+constexpr static std::size_t DEFAULT_ARENA_SIZE = 4096;
+
+namespace detail {
+
+// 256以内每16字节一级，之后每个2的幂一级: 16, 32, ..., 256, 512, 1024, 2048, 4096
+constexpr static std::size_t SIZE_CLASSES = 20;
+
+constexpr std::size_t size_class(std::size_t bytes) noexcept
+{
+  if (bytes <= 256)
+    return (std::max<std::size_t>(bytes, 1) + 15) / 16 - 1;
+
+  return 16 + static_cast<std::size_t>(std::bit_width(bytes - 1)) - 9;
+}
+
+constexpr std::size_t class_size(std::size_t size_class) noexcept
+{
+  return size_class < 16 ? (size_class + 1) * 16 : std::size_t{ 512 } << (size_class - 16);
+}
+
+constexpr bool is_small(std::size_t bytes, std::size_t alignment) noexcept
+{
+  return bytes <= MAX_SMALL_SIZE && alignment <= SMALL_ALIGNMENT;
+}
+
+// 空闲块内部存放下一个空闲块的指针
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+/**
+ * @brief 单链表的空闲块
+ *
+ */
+struct FreeList {
+  FreeBlock* head = nullptr;
+  std::size_t size = 0;
+
+  void push(void* p) noexcept
+  {
+    auto block = static_cast<FreeBlock*>(p);
+    block->next = head;
+    head = block;
+    ++size;
+  }
+
+  void* pop() noexcept
+  {
+    auto block = head;
+    head = block->next;
+    --size;
+    return block;
+  }
+};
+
+} // namespace detail
+
+
+/**
+ * @brief 单调增长的arena，deallocate什么也不做，reset()时整体释放
+ *
+ * @details 分配只是移动指针；当前块用完时向上游申请一块两倍大的新块。
+ * reset()保留最大的一块，稳定之后每个请求/每轮事件都不再访问上游，适合生命周期一致的一批临时对象
+ * @warning 不是线程安全的
+ */
+class MonotonicArena: public std::pmr::memory_resource {
+public:
+  explicit MonotonicArena(std::size_t initial_size = DEFAULT_ARENA_SIZE,
+                          std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+  /**
+   * @brief 先使用调用者提供的buffer(比如栈上的数组)，用完再向上游申请
+   *
+   */
+  explicit MonotonicArena(std::span<std::byte> buffer,
+                          std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+  MonotonicArena(const MonotonicArena& other) = delete;
+  MonotonicArena& operator=(const MonotonicArena& other) = delete;
+
+  ~MonotonicArena() override;
+
+  /**
+   * @brief 释放所有分配，保留最大的一块供之后使用
+   *
+   * @warning 之前分配的内存全部失效
+   */
+  void reset() noexcept;
+
+  // 释放所有分配，并把所有块还给上游
+  void release() noexcept;
+
+  // 自上次reset以来分配出去的字节数
+  std::size_t allocated() const noexcept { return allocated_; }
+
+  std::pmr::memory_resource* upstream() const noexcept { return upstream_; }
+
+protected:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+  // 从上游申请的块，头部记录块的大小和链接
+  struct Chunk {
+    Chunk* next;
+    std::size_t size;
+  };
+
+  std::pmr::memory_resource* upstream_;
+  std::span<std::byte> initial_;
+  // 正在使用的块，最新的在头部
+  Chunk* chunks_;
+  // reset时保留下来的最大的块
+  Chunk* spare_;
+  std::byte* current_;
+  std::byte* end_;
+  std::size_t next_size_;
+  std::size_t allocated_;
+
+  void grow(std::size_t bytes, std::size_t alignment);
+};
+
+/**
+ * @brief 按大小分级的slab池，每级一个空闲链表，释放的块立即可以被同级的分配复用
+ *
+ * @details 每级从上游按SLAB_SIZE申请slab再切成等长的块；大于MAX_SMALL_SIZE或对齐要求更高的分配直接交给上游。
+ * slab只在release()或析构时还给上游，适合一个连接/一个模块内反复分配释放同样大小对象的场景
+ * @warning 不是线程安全的，多线程使用ThreadCachingResource
+ */
+class SlabPool: public std::pmr::memory_resource {
+public:
+  explicit SlabPool(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+  SlabPool(const SlabPool& other) = delete;
+  SlabPool& operator=(const SlabPool& other) = delete;
+
+  ~SlabPool() override;
+
+  /**
+   * @brief 把所有slab还给上游
+   *
+   * @warning 之前分配的小对象全部失效，大对象不受影响
+   */
+  void release() noexcept;
+
+  // 从上游申请的slab数
+  std::size_t slabs() const noexcept { return slabs_.size(); }
+
+  std::pmr::memory_resource* upstream() const noexcept { return upstream_; }
+
+protected:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+  std::pmr::memory_resource* upstream_;
+  std::array<detail::FreeList, detail::SIZE_CLASSES> free_{};
+  std::vector<void*> slabs_;
+
+  void refill(std::size_t size_class);
+};
+
+/**
+ * @brief 线程安全的小对象分配，类似tcmalloc的线程缓存
+ *
+ * @details 每个线程每级有自己的空闲链表，分配和释放在缓存命中时没有锁也没有原子操作；
+ * 缓存空了从中心链表批量取，太长时批量还回中心链表，每次加锁摊销到一批块上。
+ * 可以在一个线程分配、在另一个线程释放。从上游申请的slab和实例本身在进程结束前都不会释放
+ */
+class ThreadCachingResource: public std::pmr::memory_resource {
+public:
+  ThreadCachingResource(const ThreadCachingResource& other) = delete;
+  ThreadCachingResource& operator=(const ThreadCachingResource& other) = delete;
+
+  // 线程缓存按线程全局共享，所以只有一个实例
+  static ThreadCachingResource& global();
+
+  // 中心链表中空闲块的字节数
+  std::size_t central_free_bytes() const;
+
+protected:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+  struct alignas(64) Central {
+    mutable std::mutex mutex{};
+    detail::FreeList list{};
+  };
+
+  std::array<Central, detail::SIZE_CLASSES> central_{};
+
+  ThreadCachingResource() = default;
+
+  void refill(detail::FreeList& cache, std::size_t size_class);
+  void flush(detail::FreeList& cache, std::size_t size_class, std::size_t count);
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_MEMORY_H
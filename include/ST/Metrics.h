@@ -0,0 +1,334 @@
+/**
+ * @file Metrics.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 低开销的计数器、仪表和延迟直方图
+ * @version 0.1
+ * @date 2022-07-21
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_METRICS_H
+#define STUDY_TOUR_METRICS_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "ST/Singleton.h"
+
+
+namespace ST {
+
+// 每个metric的分片数，线程按编号轮流分到不同分片，分片之间不共享cache line
+constexpr static std::size_t METRIC_SHARDS = 8;
+
+namespace detail {
+
+// 当前线程使用的分片，第一次使用时分配
+std::size_t metric_shard() noexcept;
+
+} // namespace detail
+
+/**
+ * @brief 单调递增的计数器
+ *
+ * @details add只是对本线程分片的一次relaxed fetch_add，读取时把所有分片加起来
+ */
+class Counter {
+public:
+  Counter() = default;
+
+  Counter(const Counter& other) = delete;
+  Counter& operator=(const Counter& other) = delete;
+
+  void add(std::uint64_t n = 1) noexcept
+  {
+    shards_[detail::metric_shard()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  std::uint64_t value() const noexcept;
+
+  void reset() noexcept;
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<std::uint64_t> value{ 0 };
+  };
+
+  Shard shards_[METRIC_SHARDS];
+};
+
+/**
+ * @brief 可增可减的当前值，比如连接数
+ *
+ */
+class Gauge {
+public:
+  Gauge() = default;
+
+  Gauge(const Gauge& other) = delete;
+  Gauge& operator=(const Gauge& other) = delete;
+
+  void set(std::int64_t value) noexcept { value_.store(value, std::memory_order_relaxed); }
+  void add(std::int64_t n = 1) noexcept { value_.fetch_add(n, std::memory_order_relaxed); }
+  void sub(std::int64_t n = 1) noexcept { value_.fetch_sub(n, std::memory_order_relaxed); }
+
+  std::int64_t value() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+  void reset() noexcept { set(0); }
+
+private:
+  std::atomic<std::int64_t> value_{ 0 };
+};
+
+/**
+ * @brief HDR风格的对数-线性直方图
+ *
+ * @details 每个2的幂区间再等分成2^SUB_BUCKET_BITS个桶，相对误差不超过1/8，
+ * 覆盖整个uint64_t范围，不需要预先指定上限；记录是对本线程分片的几次relaxed原子操作
+ */
+class Histogram {
+public:
+  constexpr static unsigned SUB_BUCKET_BITS = 3;
+  constexpr static std::size_t SUB_BUCKETS = std::size_t{ 1 } << SUB_BUCKET_BITS;
+  constexpr static std::size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief 某一时刻所有分片合并的结果
+   *
+   */
+  struct Snapshot {
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t min = 0;
+    std::uint64_t max = 0;
+    std::vector<std::uint64_t> buckets{};
+
+    double mean() const noexcept { return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count); }
+
+    /**
+     * @brief 分位数
+     *
+     * @param quantile 0到1之间，比如0.99
+     * @return std::uint64_t 所在桶的上界，不超过max
+     */
+    std::uint64_t percentile(double quantile) const noexcept;
+  };
+
+  /**
+   * @brief 析构时记录经过的纳秒数
+   *
+   */
+  class Timer {
+  public:
+    explicit Timer(Histogram& histogram) noexcept : histogram_{ histogram }, start_{ Clock::now() } {}
+
+    Timer(const Timer& other) = delete;
+    Timer& operator=(const Timer& other) = delete;
+
+    ~Timer() { histogram_.record_since(start_); }
+
+  private:
+    Histogram& histogram_;
+    Clock::time_point start_;
+  };
+
+  Histogram();
+
+  Histogram(const Histogram& other) = delete;
+  Histogram& operator=(const Histogram& other) = delete;
+
+  void record(std::uint64_t value) noexcept
+  {
+    auto& shard = shards_[detail::metric_shard()];
+    shard.buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+
+    // 大多数记录既不是最小也不是最大，只有一次load
+    auto min = shard.min.load(std::memory_order_relaxed);
+    while (value < min && !shard.min.compare_exchange_weak(min, value, std::memory_order_relaxed))
+      ;
+    auto max = shard.max.load(std::memory_order_relaxed);
+    while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+      ;
+  }
+
+  void record_since(Clock::time_point start) noexcept
+  {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    record(elapsed > 0 ? static_cast<std::uint64_t>(elapsed) : 0);
+  }
+
+  Timer time() noexcept { return Timer{ *this }; }
+
+  Snapshot snapshot() const;
+
+  void reset() noexcept;
+
+  constexpr static std::size_t bucket_of(std::uint64_t value) noexcept
+  {
+    if (value < SUB_BUCKETS)
+      return static_cast<std::size_t>(value);
+
+    auto exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+    auto sub = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + static_cast<std::size_t>(sub);
+  }
+
+  // 桶中最大的值
+  constexpr static std::uint64_t bucket_upper_bound(std::size_t bucket) noexcept
+  {
+    if (bucket < SUB_BUCKETS)
+      return bucket;
+
+    auto exponent = static_cast<unsigned>(bucket / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    auto sub = static_cast<std::uint64_t>(bucket % SUB_BUCKETS);
+    auto width = std::uint64_t{ 1 } << (exponent - SUB_BUCKET_BITS);
+    return ((SUB_BUCKETS + sub) << (exponent - SUB_BUCKET_BITS)) + (width - 1);
+  }
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<std::uint64_t> count{ 0 };
+    std::atomic<std::uint64_t> sum{ 0 };
+    std::atomic<std::uint64_t> min{ UINT64_MAX };
+    std::atomic<std::uint64_t> max{ 0 };
+    std::atomic<std::uint64_t> buckets[BUCKETS]{};
+  };
+
+  std::unique_ptr<Shard[]> shards_;
+};
+
+
+/**
+ * @brief 按名字管理所有metric，导出为文本或JSON
+ *
+ * @details 注册时加锁，返回的引用在registry的生命周期内一直有效，热路径应该保存引用而不是每次按名字查找
+ */
+class MetricRegistry {
+public:
+  MetricRegistry() = default;
+
+  MetricRegistry(const MetricRegistry& other) = delete;
+  MetricRegistry& operator=(const MetricRegistry& other) = delete;
+
+  // 全局registry，库内部的埋点都注册在这里
+  static MetricRegistry& global() { return Singleton<MetricRegistry>::instance(); }
+
+  /**
+   * @brief 获取或注册
+   *
+   * @param name 同名的metric只会创建一次，类型不同时抛出MetricTypeMismatchException
+   * @param help 说明，只在第一次注册时生效
+   */
+  Counter& counter(const std::string& name, std::string_view help = {});
+  Gauge& gauge(const std::string& name, std::string_view help = {});
+  Histogram& histogram(const std::string& name, std::string_view help = {});
+
+  /**
+   * @brief 导出为JSON
+   *
+   * @details counter和gauge为数值，histogram为{count, sum, min, max, mean, p50, p90, p99, p999}
+   */
+  std::string to_json(int indent = -1) const;
+
+  /**
+   * @brief 导出为每行"name value"的文本，histogram展开为name.count、name.p99等多行
+   *
+   */
+  std::string to_text() const;
+
+  // 所有metric清零，不会删除
+  void reset();
+
+  std::size_t size() const;
+
+private:
+  using Metric = std::variant<std::unique_ptr<Counter>, std::unique_ptr<Gauge>, std::unique_ptr<Histogram>>;
+
+  struct Entry {
+    std::string help;
+    Metric metric;
+  };
+
+  mutable std::mutex mutex_;
+  // 按名字排序，导出结果稳定
+  std::map<std::string, Entry, std::less<>> metrics_;
+
+  template<typename T>
+  T& get_or_create(const std::string& name, std::string_view help);
+};
+
+
+/**
+ * @brief 一类I/O操作的调用次数、字节数、错误数和延迟
+ *
+ */
+struct IOMetrics {
+  Counter& calls;
+  Counter& bytes;
+  Counter& errors;
+  Histogram& latency;
+
+  IOMetrics(MetricRegistry& registry, const std::string& prefix);
+
+  /**
+   * @brief 记录一次系统调用的结果
+   *
+   * @param result 系统调用的返回值，-1且errno为EAGAIN时不算错误
+   */
+  void record(ssize_t result, Histogram::Clock::time_point start) noexcept;
+};
+
+// Net::Socket的埋点
+struct SocketMetrics {
+  IOMetrics read;
+  IOMetrics write;
+  Counter& accepts;
+  Counter& accept_errors;
+
+  explicit SocketMetrics(MetricRegistry& registry = MetricRegistry::global());
+
+  static SocketMetrics& instance() { return Singleton<SocketMetrics>::instance(); }
+
+  // 不构造实例，还没有创建(或已经shutdown)时返回nullptr，给noexcept的I/O路径使用
+  static SocketMetrics* find() noexcept
+  {
+    return Singleton<SocketMetrics>::created() ? &Singleton<SocketMetrics>::get() : nullptr;
+  }
+};
+
+// FileSystem::File的埋点
+struct FileMetrics {
+  IOMetrics read;
+  IOMetrics write;
+
+  explicit FileMetrics(MetricRegistry& registry = MetricRegistry::global());
+
+  static FileMetrics& instance() { return Singleton<FileMetrics>::instance(); }
+
+  // 见SocketMetrics::find()
+  static FileMetrics* find() noexcept
+  {
+    return Singleton<FileMetrics>::created() ? &Singleton<FileMetrics>::get() : nullptr;
+  }
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_METRICS_H
@@ -0,0 +1,129 @@
+#ifndef STUDY_TOUR_NET_BUFFER_H
+#define STUDY_TOUR_NET_BUFFER_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <vector>
+
+#include "st/Result.h"
+
+
+namespace ST::Net {
+
+// forward statement
+class Socket;
+
+constexpr static std::size_t DEFAULT_BUFFER_SIZE = 4096;
+
+// 单次read_from时栈上额外缓冲区的大小
+constexpr static std::size_t EXTRA_BUFFER_SIZE = 65536;
+
+/**
+ * @brief 连续内存的收发缓冲区
+ *
+ * @details 布局为 [已读取 | 可读数据 | 可写空间]，read_index_和write_index_分别标记可读数据的起止位置<br/>
+ * 可读数据以std::span的形式暴露，上层解码时直接引用缓冲区内存，不做复制<br/>
+ * 内存来自构造时指定的memory_resource，复制出的Buffer使用默认的memory_resource
+ */
+class Buffer {
+public:
+  explicit Buffer(std::size_t initial_size = DEFAULT_BUFFER_SIZE,
+                  std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  Buffer(const Buffer& other) = default;
+  Buffer& operator=(const Buffer& other) = default;
+
+  Buffer(Buffer&& other) noexcept = default;
+  Buffer& operator=(Buffer&& other) noexcept = default;
+
+  ~Buffer() = default;
+
+  std::size_t readable_bytes() const noexcept { return write_index_ - read_index_; }
+  std::size_t writable_bytes() const noexcept { return buffer_.size() - write_index_; }
+
+  std::pmr::memory_resource* resource() const noexcept { return buffer_.get_allocator().resource(); }
+
+  /**
+   * @brief 可读数据的起始位置
+   *
+   * @return const std::byte*
+   */
+  const std::byte* peek() const noexcept { return buffer_.data() + read_index_; }
+
+  /**
+   * @brief 可读数据的视图，在下一次修改缓冲区之前有效
+   *
+   * @return std::span<const std::byte>
+   */
+  std::span<const std::byte> readable() const noexcept { return { peek(), readable_bytes() }; }
+
+  /**
+   * @brief 消费n_bytes的可读数据
+   *
+   * @param n_bytes
+   */
+  void retrieve(std::size_t n_bytes) noexcept;
+
+  /**
+   * @brief 消费所有可读数据
+   *
+   */
+  void retrieve_all() noexcept;
+
+  /**
+   * @brief 追加数据到可读数据末尾
+   *
+   * @param data
+   * @param n_bytes
+   */
+  void append(const void* data, std::size_t n_bytes);
+
+  /**
+   * @brief 保证至少有n_bytes的可写空间，优先挪动已有数据而不是扩容
+   *
+   * @param n_bytes
+   */
+  void ensure_writable(std::size_t n_bytes);
+
+  std::byte* begin_write() noexcept { return buffer_.data() + write_index_; }
+
+  /**
+   * @brief 直接写入begin_write()之后，标记已写入的n_bytes
+   *
+   * @param n_bytes
+   */
+  void has_written(std::size_t n_bytes) noexcept { write_index_ += n_bytes; }
+
+  /**
+   * @brief 从socket中读取数据到缓冲区
+   *
+   * @details 使用readv同时读入可写空间和栈上的额外缓冲区，一次系统调用即可读完socket中的数据，
+   * 缓冲区只在数据确实超出可写空间时扩容
+   * @param socket
+   * @return ssize_t  实际读取的数据，0表示对端已关闭，-1表示非阻塞socket暂无数据
+   */
+  ssize_t read_from(Socket& socket);
+
+  /**
+   * @brief 不因socket错误抛异常的read_from，对端RST(ECONNRESET)等错误以errno返回
+   *
+   * @details 只有扩容失败时抛出std::bad_alloc
+   * @param socket
+   * @return st::Result<std::size_t> 实际读取的数据，0表示对端已关闭，非阻塞socket暂无数据时为EAGAIN
+   */
+  st::Result<std::size_t> read_from(Socket& socket, std::nothrow_t);
+
+private:
+  std::pmr::vector<std::byte> buffer_;
+  std::size_t read_index_;
+  std::size_t write_index_;
+};
+
+} // namespace ST::Net
+
+#endif // STUDY_TOUR_NET_BUFFER_H
@@ -1,35 +1,170 @@
 #ifndef STUDY_TOUR_NET_CHANNEL_H
 #define STUDY_TOUR_NET_CHANNEL_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <span>
+#include <utility>
 
 #include "Socket.h"
+#include "Buffer.h"
+#include "Codec.h"
+#include "Poller.h"
 
 
 namespace ST::Net {
 
+// 待发送数据超过此值时通知上层暂停生产
+constexpr static std::size_t DEFAULT_HIGH_WATERMARK = 4 * 1024 * 1024;
+// 待发送数据回落到此值时通知上层恢复生产
+constexpr static std::size_t DEFAULT_LOW_WATERMARK = 1024 * 1024;
+
 /**
  * @brief 维持一个连接通道，可以发送和接受数据
  *
+ * @details 数据通过other收发，other为空时(比如客户端)通过self收发<br/>
+ * 阻塞模式下send会一直写到全部发送完毕；调用watch()之后socket变为非阻塞，
+ * 发送不完的数据进入输出缓冲区，由EPOLLOUT事件驱动继续发送，
+ * 缓冲区越过高/低水位时分别调用on_high_watermark/on_low_watermark，上层据此暂停/恢复生产
  */
 class Channel {
 public:
-  Channel(std::shared_ptr<Socket> self, std::shared_ptr<Socket> other);
+  using FrameCallback = std::function<void(std::span<const std::byte> payload)>;
+  using EventCallback = std::function<void(Channel& channel)>;
+
+  /**
+   * @brief
+   *
+   * @param resource 收发缓冲区的内存来源，必须比channel活得久
+   */
+  Channel(std::shared_ptr<Socket> self, std::shared_ptr<Socket> other,
+          LengthFieldCodec codec = LengthFieldCodec{},
+          std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
   Channel(const Channel& other) = delete;
   Channel& operator=(const Channel& other) = delete;
 
-  Channel(Channel&& other) noexcept = default;
-  Channel& operator=(Channel&& other) noexcept = default;
-
-  ~Channel() = default;
-
-
-  // ssize_t send();
-
-  // ssize_t receive();
-
-  // void on_received();
+  // 注册到poller之后poller持有this，不能移动
+  Channel(Channel&& other) = delete;
+  Channel& operator=(Channel&& other) = delete;
+
+  ~Channel();
+
+  /**
+   * @brief 发送一个帧，channel已经关闭或正在关闭时丢弃
+   *
+   * @param frame
+   * @return ssize_t 直接写入socket的字节数(包括帧头)，其余部分进入输出缓冲区
+   */
+  ssize_t send(std::span<const std::byte> frame);
+
+  /**
+   * @brief 一次writev发送多个帧
+   *
+   * @param frames
+   * @return ssize_t 直接写入socket的字节数(包括帧头)，其余部分进入输出缓冲区
+   */
+  ssize_t send(std::span<const std::span<const std::byte>> frames);
+
+  /**
+   * @brief 从socket读取一次数据到接收缓冲区
+   *
+   * @return ssize_t 实际读取的数据，0表示对端已关闭，-1表示非阻塞socket暂无数据
+   */
+  ssize_t receive();
+
+  /**
+   * @brief 读取一次数据，并对接收缓冲区中所有完整的帧调用on_frame
+   *
+   * @details 负载直接引用接收缓冲区，只在回调期间有效；不完整的帧留到下次接收时拼接
+   * @tparam Callback  void(std::span<const std::byte> payload)
+   * @param on_frame
+   * @return ssize_t   实际读取的数据，0表示对端已关闭，-1表示非阻塞socket暂无数据
+   */
+  template<typename Callback>
+  ssize_t on_received(Callback&& on_frame)
+  {
+    auto read_bytes = receive();
+    codec_.decode(input_, std::forward<Callback>(on_frame));
+    return read_bytes;
+  }
+
+  /**
+   * @brief 将channel注册到poller上，socket切换为非阻塞
+   *
+   * @param poller
+   * @param on_frame 收到完整帧时调用
+   */
+  void watch(Poller& poller, FrameCallback on_frame);
+
+  /**
+   * @brief 从poller上注销
+   *
+   */
+  void unwatch();
+
+  bool is_watched() const noexcept { return poller_ != nullptr; }
+
+  /**
+   * @brief 可读事件，读到socket暂无数据为止
+   *
+   * @details 对端RST等读错误按关闭处理(on_closed)；帧解码错误和on_frame抛出的异常继续向外抛出，
+   * 由poller回调统一捕获并强制关闭这个连接
+   */
+  void handle_read();
+
+  /**
+   * @brief 可写事件，尽可能发送输出缓冲区中的数据，发送完毕后不再关注EPOLLOUT
+   *
+   */
+  void handle_write();
+
+  /**
+   * @brief 优雅关闭：不再接受新的发送，输出缓冲区发送完毕后半关闭写方向(SHUT_WR)
+   *
+   * @details 之后继续接收对端数据，直到对端也关闭连接(on_closed)
+   */
+  void shutdown();
+
+  /**
+   * @brief 强制关闭，丢弃未发送的数据并向对端发送RST
+   *
+   */
+  void abort();
+
+  bool is_shutting_down() const noexcept { return shutting_down_; }
+
+  /**
+   * @brief 设置高/低水位
+   *
+   * @param low
+   * @param high
+   */
+  void watermarks(std::size_t low, std::size_t high);
+
+  std::size_t low_watermark() const noexcept { return low_watermark_; }
+  std::size_t high_watermark() const noexcept { return high_watermark_; }
+
+  void on_high_watermark(EventCallback callback) { on_high_watermark_ = std::move(callback); }
+  void on_low_watermark(EventCallback callback) { on_low_watermark_ = std::move(callback); }
+  void on_closed(EventCallback callback) { on_closed_ = std::move(callback); }
+
+  /**
+   * @brief 越过高水位之后，回落到低水位之前为true
+   *
+   */
+  bool is_paused() const noexcept { return paused_; }
+
+  bool is_closed() const noexcept { return closed_; }
+
+  // 输出缓冲区中尚未发送的数据
+  std::size_t pending_bytes() const noexcept { return output_.readable_bytes(); }
+
+  Buffer& input() noexcept { return input_; }
+  const LengthFieldCodec& codec() const noexcept { return codec_; }
 
   std::shared_ptr<Socket> self() const noexcept;
   std::shared_ptr<Socket> other() const noexcept;
@@ -37,8 +172,36 @@ public:
 private:
   std::shared_ptr<Socket> self_;
   std::shared_ptr<Socket> other_;
+  LengthFieldCodec codec_;
+  Buffer input_;
+  Buffer output_;
+
+  Poller* poller_;
+  FrameCallback on_frame_;
+  bool writing_;
+
+  std::size_t low_watermark_;
+  std::size_t high_watermark_;
+  bool paused_;
+  bool closed_;
+  bool shutting_down_;
+  bool write_shutdown_;
+  EventCallback on_high_watermark_;
+  EventCallback on_low_watermark_;
+  EventCallback on_closed_;
+
+  Socket& socket() const noexcept { return other_ ? *other_ : *self_; }
+
+  void handle_events(std::uint32_t events);
+  // 对端关闭或读出错，标记关闭并通知on_closed
+  void handle_close();
+  // 本端出错，强制关闭(RST)并通知on_closed
+  void fail(const char* reason);
+  void enable_writing(bool enable);
+  void check_watermarks();
+  void shutdown_write_if_drained();
 };
 
 } // namespace ST
 
-#endif // STUDY_TOUR_NET_CHANNEL_H
\ No newline at end of file
+#endif // STUDY_TOUR_NET_CHANNEL_H
@@ -0,0 +1,183 @@
+/**
+ * @file Codec.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 长度前缀的消息帧编解码
+ * @version 0.1
+ * @date 2022-07-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_NET_CODEC_H
+#define STUDY_TOUR_NET_CODEC_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "st/Cast.h"
+#include "st/Hash.h"
+#include "ST/Exception.h"
+#include "Buffer.h"
+
+
+namespace ST::Net {
+
+// forward statement
+class Socket;
+
+constexpr static std::size_t DEFAULT_MAX_FRAME_LENGTH = 64 * 1024 * 1024;
+
+enum class FrameChecksum {
+  None,
+  // 负载的CRC32C，硬件指令计算，检测传输或缓冲区管理导致的损坏
+  CRC32C
+};
+
+/**
+ * @brief 帧格式为 [uint32_t 长度(网络序) | 负载]
+ *
+ * @details 启用校验时为 [uint32_t 长度(网络序) | uint32_t 负载的CRC32C(网络序) | 负载]，两端必须使用相同的设置
+ */
+class LengthFieldCodec {
+public:
+  using Header = std::uint32_t;
+
+  constexpr static std::size_t HEADER_LENGTH = sizeof(Header);
+  constexpr static std::size_t CHECKSUM_LENGTH = sizeof(std::uint32_t);
+
+  explicit LengthFieldCodec(std::size_t max_frame_length = DEFAULT_MAX_FRAME_LENGTH,
+                            FrameChecksum checksum = FrameChecksum::None)
+    : max_frame_length_{ max_frame_length },
+      checksum_{ checksum }
+  {}
+
+  std::size_t max_frame_length() const noexcept { return max_frame_length_; }
+
+  FrameChecksum checksum() const noexcept { return checksum_; }
+
+  /**
+   * @brief 每帧负载之前的字节数
+   *
+   * @return std::size_t
+   */
+  std::size_t header_length() const noexcept { return header_length(checksum_); }
+
+  constexpr static std::size_t header_length(FrameChecksum checksum) noexcept
+  {
+    return checksum == FrameChecksum::CRC32C ? HEADER_LENGTH + CHECKSUM_LENGTH : HEADER_LENGTH;
+  }
+
+  /**
+   * @brief 从buffer中解出所有完整的帧
+   *
+   * @details 回调收到的负载直接引用buffer内存，只在回调期间有效，需要保存时由调用者自行复制<br/>
+   * 不完整的帧留在buffer中，等待下一次读取后继续拼接；启用校验时，校验失败抛出FrameChecksumException
+   * @tparam Callback  void(std::span<const std::byte> payload)
+   * @param buffer
+   * @param on_frame
+   * @return std::size_t 解出的帧数
+   */
+  template<typename Callback>
+  std::size_t decode(Buffer& buffer, Callback&& on_frame) const
+  {
+    std::size_t frames = 0;
+    auto header_size = header_length();
+    while (buffer.readable_bytes() >= header_size) {
+      Header header;
+      std::memcpy(&header, buffer.peek(), HEADER_LENGTH);
+      std::size_t length = st::byte_order_cast<st::Host>(header);
+
+      if (length > max_frame_length_) {
+        SPDLOG_ERROR("frame length {} exceeds limit {}", length, max_frame_length_);
+        throw FrameTooLongException{ "frame length {} exceeds limit {}", length, max_frame_length_ };
+      }
+
+      if (buffer.readable_bytes() < header_size + length)
+        break;
+
+      std::span<const std::byte> payload{ buffer.peek() + header_size, length };
+      if (checksum_ == FrameChecksum::CRC32C)
+        verify_checksum(buffer.peek() + HEADER_LENGTH, payload);
+
+      on_frame(payload);
+      buffer.retrieve(header_size + length);
+      ++frames;
+    }
+
+    return frames;
+  }
+
+  /**
+   * @brief 编码多个帧并通过一次writev发送
+   *
+   * @details 帧头和负载都以iovec的形式交给内核，负载不做复制；帧数超过IOV_MAX时分批发送，
+   * 部分写入时继续发送剩余部分，直到全部写完或非阻塞socket的发送缓冲区已满
+   * @param socket
+   * @param frames
+   * @return ssize_t 写入的总字节数(包括帧头)，可能小于帧的总长度
+   */
+  ssize_t encode(Socket& socket, std::span<const std::span<const std::byte>> frames) const;
+
+  /**
+   * @brief 编码多个帧追加到buffer中
+   *
+   * @param buffer
+   * @param frames
+   */
+  void encode(Buffer& buffer, std::span<const std::span<const std::byte>> frames) const;
+
+  /**
+   * @brief 编码多个帧追加到buffer中，跳过开头已经发送的skip字节
+   *
+   * @details 用于encode(socket)部分写入之后，只把没写完的部分放进输出缓冲区
+   * @param buffer
+   * @param frames
+   * @param skip 已经发送的字节数(包括帧头)
+   */
+  void encode(Buffer& buffer, std::span<const std::span<const std::byte>> frames, std::size_t skip) const;
+
+  /**
+   * @brief 帧编码后的总长度(包括帧头)
+   *
+   * @param frames
+   * @param checksum 启用校验时每帧多出CHECKSUM_LENGTH字节，应传入codec的checksum()
+   * @return std::size_t
+   */
+  static std::size_t encoded_length(std::span<const std::span<const std::byte>> frames,
+                                    FrameChecksum checksum = FrameChecksum::None) noexcept;
+
+private:
+  std::size_t max_frame_length_;
+  FrameChecksum checksum_;
+
+  Header make_header(std::size_t length) const;
+
+  static std::uint32_t make_checksum(std::span<const std::byte> payload) noexcept
+  {
+    return st::byte_order_cast<st::Net>(st::hash::crc32c(payload));
+  }
+
+  static void verify_checksum(const std::byte* field, std::span<const std::byte> payload)
+  {
+    std::uint32_t expected;
+    std::memcpy(&expected, field, CHECKSUM_LENGTH);
+    expected = st::byte_order_cast<st::Host>(expected);
+
+    auto actual = st::hash::crc32c(payload);
+    if (actual != expected) {
+      SPDLOG_ERROR("frame checksum mismatch, expected {:#010x}, actual {:#010x}", expected, actual);
+      throw FrameChecksumException{ "frame checksum mismatch, expected {:#010x}, actual {:#010x}", expected, actual };
+    }
+  }
+};
+
+} // namespace ST::Net
+
+#endif // STUDY_TOUR_NET_CODEC_H
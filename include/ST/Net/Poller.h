@@ -0,0 +1,83 @@
+#ifndef STUDY_TOUR_NET_POLLER_H
+#define STUDY_TOUR_NET_POLLER_H
+
+#include <sys/epoll.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "st/HashMap.h"
+
+
+namespace ST::Net {
+
+constexpr static int DEFAULT_MAX_EVENTS = 128;
+
+/**
+ * @brief epoll的封装，按fd分发就绪事件
+ *
+ */
+class Poller {
+public:
+  using Handler = std::function<void(std::uint32_t events)>;
+
+  explicit Poller(int max_events = DEFAULT_MAX_EVENTS);
+
+  Poller(const Poller& other) = delete;
+  Poller& operator=(const Poller& other) = delete;
+
+  Poller(Poller&& other) noexcept = delete;
+  Poller& operator=(Poller&& other) noexcept = delete;
+
+  // 自动销毁
+  ~Poller();
+
+  /**
+   * @brief 监听fd
+   *
+   * @param fd
+   * @param events  EPOLLIN/EPOLLOUT等
+   * @param handler fd就绪时调用，参数为就绪的事件
+   */
+  void add(int fd, std::uint32_t events, Handler handler);
+
+  /**
+   * @brief 修改fd监听的事件
+   *
+   * @param fd
+   * @param events
+   */
+  void modify(int fd, std::uint32_t events);
+
+  /**
+   * @brief 取消监听fd
+   *
+   * @param fd
+   */
+  void remove(int fd);
+
+  bool contains(int fd) const { return handlers_.contains(fd); }
+
+  std::size_t size() const noexcept { return handlers_.size(); }
+
+  /**
+   * @brief 等待事件并分发给对应的handler
+   *
+   * @param timeout 毫秒，-1表示一直等待
+   * @return int    分发的事件数，被信号中断时返回0
+   */
+  int poll(int timeout = -1);
+
+  int fd() const noexcept { return fd_; }
+
+private:
+  int fd_;
+  std::vector<epoll_event> events_;
+  st::FlatHashMap<int, std::shared_ptr<Handler>> handlers_;
+};
+
+} // namespace ST::Net
+
+#endif // STUDY_TOUR_NET_POLLER_H
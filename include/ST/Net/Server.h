@@ -0,0 +1,143 @@
+#ifndef STUDY_TOUR_NET_SERVER_H
+#define STUDY_TOUR_NET_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "ST/Memory.h"
+#include "st/HashMap.h"
+#include "Socket.h"
+#include "Channel.h"
+#include "Poller.h"
+
+
+namespace ST::Net {
+
+// 等待事件的间隔，也是响应stop()的最大延迟
+constexpr static std::chrono::milliseconds DEFAULT_POLL_TICK{ 100 };
+// 优雅关闭时等待连接关闭的默认时长
+constexpr static std::chrono::milliseconds DEFAULT_GRACE_PERIOD{ 5000 };
+
+/**
+ * @brief 基于Poller的单线程TCP服务器，管理所有已接受连接的Channel
+ *
+ * @details 关闭流程(shutdown)：
+ * 1. 停止accept并关闭监听socket，新连接直接被拒绝
+ * 2. 所有连接调用Channel::shutdown()，输出缓冲区发送完毕后半关闭写方向
+ * 3. 继续处理事件，等待对端关闭连接，最多等到grace period结束
+ * 4. 仍未关闭的连接强制关闭(RST)
+ */
+class Server {
+public:
+  using ConnectionCallback = std::function<void(Channel& channel)>;
+  // memory为这一轮事件的临时内存(见request_memory())，解码出的对象可以从中分配
+  using MessageCallback = std::function<void(Channel& channel, std::span<const std::byte> payload,
+                                             std::pmr::memory_resource& memory)>;
+
+  /**
+   * @brief
+   *
+   * @param poller
+   * @param listener 已经bind和listen的socket
+   */
+  Server(Poller& poller, Socket listener);
+
+  Server(const Server& other) = delete;
+  Server& operator=(const Server& other) = delete;
+
+  // poller持有this，不能移动
+  Server(Server&& other) noexcept = delete;
+  Server& operator=(Server&& other) noexcept = delete;
+
+  ~Server();
+
+  void on_connection(ConnectionCallback callback) { on_connection_ = std::move(callback); }
+  void on_message(MessageCallback callback) { on_message_ = std::move(callback); }
+
+  /**
+   * @brief 每个新连接在accept之后应用的socket选项
+   *
+   * @param profile
+   */
+  void profile(SocketProfile profile) { profile_ = std::move(profile); }
+
+  /**
+   * @brief 新连接使用的帧编解码设置，比如启用CRC32C校验
+   *
+   * @param codec
+   */
+  void codec(LengthFieldCodec codec) noexcept { codec_ = codec; }
+
+  /**
+   * @brief 开始接受连接
+   *
+   */
+  void start();
+
+  /**
+   * @brief 处理事件直到stop()被调用，然后执行优雅关闭
+   *
+   * @param grace 优雅关闭时等待连接关闭的最长时间
+   * @return true  所有连接都正常关闭
+   * @return false 有连接被强制关闭
+   */
+  bool run(std::chrono::milliseconds grace = DEFAULT_GRACE_PERIOD);
+
+  /**
+   * @brief 请求停止，可以在信号处理函数中调用
+   *
+   */
+  void stop() noexcept { stopping_.store(true, std::memory_order_relaxed); }
+
+  bool is_stopping() const noexcept { return stopping_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 优雅关闭，见类说明
+   *
+   * @param grace 等待连接关闭的最长时间
+   * @return true  所有连接都正常关闭
+   * @return false 有连接被强制关闭
+   */
+  bool shutdown(std::chrono::milliseconds grace = DEFAULT_GRACE_PERIOD);
+
+  bool is_accepting() const noexcept { return listener_ && listener_->opened(); }
+
+  std::size_t connections() const noexcept { return channels_.size(); }
+
+  /**
+   * @brief 处理一轮事件时的临时内存，on_message的memory参数就是它
+   *
+   * @details 每轮poll结束后整体释放，不能保存到之后的回调中
+   */
+  std::pmr::memory_resource& request_memory() noexcept { return request_memory_; }
+
+private:
+  Poller& poller_;
+  std::shared_ptr<Socket> listener_;
+  // 连接的收发缓冲区，所有连接大小相同，关闭后立即被新连接复用；必须在channels_之前声明，最后析构
+  SlabPool connection_memory_;
+  MonotonicArena request_memory_;
+  // fd到连接的映射，扁平存放，按fd查找不需要跳转节点
+  st::FlatHashMap<int, std::unique_ptr<Channel>> channels_;
+  // 已关闭的连接在事件分发结束后再销毁，避免在Channel自己的回调中析构它
+  std::vector<int> closed_;
+  std::atomic<bool> stopping_;
+  SocketProfile profile_;
+  LengthFieldCodec codec_;
+  ConnectionCallback on_connection_;
+  MessageCallback on_message_;
+
+  void handle_accept();
+  void stop_accepting();
+  void remove_closed();
+};
+
+} // namespace ST::Net
+
+#endif // STUDY_TOUR_NET_SERVER_H
@@ -1,18 +1,32 @@
 #ifndef STUDY_TOUR_NET_SOCKET_H
 #define STUDY_TOUR_NET_SOCKET_H
 
+#include <sys/uio.h>
+#include <sys/socket.h>
+
 #include <cstdint>
 #include <cstddef>
 #include <memory>
+#include <new>
+#include <optional>
+#include <span>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "st/Result.h"
 
 #include "Address.h"
+#include "SocketOption.h"
 
 
 namespace ST::Net {
 
 constexpr static int DEFAULT_BACK_LOG = 5;
 
+// 单条消息最多传递的fd数
+constexpr static std::size_t DEFAULT_MAX_PASSED_FDS = 16;
+
 /**
  * @brief 提供所有和socket相关的操作，用户不应该使用这么底层类
  *
@@ -27,26 +41,202 @@ public:
   Socket(const Socket& other) = delete;
   Socket& operator=(const Socket& other) = delete;
 
-  Socket(Socket&& other) noexcept = default;
-  Socket& operator=(Socket&& other) noexcept = default;
+  Socket(Socket&& other) noexcept;
+  Socket& operator=(Socket&& other) noexcept;
 
   // 自动销毁
   ~Socket();
 
+  /**
+   * @brief 创建一对互相连接的Unix域socket
+   *
+   * @param type TCP即SOCK_STREAM，UDP即SOCK_DGRAM
+   * @return std::pair<Socket, Socket>
+   */
+  static std::pair<Socket, Socket> pair(Type type = Type::TCP);
+
   bool is_connected() const noexcept { return connect_address_ != nullptr; }
   void connect(const std::string& address, in_port_t port);
 
+  /**
+   * @brief 连接Unix域socket
+   *
+   * @param path 以'@'开头表示abstract namespace
+   */
+  void connect(const std::string& path);
+
   bool is_binded() const noexcept { return bind_address_ != nullptr; }
   void bind(const std::string& address, in_port_t port);
   void bind(in_port_t port);
 
+  /**
+   * @brief 绑定Unix域socket
+   *
+   * @param path 以'@'开头表示abstract namespace
+   */
+  void bind(const std::string& path);
+
   void listen(int bakclog = DEFAULT_BACK_LOG);
   Socket accept();
 
+  /**
+   * @brief 非阻塞的accept
+   *
+   * @return std::optional<Socket> 没有等待中的连接(或被信号中断)时为空
+   */
+  std::optional<Socket> try_accept();
+
+  /**
+   * @brief accept之后立即对新连接应用profile
+   *
+   * @param profile
+   * @return Socket
+   */
+  Socket accept(const SocketProfile& profile);
+
+  /**
+   * @brief 不抛异常的accept，不写日志
+   *
+   * @return st::Result<Socket> 失败时为errno，非阻塞时没有等待中的连接为EAGAIN
+   */
+  st::Result<Socket> accept(std::nothrow_t) noexcept;
+
+  /**
+   * @brief 设置socket选项，选项的level/name/值类型由Option在编译期确定
+   * @example socket.set_option<Option::NoDelay>(true);
+   *
+   * @tparam Option
+   * @param value
+   */
+  template<socket_option Option>
+  void set_option(typename Option::value_type value)
+  {
+    auto storage = Option::to_storage(value);
+    set_raw_option(Option::level, Option::name, &storage, sizeof(storage));
+  }
+
+  /**
+   * @brief 读取socket选项
+   * @example auto size = socket.get_option<Option::ReceiveBuffer>();
+   *
+   * @tparam Option
+   * @return Option::value_type
+   */
+  template<socket_option Option>
+  typename Option::value_type get_option() const
+  {
+    typename Option::storage_type storage{};
+    socklen_t length = sizeof(storage);
+    get_raw_option(Option::level, Option::name, &storage, &length);
+    return Option::from_storage(storage);
+  }
+
+  /**
+   * @brief 关闭连接的读/写方向
+   *
+   * @param how SHUT_RD/SHUT_WR/SHUT_RDWR，默认半关闭写方向，对端读到EOF
+   */
+  void shutdown(int how = SHUT_WR);
+
+  /**
+   * @brief 不抛异常、不写日志的shutdown，对端已经断开时为ENOTCONN
+   *
+   * @param how
+   * @return st::Result<void>
+   */
+  st::Result<void> shutdown(int how, std::nothrow_t) noexcept;
+
+  /**
+   * @brief 提前关闭socket，重复调用无效
+   *
+   */
+  void close();
+
+  /**
+   * @brief 强制关闭，丢弃未发送的数据并向对端发送RST
+   *
+   */
+  void abort();
+
+  bool opened() const noexcept { return fd_ != -1; }
+
+  /**
+   * @brief 通过Unix域socket发送打开的fd(SCM_RIGHTS)，对端收到的是指向同一文件表项的新fd
+   *
+   * @details 同时发送1个字节的数据，避免对端把空消息当作EOF
+   * @param fds
+   */
+  void send_fds(std::span<const int> fds);
+
+  void send_fd(int fd) { send_fds(std::span<const int>{ &fd, 1 }); }
+
+  /**
+   * @brief 接收对端通过send_fds发送的fd，收到的fd由调用者负责关闭
+   *
+   * @param max_fds 最多接收的fd数
+   * @return std::vector<int> 对端已关闭时为空
+   */
+  std::vector<int> receive_fds(std::size_t max_fds = DEFAULT_MAX_PASSED_FDS);
+
+  /**
+   * @brief 接收一个fd
+   *
+   * @return int 对端已关闭时为-1
+   */
+  int receive_fd();
+
+  /**
+   * @brief 接收一个socket，比如master进程accept之后交给worker的连接
+   *
+   * @param family
+   * @param type
+   * @return std::optional<Socket> 对端已关闭时为空
+   */
+  std::optional<Socket> receive_socket(Family family = Family::IPv4, Type type = Type::TCP);
+
+  /**
+   * @brief 设置/取消非阻塞模式
+   *
+   * @details 非阻塞模式下，read/write等操作在会阻塞时(EAGAIN)返回-1而不是抛出异常
+   * @param nonblocking
+   */
+  void set_nonblocking(bool nonblocking = true);
+
   ssize_t read(void* buffer, size_t size);
 
   ssize_t write(const void* buffer, size_t size);
 
+  /**
+   * @brief 分散读，一次系统调用读入多个buffer
+   *
+   * @param vec
+   * @param count
+   * @return ssize_t  实际读出的数据
+   */
+  ssize_t readv(const iovec* vec, int count);
+
+  /**
+   * @brief 聚集写，一次系统调用写出多个buffer
+   *
+   * @param vec
+   * @param count
+   * @return ssize_t  实际写入的数据
+   */
+  ssize_t writev(const iovec* vec, int count);
+
+  /**
+   * @brief 不抛异常、不写日志的读写，用于EAGAIN/ECONNRESET频繁出现的热路径
+   *
+   * @details 写入时带MSG_NOSIGNAL，对端已关闭时返回EPIPE而不是触发SIGPIPE
+   * @example if (auto n = socket.read(buffer, size, std::nothrow); n) ... else if (n.would_block()) ...
+   *
+   * @return st::Result<std::size_t> 实际读写的字节数，失败时为errno
+   */
+  st::Result<std::size_t> read(void* buffer, size_t size, std::nothrow_t) noexcept;
+  st::Result<std::size_t> write(const void* buffer, size_t size, std::nothrow_t) noexcept;
+  st::Result<std::size_t> readv(const iovec* vec, int count, std::nothrow_t) noexcept;
+  st::Result<std::size_t> writev(const iovec* vec, int count, std::nothrow_t) noexcept;
+
   // void send(const void* buffer, size_t size);
 
   // void receive(void* buffer, size_t size);
@@ -58,7 +248,12 @@ public:
   Type type() const noexcept { return type_; }
   Protocol protocol() const noexcept { return protocol_; }
 
+  int fd() const noexcept { return fd_; }
+
 private:
+  // 接管一个已经打开的fd，比如accept得到的连接
+  Socket(int fd, Family family, Type type, Protocol protocol);
+
   int fd_;
   Family family_;
   Type type_;
@@ -69,7 +264,8 @@ private:
   void bind(std::shared_ptr<Address> address);
   void connect(std::shared_ptr<Address> address);
 
-  void set_fd(int fd) { fd_ = fd; }
+  void set_raw_option(int level, int name, const void* value, socklen_t length);
+  void get_raw_option(int level, int name, void* value, socklen_t* length) const;
 };
 
 } // namespace ST::Net
@@ -0,0 +1,187 @@
+/**
+ * @file SocketOption.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 类型安全的socket选项，level/name/值类型都在编译期确定
+ * @version 0.1
+ * @date 2022-07-05
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_NET_SOCKET_OPTION_H
+#define STUDY_TOUR_NET_SOCKET_OPTION_H
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <chrono>
+#include <concepts>
+#include <optional>
+#include <type_traits>
+
+
+namespace ST::Net {
+
+// forward statement
+class Socket;
+
+/**
+ * @brief socket选项需要满足的条件
+ *
+ * @details value_type为用户使用的类型，storage_type为setsockopt实际接受的类型
+ */
+template<typename T>
+concept socket_option = requires(typename T::value_type value, typename T::storage_type storage) {
+  { T::level } -> std::convertible_to<int>;
+  { T::name } -> std::convertible_to<int>;
+  { T::to_storage(value) } -> std::same_as<typename T::storage_type>;
+  { T::from_storage(storage) } -> std::same_as<typename T::value_type>;
+} && std::is_trivially_copyable_v<typename T::storage_type>;
+
+/**
+ * @brief 开关型选项，内核接受int
+ *
+ */
+template<int Level, int Name>
+struct BooleanOption {
+  using value_type = bool;
+  using storage_type = int;
+
+  constexpr static int level = Level;
+  constexpr static int name = Name;
+
+  constexpr static storage_type to_storage(value_type value) noexcept { return value ? 1 : 0; }
+  constexpr static value_type from_storage(storage_type storage) noexcept { return storage != 0; }
+};
+
+/**
+ * @brief 整数型选项
+ *
+ */
+template<int Level, int Name>
+struct IntegerOption {
+  using value_type = int;
+  using storage_type = int;
+
+  constexpr static int level = Level;
+  constexpr static int name = Name;
+
+  constexpr static storage_type to_storage(value_type value) noexcept { return value; }
+  constexpr static value_type from_storage(storage_type storage) noexcept { return storage; }
+};
+
+/**
+ * @brief 时长型选项，内核以整数的Unit为单位
+ *
+ */
+template<int Level, int Name, typename Unit>
+struct DurationOption {
+  using value_type = Unit;
+  using storage_type = int;
+
+  constexpr static int level = Level;
+  constexpr static int name = Name;
+
+  constexpr static storage_type to_storage(value_type value) noexcept { return static_cast<int>(value.count()); }
+  constexpr static value_type from_storage(storage_type storage) noexcept { return value_type{ storage }; }
+};
+
+namespace Option {
+
+// 关闭Nagle算法，小包立即发送
+using NoDelay = BooleanOption<IPPROTO_TCP, TCP_NODELAY>;
+// 攒满一个MSS或取消cork之后才发送
+using Cork = BooleanOption<IPPROTO_TCP, TCP_CORK>;
+// 立即回复ACK而不是延迟确认，内核可能随时自动退出quickack模式，需要在每次读取之后重新设置
+using QuickAck = BooleanOption<IPPROTO_TCP, TCP_QUICKACK>;
+// 监听socket上TFO请求队列的长度
+using FastOpen = IntegerOption<IPPROTO_TCP, TCP_FASTOPEN>;
+// 监听socket收到数据之后才唤醒accept
+using DeferAccept = DurationOption<IPPROTO_TCP, TCP_DEFER_ACCEPT, std::chrono::seconds>;
+
+using KeepAlive = BooleanOption<SOL_SOCKET, SO_KEEPALIVE>;
+using KeepAliveIdle = DurationOption<IPPROTO_TCP, TCP_KEEPIDLE, std::chrono::seconds>;
+using KeepAliveInterval = DurationOption<IPPROTO_TCP, TCP_KEEPINTVL, std::chrono::seconds>;
+using KeepAliveCount = IntegerOption<IPPROTO_TCP, TCP_KEEPCNT>;
+
+// 内核会将设置值翻倍，读出的是翻倍之后的值
+using ReceiveBuffer = IntegerOption<SOL_SOCKET, SO_RCVBUF>;
+using SendBuffer = IntegerOption<SOL_SOCKET, SO_SNDBUF>;
+// 阻塞读时忙轮询网卡队列的时长，超过net.core.busy_read需要CAP_NET_ADMIN
+using BusyPoll = DurationOption<SOL_SOCKET, SO_BUSY_POLL, std::chrono::microseconds>;
+// 连接的数据由哪个CPU处理，可以读出后将连接交给对应CPU上的线程
+using IncomingCpu = IntegerOption<SOL_SOCKET, SO_INCOMING_CPU>;
+
+using ReuseAddress = BooleanOption<SOL_SOCKET, SO_REUSEADDR>;
+using ReusePort = BooleanOption<SOL_SOCKET, SO_REUSEPORT>;
+
+/**
+ * @brief close时的行为，超时为0时直接发送RST
+ *
+ */
+struct Linger {
+  using value_type = std::optional<std::chrono::seconds>;
+  using storage_type = linger;
+
+  constexpr static int level = SOL_SOCKET;
+  constexpr static int name = SO_LINGER;
+
+  constexpr static storage_type to_storage(value_type value) noexcept
+  {
+    return value ? linger{ 1, static_cast<int>(value->count()) } : linger{ 0, 0 };
+  }
+
+  constexpr static value_type from_storage(storage_type storage) noexcept
+  {
+    return storage.l_onoff ? value_type{ std::chrono::seconds{ storage.l_linger } } : std::nullopt;
+  }
+};
+
+} // namespace ST::Net::Option
+
+
+/**
+ * @brief 一组socket选项，为空的选项不做修改
+ *
+ * @details 通常在accept之后对每个连接应用，见Socket::accept(const SocketProfile&)和Server::profile()
+ */
+struct SocketProfile {
+  std::optional<bool> no_delay;
+  std::optional<bool> cork;
+  std::optional<bool> keep_alive;
+  std::optional<std::chrono::seconds> keep_alive_idle;
+  std::optional<std::chrono::seconds> keep_alive_interval;
+  std::optional<int> keep_alive_count;
+  std::optional<int> receive_buffer;
+  std::optional<int> send_buffer;
+  std::optional<std::chrono::microseconds> busy_poll;
+
+  /**
+   * @brief 对socket应用所有非空的选项
+   *
+   * @details 不是TCP的socket(比如Unix域socket)跳过IPPROTO_TCP级别的选项<br/>
+   * 不提供QuickAck：内核随时会退出quickack模式，只在accept之后设置一次没有效果
+   * @param socket
+   */
+  void apply(Socket& socket) const;
+
+  /**
+   * @brief 请求-响应型的小包低延迟场景：关闭Nagle算法，较快地发现断开的连接
+   *
+   * @details busy_poll需要权限，并且会占满CPU，默认不开启
+   * @return SocketProfile
+   */
+  static SocketProfile low_latency();
+
+  /**
+   * @brief 大块数据传输：更大的收发缓冲区
+   *
+   * @return SocketProfile
+   */
+  static SocketProfile bulk_transfer();
+};
+
+} // namespace ST::Net
+
+#endif // STUDY_TOUR_NET_SOCKET_OPTION_H
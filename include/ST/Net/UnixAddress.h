@@ -0,0 +1,47 @@
+#ifndef STUDY_TOUR_NET_UNIX_ADDRESS_H
+#define STUDY_TOUR_NET_UNIX_ADDRESS_H
+
+#include <sys/un.h>
+
+#include <string>
+
+#include "Address.h"
+#include "ST/Global.h"
+
+
+namespace ST::Net {
+
+/**
+ * @brief Unix域socket用地址
+ *
+ * @details 以'@'开头的路径表示abstract namespace，不在文件系统中创建文件，
+ * 最后一个引用关闭时自动消失
+ */
+class UnixAddress: public Address {
+public:
+  UnixAddress();
+  explicit UnixAddress(const std::string& path);
+
+  ~UnixAddress() {}
+
+  sockaddr* address() const noexcept override { return (struct sockaddr*) &address_; }
+
+  // Unix域socket没有端口
+  in_port_t port() const noexcept override { return 0; }
+
+  Family family() const noexcept override { return Family::Unix; }
+
+  socklen_t length() const noexcept override { return length_; }
+
+  std::string to_string() const noexcept override;
+
+  bool is_abstract() const noexcept { return length_ > sizeof(sa_family_t) && address_.sun_path[0] == '\0'; }
+
+private:
+  sockaddr_un address_;
+  socklen_t length_;
+};
+
+} // namespace ST::Net
+
+#endif // STUDY_TOUR_NET_UNIX_ADDRESS_H
@@ -0,0 +1,92 @@
+/**
+ * @file PidFd.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 指向子进程的pidfd，可以注册到epoll上等待进程退出
+ * @version 0.1
+ * @date 2022-07-14
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_PID_FD_H
+#define STUDY_TOUR_PID_FD_H
+
+#include <unistd.h>
+#include <signal.h>
+
+#include <optional>
+
+#include "ST/Process.h"
+
+
+namespace ST {
+
+/**
+ * @brief pidfd的RAII封装
+ *
+ * @details pidfd始终指向打开时的那个进程，即使pid已经被回收并复用，
+ * 所以通过pidfd发送信号和wait都没有pid复用的竞争<br/>
+ * 进程退出时pidfd可读(EPOLLIN)，supervisor可以把成千上万个子进程注册在同一个Poller上，不需要SIGCHLD处理函数
+ */
+class PidFd {
+public:
+  /**
+   * @brief
+   *
+   * @param pid 当前进程的子进程
+   * @throw std::system_error 内核不支持pidfd(< 5.3)或者进程不存在
+   */
+  explicit PidFd(pid_t pid);
+
+  PidFd(const PidFd& other) = delete;
+  PidFd& operator=(const PidFd& other) = delete;
+
+  PidFd(PidFd&& other) noexcept;
+  PidFd& operator=(PidFd&& other) noexcept;
+
+  ~PidFd();
+
+  /**
+   * @brief 不抛异常的打开
+   *
+   * @param pid
+   * @return std::optional<PidFd> 内核不支持pidfd时为空
+   */
+  static std::optional<PidFd> open(pid_t pid) noexcept;
+
+  int fd() const noexcept { return fd_; }
+  pid_t pid() const noexcept { return pid_; }
+
+  /**
+   * @brief 通过pidfd发送信号
+   *
+   * @param signal
+   */
+  void send_signal(int signal = SIGTERM);
+
+  /**
+   * @brief 不阻塞地回收进程，fd可读之后调用
+   *
+   * @return std::optional<ProcessResult> 进程仍在运行时为空
+   */
+  std::optional<ProcessResult> try_wait();
+
+  /**
+   * @brief 阻塞直到进程退出并回收
+   *
+   * @return ProcessResult
+   */
+  ProcessResult wait();
+
+private:
+  int fd_;
+  pid_t pid_;
+
+  PidFd(int fd, pid_t pid) noexcept;
+
+  std::optional<ProcessResult> wait_id(int options);
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_PID_FD_H
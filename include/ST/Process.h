@@ -2,13 +2,18 @@
 #define STUDY_TOUR_PROCESS_H
 
 #include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 #include <utility>
 #include <functional>
+#include <new>
+#include <optional>
 #include <string>
 
 #include <spdlog/spdlog.h>
 
+#include "st/Result.h"
 #include "ST/Exception.h"
 
 
@@ -26,6 +31,14 @@ public:
 
   ~ProcessResult() = default;
 
+  /**
+   * @brief 从waitid的结果构造
+   *
+   * @param info
+   * @return ProcessResult
+   */
+  static ProcessResult from(const siginfo_t& info) noexcept;
+
   constexpr bool normal_exited() const { return WIFEXITED(status_); }
   constexpr int exit_status() const { return WEXITSTATUS(status_); }
   constexpr bool terminated() const { return WIFSIGNALED(status_); }
@@ -64,7 +77,18 @@ public:
 
     // 只处理子进程
     if (pid_ == 0) {
-      std::invoke(std::forward<Function>(f), std::forward<Args>(args)...);
+      // 异常不能逃出构造函数，否则子进程会继续执行父进程的代码
+      try {
+        std::invoke(std::forward<Function>(f), std::forward<Args>(args)...);
+      }
+      catch (const std::exception& e) {
+        SPDLOG_ERROR("child process[{}] exited with exception: {}", getpid(), e.what());
+        exit(EXIT_FAILURE);
+      }
+      catch (...) {
+        SPDLOG_ERROR("child process[{}] exited with unknown exception", getpid());
+        exit(EXIT_FAILURE);
+      }
       // 必须直接退出子进程
       exit(EXIT_SUCCESS);
     }
@@ -73,20 +97,64 @@ public:
   Process(const Process& other) = delete;
   Process& operator=(const Process& other) = delete;
 
-  Process(Process&& other) noexcept = default;
-  Process& operator=(Process&& other) noexcept = default;
+  Process(Process&& other) noexcept
+    : pid_{ std::exchange(other.pid_, -1) }, waited_{ other.waited_ }
+  {}
+
+  Process& operator=(Process&& other) noexcept
+  {
+    std::swap(pid_, other.pid_);
+    std::swap(waited_, other.waited_);
+    return *this;
+  }
 
   ~Process() = default;
 
+  /**
+   * @brief 接管一个不是通过fork创建的子进程，比如posix_spawn创建的
+   *
+   * @param pid 必须是当前进程的子进程
+   * @return Process
+   */
+  static Process adopt(pid_t pid) noexcept { return Process{ pid, Adopt{} }; }
+
   ProcessResult wait();
 
+  /**
+   * @brief 不抛异常、不写日志的wait
+   *
+   * @return st::Result<ProcessResult> 进程不存在或已经wait过时为ECHILD，被信号中断时为EINTR
+   */
+  st::Result<ProcessResult> wait(std::nothrow_t) noexcept;
+
+  /**
+   * @brief 不阻塞的wait
+   *
+   * @return std::optional<ProcessResult> 进程仍在运行时为空
+   */
+  std::optional<ProcessResult> try_wait();
+
+  /**
+   * @brief 向进程发送信号
+   *
+   * @exception InvalidProcessKillException 进程已经被移动或已经wait过
+   * @param signal
+   */
+  void kill(int signal = SIGTERM);
+
   constexpr pid_t get_pid() const noexcept { return pid_; }
 
   bool is_waited() const noexcept { return waited_; }
 
 private:
+  struct Adopt {};
+
   pid_t pid_;
   bool waited_;
+
+  Process(pid_t pid, Adopt) noexcept
+    : pid_{ pid }, waited_{ false }
+  {}
 };
 
 namespace ThisProcess {
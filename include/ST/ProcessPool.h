@@ -0,0 +1,194 @@
+/**
+ * @file ProcessPool.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 预先fork的worker进程池
+ * @version 0.1
+ * @date 2022-07-08
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_PROCESS_POOL_H
+#define STUDY_TOUR_PROCESS_POOL_H
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "ST/Process.h"
+#include "ST/PidFd.h"
+#include "ST/SignalSet.h"
+#include "ST/Net/Poller.h"
+
+
+namespace ST {
+
+// 升级时通过此环境变量告诉新进程继承了哪些fd，格式为"3,4,5"
+constexpr static const char* INHERITED_FDS_ENV = "ST_INHERITED_FDS";
+
+constexpr static std::chrono::milliseconds DEFAULT_SUPERVISE_TICK{ 100 };
+constexpr static std::chrono::milliseconds DEFAULT_STOP_GRACE{ 5000 };
+
+/**
+ * @brief worker退出后是否重启
+ *
+ */
+enum class RestartPolicy {
+  Never,
+  // 非正常退出(退出码不为0或被信号杀死)时重启
+  OnFailure,
+  Always
+};
+
+/**
+ * @brief 预先fork N个worker进程，监控并重启崩溃的worker
+ *
+ * @details 在start()之前打开的fd(比如监听socket)会被所有worker继承，worker各自accept即可共享连接；
+ * 每个worker通过PidFd注册在内部的epoll上，退出时立即被回收，不需要SIGCHLD处理函数；
+ * 信号也可以通过handle_signals()在同一个epoll上处理。
+ * 内核不支持pidfd(< 5.3)时退化为每个tick用WNOHANG轮询<br/>
+ * 零停机更新：reload()逐个替换worker，新worker启动之后才停止旧worker；
+ * upgrade()带着监听socket exec新的二进制，新的master就绪后旧的master调用terminate()退出
+ */
+class ProcessPool {
+public:
+  using Worker = std::function<void(std::size_t index)>;
+
+  /**
+   * @brief
+   *
+   * @param size    worker数量，通常等于CPU核数
+   * @param worker  worker进程执行的函数，参数为worker的编号，返回即退出
+   * @param policy
+   */
+  ProcessPool(std::size_t size, Worker worker, RestartPolicy policy = RestartPolicy::OnFailure);
+
+  ProcessPool(const ProcessPool& other) = delete;
+  ProcessPool& operator=(const ProcessPool& other) = delete;
+
+  ProcessPool(ProcessPool&& other) noexcept = delete;
+  ProcessPool& operator=(ProcessPool&& other) noexcept = delete;
+
+  // 仍在运行的worker会被terminate
+  ~ProcessPool();
+
+  /**
+   * @brief fork所有worker
+   *
+   */
+  void start();
+
+  /**
+   * @brief 监控worker直到stop()被调用，然后terminate所有worker
+   *
+   * @details 期间处理request_reload()的请求
+   */
+  void run(std::chrono::milliseconds grace = DEFAULT_STOP_GRACE);
+
+  /**
+   * @brief 等待并处理一轮worker退出事件
+   *
+   * @param timeout
+   */
+  void supervise(std::chrono::milliseconds timeout = DEFAULT_SUPERVISE_TICK);
+
+  /**
+   * @brief 请求run()退出，可以在信号处理函数中调用
+   *
+   */
+  void stop() noexcept { stopping_.store(true, std::memory_order_relaxed); }
+
+  /**
+   * @brief 请求run()执行一次reload()，可以在信号处理函数中调用(比如SIGHUP)
+   *
+   */
+  void request_reload() noexcept { reload_requested_.store(true, std::memory_order_relaxed); }
+
+  /**
+   * @brief 通过signalfd在内部的epoll上处理信号：SIGTERM/SIGINT调用stop()，SIGHUP调用request_reload()
+   *
+   * @details 会阻塞这些信号，需要在创建其他线程之前调用；worker启动时会解除屏蔽
+   */
+  void handle_signals();
+
+  /**
+   * @brief 向所有worker发送SIGTERM，grace之后仍未退出的发送SIGKILL
+   *
+   * @param grace
+   */
+  void terminate(std::chrono::milliseconds grace = DEFAULT_STOP_GRACE);
+
+  /**
+   * @brief 逐个替换所有worker：先启动新worker，再优雅停止旧worker，任何时刻都有worker在处理请求
+   *
+   * @param grace 等待旧worker退出的最长时间
+   */
+  void reload(std::chrono::milliseconds grace = DEFAULT_STOP_GRACE);
+
+  /**
+   * @brief 启动新的二进制作为新的master，inherited_fds会被新进程继承
+   *
+   * @details 新进程通过inherited_fds()取回这些fd；调用者确认新master就绪后terminate()旧的worker并退出<br/>
+   * 子进程在exec之前只做async-signal-safe的调用，exec失败时以127退出
+   * @param path          新二进制的路径
+   * @param arguments     argv，包括argv[0]
+   * @param inherited_fds 需要继承的fd，比如监听socket
+   * @return Process      新的master进程
+   */
+  static Process upgrade(const std::string& path,
+                         const std::vector<std::string>& arguments,
+                         std::span<const int> inherited_fds);
+
+  /**
+   * @brief 取得上一个master通过upgrade()传递下来的fd
+   *
+   * @return std::vector<int> 不是通过upgrade()启动时为空
+   */
+  static std::vector<int> inherited_fds();
+
+  std::size_t size() const noexcept { return slots_.size(); }
+
+  // 正在运行的worker数
+  std::size_t running() const noexcept;
+
+  std::vector<pid_t> pids() const;
+
+  // 累计重启的次数
+  std::size_t restarts() const noexcept { return restarts_; }
+
+private:
+  struct Slot {
+    std::optional<Process> process;
+    // 内核不支持pidfd时为空
+    std::optional<PidFd> pidfd;
+  };
+
+  std::vector<Slot> slots_;
+  Worker worker_;
+  RestartPolicy policy_;
+  Net::Poller poller_;
+  std::size_t restarts_;
+  std::atomic<bool> stopping_;
+  std::atomic<bool> reload_requested_;
+  std::unique_ptr<SignalSet> signals_;
+
+  void spawn(std::size_t index);
+  void reap(std::size_t index);
+  void detach(Slot& slot);
+  bool should_restart(const ProcessResult& result) const noexcept;
+
+  static void signal(Slot& slot, int signal);
+  static bool wait_exit(Slot& slot, std::chrono::milliseconds timeout);
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_PROCESS_POOL_H
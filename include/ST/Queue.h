@@ -0,0 +1,321 @@
+/**
+ * @file Queue.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 线程间传递任务的有界无锁队列，eventfd唤醒的适配器见WakeupQueue.h
+ * @version 0.1
+ * @date 2022-07-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_QUEUE_H
+#define STUDY_TOUR_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+namespace ST {
+
+// 队列的读写位置和slot按缓存行对齐，避免生产者和消费者之间的伪共享
+constexpr static std::size_t QUEUE_CACHE_LINE = 64;
+
+namespace detail {
+
+// 元素的未初始化存储
+template<typename T>
+struct Storage {
+  alignas(T) std::byte bytes[sizeof(T)];
+
+  T* get() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+
+  template<typename... Args>
+  void construct(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+  {
+    ::new (static_cast<void*>(bytes)) T(std::forward<Args>(args)...);
+  }
+
+  T take() noexcept
+  {
+    T value{ std::move(*get()) };
+    get()->~T();
+    return value;
+  }
+};
+
+} // namespace detail
+
+
+/**
+ * @brief 有界的多生产者多消费者队列(Dmitry Vyukov的bounded MPMC queue)
+ *
+ * @details 每个slot带一个sequence：sequence == pos时可写，== pos + 1时可读，
+ * 生产者/消费者各用一次CAS领取位置，领取之后只访问自己的slot，不需要锁。
+ * 每个slot独占缓存行，相邻位置的生产者和消费者互不干扰<br/>
+ * 和ShmRing是同一个算法，这里存放任意类型的对象，只在进程内使用
+ * @warning 领取位置之后构造元素不能失败，所以要求T的移动构造不抛异常；
+ * 可能抛异常的构造先在队列外完成再移动进来
+ */
+template<typename T>
+class MPMCQueue {
+  static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>,
+                "MPMCQueue requires a nothrow move constructible value type");
+
+public:
+  using value_type = T;
+
+  /**
+   * @brief
+   *
+   * @param capacity 向上取整为2的幂，至少为2
+   */
+  explicit MPMCQueue(std::size_t capacity)
+    : capacity_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) },
+      slots_{ std::make_unique<Slot[]>(capacity_) },
+      enqueue_{ 0 },
+      dequeue_{ 0 }
+  {
+    for (std::size_t i = 0; i < capacity_; ++i)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MPMCQueue(const MPMCQueue& other) = delete;
+  MPMCQueue& operator=(const MPMCQueue& other) = delete;
+
+  ~MPMCQueue()
+  {
+    while (try_pop())
+      ;
+  }
+
+  /**
+   * @brief 不阻塞地构造一个元素
+   *
+   * @return true  成功
+   * @return false 队列已满
+   */
+  template<typename... Args>
+  bool try_emplace(Args&&... args)
+  {
+    if constexpr (!std::is_nothrow_constructible_v<T, Args...>) {
+      // 先在外面构造，抛异常时还没有领取位置
+      return try_emplace(T(std::forward<Args>(args)...));
+    }
+    else {
+      auto [slot, position] = claim_write();
+      if (slot == nullptr)
+        return false;
+
+      slot->storage.construct(std::forward<Args>(args)...);
+      slot->sequence.store(position + 1, std::memory_order_release);
+      return true;
+    }
+  }
+
+  bool try_push(const T& value) { return try_emplace(value); }
+
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * @brief 不阻塞地取出一个元素
+   *
+   * @return std::optional<T> 队列为空时为空
+   */
+  std::optional<T> try_pop() noexcept
+  {
+    auto position = dequeue_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& slot = slots_[position & (capacity_ - 1)];
+      auto sequence = slot.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+
+      if (difference == 0) {
+        if (dequeue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          std::optional<T> value{ slot.storage.take() };
+          // 下一轮的生产者在position + capacity处写这个slot
+          slot.sequence.store(position + capacity_, std::memory_order_release);
+          return value;
+        }
+      }
+      else if (difference < 0) {
+        return std::nullopt;
+      }
+      else {
+        position = dequeue_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  // 近似值，并发时只能作为参考
+  std::size_t size() const noexcept
+  {
+    auto dequeue = dequeue_.load(std::memory_order_relaxed);
+    auto enqueue = enqueue_.load(std::memory_order_relaxed);
+    return enqueue > dequeue ? static_cast<std::size_t>(enqueue - dequeue) : 0;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+private:
+  struct alignas(QUEUE_CACHE_LINE) Slot {
+    std::atomic<std::size_t> sequence;
+    detail::Storage<T> storage;
+  };
+
+  const std::size_t capacity_;
+  const std::unique_ptr<Slot[]> slots_;
+  alignas(QUEUE_CACHE_LINE) std::atomic<std::size_t> enqueue_;
+  alignas(QUEUE_CACHE_LINE) std::atomic<std::size_t> dequeue_;
+
+  // 领取一个可写的位置，队列已满时slot为nullptr
+  std::pair<Slot*, std::size_t> claim_write() noexcept
+  {
+    auto position = enqueue_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& slot = slots_[position & (capacity_ - 1)];
+      auto sequence = slot.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+      if (difference == 0) {
+        if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          return { &slot, position };
+      }
+      else if (difference < 0) {
+        return { nullptr, position };
+      }
+      else {
+        position = enqueue_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
+
+/**
+ * @brief 有界的单生产者单消费者环形队列
+ *
+ * @details 生产者只写head_，消费者只写tail_，两者各占一个缓存行，没有CAS；
+ * 双方各自缓存对方的位置，只有缓存的值显示队列满/空时才读对方的缓存行
+ * @warning 同一时刻只能有一个线程push，一个线程pop
+ */
+template<typename T>
+class SPSCQueue {
+public:
+  using value_type = T;
+
+  /**
+   * @brief
+   *
+   * @param capacity 向上取整为2的幂
+   */
+  explicit SPSCQueue(std::size_t capacity)
+    : capacity_{ std::bit_ceil(std::max<std::size_t>(capacity, 1)) },
+      slots_{ std::make_unique<detail::Storage<T>[]>(capacity_) },
+      head_{ 0 },
+      cached_tail_{ 0 },
+      tail_{ 0 },
+      cached_head_{ 0 }
+  {}
+
+  SPSCQueue(const SPSCQueue& other) = delete;
+  SPSCQueue& operator=(const SPSCQueue& other) = delete;
+
+  ~SPSCQueue()
+  {
+    while (front() != nullptr)
+      pop();
+  }
+
+  // 生产者调用，队列已满时返回false
+  template<typename... Args>
+  bool try_emplace(Args&&... args)
+  {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ == capacity_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head - cached_tail_ == capacity_)
+        return false;
+    }
+
+    // 构造抛异常时head_还没有发布，队列不受影响
+    slots_[head & (capacity_ - 1)].construct(std::forward<Args>(args)...);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T& value) { return try_emplace(value); }
+
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * @brief 消费者调用，不移动地访问队首元素
+   *
+   * @return T* 队列为空时为nullptr
+   */
+  T* front() noexcept
+  {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == cached_head_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail == cached_head_)
+        return nullptr;
+    }
+
+    return slots_[tail & (capacity_ - 1)].get();
+  }
+
+  // 消费者调用，必须在front()返回非空之后
+  void pop() noexcept
+  {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    slots_[tail & (capacity_ - 1)].get()->~T();
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  // 消费者调用，队列为空时为空
+  std::optional<T> try_pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+  {
+    auto value = front();
+    if (value == nullptr)
+      return std::nullopt;
+
+    std::optional<T> result{ std::move(*value) };
+    pop();
+    return result;
+  }
+
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  // 近似值，并发时只能作为参考
+  std::size_t size() const noexcept
+  {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_relaxed);
+    return head > tail ? static_cast<std::size_t>(head - tail) : 0;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+private:
+  const std::size_t capacity_;
+  const std::unique_ptr<detail::Storage<T>[]> slots_;
+  // 生产者独占
+  alignas(QUEUE_CACHE_LINE) std::atomic<std::size_t> head_;
+  std::size_t cached_tail_;
+  // 消费者独占
+  alignas(QUEUE_CACHE_LINE) std::atomic<std::size_t> tail_;
+  std::size_t cached_head_;
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_QUEUE_H
@@ -0,0 +1,95 @@
+/**
+ * @file SharedMemory.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 进程间共享内存
+ * @version 0.1
+ * @date 2022-07-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_SHARED_MEMORY_H
+#define STUDY_TOUR_SHARED_MEMORY_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+#include "ST/FileSystem/File.h"
+
+
+namespace ST {
+
+/**
+ * @brief 一段MAP_SHARED映射的共享内存，RAII，析构时munmap并关闭fd
+ *
+ * @details 三种来源：
+ * 1. anonymous(): memfd_create，没有名字，fork出的子进程直接继承映射，其他进程通过fd传递(SCM_RIGHTS)获得
+ * 2. open(): shm_open，/dev/shm下有名字，无关的进程也可以按名字打开
+ * 3. attach(): 接管一个已有的fd，比如fd传递或exec继承来的memfd
+ */
+class SharedMemory {
+public:
+  SharedMemory(const SharedMemory& other) = delete;
+  SharedMemory& operator=(const SharedMemory& other) = delete;
+
+  SharedMemory(SharedMemory&& other) noexcept;
+  SharedMemory& operator=(SharedMemory&& other) noexcept;
+
+  ~SharedMemory();
+
+  /**
+   * @brief 创建匿名共享内存
+   *
+   * @param name 只用于调试，出现在/proc/<pid>/fd中
+   * @param size
+   * @return SharedMemory 内容全为0
+   */
+  static SharedMemory anonymous(const std::string& name, std::size_t size);
+
+  /**
+   * @brief 打开/创建有名字的共享内存
+   *
+   * @param name   以'/'开头，比如"/st-ring"
+   * @param size   新创建时的大小；打开已有的共享内存时为0，使用其实际大小
+   * @param create 不存在时是否创建
+   * @return SharedMemory
+   */
+  static SharedMemory open(const std::string& name, std::size_t size = 0, bool create = true);
+
+  /**
+   * @brief 删除有名字的共享内存，已经映射的进程不受影响
+   *
+   * @param name
+   */
+  static void unlink(const std::string& name);
+
+  /**
+   * @brief 接管fd并映射其全部大小
+   *
+   * @param fd 接管后由SharedMemory负责关闭
+   * @return SharedMemory
+   */
+  static SharedMemory attach(int fd);
+
+  void* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+  int fd() const noexcept { return file_.fd(); }
+
+  std::span<std::byte> bytes() const noexcept { return { static_cast<std::byte*>(data_), size_ }; }
+
+private:
+  FileSystem::File file_;
+  void* data_;
+  std::size_t size_;
+
+  SharedMemory(FileSystem::File file, std::size_t size);
+
+  void release() noexcept;
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_SHARED_MEMORY_H
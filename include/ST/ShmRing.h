@@ -0,0 +1,211 @@
+/**
+ * @file ShmRing.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 共享内存上的无锁消息队列，用于父进程和fork出的worker之间传递消息
+ * @version 0.1
+ * @date 2022-07-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_SHM_RING_H
+#define STUDY_TOUR_SHM_RING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "ST/SharedMemory.h"
+
+
+namespace ST {
+
+/**
+ * @brief 队列两端的并发模式
+ *
+ */
+enum class RingMode : std::uint32_t {
+  // 单生产者单消费者，push/pop不需要CAS
+  SPSC,
+  // 多生产者多消费者
+  MPMC
+};
+
+/**
+ * @brief 固定容量、固定最大消息长度的共享内存消息队列
+ *
+ * @details 基于Dmitry Vyukov的bounded MPMC queue：每个slot带一个sequence，
+ * 生产者/消费者通过比较sequence和自己的位置判断slot是否可写/可读，不需要锁；
+ * SPSC模式下位置只有一个线程修改，省掉CAS<br/>
+ * 阻塞的push/pop先自旋，然后在共享内存中的futex上睡眠(不带FUTEX_PRIVATE_FLAG，跨进程有效)，
+ * 对端只在有等待者时才调用futex_wake，快速路径上没有系统调用<br/>
+ * 用法：fork之前create()，父子进程各自持有同一段映射；无关进程通过SharedMemory::open()或fd传递后attach()
+ * @warning 不同进程必须是同一个ABI(同样的原子类型布局)
+ */
+class ShmRing {
+public:
+  ShmRing(const ShmRing& other) = delete;
+  ShmRing& operator=(const ShmRing& other) = delete;
+
+  ShmRing(ShmRing&& other) noexcept = default;
+  ShmRing& operator=(ShmRing&& other) noexcept = default;
+
+  ~ShmRing() = default;
+
+  /**
+   * @brief 在匿名共享内存(memfd)上创建队列
+   *
+   * @param capacity      最多容纳的消息数，向上取整为2的幂
+   * @param message_size  单条消息的最大长度
+   * @param mode
+   * @return ShmRing
+   */
+  static ShmRing create(std::size_t capacity, std::size_t message_size, RingMode mode = RingMode::MPMC);
+
+  /**
+   * @brief 在有名字的共享内存(shm_open)上创建队列，其他进程可以open后attach
+   *
+   * @param name 以'/'开头
+   * @param capacity
+   * @param message_size
+   * @param mode
+   * @return ShmRing
+   */
+  static ShmRing create(const std::string& name, std::size_t capacity, std::size_t message_size, RingMode mode = RingMode::MPMC);
+
+  /**
+   * @brief 使用已经由create()初始化过的共享内存
+   *
+   * @details 校验header中的容量(2的幂)、slot间隔和共享内存大小，不一致时抛出std::invalid_argument
+   * @param memory
+   * @return ShmRing
+   */
+  static ShmRing attach(SharedMemory memory);
+
+  /**
+   * @brief 不阻塞地写入一条消息
+   *
+   * @param message 长度不能超过message_size()
+   * @return true   写入成功
+   * @return false  队列已满
+   */
+  bool try_push(std::span<const std::byte> message);
+
+  /**
+   * @brief 写入一条消息，队列满时阻塞
+   *
+   * @param message
+   */
+  void push(std::span<const std::byte> message);
+
+  /**
+   * @brief 写入一条消息，队列满时最多等待timeout
+   *
+   * @param message
+   * @param timeout
+   * @return true  写入成功
+   * @return false 超时
+   */
+  bool push(std::span<const std::byte> message, std::chrono::milliseconds timeout);
+
+  /**
+   * @brief 不阻塞地取出一条消息
+   *
+   * @param buffer 长度不能小于message_size()
+   * @return std::optional<std::size_t> 消息长度，队列为空时为空
+   */
+  std::optional<std::size_t> try_pop(std::span<std::byte> buffer);
+
+  /**
+   * @brief 取出一条消息，队列为空时阻塞
+   *
+   * @param buffer
+   * @return std::size_t 消息长度
+   */
+  std::size_t pop(std::span<std::byte> buffer);
+
+  /**
+   * @brief 取出一条消息，队列为空时最多等待timeout
+   *
+   * @param buffer
+   * @param timeout
+   * @return std::optional<std::size_t> 消息长度，超时时为空
+   */
+  std::optional<std::size_t> pop(std::span<std::byte> buffer, std::chrono::milliseconds timeout);
+
+  /**
+   * @brief 不拷贝地处理一条消息，callback返回后slot才会被释放
+   *
+   * @param callback void(std::span<const std::byte>)
+   * @return true  处理了一条消息
+   * @return false 队列为空
+   */
+  template<typename Callback>
+  bool try_consume(Callback&& callback)
+  {
+    auto claim = claim_read();
+    if (!claim)
+      return false;
+
+    // callback抛异常时也要释放slot，否则队列永远卡在这个位置
+    Release release{ *this, *claim };
+    std::invoke(std::forward<Callback>(callback), claim->payload);
+    return true;
+  }
+
+  std::size_t capacity() const noexcept;
+  std::size_t message_size() const noexcept;
+  RingMode mode() const noexcept;
+
+  // 近似值，并发时只能作为参考
+  std::size_t size() const noexcept;
+  bool empty() const noexcept { return size() == 0; }
+
+  // 底层共享内存的fd，可以传递给其他进程后attach
+  int fd() const noexcept { return memory_.fd(); }
+
+private:
+  struct Header;
+
+  struct ReadClaim {
+    std::byte* slot;
+    std::uint64_t position;
+    std::span<const std::byte> payload;
+  };
+
+  struct Release {
+    ShmRing& ring;
+    const ReadClaim& claim;
+
+    ~Release() { ring.release_read(claim); }
+  };
+
+  SharedMemory memory_;
+  Header* header_;
+  std::byte* slots_;
+  // 校验过的布局，不再从共享内存中读取，对端改写header也不会越界
+  std::size_t capacity_;
+  std::size_t message_size_;
+  std::size_t slot_stride_;
+
+  ShmRing(SharedMemory memory, std::size_t capacity, std::size_t message_size);
+
+  static ShmRing initialize(SharedMemory memory, std::size_t capacity, std::size_t message_size, RingMode mode);
+  static std::size_t required_size(std::size_t capacity, std::size_t message_size) noexcept;
+
+  std::byte* slot_at(std::uint64_t position) const noexcept;
+
+  std::optional<ReadClaim> claim_read() noexcept;
+  void release_read(const ReadClaim& claim) noexcept;
+
+  bool wait_writable(std::span<const std::byte> message, std::optional<std::chrono::steady_clock::time_point> deadline);
+  std::optional<std::size_t> wait_readable(std::span<std::byte> buffer, std::optional<std::chrono::steady_clock::time_point> deadline);
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_SHM_RING_H
@@ -0,0 +1,92 @@
+/**
+ * @file SignalSet.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 基于signalfd的信号处理，信号作为普通的fd事件在epoll循环中处理
+ * @version 0.1
+ * @date 2022-07-14
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_SIGNAL_SET_H
+#define STUDY_TOUR_SIGNAL_SET_H
+
+#include <signal.h>
+#include <sys/signalfd.h>
+
+#include <functional>
+#include <initializer_list>
+#include <optional>
+
+#include "ST/Net/Poller.h"
+
+
+namespace ST {
+
+/**
+ * @brief 一组通过signalfd同步接收的信号
+ *
+ * @details 构造时阻塞这些信号(pthread_sigmask)，信号不再异步打断程序，而是排队等待从fd中读取，
+ * 回调中可以做任何事情，没有async-signal-safe的限制<br/>
+ * 析构时恢复原来的信号屏蔽字
+ * @warning 信号屏蔽字是线程级的，必须在创建其他线程之前构造，否则其他线程仍会以默认方式处理这些信号；
+ * fork/exec出的子进程会继承屏蔽字，需要自己解除(Command::spawn和ProcessPool已经处理)
+ */
+class SignalSet {
+public:
+  using Handler = std::function<void(const signalfd_siginfo& info)>;
+
+  SignalSet(std::initializer_list<int> signals);
+
+  SignalSet(const SignalSet& other) = delete;
+  SignalSet& operator=(const SignalSet& other) = delete;
+
+  // poller持有this，不能移动
+  SignalSet(SignalSet&& other) noexcept = delete;
+  SignalSet& operator=(SignalSet&& other) noexcept = delete;
+
+  ~SignalSet();
+
+  void add(int signal);
+  void remove(int signal);
+  bool contains(int signal) const noexcept;
+
+  int fd() const noexcept { return fd_; }
+
+  /**
+   * @brief 不阻塞地读取一个待处理的信号
+   *
+   * @return std::optional<signalfd_siginfo> 没有待处理的信号时为空
+   */
+  std::optional<signalfd_siginfo> read();
+
+  /**
+   * @brief 注册到poller上，收到信号时调用handler
+   *
+   * @param poller
+   * @param handler
+   */
+  void watch(Net::Poller& poller, Handler handler);
+
+  void unwatch();
+
+  /**
+   * @brief 解除当前线程对所有信号的屏蔽，fork出的子进程在执行自己的代码之前调用
+   *
+   */
+  static void unblock_all();
+
+private:
+  int fd_;
+  sigset_t signals_;
+  sigset_t previous_mask_;
+  Net::Poller* poller_;
+  Handler handler_;
+
+  void update();
+  void handle_read();
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_SIGNAL_SET_H
@@ -11,6 +11,17 @@
 #ifndef STUDY_TOUR_SINGLETON_H
 #define STUDY_TOUR_SINGLETON_H
 
+#include <sched.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <utility>
 
 #include "TypeTraits.h"
@@ -34,6 +45,333 @@ T* static_singleton(Args&&... args)
   return &singleton;
 }
 
+
+/**
+ * @brief 单例的销毁顺序，可以特化，值大的先销毁
+ *
+ * @details 比如Logger特化为较小的值，其他单例销毁时还能写日志
+ */
+template<typename T>
+constexpr int singleton_shutdown_order = 0;
+
+/**
+ * @brief 显式、有序的销毁
+ *
+ * @details Singleton、PerThread、PerCpu创建时在这里登记；不调用shutdown时它们永远不会被销毁，
+ * 从而避免静态对象析构顺序的问题
+ */
+class ShutdownRegistry {
+public:
+  ShutdownRegistry() = delete;
+
+  /**
+   * @brief 登记一个销毁函数
+   *
+   * @param order 值大的先执行，相同时按登记的逆序执行
+   */
+  static void add(int order, std::function<void()> shutdown);
+
+  /**
+   * @brief 按顺序执行所有销毁函数并清空，执行期间登记的也会被执行
+   *
+   * @warning 调用时不能有其他线程还在使用这些单例
+   */
+  static void shutdown();
+
+  static std::size_t size();
+};
+
+
+/**
+ * @brief 可以显式销毁、可以重新创建的单例
+ *
+ * @details 对象放在静态存储中，指针是constinit的，没有函数内static的初始化检查：
+ * instance()是一次acquire load加一个分支，get()只有一次load
+ */
+template<typename T>
+class Singleton {
+public:
+  Singleton() = delete;
+
+  /**
+   * @brief 用args创建单例，已经存在时直接返回已有的对象，args被忽略
+   *
+   */
+  template<typename... Args>
+  static T& create(Args&&... args)
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (auto instance = instance_.load(std::memory_order_relaxed))
+      return *instance;
+
+    auto instance = new (storage_) T{ std::forward<Args>(args)... };
+    if (!registered_) {
+      registered_ = true;
+      ShutdownRegistry::add(singleton_shutdown_order<T>, [] {
+        destroy();
+        std::lock_guard<std::mutex> lock{ mutex_ };
+        registered_ = false;
+      });
+    }
+    instance_.store(instance, std::memory_order_release);
+
+    return *instance;
+  }
+
+  /**
+   * @brief 获取单例，不存在时默认构造
+   *
+   */
+  static T& instance() requires std::default_initializable<T>
+  {
+    if (auto instance = instance_.load(std::memory_order_acquire)) [[likely]]
+      return *instance;
+
+    return create();
+  }
+
+  /**
+   * @brief 获取已经创建的单例，不检查
+   *
+   * @warning 必须先create，否则是未定义行为
+   */
+  static T& get() noexcept { return *instance_.load(std::memory_order_acquire); }
+
+  static bool created() noexcept { return instance_.load(std::memory_order_acquire) != nullptr; }
+
+  /**
+   * @brief 销毁单例，之后可以再次create
+   *
+   * @warning 调用时不能有其他线程还在使用单例
+   */
+  static void destroy()
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (auto instance = instance_.exchange(nullptr, std::memory_order_acq_rel))
+      instance->~T();
+  }
+
+private:
+  alignas(T) static inline std::byte storage_[sizeof(T)];
+  static constinit inline std::atomic<T*> instance_{ nullptr };
+  static constinit inline std::mutex mutex_{};
+  // destroy后重新create时不重复登记，shutdown之后重新登记
+  static constinit inline bool registered_ = false;
+};
+
+
+/**
+ * @brief 每个线程一个实例，比如线程本地的计数器、内存缓存
+ *
+ * @details local()是一次thread_local指针的load加一个分支；线程退出时实例不会销毁，
+ * 而是留给之后的新线程复用，所以for_each能看到已退出线程的最终值<br/>
+ * for_each和各线程的local()并发执行，T需要自己保证并发读的安全(比如用relaxed原子变量)
+ * @tparam Tag 区分同一个T的不同用途
+ */
+template<typename T, typename Tag = void>
+class PerThread {
+public:
+  PerThread() = delete;
+
+  static T& local()
+  {
+    // destroy之后其他线程缓存的指针已经失效，用代数区分
+    if (auto value = local_; value != nullptr &&
+        local_generation_ == generation_.load(std::memory_order_acquire)) [[likely]]
+      return *value;
+
+    return attach();
+  }
+
+  /**
+   * @brief 遍历所有实例，包括已退出线程留下的
+   *
+   */
+  template<typename Function>
+  static void for_each(Function&& f)
+  {
+    for (auto node = head_.load(std::memory_order_acquire); node != nullptr; node = node->next)
+      f(node->value);
+  }
+
+  // 创建过的实例数，也就是同时使用过的最大线程数
+  static std::size_t size() noexcept
+  {
+    std::size_t count = 0;
+    for (auto node = head_.load(std::memory_order_acquire); node != nullptr; node = node->next)
+      ++count;
+    return count;
+  }
+
+  /**
+   * @brief 销毁所有实例，之后各线程的local()会重新创建实例
+   *
+   * @warning 调用期间不能有其他线程在使用local()返回的引用
+   */
+  static void destroy()
+  {
+    // 先让所有线程缓存的local_和Releaser失效，再释放节点
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    auto node = head_.exchange(nullptr, std::memory_order_acq_rel);
+    while (node != nullptr)
+      delete std::exchange(node, node->next);
+
+    local_ = nullptr;
+    releaser_.node = nullptr;
+  }
+
+private:
+  struct Node {
+    T value{};
+    Node* next = nullptr;
+    std::atomic<bool> in_use{ true };
+  };
+
+  // 线程退出时把实例交还，留给之后的线程
+  struct Releaser {
+    Node* node = nullptr;
+    std::uint64_t generation = 0;
+
+    ~Releaser()
+    {
+      // 节点属于destroy之前的一代时已经被释放
+      if (node != nullptr && generation == generation_.load(std::memory_order_acquire))
+        node->in_use.store(false, std::memory_order_release);
+      local_ = nullptr;
+    }
+  };
+
+  // 只有trivial的thread_local才没有初始化检查，带析构的Releaser只在慢路径访问
+  static constinit inline thread_local T* local_ = nullptr;
+  static constinit inline thread_local std::uint64_t local_generation_ = 0;
+  static inline thread_local Releaser releaser_{};
+  static constinit inline std::atomic<Node*> head_{ nullptr };
+  static constinit inline std::atomic<std::uint64_t> generation_{ 0 };
+  static constinit inline std::mutex mutex_{};
+  static constinit inline bool registered_ = false;
+
+  static T& attach()
+  {
+    {
+      std::lock_guard<std::mutex> lock{ mutex_ };
+      if (!registered_) {
+        registered_ = true;
+        ShutdownRegistry::add(singleton_shutdown_order<T>, [] {
+          destroy();
+          std::lock_guard<std::mutex> lock{ mutex_ };
+          registered_ = false;
+        });
+      }
+    }
+
+    Node* node = nullptr;
+    for (auto free = head_.load(std::memory_order_acquire); free != nullptr; free = free->next) {
+      auto in_use = false;
+      if (free->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+        node = free;
+        break;
+      }
+    }
+
+    if (node == nullptr) {
+      node = new Node{};
+      node->next = head_.load(std::memory_order_relaxed);
+      while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        ;
+    }
+
+    auto generation = generation_.load(std::memory_order_acquire);
+    releaser_.node = node;
+    releaser_.generation = generation;
+    local_generation_ = generation;
+    local_ = &node->value;
+    return node->value;
+  }
+};
+
+
+/**
+ * @brief 每个CPU一个实例，实例数不随线程数增长
+ *
+ * @details local()按sched_getcpu()选择实例，线程随时可能被迁移到其他CPU，
+ * 所以T必须是线程安全的(比如relaxed原子计数)；每个实例独占cache line，避免伪共享
+ * @tparam Tag 区分同一个T的不同用途
+ */
+template<typename T, typename Tag = void>
+class PerCpu {
+public:
+  PerCpu() = delete;
+
+  static T& local()
+  {
+    auto slots = slots_.load(std::memory_order_acquire);
+    if (slots == nullptr) [[unlikely]]
+      slots = allocate();
+
+    // glibc通过vDSO/rseq实现，不陷入内核
+    auto cpu = ::sched_getcpu();
+    return slots[cpu < 0 ? 0 : static_cast<std::size_t>(cpu) % count_].value;
+  }
+
+  template<typename Function>
+  static void for_each(Function&& f)
+  {
+    auto slots = slots_.load(std::memory_order_acquire);
+    if (slots == nullptr)
+      return;
+
+    for (std::size_t i = 0; i < count_; ++i)
+      f(slots[i].value);
+  }
+
+  static std::size_t size() noexcept { return slots_.load(std::memory_order_acquire) == nullptr ? 0 : count_; }
+
+  /**
+   * @brief 销毁所有实例
+   *
+   * @warning 调用时不能有其他线程还在使用
+   */
+  static void destroy()
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    delete[] slots_.exchange(nullptr, std::memory_order_acq_rel);
+  }
+
+private:
+  struct alignas(64) Slot {
+    T value{};
+  };
+
+  static constinit inline std::atomic<Slot*> slots_{ nullptr };
+  static constinit inline std::size_t count_ = 0;
+  static constinit inline std::mutex mutex_{};
+  static constinit inline bool registered_ = false;
+
+  static Slot* allocate()
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (auto slots = slots_.load(std::memory_order_relaxed))
+      return slots;
+
+    // 按配置的CPU数而不是在线的CPU数，CPU热插拔后编号也不会越界
+    auto cpus = ::sysconf(_SC_NPROCESSORS_CONF);
+    count_ = cpus > 0 ? static_cast<std::size_t>(cpus) : 1;
+    auto slots = new Slot[count_]{};
+
+    if (!registered_) {
+      registered_ = true;
+      ShutdownRegistry::add(singleton_shutdown_order<T>, [] {
+        destroy();
+        std::lock_guard<std::mutex> lock{ mutex_ };
+        registered_ = false;
+      });
+    }
+    slots_.store(slots, std::memory_order_release);
+
+    return slots;
+  }
+};
+
 } // namespace ST
 
-#endif // STUDY_TOUR_SINGLETON_H
\ No newline at end of file
+#endif // STUDY_TOUR_SINGLETON_H
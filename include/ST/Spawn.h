@@ -0,0 +1,182 @@
+/**
+ * @file Spawn.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 基于posix_spawn的进程启动，不复制父进程的页表
+ * @version 0.1
+ * @date 2022-07-10
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_SPAWN_H
+#define STUDY_TOUR_SPAWN_H
+
+#include <unistd.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ST/Process.h"
+#include "ST/PidFd.h"
+#include "ST/FileSystem/File.h"
+
+
+namespace ST {
+
+/**
+ * @brief 子进程标准输入输出的来源/去向
+ *
+ */
+enum class Stdio {
+  // 和父进程共用
+  Inherit,
+  // 创建管道，父进程通过Child读写
+  Pipe,
+  // 重定向到/dev/null
+  Null
+};
+
+/**
+ * @brief spawn出的子进程
+ *
+ * @details 析构时关闭管道和pidfd，但不会wait，需要调用者wait回收子进程
+ */
+class Child {
+public:
+  Child(Process process, std::optional<PidFd> pidfd, int input, int output, int error);
+
+  Child(const Child& other) = delete;
+  Child& operator=(const Child& other) = delete;
+
+  Child(Child&& other) noexcept;
+  Child& operator=(Child&& other) noexcept = delete;
+
+  ~Child();
+
+  pid_t pid() const noexcept { return process_.get_pid(); }
+
+  /**
+   * @brief 子进程退出时可读，可以注册到Poller上异步等待
+   *
+   * @return int 内核不支持pidfd时为-1
+   */
+  int pidfd() const noexcept { return pidfd_ ? pidfd_->fd() : -1; }
+
+  // 只有对应的Stdio为Pipe时才是opened的
+  FileSystem::File& standard_input() noexcept { return input_; }
+  FileSystem::File& standard_output() noexcept { return output_; }
+  FileSystem::File& standard_error() noexcept { return error_; }
+
+  /**
+   * @brief 关闭子进程的标准输入，子进程读到EOF
+   *
+   */
+  void close_input();
+
+  /**
+   * @brief 等待子进程退出，等待之前先关闭标准输入，避免子进程等待输入而死锁
+   *
+   * @return ProcessResult
+   */
+  ProcessResult wait();
+
+  std::optional<ProcessResult> try_wait() { return process_.try_wait(); }
+
+  /**
+   * @brief 向子进程发送信号
+   *
+   * @details 有pidfd时通过pidfd发送，子进程已被回收时失败(ESRCH)，不会误发给复用了pid的其他进程；
+   * 内核不支持pidfd时退回kill(2)
+   * @param signal
+   */
+  void kill(int signal = SIGTERM);
+
+private:
+  Process process_;
+  std::optional<PidFd> pidfd_;
+  FileSystem::File input_;
+  FileSystem::File output_;
+  FileSystem::File error_;
+
+  void close_all() noexcept;
+};
+
+/**
+ * @brief 执行完毕的子进程的结果和全部输出
+ *
+ */
+struct Output {
+  ProcessResult status;
+  std::string output;
+  std::string error;
+};
+
+/**
+ * @brief 描述要执行的命令，通过spawn()启动
+ *
+ * @details 使用posix_spawn(glibc内部为clone(CLONE_VM|CLONE_VFORK))，子进程和父进程共享地址空间直到exec，
+ * 不像fork那样复制页表，父进程占用内存很大时也不会停顿；exec失败时spawn()直接抛出异常<br/>
+ * 例：
+ * @code
+ * auto child = ST::Command{ "sort" }.argument("-n").standard_input(ST::Stdio::Pipe).spawn();
+ * @endcode
+ */
+class Command {
+public:
+  /**
+   * @brief
+   *
+   * @param program 不包含'/'时在PATH中查找
+   */
+  explicit Command(std::string program);
+
+  Command& argument(std::string argument);
+  Command& arguments(const std::vector<std::string>& arguments);
+
+  // 在继承的环境变量之上增加/覆盖
+  Command& environment(const std::string& key, std::string value);
+  Command& remove_environment(const std::string& key);
+  // 不继承父进程的环境变量
+  Command& clear_environment();
+
+  // 子进程的工作目录
+  Command& directory(std::string path);
+
+  Command& standard_input(Stdio stdio);
+  Command& standard_output(Stdio stdio);
+  Command& standard_error(Stdio stdio);
+
+  /**
+   * @brief 启动子进程，不等待
+   *
+   * @return Child
+   */
+  Child spawn() const;
+
+  /**
+   * @brief 启动子进程，收集标准输出和标准错误直到子进程退出
+   *
+   * @details 未设置为Pipe的标准输出和标准错误都会被设置为Pipe，标准输入未设置时为Null
+   * @return Output
+   */
+  Output output() const;
+
+private:
+  std::string program_;
+  std::vector<std::string> arguments_;
+  // 值为空表示删除该环境变量
+  std::map<std::string, std::optional<std::string>> environment_;
+  bool clear_environment_;
+  std::optional<std::string> directory_;
+  std::optional<Stdio> input_;
+  std::optional<Stdio> output_;
+  std::optional<Stdio> error_;
+
+  std::vector<std::string> make_environment() const;
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_SPAWN_H
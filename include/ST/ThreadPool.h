@@ -0,0 +1,230 @@
+/**
+ * @file ThreadPool.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief work stealing线程池
+ * @version 0.1
+ * @date 2022-07-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_THREAD_POOL_H
+#define STUDY_TOUR_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ST/Singleton.h"
+
+
+namespace ST {
+
+// parallel_for未指定粒度时，每个worker平均分到的块数，块太大负载不均衡，太小调度开销大
+constexpr static std::size_t DEFAULT_CHUNKS_PER_WORKER = 8;
+
+/**
+ * @brief worker线程是否绑定CPU
+ *
+ */
+enum class Affinity {
+  // 由调度器决定
+  None,
+  // 每个worker绑定一个CPU，同一NUMA节点的CPU相邻分配
+  Pinned
+};
+
+/**
+ * @brief 每个worker一个Chase-Lev双端队列的work stealing线程池
+ *
+ * @details worker提交的任务压入自己队列的底部并从底部取出(LIFO，缓存友好)，
+ * 空闲的worker从其他worker队列的顶部偷取(FIFO)，优先偷同一NUMA节点的worker；
+ * 非worker线程提交的任务进入全局队列<br/>
+ * 没有任务时worker在std::atomic::wait上睡眠，提交者只在有睡眠的worker时才notify<br/>
+ * 析构时执行完所有已提交的任务再退出
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief
+   *
+   * @param size     worker数，为0时等于当前进程可用的CPU数
+   * @param affinity
+   */
+  explicit ThreadPool(std::size_t size = 0, Affinity affinity = Affinity::Pinned);
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  ThreadPool(ThreadPool&& other) noexcept = delete;
+  ThreadPool& operator=(ThreadPool&& other) noexcept = delete;
+
+  ~ThreadPool();
+
+  // 全局共享的线程池，worker数等于可用的CPU数，第一次使用时创建
+  static ThreadPool& global() { return Singleton<ThreadPool>::instance(); }
+
+  /**
+   * @brief 提交任务
+   *
+   * @return std::future 任务的返回值或抛出的异常
+   */
+  template<typename Function, typename... Args>
+  auto submit(Function&& f, Args&&... args)
+    -> std::future<std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>>
+  {
+    using Result = std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>;
+
+    std::packaged_task<Result()> task{
+      [f = std::forward<Function>(f), ...args = std::forward<Args>(args)] () mutable {
+        return std::invoke(std::move(f), std::move(args)...);
+      }
+    };
+    auto future = task.get_future();
+    schedule(make_task(std::move(task)));
+
+    return future;
+  }
+
+  /**
+   * @brief 并行执行body(i)，i属于[begin, end)，返回时全部执行完毕
+   *
+   * @details 区间按grain切成块，worker和调用线程动态领取块，调用线程也参与计算，
+   * 所以可以在worker中嵌套调用；body抛出的第一个异常在所有块结束后重新抛出
+   * @param grain 每块的元素数，为0时自动选择
+   */
+  template<std::integral Index, typename Body>
+  void parallel_for(Index begin, Index end, Body&& body, std::size_t grain = 0)
+  {
+    if (begin >= end)
+      return;
+
+    auto count = static_cast<std::size_t>(end - begin);
+    if (grain == 0)
+      grain = std::max<std::size_t>(1, count / (size() * DEFAULT_CHUNKS_PER_WORKER));
+    auto chunks = (count + grain - 1) / grain;
+
+    auto state = std::make_shared<ParallelState>();
+    // 调用者等到所有块完成才返回，领不到块的runner不会访问body，所以可以按引用捕获
+    auto runner = [state, begin, count, grain, chunks, &body] {
+      for (;;) {
+        auto chunk = state->next.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= chunks)
+          return;
+
+        try {
+          auto first = chunk * grain;
+          auto last = std::min(first + grain, count);
+          for (auto i = first; i < last; ++i)
+            body(static_cast<Index>(begin + static_cast<Index>(i)));
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock{ state->mutex };
+          if (!state->error)
+            state->error = std::current_exception();
+        }
+
+        if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks)
+          state->done.notify_all();
+      }
+    };
+
+    auto helpers = std::min(size(), chunks - 1);
+    for (std::size_t i = 0; i < helpers; ++i)
+      schedule(make_task(runner));
+
+    runner();
+
+    for (auto done = state->done.load(std::memory_order_acquire); done != chunks; done = state->done.load(std::memory_order_acquire))
+      state->done.wait(done, std::memory_order_acquire);
+
+    if (state->error)
+      std::rethrow_exception(state->error);
+  }
+
+  std::size_t size() const noexcept { return workers_.size(); }
+
+  /**
+   * @brief 当前线程在本线程池中的worker编号
+   *
+   * @return std::ptrdiff_t 不是本线程池的worker时为-1
+   */
+  std::ptrdiff_t worker_index() const noexcept;
+
+  /**
+   * @brief worker绑定的CPU
+   *
+   * @return std::vector<int> 未绑定时为空
+   */
+  std::vector<int> cpus() const;
+
+private:
+  class Task {
+  public:
+    virtual ~Task() = default;
+    virtual void run() = 0;
+  };
+
+  template<typename Function>
+  class FunctionTask: public Task {
+  public:
+    explicit FunctionTask(Function f) : f_{ std::move(f) } {}
+
+    void run() override { f_(); }
+
+  private:
+    Function f_;
+  };
+
+  struct ParallelState {
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<std::size_t> done{ 0 };
+    std::mutex mutex;
+    std::exception_ptr error;
+  };
+
+  class Deque;
+
+  struct Worker {
+    std::unique_ptr<Deque> deque;
+    // 偷取顺序，同一NUMA节点的worker在前
+    std::vector<std::size_t> victims;
+    int cpu = -1;
+    std::jthread thread;
+  };
+
+  std::vector<Worker> workers_;
+  std::mutex global_mutex_;
+  std::deque<Task*> global_;
+  std::atomic<std::size_t> global_size_;
+  // 有新任务且有睡眠的worker时加1，worker在上面wait
+  std::atomic<std::uint32_t> epoch_;
+  std::atomic<std::uint32_t> sleeping_;
+
+  template<typename Function>
+  static Task* make_task(Function f) { return new FunctionTask<Function>{ std::move(f) }; }
+
+  void schedule(Task* task);
+  void run(std::stop_token token, std::size_t index);
+  Task* find_task(std::size_t index);
+  Task* pop_global();
+  void wake_one() noexcept;
+  static void execute(Task* task) noexcept;
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_THREAD_POOL_H
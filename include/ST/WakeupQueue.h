@@ -0,0 +1,183 @@
+/**
+ * @file WakeupQueue.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 用eventfd唤醒事件循环的队列适配器
+ * @version 0.1
+ * @date 2022-07-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_WAKEUP_QUEUE_H
+#define STUDY_TOUR_WAKEUP_QUEUE_H
+
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "ST/EventFd.h"
+#include "ST/Queue.h"
+#include "ST/Net/Poller.h"
+
+
+namespace ST {
+
+/**
+ * @brief 给队列加上eventfd唤醒，让事件循环线程在epoll上等待其他线程交过来的任务
+ *
+ * @details 消费者取空队列后先标记sleeping_再检查一次队列，然后才回到epoll；生产者入队后检查sleeping_，
+ * 只有消费者可能在睡眠时才写eventfd。两边之间都有seq_cst fence，所以要么生产者看到标记，要么消费者看到新元素，
+ * 不会丢失唤醒；消费者忙碌时入队没有系统调用
+ * @tparam Queue MPMCQueue或SPSCQueue
+ * @warning 只能有一个消费者线程
+ */
+template<typename Queue>
+class WakeupQueue {
+public:
+  using value_type = typename Queue::value_type;
+
+  explicit WakeupQueue(std::size_t capacity)
+    : queue_{ capacity }, event_{}, sleeping_{ true }
+  {}
+
+  WakeupQueue(const WakeupQueue& other) = delete;
+  WakeupQueue& operator=(const WakeupQueue& other) = delete;
+
+  // 生产者调用，队列已满时返回false
+  template<typename... Args>
+  bool try_emplace(Args&&... args)
+  {
+    if (!queue_.try_emplace(std::forward<Args>(args)...))
+      return false;
+
+    wake();
+    return true;
+  }
+
+  bool try_push(const value_type& value) { return try_emplace(value); }
+
+  bool try_push(value_type&& value) { return try_emplace(std::move(value)); }
+
+  /**
+   * @brief 消费者调用，处理队列中所有的元素，返回前标记为睡眠
+   *
+   * @param handler void(value_type&&)
+   * @return std::size_t 处理的元素数
+   */
+  template<typename Handler>
+  std::size_t drain(Handler&& handler)
+  {
+    std::size_t count = 0;
+    sleeping_.store(false, std::memory_order_relaxed);
+    for (;;) {
+      while (auto value = queue_.try_pop()) {
+        std::invoke(handler, std::move(*value));
+        ++count;
+      }
+
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      auto value = queue_.try_pop();
+      if (!value)
+        return count;
+
+      sleeping_.store(false, std::memory_order_relaxed);
+      std::invoke(handler, std::move(*value));
+      ++count;
+    }
+  }
+
+  /**
+   * @brief 消费者调用，取出一个元素，队列为空时最多等待timeout
+   *
+   * @param timeout 负数表示一直等待
+   * @return std::optional<value_type> 超时时为空
+   */
+  std::optional<value_type> pop(std::chrono::milliseconds timeout = std::chrono::milliseconds{ -1 })
+  {
+    if (auto value = queue_.try_pop())
+      return value;
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (auto value = queue_.try_pop()) {
+        sleeping_.store(false, std::memory_order_relaxed);
+        return value;
+      }
+
+      auto remaining = std::chrono::milliseconds{ -1 };
+      if (timeout.count() >= 0) {
+        remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+          return std::nullopt;
+      }
+
+      if (event_.wait(remaining))
+        event_.consume();
+    }
+  }
+
+  /**
+   * @brief 在poller上监听eventfd，被唤醒时用handler处理所有元素
+   *
+   * @details 调用之前已经入队的元素在第一次唤醒时处理；poller所在的线程就是消费者
+   * @param poller
+   * @param handler void(value_type&&)
+   */
+  template<typename Handler>
+  void watch(Net::Poller& poller, Handler handler)
+  {
+    poller.add(event_.fd(), EPOLLIN, [this, handler = std::move(handler)] (std::uint32_t) mutable {
+      event_.consume();
+      drain(handler);
+    });
+
+    // 注册之前入队的元素可能已经通知过，补一次
+    if (!queue_.empty())
+      event_.notify();
+  }
+
+  void unwatch(Net::Poller& poller)
+  {
+    if (poller.contains(event_.fd()))
+      poller.remove(event_.fd());
+  }
+
+  // 生产者调用，不入队只唤醒消费者，比如通知事件循环退出
+  void notify() { event_.notify(); }
+
+  int fd() const noexcept { return event_.fd(); }
+
+  std::size_t capacity() const noexcept { return queue_.capacity(); }
+
+  // 近似值，并发时只能作为参考
+  std::size_t size() const noexcept { return queue_.size(); }
+
+  bool empty() const noexcept { return queue_.empty(); }
+
+private:
+  Queue queue_;
+  EventFd event_;
+  // 消费者可能在epoll上睡眠，生产者需要写eventfd
+  alignas(QUEUE_CACHE_LINE) std::atomic<bool> sleeping_;
+
+  void wake()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false, std::memory_order_acq_rel))
+      event_.notify();
+  }
+};
+
+} // namespace ST
+
+#endif // STUDY_TOUR_WAKEUP_QUEUE_H
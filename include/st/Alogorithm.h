@@ -1,34 +1,446 @@
 #ifndef STUDY_TOUR_ALGORITHM_H
 #define STUDY_TOUR_ALGORITHM_H
 
+#include <algorithm>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
 #include <utility>
+#include <vector>
+
+#include "ST/ThreadPool.h"
 
 
 namespace st {
 namespace detail {
 
+// 一趟冒泡，把前N个元素中最大的移到arr[N - 1]，相等的元素不交换
 template<typename T, typename Comparator>
 void bubble(T arr[], size_t N)
 {
   Comparator comparator{};
-  for (size_t i = 0; i < N; ++i)
-    if (!comparator(arr[i], arr[i + 1]))
+  for (size_t i = 0; i + 1 < N; ++i)
+    if (comparator(arr[i + 1], arr[i]))
       std::swap(arr[i], arr[i + 1]);
 }
 
 } // namespace detail
 
 
+namespace detail::parallel {
+
+// 未指定粒度时每块至少这么多元素，再小的块调度开销比计算还大
+constexpr std::size_t MIN_GRAIN = std::size_t{ 1 } << 12;
+
+inline std::size_t grain_for(const ST::ThreadPool& pool, std::size_t size, std::size_t grain) noexcept
+{
+  if (grain != 0)
+    return grain;
+
+  return std::max(MIN_GRAIN, size / (pool.size() * ST::DEFAULT_CHUNKS_PER_WORKER));
+}
+
+/**
+ * @brief 把[0, size)按grain切块，并行执行body(chunk, begin, end)
+ *
+ */
+template<typename Body>
+void for_each_chunk(ST::ThreadPool& pool, std::size_t size, std::size_t grain, Body&& body)
+{
+  auto chunks = (size + grain - 1) / grain;
+  pool.parallel_for(std::size_t{ 0 }, chunks, [&body, size, grain] (std::size_t chunk) {
+    auto begin = chunk * grain;
+    body(chunk, begin, std::min(begin + grain, size));
+  }, 1);
+}
+
+} // namespace detail::parallel
+
+
+/**
+ * @brief 冒泡排序，稳定，O(n^2)
+ *
+ * @warning 只用于演示，实际使用st::sort、st::radix_sort或st::parallel_sort(st/Sort.h)
+ */
 template<typename T, typename Comparator = std::less<T>>
 void bubble_sort(T arr[], size_t N)
 {
   for (auto rest = N; rest > 1; --rest)
-    bubble_sort<T, Comparator>(arr, rest);
+    detail::bubble<T, Comparator>(arr, rest);
+}
+
+
+namespace detail::parallel {
+
+/**
+ * @brief 两遍扫描: 先并行求每块的和，串行求块的前缀，再并行写出每块的扫描结果
+ *
+ * @details 第二遍每个元素先读后写，out可以和first是同一个区间
+ * @param init exclusive scan的初始值，inclusive scan时为空
+ */
+template<bool Inclusive, typename Iterator, typename OutputIterator, typename T, typename BinaryOp>
+OutputIterator scan(ST::ThreadPool& pool, Iterator first, Iterator last, OutputIterator out,
+                    std::optional<T> init, BinaryOp& op, std::size_t grain)
+{
+  auto size = static_cast<std::size_t>(last - first);
+  grain = grain_for(pool, size, grain);
+
+  // 块内的扫描，accumulator为块之前所有元素的和
+  auto scan_chunk = [first, out, &op] (std::optional<T> accumulator, std::size_t begin, std::size_t end) {
+    auto input = first + static_cast<std::ptrdiff_t>(begin);
+    auto output = out + static_cast<std::ptrdiff_t>(begin);
+    for (auto stop = first + static_cast<std::ptrdiff_t>(end); input != stop; ++input, ++output) {
+      T value = *input;
+      if constexpr (Inclusive) {
+        accumulator = accumulator ? T(std::invoke(op, std::move(*accumulator), std::move(value))) : std::move(value);
+        *output = *accumulator;
+      }
+      else {
+        *output = *accumulator;
+        accumulator = T(std::invoke(op, std::move(*accumulator), std::move(value)));
+      }
+    }
+  };
+
+  if (size <= grain) {
+    scan_chunk(std::move(init), 0, size);
+    return out + static_cast<std::ptrdiff_t>(size);
+  }
+
+  auto chunks = (size + grain - 1) / grain;
+  // offsets[i]为第i块之前所有元素的和，最后一块的和用不到
+  std::vector<std::optional<T>> offsets(chunks);
+  offsets[0] = std::move(init);
+
+  std::vector<std::optional<T>> sums(chunks - 1);
+  for_each_chunk(pool, (chunks - 1) * grain, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+    auto it = first + static_cast<std::ptrdiff_t>(begin);
+    T sum = *it;
+    for (++it; it != first + static_cast<std::ptrdiff_t>(end); ++it)
+      sum = std::invoke(op, std::move(sum), *it);
+    sums[chunk].emplace(std::move(sum));
+  });
+
+  for (std::size_t i = 1; i < chunks; ++i) {
+    if (offsets[i - 1])
+      offsets[i].emplace(std::invoke(op, *offsets[i - 1], std::move(*sums[i - 1])));
+    else
+      offsets[i] = std::move(sums[i - 1]);
+  }
+
+  for_each_chunk(pool, size, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+    scan_chunk(std::move(offsets[chunk]), begin, end);
+  });
+
+  return out + static_cast<std::ptrdiff_t>(size);
+}
+
+// 大小为k的最大堆，保留[first, last)中按comp最小的k个元素
+template<typename Iterator, typename Compare>
+auto top_k_heap(Iterator first, Iterator last, std::size_t k, Compare& comp)
+{
+  std::vector<std::iter_value_t<Iterator>> heap{};
+  heap.reserve(std::min(k, static_cast<std::size_t>(last - first)));
+
+  for (; first != last; ++first) {
+    if (heap.size() < k) {
+      heap.push_back(*first);
+      std::push_heap(heap.begin(), heap.end(), comp);
+    }
+    else if (comp(*first, heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), comp);
+      heap.back() = *first;
+      std::push_heap(heap.begin(), heap.end(), comp);
+    }
+  }
+
+  return heap;
+}
+
+} // namespace detail::parallel
+
+
+/**
+ * @brief 先对每个元素做transform再并行归约，reduce必须满足结合律，不要求交换律(块内和块间都按原来的顺序归约)
+ * @example auto bytes = st::parallel_transform_reduce(pool, files.begin(), files.end(), std::size_t{ 0 }, std::plus<>{}, &Entry::size);
+ *
+ * @param grain 每块的元素数，为0时自动选择，元素数不超过grain时直接串行执行
+ */
+template<std::random_access_iterator Iterator, typename T, typename BinaryOp, typename UnaryOp>
+T parallel_transform_reduce(ST::ThreadPool& pool, Iterator first, Iterator last, T init,
+                            BinaryOp reduce, UnaryOp transform, std::size_t grain = 0)
+{
+  auto size = static_cast<std::size_t>(last - first);
+  grain = detail::parallel::grain_for(pool, size, grain);
+
+  if (size <= grain) {
+    for (; first != last; ++first)
+      init = std::invoke(reduce, std::move(init), std::invoke(transform, *first));
+    return init;
+  }
+
+  // 每块从自己的第一个元素开始归约，init只参与一次
+  std::vector<std::optional<T>> partials((size + grain - 1) / grain);
+  detail::parallel::for_each_chunk(pool, size, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+    auto it = first + static_cast<std::ptrdiff_t>(begin);
+    T partial = std::invoke(transform, *it);
+    for (++it; it != first + static_cast<std::ptrdiff_t>(end); ++it)
+      partial = std::invoke(reduce, std::move(partial), std::invoke(transform, *it));
+    partials[chunk].emplace(std::move(partial));
+  });
+
+  for (auto& partial: partials)
+    init = std::invoke(reduce, std::move(init), std::move(*partial));
+
+  return init;
+}
+
+/**
+ * @brief 并行归约
+ * @example auto total = st::parallel_reduce(ST::ThreadPool::global(), data.begin(), data.end(), std::int64_t{ 0 });
+ *
+ */
+template<std::random_access_iterator Iterator, typename T, typename BinaryOp = std::plus<>>
+T parallel_reduce(ST::ThreadPool& pool, Iterator first, Iterator last, T init, BinaryOp op = {}, std::size_t grain = 0)
+{
+  return parallel_transform_reduce(pool, first, last, std::move(init), std::move(op), std::identity{}, grain);
+}
+
+/**
+ * @brief 并行前缀和，out[i] = first[0] op ... op first[i]
+ * @example st::parallel_inclusive_scan(pool, sizes.begin(), sizes.end(), sizes.begin());
+ *
+ * @param out 可以等于first(原地扫描)，但不能和输入部分重叠
+ * @return OutputIterator 写入的最后一个元素之后
+ */
+template<std::random_access_iterator Iterator, std::random_access_iterator OutputIterator, typename BinaryOp = std::plus<>>
+OutputIterator parallel_inclusive_scan(ST::ThreadPool& pool, Iterator first, Iterator last, OutputIterator out,
+                                       BinaryOp op = {}, std::size_t grain = 0)
+{
+  using T = std::iter_value_t<Iterator>;
+  return detail::parallel::scan<true>(pool, first, last, out, std::optional<T>{}, op, grain);
+}
+
+/**
+ * @brief 并行前缀和，不包含当前元素，out[i] = init op first[0] op ... op first[i - 1]
+ * @example st::parallel_exclusive_scan(pool, sizes.begin(), sizes.end(), offsets.begin(), std::size_t{ 0 });
+ *
+ */
+template<std::random_access_iterator Iterator, std::random_access_iterator OutputIterator, typename T, typename BinaryOp = std::plus<>>
+OutputIterator parallel_exclusive_scan(ST::ThreadPool& pool, Iterator first, Iterator last, OutputIterator out,
+                                       T init, BinaryOp op = {}, std::size_t grain = 0)
+{
+  return detail::parallel::scan<false>(pool, first, last, out, std::optional<T>{ std::move(init) }, op, grain);
+}
+
+/**
+ * @brief 并行稳定划分，满足pred的元素移到前面，两部分内部都保持原来的相对顺序
+ * @example auto middle = st::parallel_stable_partition(pool, jobs.begin(), jobs.end(), &Job::ready);
+ *
+ * @details 每个元素只调用一次pred；先并行计算每块的计数，前缀和得到每块的写入位置，
+ * 再并行移动到缓冲区并移回，需要O(n)额外空间；元素不能默认构造时退化为std::stable_partition
+ * @return Iterator 第一个不满足pred的元素
+ */
+template<std::random_access_iterator Iterator, typename Predicate>
+Iterator parallel_stable_partition(ST::ThreadPool& pool, Iterator first, Iterator last, Predicate pred, std::size_t grain = 0)
+{
+  using Value = std::iter_value_t<Iterator>;
+
+  auto size = static_cast<std::size_t>(last - first);
+  grain = detail::parallel::grain_for(pool, size, grain);
+
+  if constexpr (!std::default_initializable<Value>) {
+    return std::stable_partition(first, last, std::ref(pred));
+  }
+  else {
+    if (size <= grain)
+      return std::stable_partition(first, last, std::ref(pred));
+
+    auto chunks = (size + grain - 1) / grain;
+    std::vector<unsigned char> flags(size);
+    std::vector<std::size_t> selected(chunks);
+
+    detail::parallel::for_each_chunk(pool, size, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+      std::size_t count = 0;
+      for (auto i = begin; i < end; ++i) {
+        flags[i] = static_cast<bool>(std::invoke(pred, first[static_cast<std::ptrdiff_t>(i)]));
+        count += flags[i];
+      }
+      selected[chunk] = count;
+    });
+
+    // selected改为每块之前满足pred的元素数
+    std::size_t total = 0;
+    for (auto& count: selected)
+      total += std::exchange(count, total);
+
+    std::vector<Value> buffer(size);
+    detail::parallel::for_each_chunk(pool, size, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+      auto accepted = selected[chunk];
+      auto rejected = total + (begin - selected[chunk]);
+      for (auto i = begin; i < end; ++i)
+        buffer[flags[i] ? accepted++ : rejected++] = std::move(first[static_cast<std::ptrdiff_t>(i)]);
+    });
+
+    detail::parallel::for_each_chunk(pool, size, grain, [&] (std::size_t, std::size_t begin, std::size_t end) {
+      std::move(buffer.begin() + static_cast<std::ptrdiff_t>(begin), buffer.begin() + static_cast<std::ptrdiff_t>(end),
+                first + static_cast<std::ptrdiff_t>(begin));
+    });
+
+    return first + static_cast<std::ptrdiff_t>(total);
+  }
+}
+
+/**
+ * @brief 并行选出按comp最小的k个元素
+ * @example auto slowest = st::parallel_top_k(pool, latencies.begin(), latencies.end(), 10, std::greater<>{});
+ *
+ * @details 每块用大小为k的堆选出候选，再从所有候选中选出结果，O(n log k)；相等的元素之间不保证稳定
+ * @return std::vector 按comp升序排列，元素数为min(k, last - first)
+ */
+template<std::random_access_iterator Iterator, typename Compare = std::less<>>
+std::vector<std::iter_value_t<Iterator>> parallel_top_k(ST::ThreadPool& pool, Iterator first, Iterator last, std::size_t k,
+                                                        Compare comp = {}, std::size_t grain = 0)
+{
+  auto size = static_cast<std::size_t>(last - first);
+  grain = std::max(detail::parallel::grain_for(pool, size, grain), k);
+
+  std::vector<std::iter_value_t<Iterator>> result{};
+  if (k == 0)
+    return result;
+
+  if (size <= grain) {
+    result = detail::parallel::top_k_heap(first, last, k, comp);
+  }
+  else {
+    std::vector<decltype(result)> candidates((size + grain - 1) / grain);
+    detail::parallel::for_each_chunk(pool, size, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+      candidates[chunk] = detail::parallel::top_k_heap(first + static_cast<std::ptrdiff_t>(begin),
+                                                       first + static_cast<std::ptrdiff_t>(end), k, comp);
+    });
+
+    std::vector<std::iter_value_t<Iterator>> merged{};
+    merged.reserve(candidates.size() * k);
+    for (auto& candidate: candidates)
+      std::move(candidate.begin(), candidate.end(), std::back_inserter(merged));
+
+    result = detail::parallel::top_k_heap(merged.begin(), merged.end(), k, comp);
+  }
+
+  std::sort_heap(result.begin(), result.end(), comp);
+  return result;
+}
+
+
+/**
+ * @brief 败者树，k路归并时每输出一个元素只需要log(k)次比较，比堆少一半
+ *
+ * @details 树只保存数据源的编号，数据由调用者管理: less(i, j)比较数据源i和j的当前元素，
+ * exhausted(i)表示数据源i已经取完；取完的数据源总是输，相等时编号小的赢，归并是稳定的
+ * @example
+ * st::LoserTree tree{ runs.size(), less, exhausted };
+ * for (; !tree.empty(); tree.replay()) { auto i = tree.top(); ...; ++runs[i].first; }
+ */
+template<typename Less, typename Exhausted>
+class LoserTree {
+public:
+  LoserTree(std::size_t k, Less less, Exhausted exhausted)
+    : k_{ k },
+      less_{ std::move(less) },
+      exhausted_{ std::move(exhausted) },
+      losers_(std::max<std::size_t>(k, 1), 0)
+  {
+    if (k_ == 0)
+      return;
+
+    // 叶子i在k + i，节点n的子节点为2n和2n + 1，自底向上比赛一次
+    std::vector<std::size_t> winners(2 * k_);
+    for (std::size_t i = 0; i < k_; ++i)
+      winners[k_ + i] = i;
+
+    for (auto node = k_ - 1; node >= 1; --node) {
+      auto left = winners[2 * node];
+      auto right = winners[2 * node + 1];
+      auto left_wins = beats(left, right);
+      winners[node] = left_wins ? left : right;
+      losers_[node] = left_wins ? right : left;
+    }
+
+    losers_[0] = winners[1];
+  }
+
+  // 当前最小元素所在的数据源
+  std::size_t top() const noexcept { return losers_[0]; }
+
+  bool empty() const { return k_ == 0 || exhausted_(losers_[0]); }
+
+  std::size_t size() const noexcept { return k_; }
+
+  /**
+   * @brief 调用者前进了top()数据源之后，沿着它到根的路径重新比赛
+   *
+   */
+  void replay()
+  {
+    auto winner = losers_[0];
+    for (auto node = (winner + k_) / 2; node >= 1; node /= 2) {
+      if (beats(losers_[node], winner))
+        std::swap(losers_[node], winner);
+    }
+
+    losers_[0] = winner;
+  }
+
+private:
+  std::size_t k_;
+  Less less_;
+  Exhausted exhausted_;
+  // losers_[0]为胜者，losers_[1..k)为每个内部节点的败者
+  std::vector<std::size_t> losers_;
+
+  bool beats(std::size_t a, std::size_t b) const
+  {
+    if (exhausted_(a))
+      return false;
+    if (exhausted_(b))
+      return true;
+
+    return less_(a, b) || (!less_(b, a) && a < b);
+  }
+};
+
+/**
+ * @brief k路归并，相等的元素按所在run的顺序输出
+ * @example st::kway_merge(runs, std::back_inserter(merged));  // runs为std::vector<std::pair<Iterator, Iterator>>
+ *
+ * @param runs 每个run为[first, last)，各自按comp有序
+ * @return OutputIterator 写入的最后一个元素之后
+ */
+template<std::ranges::input_range Runs, typename OutputIterator, typename Compare = std::less<>>
+OutputIterator kway_merge(const Runs& runs, OutputIterator out, Compare comp = {})
+{
+  std::vector<std::ranges::range_value_t<Runs>> heads(std::ranges::begin(runs), std::ranges::end(runs));
+
+  LoserTree tree{
+    heads.size(),
+    [&heads, &comp] (std::size_t i, std::size_t j) { return static_cast<bool>(comp(*heads[i].first, *heads[j].first)); },
+    [&heads] (std::size_t i) { return heads[i].first == heads[i].second; }
+  };
+
+  for (; !tree.empty(); tree.replay()) {
+    auto& head = heads[tree.top()];
+    *out = *head.first;
+    ++out;
+    ++head.first;
+  }
+
+  return out;
 }
 
 } // namespace st
 
-#endif // STUDY_TOUR_ALGORITHM_H
\ No newline at end of file
+#endif // STUDY_TOUR_ALGORITHM_H
@@ -4,8 +4,19 @@
 #include <endian.h>
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
 #include <type_traits>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STUDY_TOUR_CAST_X86 1
+#endif
+
 #include "Global.h"
 #include "TypeTraits.h"
 
@@ -14,75 +25,168 @@ namespace st {
 
 namespace detail {
 
+/**
+ * @brief 字节逆序，C++23的std::byteswap之前用编译器内建函数，可以在编译期求值
+ *
+ * @tparam Integer
+ * @param integer
+ * @return Integer
+ */
+template<typename Integer>
+constexpr Integer byteswap(Integer integer) noexcept
+{
+  if constexpr (sizeof(Integer) == 1)
+    return integer;
+  else if constexpr (sizeof(Integer) == 2)
+    return static_cast<Integer>(__builtin_bswap16(static_cast<std::uint16_t>(integer)));
+  else if constexpr (sizeof(Integer) == 4)
+    return static_cast<Integer>(__builtin_bswap32(static_cast<std::uint32_t>(integer)));
+  else
+    return static_cast<Integer>(__builtin_bswap64(static_cast<std::uint64_t>(integer)));
+}
+
 template<typename End, typename Integer,
       std::enable_if_t<std::is_integral_v<Integer>, bool> = true,
       is_end<End> = true>
 struct ByteOrderCast {
   /**
-   * @brief 8bit的整数无需转换
+   * @brief 网络字节序为Big Endian，Net和Host两个方向都是同一个操作，8bit的整数无需转换
    *
    * @param integer
    * @return Integer
    */
-  Integer operator()(Integer integer)
+  constexpr Integer operator()(Integer integer) const noexcept
   {
-    return integer;
+    if constexpr (std::endian::native == std::endian::big)
+      return integer;
+    else
+      return byteswap(integer);
   }
 };
 
-template<>
-struct ByteOrderCast<Net, uint16_t> {
-  uint16_t operator()(uint16_t integer)
-  {
-    // 网络字节序为Big Endian
-    return htobe16(integer);
-  }
-};
 
-template<>
-struct ByteOrderCast<Net, uint32_t> {
-  uint32_t operator()(uint32_t integer)
-  {
-    // 网络字节序为Big Endian
-    return htobe32(integer);
+// 标量实现，同时处理SIMD剩下的尾部
+template<typename Integer>
+void byteswap_scalar(const Integer* from, Integer* to, std::size_t count) noexcept
+{
+  for (std::size_t i = 0; i < count; ++i)
+    to[i] = byteswap(from[i]);
+}
+
+#ifdef STUDY_TOUR_CAST_X86
+
+// pshufb的掩码: 每个Size字节的元素在128位内逆序
+template<std::size_t Size>
+__attribute__((target("ssse3")))
+inline __m128i byteswap_mask() noexcept
+{
+  if constexpr (Size == 2)
+    return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  else if constexpr (Size == 4)
+    return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  else
+    return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+}
+
+template<typename Integer>
+__attribute__((target("ssse3")))
+void byteswap_ssse3(const Integer* from, Integer* to, std::size_t count) noexcept
+{
+  constexpr std::size_t LANES = sizeof(__m128i) / sizeof(Integer);
+  auto mask = byteswap_mask<sizeof(Integer)>();
+
+  std::size_t i = 0;
+  for (; i + LANES <= count; i += LANES) {
+    auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), _mm_shuffle_epi8(value, mask));
   }
-};
 
-template<>
-struct ByteOrderCast<Net, uint64_t> {
-  uint64_t operator()(uint64_t integer)
-  {
-    // 网络字节序为Big Endian
-    return htobe64(integer);
+  byteswap_scalar(from + i, to + i, count - i);
+}
+
+template<typename Integer>
+__attribute__((target("avx2")))
+void byteswap_avx2(const Integer* from, Integer* to, std::size_t count) noexcept
+{
+  constexpr std::size_t LANES = sizeof(__m256i) / sizeof(Integer);
+  // vpshufb只在128位的lane内重排，两个lane用同一个掩码
+  auto mask = _mm256_broadcastsi128_si256(byteswap_mask<sizeof(Integer)>());
+
+  std::size_t i = 0;
+  // 展开一次，两次load之间没有依赖
+  for (; i + 2 * LANES <= count; i += 2 * LANES) {
+    auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+    auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i + LANES));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), _mm256_shuffle_epi8(first, mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i + LANES), _mm256_shuffle_epi8(second, mask));
   }
-};
 
-template<>
-struct ByteOrderCast<Host, uint16_t> {
-  uint16_t operator()(uint16_t integer)
-  {
-    // 网络字节序为Big Endian
-    return be16toh(integer);
+  for (; i + LANES <= count; i += LANES) {
+    auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), _mm256_shuffle_epi8(value, mask));
   }
+
+  byteswap_scalar(from + i, to + i, count - i);
+}
+
+#endif // STUDY_TOUR_CAST_X86
+
+enum class SimdLevel {
+  Scalar,
+  SSSE3,
+  AVX2
 };
 
-template<>
-struct ByteOrderCast<Host, uint32_t> {
-  uint32_t operator()(uint32_t integer)
-  {
-    // 网络字节序为Big Endian
-    return be32toh(integer);
+/**
+ * @brief 运行时检测到的指令集，只检测一次
+ *
+ * @return SimdLevel
+ */
+inline SimdLevel simd_level() noexcept
+{
+#ifdef STUDY_TOUR_CAST_X86
+  static const SimdLevel level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+      return SimdLevel::SSSE3;
+    return SimdLevel::Scalar;
+  }();
+
+  return level;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
+
+/**
+ * @brief 批量字节逆序，from和to可以相同(原地转换)，但不能部分重叠
+ *
+ * @param level 使用的指令集，不能高于simd_level()
+ */
+template<typename Integer>
+void byteswap(const Integer* from, Integer* to, std::size_t count, SimdLevel level) noexcept
+{
+  if constexpr (sizeof(Integer) == 1) {
+    if (from != to)
+      std::copy(from, from + count, to);
   }
-};
+  else {
+#ifdef STUDY_TOUR_CAST_X86
+    switch (level) {
+    case SimdLevel::AVX2:
+      return byteswap_avx2(from, to, count);
+    case SimdLevel::SSSE3:
+      return byteswap_ssse3(from, to, count);
+    default:
+      break;
+    }
+#endif
 
-template<>
-struct ByteOrderCast<Host, uint64_t> {
-  uint64_t operator()(uint64_t integer)
-  {
-    // 网络字节序为Big Endian
-    return be64toh(integer);
+    byteswap_scalar(from, to, count);
   }
-};
+}
 
 } // namespace st::detail
 
@@ -113,11 +217,52 @@ To* c_ptr_cast(From* from)
 template<typename End, typename Integer,
       std::enable_if_t<std::is_integral_v<Integer>, bool> = true,
       is_end<End> = true>
-Integer byte_order_cast(Integer integer)
+constexpr Integer byte_order_cast(Integer integer) noexcept
 {
   return detail::ByteOrderCast<End, Integer>{}(integer);
 }
 
+/**
+ * @brief 批量字节序转换，运行时选择AVX2/SSSE3/标量实现
+ * @example st::byte_order_cast<st::Net>(std::span{ host_column }, std::span{ net_column });
+ *
+ * @tparam End
+ * @param from 待转换的数组
+ * @param to 转换结果，长度不能小于from，可以和from是同一个数组，但不能部分重叠
+ * @exception std::length_error to比from短
+ */
+template<typename End, typename From, std::size_t FromExtent, typename To, std::size_t ToExtent,
+      std::enable_if_t<std::is_integral_v<To> && std::is_same_v<std::remove_const_t<From>, To>, bool> = true,
+      is_end<End> = true>
+void byte_order_cast(std::span<From, FromExtent> from, std::span<To, ToExtent> to)
+{
+  if (to.size() < from.size())
+    throw std::length_error{ "byte order cast destination is shorter than source" };
+
+  if constexpr (std::endian::native == std::endian::big) {
+    if (from.data() != to.data())
+      std::copy(from.begin(), from.end(), to.begin());
+  }
+  else {
+    detail::byteswap(from.data(), to.data(), from.size(), detail::simd_level());
+  }
+}
+
+/**
+ * @brief 原地批量字节序转换
+ * @example st::byte_order_cast<st::Host>(std::span{ column });
+ *
+ * @tparam End
+ * @param integers
+ */
+template<typename End, typename Integer, std::size_t Extent,
+      std::enable_if_t<std::is_integral_v<Integer> && !std::is_const_v<Integer>, bool> = true,
+      is_end<End> = true>
+void byte_order_cast(std::span<Integer, Extent> integers)
+{
+  byte_order_cast<End>(std::span<const Integer, Extent>{ integers }, integers);
+}
+
 } // namespace st
 
-#endif // STUDY_TOUR_CAST_H
\ No newline at end of file
+#endif // STUDY_TOUR_CAST_H
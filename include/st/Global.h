@@ -1,8 +1,9 @@
-#ifndef STUDY_TOUR_GLOBAL_H
-#define STUDY_TOUR_GLOBAL_H
+#ifndef STUDY_TOUR_ST_GLOBAL_H
+#define STUDY_TOUR_ST_GLOBAL_H
 
 #include <netinet/in.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 
 #include <string>
 #include <cstddef>
@@ -44,15 +45,15 @@ constexpr static int MAX_BUFFER = 4096;
 
 constexpr static int MAX_LINE = 4096;
 
-template<EnumType T>
+template<enum_type T>
 int to_int(T enum_value);
 
-template<EnumType T>
+template<enum_type T>
 std::string to_string(T enum_value);
 
 
 template<>
-int to_int(net::Family family)
+inline int to_int(net::Family family)
 {
   switch (family) {
   case net::Family::IPv4:
@@ -65,7 +66,7 @@ int to_int(net::Family family)
 }
 
 template<>
-int to_int(net::Type type)
+inline int to_int(net::Type type)
 {
   switch (type) {
   case net::Type::TCP:
@@ -78,7 +79,7 @@ int to_int(net::Type type)
 }
 
 template<>
-int to_int(net::Protocol protocol)
+inline int to_int(net::Protocol protocol)
 {
   switch (protocol) {
   case net::Protocol::Undefined:
@@ -88,7 +89,7 @@ int to_int(net::Protocol protocol)
 }
 
 template<>
-std::string to_string(net::Family family)
+inline std::string to_string(net::Family family)
 {
   switch (family) {
   case net::Family::IPv4:
@@ -101,7 +102,7 @@ std::string to_string(net::Family family)
 }
 
 template<>
-std::string to_string(net::Type type)
+inline std::string to_string(net::Type type)
 {
   switch (type) {
   case net::Type::TCP:
@@ -114,7 +115,7 @@ std::string to_string(net::Type type)
 }
 
 template<>
-std::string to_string(net::Protocol protocol)
+inline std::string to_string(net::Protocol protocol)
 {
   switch (protocol) {
   case net::Protocol::Undefined:
@@ -125,4 +126,4 @@ std::string to_string(net::Protocol protocol)
 
 } // namespace st
 
-#endif // STUDY_TOUR_GLOBAL_H
\ No newline at end of file
+#endif // STUDY_TOUR_ST_GLOBAL_H
\ No newline at end of file
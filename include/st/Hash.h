@@ -0,0 +1,707 @@
+/**
+ * @file Hash.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 校验和与哈希: CRC32C、XXH64、XXH3，运行时按CPU选择SSE4.2/PCLMUL/AVX2实现
+ * @version 0.1
+ * @date 2022-07-29
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_HASH_H
+#define STUDY_TOUR_HASH_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#include "Cast.h"
+
+#ifdef STUDY_TOUR_CAST_X86
+#include <immintrin.h>
+#endif
+
+
+namespace st::hash {
+
+namespace detail {
+
+// 按小端读取，大端机器上逆序
+template<typename Integer>
+inline Integer read_le(const std::byte* data) noexcept
+{
+  Integer value;
+  std::memcpy(&value, data, sizeof(Integer));
+  if constexpr (std::endian::native == std::endian::big)
+    value = st::detail::byteswap(value);
+  return value;
+}
+
+inline std::uint64_t mul128_fold64(std::uint64_t lhs, std::uint64_t rhs) noexcept
+{
+  auto product = static_cast<unsigned __int128>(lhs) * rhs;
+  return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+}
+
+
+// ---------------------------------------- CRC32C ----------------------------------------
+
+// Castagnoli多项式0x1EDC6F41按位反转
+constexpr static std::uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+enum class CrcLevel {
+  // 查表，每次8字节(slicing-by-8)
+  Software,
+  // crc32指令，单条依赖链
+  SSE42,
+  // 三条crc32依赖链并行，用pclmulqdq合并
+  PCLMUL
+};
+
+/**
+ * @brief 运行时检测到的CRC指令集，只检测一次
+ *
+ * @return CrcLevel
+ */
+inline CrcLevel crc_level() noexcept
+{
+#ifdef STUDY_TOUR_CAST_X86
+  static const CrcLevel level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul"))
+      return CrcLevel::PCLMUL;
+    if (__builtin_cpu_supports("sse4.2"))
+      return CrcLevel::SSE42;
+    return CrcLevel::Software;
+  }();
+
+  return level;
+#else
+  return CrcLevel::Software;
+#endif
+}
+
+constexpr std::array<std::array<std::uint32_t, 256>, 8> make_crc32c_tables() noexcept
+{
+  std::array<std::array<std::uint32_t, 256>, 8> tables{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    auto crc = i;
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+    tables[0][i] = crc;
+  }
+
+  // tables[k][i]: 字节i之后再跟k个0字节的CRC
+  for (std::size_t k = 1; k < 8; ++k)
+    for (std::uint32_t i = 0; i < 256; ++i)
+      tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+
+  return tables;
+}
+
+inline constexpr auto CRC32C_TABLES = make_crc32c_tables();
+
+// 以下的crc都是未取反的寄存器值
+inline std::uint32_t crc32c_software(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept
+{
+  auto& t = CRC32C_TABLES;
+  for (; size >= 8; data += 8, size -= 8) {
+    auto low = read_le<std::uint32_t>(data) ^ crc;
+    auto high = read_le<std::uint32_t>(data + 4);
+    crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+          t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+  }
+
+  for (; size > 0; ++data, --size)
+    crc = (crc >> 8) ^ t[0][(crc ^ std::to_integer<std::uint32_t>(*data)) & 0xFF];
+
+  return crc;
+}
+
+/**
+ * @brief x^exponent mod P，按位反转表示
+ *
+ * @details 用于把一段数据的CRC"平移"过后面若干字节，只在编译期计算常量
+ */
+constexpr std::uint32_t crc32c_x_pow(std::uint64_t exponent) noexcept
+{
+  // 反转表示中最高位是x^0
+  std::uint32_t value = 0x80000000;
+  for (; exponent > 0; --exponent)
+    value = (value & 1) ? (value >> 1) ^ CRC32C_POLYNOMIAL : value >> 1;
+  return value;
+}
+
+#ifdef STUDY_TOUR_CAST_X86
+
+__attribute__((target("sse4.2")))
+inline std::uint32_t crc32c_sse42(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept
+{
+  std::uint64_t crc64 = crc;
+  for (; size >= 8; data += 8, size -= 8)
+    crc64 = _mm_crc32_u64(crc64, read_le<std::uint64_t>(data));
+
+  crc = static_cast<std::uint32_t>(crc64);
+  for (; size > 0; ++data, --size)
+    crc = _mm_crc32_u8(crc, std::to_integer<std::uint8_t>(*data));
+
+  return crc;
+}
+
+/**
+ * @brief 把3 * Block字节分成三段，三条crc32依赖链交错执行
+ *
+ * @details crc32指令延迟3个周期、吞吐1个周期，单条链只用到1/3的吞吐。
+ * 三段的CRC分别为a、b、c，整段的CRC = a * x^(16 * Block) + b * x^(8 * Block) + c (mod P)。
+ * 对反转表示，clmul(a, x^(n - 33))再经过一次crc32(0, ·)正好得到a * x^n mod P
+ */
+template<std::size_t Block>
+__attribute__((target("sse4.2,pclmul")))
+inline std::uint32_t crc32c_3way(std::uint32_t crc, const std::byte* data) noexcept
+{
+  constexpr std::uint32_t SHIFT_2 = crc32c_x_pow(16 * Block - 33);
+  constexpr std::uint32_t SHIFT_1 = crc32c_x_pow(8 * Block - 33);
+
+  std::uint64_t a = crc;
+  std::uint64_t b = 0;
+  std::uint64_t c = 0;
+  for (std::size_t i = 0; i < Block; i += 8) {
+    a = _mm_crc32_u64(a, read_le<std::uint64_t>(data + i));
+    b = _mm_crc32_u64(b, read_le<std::uint64_t>(data + Block + i));
+    c = _mm_crc32_u64(c, read_le<std::uint64_t>(data + 2 * Block + i));
+  }
+
+  auto shifted_a = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(a)), _mm_cvtsi32_si128(static_cast<int>(SHIFT_2)), 0x00);
+  auto shifted_b = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(b)), _mm_cvtsi32_si128(static_cast<int>(SHIFT_1)), 0x00);
+  auto folded = static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_xor_si128(shifted_a, shifted_b)));
+
+  return static_cast<std::uint32_t>(_mm_crc32_u64(0, folded) ^ c);
+}
+
+__attribute__((target("sse4.2,pclmul")))
+inline std::uint32_t crc32c_pclmul(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept
+{
+  // 大块摊销合并的开销，小块让中等长度的数据也能并行
+  constexpr std::size_t LONG_BLOCK = 8192;
+  constexpr std::size_t SHORT_BLOCK = 256;
+
+  for (; size >= 3 * LONG_BLOCK; data += 3 * LONG_BLOCK, size -= 3 * LONG_BLOCK)
+    crc = crc32c_3way<LONG_BLOCK>(crc, data);
+
+  for (; size >= 3 * SHORT_BLOCK; data += 3 * SHORT_BLOCK, size -= 3 * SHORT_BLOCK)
+    crc = crc32c_3way<SHORT_BLOCK>(crc, data);
+
+  return crc32c_sse42(crc, data, size);
+}
+
+#endif // STUDY_TOUR_CAST_X86
+
+/**
+ * @brief 更新CRC32C寄存器
+ *
+ * @param level 使用的指令集，不能高于crc_level()
+ */
+inline std::uint32_t crc32c(std::uint32_t crc, const std::byte* data, std::size_t size, CrcLevel level) noexcept
+{
+#ifdef STUDY_TOUR_CAST_X86
+  switch (level) {
+  case CrcLevel::PCLMUL:
+    return crc32c_pclmul(crc, data, size);
+  case CrcLevel::SSE42:
+    return crc32c_sse42(crc, data, size);
+  default:
+    break;
+  }
+#endif
+
+  return crc32c_software(crc, data, size);
+}
+
+
+// ---------------------------------------- xxHash ----------------------------------------
+
+constexpr static std::uint32_t PRIME32_1 = 0x9E3779B1U;
+constexpr static std::uint32_t PRIME32_2 = 0x85EBCA77U;
+constexpr static std::uint32_t PRIME32_3 = 0xC2B2AE3DU;
+constexpr static std::uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr static std::uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr static std::uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr static std::uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr static std::uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+constexpr static std::uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+constexpr static std::uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+inline std::uint64_t xxh64_round(std::uint64_t acc, std::uint64_t input) noexcept
+{
+  acc += input * PRIME64_2;
+  acc = std::rotl(acc, 31);
+  return acc * PRIME64_1;
+}
+
+inline std::uint64_t xxh64_merge_round(std::uint64_t acc, std::uint64_t value) noexcept
+{
+  acc ^= xxh64_round(0, value);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+inline std::uint64_t xxh64_avalanche(std::uint64_t hash) noexcept
+{
+  hash ^= hash >> 33;
+  hash *= PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= PRIME64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+inline std::uint64_t xxh64(const std::byte* data, std::size_t size, std::uint64_t seed) noexcept
+{
+  auto end = data + size;
+  std::uint64_t hash;
+
+  if (size >= 32) {
+    std::uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+    std::uint64_t v2 = seed + PRIME64_2;
+    std::uint64_t v3 = seed;
+    std::uint64_t v4 = seed - PRIME64_1;
+
+    for (; end - data >= 32; data += 32) {
+      v1 = xxh64_round(v1, read_le<std::uint64_t>(data));
+      v2 = xxh64_round(v2, read_le<std::uint64_t>(data + 8));
+      v3 = xxh64_round(v3, read_le<std::uint64_t>(data + 16));
+      v4 = xxh64_round(v4, read_le<std::uint64_t>(data + 24));
+    }
+
+    hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+    hash = xxh64_merge_round(hash, v1);
+    hash = xxh64_merge_round(hash, v2);
+    hash = xxh64_merge_round(hash, v3);
+    hash = xxh64_merge_round(hash, v4);
+  }
+  else {
+    hash = seed + PRIME64_5;
+  }
+
+  hash += size;
+
+  for (; end - data >= 8; data += 8) {
+    hash ^= xxh64_round(0, read_le<std::uint64_t>(data));
+    hash = std::rotl(hash, 27) * PRIME64_1 + PRIME64_4;
+  }
+
+  if (end - data >= 4) {
+    hash ^= static_cast<std::uint64_t>(read_le<std::uint32_t>(data)) * PRIME64_1;
+    hash = std::rotl(hash, 23) * PRIME64_2 + PRIME64_3;
+    data += 4;
+  }
+
+  for (; data != end; ++data) {
+    hash ^= std::to_integer<std::uint64_t>(*data) * PRIME64_5;
+    hash = std::rotl(hash, 11) * PRIME64_1;
+  }
+
+  return xxh64_avalanche(hash);
+}
+
+
+// XXH3默认的192字节secret
+alignas(64) inline constexpr std::uint8_t XXH3_SECRET[192] = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+enum class XxhLevel {
+  Scalar,
+  // x86-64的基线，不需要检测
+  SSE2,
+  AVX2
+};
+
+/**
+ * @brief 运行时检测到的XXH3累加指令集，只检测一次
+ *
+ * @return XxhLevel
+ */
+inline XxhLevel xxh3_level() noexcept
+{
+#ifdef STUDY_TOUR_CAST_X86
+  static const XxhLevel level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return XxhLevel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+      return XxhLevel::SSE2;
+    return XxhLevel::Scalar;
+  }();
+
+  return level;
+#else
+  return XxhLevel::Scalar;
+#endif
+}
+
+constexpr static std::size_t XXH3_SECRET_SIZE = sizeof(XXH3_SECRET);
+constexpr static std::size_t XXH3_STRIPE_LENGTH = 64;
+constexpr static std::size_t XXH3_SECRET_CONSUME_RATE = 8;
+constexpr static std::size_t XXH3_STRIPES_PER_BLOCK = (XXH3_SECRET_SIZE - XXH3_STRIPE_LENGTH) / XXH3_SECRET_CONSUME_RATE;
+constexpr static std::size_t XXH3_BLOCK_LENGTH = XXH3_STRIPE_LENGTH * XXH3_STRIPES_PER_BLOCK;
+
+inline const std::byte* xxh3_default_secret() noexcept
+{
+  return reinterpret_cast<const std::byte*>(XXH3_SECRET);
+}
+
+inline std::uint64_t xxh3_avalanche(std::uint64_t hash) noexcept
+{
+  hash ^= hash >> 37;
+  hash *= PRIME_MX1;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+inline std::uint64_t xxh3_rrmxmx(std::uint64_t hash, std::uint64_t size) noexcept
+{
+  hash ^= std::rotl(hash, 49) ^ std::rotl(hash, 24);
+  hash *= PRIME_MX2;
+  hash ^= (hash >> 35) + size;
+  hash *= PRIME_MX2;
+  hash ^= hash >> 28;
+  return hash;
+}
+
+inline std::uint64_t xxh3_mix16(const std::byte* data, const std::byte* secret, std::uint64_t seed) noexcept
+{
+  return mul128_fold64(read_le<std::uint64_t>(data) ^ (read_le<std::uint64_t>(secret) + seed),
+                       read_le<std::uint64_t>(data + 8) ^ (read_le<std::uint64_t>(secret + 8) - seed));
+}
+
+// 0到16字节，哈希表的大部分key都在这里
+inline std::uint64_t xxh3_0to16(const std::byte* data, std::size_t size, const std::byte* secret, std::uint64_t seed) noexcept
+{
+  if (size > 8) {
+    auto bitflip1 = (read_le<std::uint64_t>(secret + 24) ^ read_le<std::uint64_t>(secret + 32)) + seed;
+    auto bitflip2 = (read_le<std::uint64_t>(secret + 40) ^ read_le<std::uint64_t>(secret + 48)) - seed;
+    auto low = read_le<std::uint64_t>(data) ^ bitflip1;
+    auto high = read_le<std::uint64_t>(data + size - 8) ^ bitflip2;
+    auto acc = size + st::detail::byteswap(low) + high + mul128_fold64(low, high);
+    return xxh3_avalanche(acc);
+  }
+
+  if (size >= 4) {
+    seed ^= static_cast<std::uint64_t>(st::detail::byteswap(static_cast<std::uint32_t>(seed))) << 32;
+    auto first = read_le<std::uint32_t>(data);
+    auto last = read_le<std::uint32_t>(data + size - 4);
+    auto bitflip = (read_le<std::uint64_t>(secret + 8) ^ read_le<std::uint64_t>(secret + 16)) - seed;
+    auto input = last + (static_cast<std::uint64_t>(first) << 32);
+    return xxh3_rrmxmx(input ^ bitflip, size);
+  }
+
+  if (size > 0) {
+    auto c1 = std::to_integer<std::uint32_t>(data[0]);
+    auto c2 = std::to_integer<std::uint32_t>(data[size >> 1]);
+    auto c3 = std::to_integer<std::uint32_t>(data[size - 1]);
+    auto combined = (c1 << 16) | (c2 << 24) | c3 | (static_cast<std::uint32_t>(size) << 8);
+    auto bitflip = (read_le<std::uint32_t>(secret) ^ read_le<std::uint32_t>(secret + 4)) + seed;
+    return xxh64_avalanche(static_cast<std::uint64_t>(combined) ^ bitflip);
+  }
+
+  return xxh64_avalanche(seed ^ read_le<std::uint64_t>(secret + 56) ^ read_le<std::uint64_t>(secret + 64));
+}
+
+inline std::uint64_t xxh3_17to128(const std::byte* data, std::size_t size, const std::byte* secret, std::uint64_t seed) noexcept
+{
+  std::uint64_t acc = size * PRIME64_1;
+  if (size > 32) {
+    if (size > 64) {
+      if (size > 96) {
+        acc += xxh3_mix16(data + 48, secret + 96, seed);
+        acc += xxh3_mix16(data + size - 64, secret + 112, seed);
+      }
+      acc += xxh3_mix16(data + 32, secret + 64, seed);
+      acc += xxh3_mix16(data + size - 48, secret + 80, seed);
+    }
+    acc += xxh3_mix16(data + 16, secret + 32, seed);
+    acc += xxh3_mix16(data + size - 32, secret + 48, seed);
+  }
+  acc += xxh3_mix16(data, secret, seed);
+  acc += xxh3_mix16(data + size - 16, secret + 16, seed);
+
+  return xxh3_avalanche(acc);
+}
+
+inline std::uint64_t xxh3_129to240(const std::byte* data, std::size_t size, const std::byte* secret, std::uint64_t seed) noexcept
+{
+  constexpr std::size_t START_OFFSET = 3;
+  constexpr std::size_t LAST_OFFSET = 17;
+  constexpr std::size_t SECRET_SIZE_MIN = 136;
+
+  std::uint64_t acc = size * PRIME64_1;
+  for (std::size_t i = 0; i < 8; ++i)
+    acc += xxh3_mix16(data + 16 * i, secret + 16 * i, seed);
+  acc = xxh3_avalanche(acc);
+
+  auto rounds = size / 16;
+  for (std::size_t i = 8; i < rounds; ++i)
+    acc += xxh3_mix16(data + 16 * i, secret + 16 * (i - 8) + START_OFFSET, seed);
+  acc += xxh3_mix16(data + size - 16, secret + SECRET_SIZE_MIN - LAST_OFFSET, seed);
+
+  return xxh3_avalanche(acc);
+}
+
+// 超过240字节时，8个64位累加器按64字节一个stripe处理，每个block之后打散一次
+inline void xxh3_accumulate_scalar(std::uint64_t* acc, const std::byte* data, const std::byte* secret) noexcept
+{
+  for (std::size_t i = 0; i < 8; ++i) {
+    auto value = read_le<std::uint64_t>(data + 8 * i);
+    auto key = value ^ read_le<std::uint64_t>(secret + 8 * i);
+    acc[i ^ 1] += value;
+    acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+  }
+}
+
+inline void xxh3_scramble_scalar(std::uint64_t* acc, const std::byte* secret) noexcept
+{
+  for (std::size_t i = 0; i < 8; ++i) {
+    auto value = acc[i];
+    value ^= value >> 47;
+    value ^= read_le<std::uint64_t>(secret + 8 * i);
+    acc[i] = value * PRIME32_1;
+  }
+}
+
+#ifdef STUDY_TOUR_CAST_X86
+
+__attribute__((target("sse2")))
+inline void xxh3_accumulate_sse2(std::uint64_t* acc, const std::byte* data, const std::byte* secret) noexcept
+{
+  auto accumulators = reinterpret_cast<__m128i*>(acc);
+  for (std::size_t i = 0; i < 4; ++i) {
+    auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+    auto key = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+    // 每个64位lane的低32位乘高32位
+    auto product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+    // 相邻两个lane交换后累加原始数据
+    auto swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+    auto sum = _mm_add_epi64(_mm_loadu_si128(accumulators + i), swapped);
+    _mm_storeu_si128(accumulators + i, _mm_add_epi64(product, sum));
+  }
+}
+
+__attribute__((target("sse2")))
+inline void xxh3_scramble_sse2(std::uint64_t* acc, const std::byte* secret) noexcept
+{
+  auto accumulators = reinterpret_cast<__m128i*>(acc);
+  auto prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+  for (std::size_t i = 0; i < 4; ++i) {
+    auto value = _mm_loadu_si128(accumulators + i);
+    value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+    auto key = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+    // 64位乘32位拆成低32位和高32位两次乘法
+    auto low = _mm_mul_epu32(key, prime);
+    auto high = _mm_mul_epu32(_mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+    _mm_storeu_si128(accumulators + i, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+  }
+}
+
+__attribute__((target("avx2")))
+inline void xxh3_accumulate_avx2(std::uint64_t* acc, const std::byte* data, const std::byte* secret) noexcept
+{
+  auto accumulators = reinterpret_cast<__m256i*>(acc);
+  for (std::size_t i = 0; i < 2; ++i) {
+    auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + i);
+    auto key = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+    auto product = _mm256_mul_epu32(key, _mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+    auto swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+    auto sum = _mm256_add_epi64(_mm256_loadu_si256(accumulators + i), swapped);
+    _mm256_storeu_si256(accumulators + i, _mm256_add_epi64(product, sum));
+  }
+}
+
+__attribute__((target("avx2")))
+inline void xxh3_scramble_avx2(std::uint64_t* acc, const std::byte* secret) noexcept
+{
+  auto accumulators = reinterpret_cast<__m256i*>(acc);
+  auto prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+  for (std::size_t i = 0; i < 2; ++i) {
+    auto value = _mm256_loadu_si256(accumulators + i);
+    value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+    auto key = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+    auto low = _mm256_mul_epu32(key, prime);
+    auto high = _mm256_mul_epu32(_mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+    _mm256_storeu_si256(accumulators + i, _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+  }
+}
+
+#endif // STUDY_TOUR_CAST_X86
+
+// Accumulate和Scramble在模板参数中，内层循环可以内联
+template<auto Accumulate, auto Scramble>
+inline std::uint64_t xxh3_long(const std::byte* data, std::size_t size, const std::byte* secret) noexcept
+{
+  constexpr std::size_t LAST_ACCUMULATE_START = 7;
+  constexpr std::size_t MERGE_ACCUMULATORS_START = 11;
+
+  alignas(64) std::uint64_t acc[8] = {
+    PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+  };
+
+  auto blocks = (size - 1) / XXH3_BLOCK_LENGTH;
+  for (std::size_t block = 0; block < blocks; ++block) {
+    auto input = data + block * XXH3_BLOCK_LENGTH;
+    for (std::size_t stripe = 0; stripe < XXH3_STRIPES_PER_BLOCK; ++stripe)
+      Accumulate(acc, input + stripe * XXH3_STRIPE_LENGTH, secret + stripe * XXH3_SECRET_CONSUME_RATE);
+    Scramble(acc, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LENGTH);
+  }
+
+  auto stripes = ((size - 1) - blocks * XXH3_BLOCK_LENGTH) / XXH3_STRIPE_LENGTH;
+  auto input = data + blocks * XXH3_BLOCK_LENGTH;
+  for (std::size_t stripe = 0; stripe < stripes; ++stripe)
+    Accumulate(acc, input + stripe * XXH3_STRIPE_LENGTH, secret + stripe * XXH3_SECRET_CONSUME_RATE);
+
+  // 最后一个stripe和前面的可能重叠
+  Accumulate(acc, data + size - XXH3_STRIPE_LENGTH, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LENGTH - LAST_ACCUMULATE_START);
+
+  std::uint64_t result = size * PRIME64_1;
+  for (std::size_t i = 0; i < 4; ++i) {
+    auto merge_secret = secret + MERGE_ACCUMULATORS_START + 16 * i;
+    result += mul128_fold64(acc[2 * i] ^ read_le<std::uint64_t>(merge_secret),
+                            acc[2 * i + 1] ^ read_le<std::uint64_t>(merge_secret + 8));
+  }
+
+  return xxh3_avalanche(result);
+}
+
+/**
+ * @brief XXH3 64位
+ *
+ * @param level 使用的指令集，不能高于xxh3_level()，只影响超过240字节的输入
+ */
+inline std::uint64_t xxh3(const std::byte* data, std::size_t size, std::uint64_t seed, XxhLevel level) noexcept
+{
+  auto secret = xxh3_default_secret();
+  if (size <= 16)
+    return xxh3_0to16(data, size, secret, seed);
+  if (size <= 128)
+    return xxh3_17to128(data, size, secret, seed);
+  if (size <= 240)
+    return xxh3_129to240(data, size, secret, seed);
+
+  // 有seed时由默认secret派生一个
+  alignas(64) std::byte custom[XXH3_SECRET_SIZE];
+  if (seed != 0) {
+    for (std::size_t i = 0; i < XXH3_SECRET_SIZE; i += 16) {
+      auto low = read_le<std::uint64_t>(secret + i) + seed;
+      auto high = read_le<std::uint64_t>(secret + i + 8) - seed;
+      if constexpr (std::endian::native == std::endian::big) {
+        low = st::detail::byteswap(low);
+        high = st::detail::byteswap(high);
+      }
+      std::memcpy(custom + i, &low, 8);
+      std::memcpy(custom + i + 8, &high, 8);
+    }
+    secret = custom;
+  }
+
+#ifdef STUDY_TOUR_CAST_X86
+  if constexpr (std::endian::native == std::endian::little) {
+    switch (level) {
+    case XxhLevel::AVX2:
+      return xxh3_long<xxh3_accumulate_avx2, xxh3_scramble_avx2>(data, size, secret);
+    case XxhLevel::SSE2:
+      return xxh3_long<xxh3_accumulate_sse2, xxh3_scramble_sse2>(data, size, secret);
+    default:
+      break;
+    }
+  }
+#endif
+
+  return xxh3_long<xxh3_accumulate_scalar, xxh3_scramble_scalar>(data, size, secret);
+}
+
+} // namespace detail
+
+
+/**
+ * @brief CRC32C(Castagnoli)，iSCSI/ext4/RocksDB等使用的校验和
+ *
+ * @details 运行时选择实现: SSE4.2 + PCLMUL时三路并行的crc32指令，只有SSE4.2时单路，否则查表。
+ * 可以分段计算: crc32c(b, crc32c(a)) == crc32c(a + b)
+ * @param data
+ * @param crc 之前的数据的CRC，第一段为0
+ * @return std::uint32_t
+ */
+inline std::uint32_t crc32c(std::span<const std::byte> data, std::uint32_t crc = 0) noexcept
+{
+  return ~detail::crc32c(~crc, data.data(), data.size(), detail::crc_level());
+}
+
+inline std::uint32_t crc32c(std::string_view data, std::uint32_t crc = 0) noexcept
+{
+  return crc32c(std::as_bytes(std::span{ data }), crc);
+}
+
+/**
+ * @brief XXH64，和官方实现的结果一致
+ *
+ * @param data
+ * @param seed
+ * @return std::uint64_t
+ */
+inline std::uint64_t xxh64(std::span<const std::byte> data, std::uint64_t seed = 0) noexcept
+{
+  return detail::xxh64(data.data(), data.size(), seed);
+}
+
+inline std::uint64_t xxh64(std::string_view data, std::uint64_t seed = 0) noexcept
+{
+  return xxh64(std::as_bytes(std::span{ data }), seed);
+}
+
+/**
+ * @brief XXH3 64位，和官方XXH3_64bits_withSeed的结果一致
+ *
+ * @details 短输入只有几次乘法，长输入运行时选择AVX2/SSE2/标量的累加
+ * @param data
+ * @param seed
+ * @return std::uint64_t
+ */
+inline std::uint64_t xxh3(std::span<const std::byte> data, std::uint64_t seed = 0) noexcept
+{
+  return detail::xxh3(data.data(), data.size(), seed, detail::xxh3_level());
+}
+
+inline std::uint64_t xxh3(std::string_view data, std::uint64_t seed = 0) noexcept
+{
+  return xxh3(std::as_bytes(std::span{ data }), seed);
+}
+
+/**
+ * @brief 字符串哈希函数对象，可以用std::string_view/const char*异构查找
+ *
+ */
+struct StringHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view string) const noexcept
+  {
+    return static_cast<std::size_t>(xxh3(string));
+  }
+};
+
+} // namespace st::hash
+
+#endif // STUDY_TOUR_HASH_H
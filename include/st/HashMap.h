@@ -0,0 +1,1279 @@
+/**
+ * @file HashMap.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 扁平的开放寻址哈希表(Swiss table风格)，以及按分片加锁的并发版本
+ * @version 0.1
+ * @date 2022-07-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_HASH_MAP_H
+#define STUDY_TOUR_HASH_MAP_H
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Hash.h"
+
+
+namespace st {
+
+/**
+ * @brief 哈希表默认的哈希函数，字符串类型用XXH3并支持用std::string_view/const char*异构查找
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Hash: std::hash<T> {};
+
+template<>
+struct Hash<std::string>: hash::StringHash {};
+
+template<>
+struct Hash<std::string_view>: hash::StringHash {};
+
+
+namespace detail::hash_table {
+
+// 控制字节: 最高位为1表示空位，否则低7位是哈希值的h2部分
+using ctrl_t = std::uint8_t;
+
+constexpr static ctrl_t EMPTY = 0x80;
+// 一次比较的控制字节数
+constexpr static std::size_t GROUP_WIDTH = 16;
+constexpr static std::size_t MIN_CAPACITY = GROUP_WIDTH;
+
+// 最大负载因子7/8
+constexpr std::size_t max_size_for(std::size_t capacity) noexcept
+{
+  return capacity - capacity / 8;
+}
+
+// 容纳size个元素需要的容量，总是2的幂
+constexpr std::size_t capacity_for(std::size_t size) noexcept
+{
+  if (size == 0)
+    return 0;
+
+  return std::bit_ceil(std::max(MIN_CAPACITY, size + (size + 6) / 7));
+}
+
+/**
+ * @brief 把用户的哈希值打散，std::hash<int>这样的恒等哈希也能均匀分布
+ *
+ * @details 64x64->128位乘法，高低两半异或
+ */
+inline std::uint64_t mix(std::size_t hash) noexcept
+{
+  auto product = static_cast<unsigned __int128>(hash) * 0x9E3779B97F4A7C15ull;
+  return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+}
+
+// 起始探测位置
+constexpr std::size_t h1(std::uint64_t hash) noexcept
+{
+  return static_cast<std::size_t>(hash >> 7);
+}
+
+// 存进控制字节的7位
+constexpr ctrl_t h2(std::uint64_t hash) noexcept
+{
+  return static_cast<ctrl_t>(hash & 0x7F);
+}
+
+/**
+ * @brief 一组GROUP_WIDTH个控制字节，每个匹配的字节对应掩码中的一位
+ *
+ */
+#ifdef __SSE2__
+
+struct Group {
+  __m128i ctrl;
+
+  explicit Group(const ctrl_t* position) noexcept
+    : ctrl{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(position)) }
+  {}
+
+  std::uint32_t match(ctrl_t hash) const noexcept
+  {
+    auto pattern = _mm_set1_epi8(static_cast<char>(hash));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(pattern, ctrl)));
+  }
+
+  // 空位的最高位是1，movemask直接得到掩码
+  std::uint32_t match_empty() const noexcept
+  {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+  }
+
+  std::uint32_t match_full() const noexcept
+  {
+    return match_empty() ^ 0xFFFF;
+  }
+};
+
+#else
+
+struct Group {
+  ctrl_t ctrl[GROUP_WIDTH];
+
+  explicit Group(const ctrl_t* position) noexcept
+  {
+    std::memcpy(ctrl, position, GROUP_WIDTH);
+  }
+
+  std::uint32_t match(ctrl_t hash) const noexcept
+  {
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+      mask |= static_cast<std::uint32_t>(ctrl[i] == hash) << i;
+
+    return mask;
+  }
+
+  std::uint32_t match_empty() const noexcept
+  {
+    return match(EMPTY);
+  }
+
+  std::uint32_t match_full() const noexcept
+  {
+    return match_empty() ^ 0xFFFF;
+  }
+};
+
+#endif // __SSE2__
+
+
+template<typename Key>
+struct SetPolicy {
+  using key_type = Key;
+  using value_type = Key;
+  using slot_type = Key;
+
+  constexpr static bool CONST_ITERATOR = true;
+
+  static const Key& key(const slot_type& slot) noexcept { return slot; }
+
+  // 从src移动到dst并析构src
+  template<typename Allocator>
+  static void transfer(Allocator& allocator, slot_type* dst, slot_type* src)
+  {
+    std::allocator_traits<Allocator>::construct(allocator, dst, std::move(*src));
+    std::allocator_traits<Allocator>::destroy(allocator, src);
+  }
+};
+
+template<typename Key, typename Value>
+struct MapPolicy {
+  using key_type = Key;
+  using value_type = std::pair<const Key, Value>;
+  using slot_type = value_type;
+
+  constexpr static bool CONST_ITERATOR = false;
+
+  static const Key& key(const slot_type& slot) noexcept { return slot.first; }
+
+  // key是const的，移动前去掉const，原来的元素马上就会析构
+  template<typename Allocator>
+  static void transfer(Allocator& allocator, slot_type* dst, slot_type* src)
+  {
+    std::allocator_traits<Allocator>::construct(allocator, dst,
+                                                std::piecewise_construct,
+                                                std::forward_as_tuple(std::move(const_cast<Key&>(src->first))),
+                                                std::forward_as_tuple(std::move(src->second)));
+    std::allocator_traits<Allocator>::destroy(allocator, src);
+  }
+};
+
+// 异构查找时key_arg<K>就是K，可以推导；否则是key_type，K取默认值
+template<bool Transparent>
+struct KeyArg {
+  template<typename K, typename Key>
+  using type = Key;
+};
+
+template<>
+struct KeyArg<true> {
+  template<typename K, typename Key>
+  using type = K;
+};
+
+
+/**
+ * @brief 前向迭代器，跳过空位时一次检查一组控制字节
+ *
+ * @tparam Value value_type或const value_type
+ */
+template<typename Value>
+class Iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::remove_const_t<Value>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = Value*;
+  using reference = Value&;
+
+  Iterator() = default;
+
+  template<typename Other>
+    requires (std::is_const_v<Value> && std::same_as<Other, std::remove_const_t<Value>>)
+  Iterator(const Iterator<Other>& other) noexcept
+    : ctrl_{ other.ctrl_ }, slot_{ other.slot_ }, end_{ other.end_ }
+  {}
+
+  reference operator*() const noexcept { return *slot_; }
+
+  pointer operator->() const noexcept { return slot_; }
+
+  Iterator& operator++() noexcept
+  {
+    ++ctrl_;
+    ++slot_;
+    skip_empty();
+    return *this;
+  }
+
+  Iterator operator++(int) noexcept
+  {
+    auto copy = *this;
+    ++*this;
+    return copy;
+  }
+
+  friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept
+  {
+    return lhs.ctrl_ == rhs.ctrl_;
+  }
+
+private:
+  const ctrl_t* ctrl_ = nullptr;
+  Value* slot_ = nullptr;
+  const ctrl_t* end_ = nullptr;
+
+  Iterator(const ctrl_t* ctrl, Value* slot, const ctrl_t* end) noexcept
+    : ctrl_{ ctrl }, slot_{ slot }, end_{ end }
+  {}
+
+  // ctrl_到end_之间的控制字节都是真实的，end_之后是开头的复制，不能当作元素
+  void skip_empty() noexcept
+  {
+    while (ctrl_ != end_) {
+      auto remaining = end_ - ctrl_;
+      auto full = Group{ ctrl_ }.match_full();
+      if (full != 0) {
+        auto offset = std::min<std::ptrdiff_t>(std::countr_zero(full), remaining);
+        ctrl_ += offset;
+        slot_ += offset;
+        return;
+      }
+
+      auto step = std::min<std::ptrdiff_t>(GROUP_WIDTH, remaining);
+      ctrl_ += step;
+      slot_ += step;
+    }
+  }
+
+  template<typename Other>
+  friend class Iterator;
+
+  template<typename Policy, typename Hash, typename KeyEqual, typename Allocator>
+  friend class Table;
+};
+
+
+/**
+ * @brief 线性探测的扁平哈希表，元素直接存放在一个数组中
+ *
+ * @details 每个位置有一个控制字节，查找时用SIMD一次比较GROUP_WIDTH个控制字节，只有h2相同的位置才比较key。
+ * 线性探测下key只可能出现在起始位置之后的第一个空位之前，遇到空位就结束查找。
+ * 删除时把后面的元素往前移(backward shift)，不需要墓碑，删除多了查找也不会变慢。
+ * 控制字节数组末尾复制了开头的GROUP_WIDTH - 1个字节，任意位置开始的一组都不需要处理回绕
+ * @warning 插入可能导致扩容，删除会移动其他元素，两者都会使所有迭代器和引用失效；
+ * 扩容和删除时移动元素，元素的移动构造不应该抛出异常
+ */
+template<typename Policy, typename Hash, typename KeyEqual, typename Allocator>
+class Table {
+  using slot_type = typename Policy::slot_type;
+  using alloc_traits = std::allocator_traits<Allocator>;
+  using ctrl_allocator = typename alloc_traits::template rebind_alloc<ctrl_t>;
+
+  constexpr static bool TRANSPARENT = requires {
+    typename Hash::is_transparent;
+    typename KeyEqual::is_transparent;
+  };
+
+public:
+  using key_type = typename Policy::key_type;
+  using value_type = typename Policy::value_type;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = typename alloc_traits::pointer;
+  using const_pointer = typename alloc_traits::const_pointer;
+  using const_iterator = Iterator<const value_type>;
+  using iterator = std::conditional_t<Policy::CONST_ITERATOR, const_iterator, Iterator<value_type>>;
+
+  template<typename K>
+  using key_arg = typename KeyArg<TRANSPARENT>::template type<K, key_type>;
+
+  Table() noexcept(std::is_nothrow_default_constructible_v<Hash> &&
+                   std::is_nothrow_default_constructible_v<KeyEqual> &&
+                   std::is_nothrow_default_constructible_v<Allocator>)
+    : Table{ Allocator{} }
+  {}
+
+  explicit Table(const Allocator& allocator) noexcept
+    : hash_{}, equal_{}, allocator_{ allocator }
+  {}
+
+  explicit Table(size_type bucket_count,
+                 const Hash& hash = Hash{},
+                 const KeyEqual& equal = KeyEqual{},
+                 const Allocator& allocator = Allocator{})
+    : hash_{ hash }, equal_{ equal }, allocator_{ allocator }
+  {
+    if (bucket_count > 0)
+      resize(std::bit_ceil(std::max(MIN_CAPACITY, bucket_count)));
+  }
+
+  Table(size_type bucket_count, const Allocator& allocator)
+    : Table{ bucket_count, Hash{}, KeyEqual{}, allocator }
+  {}
+
+  Table(std::initializer_list<value_type> values,
+        size_type bucket_count = 0,
+        const Hash& hash = Hash{},
+        const KeyEqual& equal = KeyEqual{},
+        const Allocator& allocator = Allocator{})
+    : Table{ bucket_count, hash, equal, allocator }
+  {
+    insert(values.begin(), values.end());
+  }
+
+  template<std::input_iterator InputIterator>
+  Table(InputIterator first, InputIterator last,
+        size_type bucket_count = 0,
+        const Hash& hash = Hash{},
+        const KeyEqual& equal = KeyEqual{},
+        const Allocator& allocator = Allocator{})
+    : Table{ bucket_count, hash, equal, allocator }
+  {
+    insert(first, last);
+  }
+
+  Table(const Table& other)
+    : Table{ other, alloc_traits::select_on_container_copy_construction(other.allocator_) }
+  {}
+
+  Table(const Table& other, const Allocator& allocator)
+    : Table{ 0, other.hash_, other.equal_, allocator }
+  {
+    copy_from(other);
+  }
+
+  Table(Table&& other) noexcept
+    : hash_{ std::move(other.hash_) },
+      equal_{ std::move(other.equal_) },
+      allocator_{ std::move(other.allocator_) },
+      ctrl_{ std::exchange(other.ctrl_, nullptr) },
+      slots_{ std::exchange(other.slots_, nullptr) },
+      capacity_{ std::exchange(other.capacity_, 0) },
+      size_{ std::exchange(other.size_, 0) }
+  {}
+
+  Table& operator=(const Table& other)
+  {
+    if (this == &other)
+      return *this;
+
+    destroy();
+    hash_ = other.hash_;
+    equal_ = other.equal_;
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+      allocator_ = other.allocator_;
+
+    copy_from(other);
+    return *this;
+  }
+
+  Table& operator=(Table&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                           alloc_traits::is_always_equal::value)
+  {
+    if (this == &other)
+      return *this;
+
+    hash_ = std::move(other.hash_);
+    equal_ = std::move(other.equal_);
+
+    constexpr bool steal = alloc_traits::propagate_on_container_move_assignment::value ||
+                           alloc_traits::is_always_equal::value;
+    if (steal || allocator_ == other.allocator_) {
+      destroy();
+      if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+        allocator_ = std::move(other.allocator_);
+
+      ctrl_ = std::exchange(other.ctrl_, nullptr);
+      slots_ = std::exchange(other.slots_, nullptr);
+      capacity_ = std::exchange(other.capacity_, 0);
+      size_ = std::exchange(other.size_, 0);
+    }
+    else {
+      // 分配器不同，只能逐个移动元素
+      clear();
+      reserve(other.size_);
+      for (auto& value: other)
+        emplace_unique(hash_of(Policy::key(value)), std::move(value));
+      other.clear();
+    }
+
+    return *this;
+  }
+
+  ~Table()
+  {
+    destroy();
+  }
+
+  iterator begin() noexcept { return skipped(iterator_at(0)); }
+  const_iterator begin() const noexcept { return skipped(const_iterator_at(0)); }
+  const_iterator cbegin() const noexcept { return begin(); }
+
+  iterator end() noexcept { return iterator_at(capacity_); }
+  const_iterator end() const noexcept { return const_iterator_at(capacity_); }
+  const_iterator cend() const noexcept { return end(); }
+
+  bool empty() const noexcept { return size_ == 0; }
+
+  size_type size() const noexcept { return size_; }
+
+  size_type max_size() const noexcept { return max_size_for(std::size_t{ 1 } << 62); }
+
+  // 槽位数，总是0或者2的幂
+  size_type capacity() const noexcept { return capacity_; }
+
+  float load_factor() const noexcept
+  {
+    return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / static_cast<float>(capacity_);
+  }
+
+  float max_load_factor() const noexcept { return 0.875f; }
+
+  hasher hash_function() const { return hash_; }
+
+  key_equal key_eq() const { return equal_; }
+
+  allocator_type get_allocator() const noexcept { return allocator_; }
+
+  // 析构所有元素，保留容量
+  void clear() noexcept
+  {
+    if (size_ == 0)
+      return;
+
+    destroy_slots();
+    std::fill_n(ctrl_, capacity_ + GROUP_WIDTH - 1, EMPTY);
+    size_ = 0;
+  }
+
+  // 保证插入count个元素之前不会扩容
+  void reserve(size_type count)
+  {
+    if (count > max_size_for(capacity_))
+      resize(capacity_for(count));
+  }
+
+  /**
+   * @brief 调整到至少bucket_count个槽位，并且能容纳当前所有元素
+   *
+   * @param bucket_count 为0并且表是空的时候释放所有内存
+   */
+  void rehash(size_type bucket_count)
+  {
+    if (bucket_count == 0 && size_ == 0) {
+      destroy();
+      return;
+    }
+
+    auto capacity = std::max(capacity_for(size_), std::bit_ceil(std::max(MIN_CAPACITY, bucket_count)));
+    if (capacity != capacity_)
+      resize(capacity);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value)
+  {
+    return emplace_key(Policy::key(value), value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value)
+  {
+    return emplace_key(Policy::key(value), std::move(value));
+  }
+
+  template<std::input_iterator InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    if constexpr (std::forward_iterator<InputIterator>)
+      reserve(size_ + static_cast<size_type>(std::distance(first, last)));
+
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  void insert(std::initializer_list<value_type> values)
+  {
+    insert(values.begin(), values.end());
+  }
+
+  template<typename K = key_type>
+  iterator find(const key_arg<K>& key)
+  {
+    auto index = find_index(key, hash_of(key));
+    return index == capacity_ ? end() : iterator_at(index);
+  }
+
+  template<typename K = key_type>
+  const_iterator find(const key_arg<K>& key) const
+  {
+    auto index = find_index(key, hash_of(key));
+    return index == capacity_ ? end() : const_iterator_at(index);
+  }
+
+  template<typename K = key_type>
+  bool contains(const key_arg<K>& key) const
+  {
+    return find_index(key, hash_of(key)) != capacity_;
+  }
+
+  template<typename K = key_type>
+  size_type count(const key_arg<K>& key) const
+  {
+    return contains<K>(key) ? 1 : 0;
+  }
+
+  template<typename K = key_type>
+  size_type erase(const key_arg<K>& key)
+  {
+    auto index = find_index(key, hash_of(key));
+    if (index == capacity_)
+      return 0;
+
+    erase_at(index);
+    return 1;
+  }
+
+  /**
+   * @brief 删除position处的元素
+   *
+   * @warning 后面的元素可能被移到position处，遍历时删除请用erase_if
+   */
+  void erase(const_iterator position)
+  {
+    erase_at(static_cast<size_type>(position.ctrl_ - ctrl_));
+  }
+
+  void erase(iterator position) requires (!std::same_as<iterator, const_iterator>)
+  {
+    erase(const_iterator{ position });
+  }
+
+  void swap(Table& other) noexcept
+  {
+    using std::swap;
+    swap(hash_, other.hash_);
+    swap(equal_, other.equal_);
+    if constexpr (alloc_traits::propagate_on_container_swap::value)
+      swap(allocator_, other.allocator_);
+
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+  }
+
+  friend void swap(Table& lhs, Table& rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  friend bool operator==(const Table& lhs, const Table& rhs)
+  {
+    if (lhs.size_ != rhs.size_)
+      return false;
+
+    return std::all_of(lhs.begin(), lhs.end(), [&rhs] (const value_type& value) {
+      auto it = rhs.find(Policy::key(value));
+      return it != rhs.end() && *it == value;
+    });
+  }
+
+  /**
+   * @brief 删除所有满足predicate的元素
+   *
+   * @details 从一个空位之后开始绕一圈，后移删除只会把还没访问过的元素移到当前位置，每个元素只访问一次
+   * @return size_type 删除的元素数
+   */
+  template<typename Predicate>
+  friend size_type erase_if(Table& table, Predicate predicate)
+  {
+    if (table.size_ == 0)
+      return 0;
+
+    auto mask = table.capacity_ - 1;
+    size_type start = 0;
+    while (table.ctrl_[start] != EMPTY)
+      ++start;
+
+    size_type erased = 0;
+    for (size_type step = 1; step < table.capacity_; ) {
+      auto index = (start + step) & mask;
+      if (table.ctrl_[index] != EMPTY && predicate(std::as_const(table.slots_[index]))) {
+        table.erase_at(index);
+        ++erased;
+      }
+      else {
+        ++step;
+      }
+    }
+
+    return erased;
+  }
+
+protected:
+  [[no_unique_address]] Hash hash_;
+  [[no_unique_address]] KeyEqual equal_;
+  [[no_unique_address]] Allocator allocator_;
+  ctrl_t* ctrl_ = nullptr;
+  slot_type* slots_ = nullptr;
+  size_type capacity_ = 0;
+  size_type size_ = 0;
+
+  template<typename K>
+  std::uint64_t hash_of(const K& key) const
+  {
+    return mix(hash_(key));
+  }
+
+  // 没找到时返回capacity_
+  template<typename K>
+  size_type find_index(const K& key, std::uint64_t hash) const
+  {
+    if (capacity_ == 0)
+      return capacity_;
+
+    auto mask = capacity_ - 1;
+    auto tag = h2(hash);
+    for (auto position = h1(hash) & mask; ; position = (position + GROUP_WIDTH) & mask) {
+      Group group{ ctrl_ + position };
+      auto empty = group.match_empty();
+
+      // 只有第一个空位之前的才可能是要找的key，empty为0时掩码是全1
+      for (auto bits = group.match(tag) & ((empty & (0u - empty)) - 1u); bits != 0; bits &= bits - 1) {
+        auto index = (position + static_cast<size_type>(std::countr_zero(bits))) & mask;
+        if (equal_(Policy::key(slots_[index]), key))
+          return index;
+      }
+
+      if (empty != 0)
+        return capacity_;
+    }
+  }
+
+  // 从起始位置开始的第一个空位，负载因子保证一定存在
+  size_type find_empty(std::uint64_t hash) const noexcept
+  {
+    auto mask = capacity_ - 1;
+    for (auto position = h1(hash) & mask; ; position = (position + GROUP_WIDTH) & mask) {
+      auto empty = Group{ ctrl_ + position }.match_empty();
+      if (empty != 0)
+        return (position + static_cast<size_type>(std::countr_zero(empty))) & mask;
+    }
+  }
+
+  /**
+   * @brief key不存在时用args构造新元素
+   *
+   * @param key  只用来查找，在构造新元素之前不会被移走
+   * @param args 构造value_type的参数
+   */
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> emplace_key(const K& key, Args&&... args)
+  {
+    return emplace_hashed(hash_of(key), key, std::forward<Args>(args)...);
+  }
+
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> emplace_hashed(std::uint64_t hash, const K& key, Args&&... args)
+  {
+    auto index = find_index(key, hash);
+    if (index != capacity_)
+      return { iterator_at(index), false };
+
+    return { iterator_at(emplace_unique(hash, std::forward<Args>(args)...)), true };
+  }
+
+  // 调用者保证key不存在
+  template<typename... Args>
+  size_type emplace_unique(std::uint64_t hash, Args&&... args)
+  {
+    if (size_ >= max_size_for(capacity_))
+      resize(capacity_for(size_ + 1));
+
+    auto index = find_empty(hash);
+    alloc_traits::construct(allocator_, slots_ + index, std::forward<Args>(args)...);
+    set_ctrl(index, h2(hash));
+    ++size_;
+    return index;
+  }
+
+  void erase_at(size_type index) noexcept
+  {
+    auto mask = capacity_ - 1;
+    alloc_traits::destroy(allocator_, slots_ + index);
+    --size_;
+
+    // 空位之后同一簇中的元素，如果起始位置不在空位和它自己之间，就可以前移填补空位
+    auto hole = index;
+    for (auto next = (hole + 1) & mask; ctrl_[next] != EMPTY; next = (next + 1) & mask) {
+      auto home = h1(hash_of(Policy::key(slots_[next]))) & mask;
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        Policy::transfer(allocator_, slots_ + hole, slots_ + next);
+        set_ctrl(hole, ctrl_[next]);
+        hole = next;
+      }
+    }
+
+    set_ctrl(hole, EMPTY);
+  }
+
+private:
+  iterator iterator_at(size_type index) noexcept
+  {
+    return { ctrl_ + index, slots_ + index, ctrl_ + capacity_ };
+  }
+
+  const_iterator const_iterator_at(size_type index) const noexcept
+  {
+    return { ctrl_ + index, slots_ + index, ctrl_ + capacity_ };
+  }
+
+  // begin()从位置0开始，需要跳到第一个元素
+  template<typename It>
+  static It skipped(It it) noexcept
+  {
+    if (it.ctrl_ != it.end_ && *it.ctrl_ == EMPTY)
+      it.skip_empty();
+    return it;
+  }
+
+  void set_ctrl(size_type index, ctrl_t ctrl) noexcept
+  {
+    ctrl_[index] = ctrl;
+    if (index < GROUP_WIDTH - 1)
+      ctrl_[capacity_ + index] = ctrl;
+  }
+
+  void resize(size_type capacity)
+  {
+    ctrl_allocator ctrl_alloc{ allocator_ };
+
+    auto ctrl = std::allocator_traits<ctrl_allocator>::allocate(ctrl_alloc, capacity + GROUP_WIDTH - 1);
+    slot_type* slots;
+    try {
+      slots = alloc_traits::allocate(allocator_, capacity);
+    }
+    catch (...) {
+      std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, ctrl, capacity + GROUP_WIDTH - 1);
+      throw;
+    }
+    std::fill_n(ctrl, capacity + GROUP_WIDTH - 1, EMPTY);
+
+    auto old_ctrl = std::exchange(ctrl_, ctrl);
+    auto old_slots = std::exchange(slots_, slots);
+    auto old_capacity = std::exchange(capacity_, capacity);
+
+    for (size_type i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] == EMPTY)
+        continue;
+
+      auto hash = hash_of(Policy::key(old_slots[i]));
+      auto index = find_empty(hash);
+      Policy::transfer(allocator_, slots_ + index, old_slots + i);
+      set_ctrl(index, h2(hash));
+    }
+
+    if (old_capacity > 0) {
+      std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, old_ctrl, old_capacity + GROUP_WIDTH - 1);
+      alloc_traits::deallocate(allocator_, old_slots, old_capacity);
+    }
+  }
+
+  void copy_from(const Table& other)
+  {
+    reserve(other.size_);
+    for (auto& value: other)
+      emplace_unique(hash_of(Policy::key(value)), value);
+  }
+
+  void destroy_slots() noexcept
+  {
+    if constexpr (!std::is_trivially_destructible_v<slot_type>) {
+      for (size_type i = 0; i < capacity_; ++i)
+        if (ctrl_[i] != EMPTY)
+          alloc_traits::destroy(allocator_, slots_ + i);
+    }
+  }
+
+  // 析构所有元素并释放内存
+  void destroy() noexcept
+  {
+    if (capacity_ == 0)
+      return;
+
+    destroy_slots();
+
+    ctrl_allocator ctrl_alloc{ allocator_ };
+    std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, ctrl_, capacity_ + GROUP_WIDTH - 1);
+    alloc_traits::deallocate(allocator_, slots_, capacity_);
+
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+  }
+};
+
+} // namespace detail::hash_table
+
+
+/**
+ * @brief 扁平哈希集合，接口和std::unordered_set基本一致
+ *
+ * @details 见detail::hash_table::Table。Hash和KeyEqual都有is_transparent时支持异构查找
+ * @warning 插入和删除都会使迭代器和引用失效
+ */
+template<typename Key,
+         typename Hash = st::Hash<Key>,
+         typename KeyEqual = std::equal_to<>,
+         typename Allocator = std::allocator<Key>>
+class FlatHashSet: public detail::hash_table::Table<detail::hash_table::SetPolicy<Key>, Hash, KeyEqual, Allocator> {
+  using Base = detail::hash_table::Table<detail::hash_table::SetPolicy<Key>, Hash, KeyEqual, Allocator>;
+
+public:
+  using typename Base::iterator;
+  using typename Base::key_type;
+  using typename Base::value_type;
+
+  using Base::Base;
+  using Base::insert;
+
+  template<typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    if constexpr (sizeof...(Args) == 1 && (std::same_as<std::remove_cvref_t<Args>, key_type> && ...)) {
+      return this->emplace_key(args..., std::forward<Args>(args)...);
+    }
+    else {
+      key_type key(std::forward<Args>(args)...);
+      return this->emplace_key(key, std::move(key));
+    }
+  }
+};
+
+/**
+ * @brief 扁平哈希表，接口和std::unordered_map基本一致
+ *
+ * @details 见detail::hash_table::Table。Hash和KeyEqual都有is_transparent时支持异构查找，
+ * 比如FlatHashMap<std::string, T>可以直接用std::string_view和字符串字面量查找
+ * @warning 插入和删除都会使迭代器和引用失效
+ */
+template<typename Key,
+         typename Value,
+         typename Hash = st::Hash<Key>,
+         typename KeyEqual = std::equal_to<>,
+         typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class FlatHashMap: public detail::hash_table::Table<detail::hash_table::MapPolicy<Key, Value>, Hash, KeyEqual, Allocator> {
+  using Base = detail::hash_table::Table<detail::hash_table::MapPolicy<Key, Value>, Hash, KeyEqual, Allocator>;
+
+public:
+  using typename Base::iterator;
+  using typename Base::const_iterator;
+  using typename Base::key_type;
+  using typename Base::value_type;
+  using mapped_type = Value;
+
+  template<typename K>
+  using key_arg = typename Base::template key_arg<K>;
+
+  using Base::Base;
+  using Base::insert;
+
+  template<typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    if constexpr (sizeof...(Args) == 2 && std::same_as<std::remove_cvref_t<std::tuple_element_t<0, std::tuple<Args...>>>, key_type>) {
+      auto&& key = std::get<0>(std::forward_as_tuple(args...));
+      return this->emplace_key(key, std::forward<Args>(args)...);
+    }
+    else {
+      // 无法直接取到key，先构造出来再移动进去
+      value_type value(std::forward<Args>(args)...);
+      return this->emplace_key(value.first, std::piecewise_construct,
+                               std::forward_as_tuple(std::move(const_cast<key_type&>(value.first))),
+                               std::forward_as_tuple(std::move(value.second)));
+    }
+  }
+
+  template<typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+  {
+    return this->emplace_key(key, std::piecewise_construct,
+                             std::forward_as_tuple(key),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template<typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+  {
+    return this->emplace_key(key, std::piecewise_construct,
+                             std::forward_as_tuple(std::move(key)),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template<typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& value)
+  {
+    auto result = try_emplace(key, std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  template<typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& value)
+  {
+    auto result = try_emplace(std::move(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  Value& operator[](const key_type& key) { return try_emplace(key).first->second; }
+
+  Value& operator[](key_type&& key) { return try_emplace(std::move(key)).first->second; }
+
+  template<typename K = key_type>
+  Value& at(const key_arg<K>& key)
+  {
+    auto it = this->template find<K>(key);
+    if (it == this->end())
+      throw std::out_of_range{ "st::FlatHashMap::at: key not found" };
+    return it->second;
+  }
+
+  template<typename K = key_type>
+  const Value& at(const key_arg<K>& key) const
+  {
+    auto it = this->template find<K>(key);
+    if (it == this->end())
+      throw std::out_of_range{ "st::FlatHashMap::at: key not found" };
+    return it->second;
+  }
+
+private:
+  template<typename K, typename V, typename H, typename E, typename A>
+  friend class ConcurrentFlatHashMap;
+};
+
+
+// 分片数默认值，远多于线程数时锁冲突很少
+constexpr static std::size_t DEFAULT_HASH_MAP_SHARDS = 64;
+
+/**
+ * @brief 按哈希值分片的并发哈希表，每个分片是一个FlatHashMap和一把读写锁
+ *
+ * @details 哈希值的高位选分片，低位在分片内探测，两者互不影响，同一个key的哈希只计算一次。
+ * 不提供迭代器，元素只能在持有分片锁的回调中访问(visit/cvisit/for_each)
+ * @warning 回调中不能再访问同一个表，否则可能死锁
+ */
+template<typename Key,
+         typename Value,
+         typename Hash = st::Hash<Key>,
+         typename KeyEqual = std::equal_to<>,
+         typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class ConcurrentFlatHashMap {
+  using Map = FlatHashMap<Key, Value, Hash, KeyEqual, Allocator>;
+
+public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = typename Map::value_type;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+
+  template<typename K>
+  using key_arg = typename Map::template key_arg<K>;
+
+  /**
+   * @param shards 分片数，向上取整到2的幂
+   */
+  explicit ConcurrentFlatHashMap(size_type shards = DEFAULT_HASH_MAP_SHARDS,
+                                 const Hash& hash = Hash{},
+                                 const KeyEqual& equal = KeyEqual{},
+                                 const Allocator& allocator = Allocator{})
+    : hash_{ hash },
+      shard_bits_{ std::countr_zero(std::bit_ceil(std::max<size_type>(shards, 1))) },
+      shards_{ std::make_unique<Shard[]>(std::size_t{ 1 } << shard_bits_) }
+  {
+    for (auto& shard: std::span{ shards_.get(), this->shards() })
+      shard.map = Map{ 0, hash, equal, allocator };
+  }
+
+  ConcurrentFlatHashMap(const ConcurrentFlatHashMap& other) = delete;
+  ConcurrentFlatHashMap& operator=(const ConcurrentFlatHashMap& other) = delete;
+
+  size_type shards() const noexcept { return std::size_t{ 1 } << shard_bits_; }
+
+  // 逐个分片加锁求和，并发修改时只是一个近似值
+  size_type size() const
+  {
+    size_type size = 0;
+    for (auto& shard: all_shards()) {
+      std::shared_lock lock{ shard.mutex };
+      size += shard.map.size();
+    }
+
+    return size;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  void clear()
+  {
+    for (auto& shard: all_shards()) {
+      std::unique_lock lock{ shard.mutex };
+      shard.map.clear();
+    }
+  }
+
+  // 按平均值给每个分片预留空间
+  void reserve(size_type count)
+  {
+    for (auto& shard: all_shards()) {
+      std::unique_lock lock{ shard.mutex };
+      shard.map.reserve(count / shards() + 1);
+    }
+  }
+
+  bool insert(const value_type& value)
+  {
+    return try_emplace(value.first, value.second);
+  }
+
+  bool insert(value_type&& value)
+  {
+    return try_emplace(std::move(const_cast<key_type&>(value.first)), std::move(value.second));
+  }
+
+  // 插入成功返回true
+  template<typename K, typename... Args>
+    requires std::constructible_from<key_type, K&&>
+  bool try_emplace(K&& key, Args&&... args)
+  {
+    return try_emplace_or_visit(std::forward<K>(key), [] (value_type&) {}, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief key不存在时插入，否则在锁内调用visitor修改已有的元素
+   *
+   * @return bool 插入了新元素时返回true
+   */
+  template<typename K, typename Visitor, typename... Args>
+    requires std::constructible_from<key_type, K&&>
+  bool try_emplace_or_visit(K&& key, Visitor&& visitor, Args&&... args)
+  {
+    const key_type& lookup = key;
+    auto hash = detail::hash_table::mix(hash_(lookup));
+    auto& shard = shard_of(hash);
+
+    std::unique_lock lock{ shard.mutex };
+    auto [it, inserted] = shard.map.emplace_hashed(hash, lookup, std::piecewise_construct,
+                                                   std::forward_as_tuple(std::forward<K>(key)),
+                                                   std::forward_as_tuple(std::forward<Args>(args)...));
+    if (!inserted)
+      std::invoke(visitor, *it);
+
+    return inserted;
+  }
+
+  template<typename M>
+  bool insert_or_assign(const key_type& key, M&& value)
+  {
+    return try_emplace_or_visit(key, [&value] (value_type& existing) { existing.second = std::forward<M>(value); },
+                                std::forward<M>(value));
+  }
+
+  template<typename K = key_type>
+  size_type erase(const key_arg<K>& key)
+  {
+    auto hash = detail::hash_table::mix(hash_(key));
+    auto& shard = shard_of(hash);
+
+    std::unique_lock lock{ shard.mutex };
+    auto index = shard.map.find_index(key, hash);
+    if (index == shard.map.capacity_)
+      return 0;
+
+    shard.map.erase_at(index);
+    return 1;
+  }
+
+  template<typename K = key_type>
+  bool contains(const key_arg<K>& key) const
+  {
+    return cvisit<K>(key, [] (const value_type&) {});
+  }
+
+  // 返回value的拷贝，不存在时返回std::nullopt
+  template<typename K = key_type>
+  std::optional<Value> get(const key_arg<K>& key) const requires std::copy_constructible<Value>
+  {
+    std::optional<Value> value{};
+    cvisit<K>(key, [&value] (const value_type& existing) { value.emplace(existing.second); });
+    return value;
+  }
+
+  /**
+   * @brief 持有写锁访问key对应的元素
+   *
+   * @return bool key存在时返回true
+   */
+  template<typename K = key_type, typename Visitor>
+  bool visit(const key_arg<K>& key, Visitor&& visitor)
+  {
+    auto hash = detail::hash_table::mix(hash_(key));
+    auto& shard = shard_of(hash);
+
+    std::unique_lock lock{ shard.mutex };
+    auto index = shard.map.find_index(key, hash);
+    if (index == shard.map.capacity_)
+      return false;
+
+    std::invoke(visitor, shard.map.slots_[index]);
+    return true;
+  }
+
+  // 持有读锁访问key对应的元素
+  template<typename K = key_type, typename Visitor>
+  bool cvisit(const key_arg<K>& key, Visitor&& visitor) const
+  {
+    auto hash = detail::hash_table::mix(hash_(key));
+    auto& shard = shard_of(hash);
+
+    std::shared_lock lock{ shard.mutex };
+    auto index = shard.map.find_index(key, hash);
+    if (index == shard.map.capacity_)
+      return false;
+
+    std::invoke(visitor, std::as_const(shard.map.slots_[index]));
+    return true;
+  }
+
+  // 逐个分片持有写锁访问所有元素
+  template<typename Visitor>
+  void for_each(Visitor&& visitor)
+  {
+    for (auto& shard: all_shards()) {
+      std::unique_lock lock{ shard.mutex };
+      for (auto& value: shard.map)
+        std::invoke(visitor, value);
+    }
+  }
+
+  template<typename Visitor>
+  void cfor_each(Visitor&& visitor) const
+  {
+    for (auto& shard: all_shards()) {
+      std::shared_lock lock{ shard.mutex };
+      for (auto& value: std::as_const(shard.map))
+        std::invoke(visitor, value);
+    }
+  }
+
+  template<typename Predicate>
+  friend size_type erase_if(ConcurrentFlatHashMap& map, Predicate predicate)
+  {
+    size_type erased = 0;
+    for (auto& shard: map.all_shards()) {
+      std::unique_lock lock{ shard.mutex };
+      erased += erase_if(shard.map, predicate);
+    }
+
+    return erased;
+  }
+
+private:
+  // 每个分片独占缓存行，相邻分片的锁互不干扰
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex{};
+    Map map{};
+  };
+
+  [[no_unique_address]] Hash hash_;
+  int shard_bits_;
+  std::unique_ptr<Shard[]> shards_;
+
+  Shard& shard_of(std::uint64_t hash) const noexcept
+  {
+    // 只有一个分片时右移64位是未定义行为
+    return shard_bits_ == 0 ? shards_[0] : shards_[hash >> (64 - shard_bits_)];
+  }
+
+  std::span<Shard> all_shards() const noexcept { return { shards_.get(), shards() }; }
+};
+
+
+namespace pmr {
+
+template<typename Key, typename Hash = st::Hash<Key>, typename KeyEqual = std::equal_to<>>
+using FlatHashSet = st::FlatHashSet<Key, Hash, KeyEqual, std::pmr::polymorphic_allocator<Key>>;
+
+template<typename Key, typename Value, typename Hash = st::Hash<Key>, typename KeyEqual = std::equal_to<>>
+using FlatHashMap = st::FlatHashMap<Key, Value, Hash, KeyEqual,
+                                    std::pmr::polymorphic_allocator<std::pair<const Key, Value>>>;
+
+} // namespace pmr
+
+} // namespace st
+
+#endif // STUDY_TOUR_HASH_MAP_H
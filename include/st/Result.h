@@ -0,0 +1,210 @@
+/**
+ * @file Result.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 不抛异常的返回值，类似std::expected<T, errno>
+ * @version 0.1
+ * @date 2022-07-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_RESULT_H
+#define STUDY_TOUR_RESULT_H
+
+#include <errno.h>
+
+#include <memory>
+#include <new>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+
+namespace st {
+
+/**
+ * @brief 失败时的errno
+ *
+ * @example return st::Error{ errno };
+ */
+struct Error {
+  int code;
+};
+
+/**
+ * @brief 成功时保存T，失败时只保存errno，本身不会分配内存
+ *
+ * @details EAGAIN、ECONNRESET这类常见的错误不再抛异常，调用者按errno分支即可；
+ * 需要异常时调用value()，失败时才构造std::system_error
+ * @tparam T
+ */
+template<typename T>
+class [[nodiscard]] Result {
+public:
+  using value_type = T;
+
+  Result(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>)
+    : error_{ 0 }
+  {
+    std::construct_at(std::addressof(value_), value);
+  }
+
+  Result(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+    : error_{ 0 }
+  {
+    std::construct_at(std::addressof(value_), std::move(value));
+  }
+
+  Result(Error error) noexcept
+    : error_{ error.code == 0 ? EINVAL : error.code }
+  {}
+
+  Result(const Result& other) requires std::is_copy_constructible_v<T>
+    : error_{ other.error_ }
+  {
+    if (other.has_value())
+      std::construct_at(std::addressof(value_), other.value_);
+  }
+
+  Result(Result&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    : error_{ other.error_ }
+  {
+    if (other.has_value())
+      std::construct_at(std::addressof(value_), std::move(other.value_));
+  }
+
+  Result& operator=(const Result& other) requires std::is_copy_constructible_v<T>
+  {
+    if (this != &other) {
+      reset();
+      if (other.has_value())
+        std::construct_at(std::addressof(value_), other.value_);
+      error_ = other.error_;
+    }
+
+    return *this;
+  }
+
+  Result& operator=(Result&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+  {
+    if (this != &other) {
+      reset();
+      if (other.has_value())
+        std::construct_at(std::addressof(value_), std::move(other.value_));
+      error_ = other.error_;
+    }
+
+    return *this;
+  }
+
+  ~Result() { reset(); }
+
+  bool has_value() const noexcept { return error_ == 0; }
+  explicit operator bool() const noexcept { return has_value(); }
+
+  // 成功时为0
+  int error() const noexcept { return error_; }
+
+  std::error_code error_code() const noexcept { return { error_, std::generic_category() }; }
+
+  // 非阻塞fd暂时不可读写
+  bool would_block() const noexcept { return error_ == EAGAIN || error_ == EWOULDBLOCK; }
+
+  /**
+   * @brief 取出值
+   *
+   * @exception std::system_error 失败时抛出
+   */
+  T& value() &
+  {
+    throw_if_error();
+    return value_;
+  }
+
+  const T& value() const &
+  {
+    throw_if_error();
+    return value_;
+  }
+
+  T&& value() &&
+  {
+    throw_if_error();
+    return std::move(value_);
+  }
+
+  // 不检查，失败时是未定义行为
+  T& operator*() & noexcept { return value_; }
+  const T& operator*() const & noexcept { return value_; }
+  T&& operator*() && noexcept { return std::move(value_); }
+
+  T* operator->() noexcept { return std::addressof(value_); }
+  const T* operator->() const noexcept { return std::addressof(value_); }
+
+  template<typename U>
+  T value_or(U&& default_value) const &
+  {
+    return has_value() ? value_ : static_cast<T>(std::forward<U>(default_value));
+  }
+
+  template<typename U>
+  T value_or(U&& default_value) &&
+  {
+    return has_value() ? std::move(value_) : static_cast<T>(std::forward<U>(default_value));
+  }
+
+private:
+  // 只有成功时value_才是活跃的成员
+  union {
+    T value_;
+  };
+  int error_;
+
+  void reset() noexcept
+  {
+    if (has_value())
+      std::destroy_at(std::addressof(value_));
+  }
+
+  void throw_if_error() const
+  {
+    if (!has_value())
+      throw std::system_error{ error_, std::generic_category() };
+  }
+};
+
+/**
+ * @brief 没有返回值的操作，只有errno
+ *
+ */
+template<>
+class [[nodiscard]] Result<void> {
+public:
+  using value_type = void;
+
+  Result() noexcept : error_{ 0 } {}
+
+  Result(Error error) noexcept : error_{ error.code == 0 ? EINVAL : error.code } {}
+
+  bool has_value() const noexcept { return error_ == 0; }
+  explicit operator bool() const noexcept { return has_value(); }
+
+  int error() const noexcept { return error_; }
+
+  std::error_code error_code() const noexcept { return { error_, std::generic_category() }; }
+
+  bool would_block() const noexcept { return error_ == EAGAIN || error_ == EWOULDBLOCK; }
+
+  void value() const
+  {
+    if (!has_value())
+      throw std::system_error{ error_, std::generic_category() };
+  }
+
+private:
+  int error_;
+};
+
+} // namespace st
+
+#endif // STUDY_TOUR_RESULT_H
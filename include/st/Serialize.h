@@ -0,0 +1,748 @@
+/**
+ * @file Serialize.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 编译期反射的二进制序列化，直接读写std::span<std::byte>，读取字符串时不拷贝
+ * @version 0.1
+ * @date 2022-07-23
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_SERIALIZE_H
+#define STUDY_TOUR_SERIALIZE_H
+
+#include <errno.h>
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Cast.h"
+#include "Concept.h"
+#include "Result.h"
+
+
+namespace st {
+
+/**
+ * @brief 按varint(LEB128)编码的整数，有符号数先做zigzag，小的值只占1个字节
+ * @example struct Message { st::Varint<std::uint32_t> id; std::string_view name; };
+ *
+ * @tparam Integer
+ */
+template<std::integral Integer>
+struct Varint {
+  Integer value{};
+
+  constexpr Varint() noexcept = default;
+  constexpr Varint(Integer integer) noexcept : value{ integer } {}
+
+  constexpr operator Integer() const noexcept { return value; }
+};
+
+/**
+ * @brief 序列化的输出，空间不足时置failed，之后的写入都被忽略
+ *
+ */
+class Writer {
+public:
+  explicit Writer(std::span<std::byte> buffer) noexcept
+    : buffer_{ buffer }, offset_{ 0 }, failed_{ false }
+  {}
+
+  std::size_t offset() const noexcept { return offset_; }
+  bool failed() const noexcept { return failed_; }
+
+  /**
+   * @brief 预留size个字节
+   *
+   * @return std::byte* 空间不足时为nullptr
+   */
+  std::byte* reserve(std::size_t size) noexcept
+  {
+    if (failed_ || buffer_.size() - offset_ < size) {
+      failed_ = true;
+      return nullptr;
+    }
+
+    auto data = buffer_.data() + offset_;
+    offset_ += size;
+    return data;
+  }
+
+  void bytes(const void* data, std::size_t size) noexcept
+  {
+    if (auto out = reserve(size); out != nullptr && size != 0)
+      std::memcpy(out, data, size);
+  }
+
+  // 固定长度，网络序
+  template<std::integral Integer>
+  void fixed(Integer integer) noexcept
+  {
+    auto net = byte_order_cast<Net>(integer);
+    bytes(&net, sizeof(net));
+  }
+
+  void varint(std::uint64_t value) noexcept
+  {
+    std::byte encoded[MAX_VARINT_LENGTH];
+    std::size_t length = 0;
+    while (value >= 0x80) {
+      encoded[length++] = static_cast<std::byte>((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    encoded[length++] = static_cast<std::byte>(value);
+
+    bytes(encoded, length);
+  }
+
+  constexpr static std::size_t MAX_VARINT_LENGTH = 10;
+
+  constexpr static std::size_t varint_length(std::uint64_t value) noexcept
+  {
+    // 每7位一个字节，0也占1个字节
+    return value == 0 ? 1 : (static_cast<std::size_t>(std::bit_width(value)) + 6) / 7;
+  }
+
+private:
+  std::span<std::byte> buffer_;
+  std::size_t offset_;
+  bool failed_;
+};
+
+/**
+ * @brief 反序列化的输入，数据不完整或格式错误时置failed
+ *
+ */
+class Reader {
+public:
+  explicit Reader(std::span<const std::byte> buffer) noexcept
+    : buffer_{ buffer }, offset_{ 0 }, failed_{ false }
+  {}
+
+  std::size_t offset() const noexcept { return offset_; }
+  std::size_t remaining() const noexcept { return buffer_.size() - offset_; }
+  bool failed() const noexcept { return failed_; }
+
+  void fail() noexcept { failed_ = true; }
+
+  /**
+   * @brief 取出size个字节，返回的指针指向输入本身
+   *
+   * @return const std::byte* 数据不足时为nullptr
+   */
+  const std::byte* take(std::size_t size) noexcept
+  {
+    if (failed_ || remaining() < size) {
+      failed_ = true;
+      return nullptr;
+    }
+
+    auto data = buffer_.data() + offset_;
+    offset_ += size;
+    return data;
+  }
+
+  bool bytes(void* data, std::size_t size) noexcept
+  {
+    auto in = take(size);
+    if (in != nullptr && size != 0)
+      std::memcpy(data, in, size);
+
+    return in != nullptr;
+  }
+
+  template<std::integral Integer>
+  bool fixed(Integer& integer) noexcept
+  {
+    Integer net;
+    if (!bytes(&net, sizeof(net)))
+      return false;
+
+    integer = byte_order_cast<Host>(net);
+    return true;
+  }
+
+  bool varint(std::uint64_t& value) noexcept
+  {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      auto in = take(1);
+      if (in == nullptr)
+        return false;
+
+      auto byte = std::to_integer<std::uint64_t>(*in);
+      // 第10个字节只能剩下最高的1位
+      if (shift == 63 && byte > 1)
+        break;
+
+      value |= (byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+
+    failed_ = true;
+    return false;
+  }
+
+private:
+  std::span<const std::byte> buffer_;
+  std::size_t offset_;
+  bool failed_;
+};
+
+/**
+ * @brief 自定义类型的序列化，特化时提供:
+ * static std::size_t size(const T&);
+ * static void write(Writer&, const T&);
+ * static void read(Reader&, T&);
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Serializer {};
+
+template<typename T>
+concept custom_serializable = requires(const T& value, T& out, Writer& writer, Reader& reader) {
+  { Serializer<T>::size(value) } -> std::convertible_to<std::size_t>;
+  Serializer<T>::write(writer, value);
+  Serializer<T>::read(reader, out);
+};
+
+
+namespace detail {
+
+template<typename T>
+struct is_varint : std::false_type {};
+template<typename Integer>
+struct is_varint<Varint<Integer>> : std::true_type {};
+
+template<typename T>
+struct is_vector : std::false_type {};
+template<typename T, typename Allocator>
+struct is_vector<std::vector<T, Allocator>> : std::true_type {};
+
+template<typename T>
+struct is_optional : std::false_type {};
+template<typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template<typename T>
+struct is_std_array : std::false_type {};
+template<typename T, std::size_t N>
+struct is_std_array<std::array<T, N>> : std::true_type {};
+
+template<typename T>
+concept tuple_like = !is_std_array<T>::value && requires { std::tuple_size<T>::value; };
+
+template<typename T>
+concept byte_span = std::is_same_v<T, std::span<const std::byte>>;
+
+template<typename T>
+concept wire_string = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+// 可以转换成任何类型(除了聚合本身)，用来数出聚合的成员个数
+template<typename Aggregate>
+struct AnyField {
+  template<typename T>
+    requires (!std::is_same_v<std::remove_cvref_t<T>, Aggregate>)
+  operator T() const;
+};
+
+template<typename Aggregate, typename... Fields>
+consteval std::size_t field_count() noexcept
+{
+  if constexpr (requires { Aggregate{ Fields{}..., AnyField<Aggregate>{} }; })
+    return field_count<Aggregate, Fields..., AnyField<Aggregate>>();
+  else
+    return sizeof...(Fields);
+}
+
+constexpr std::size_t MAX_REFLECTED_FIELDS = 16;
+
+/**
+ * @brief 每个成员用一对空花括号初始化时数出的成员个数
+ *
+ * @details field_count用表达式初始化，C数组成员会发生花括号省略，每个数组元素都算一个成员，
+ * 和结构化绑定的个数对不上；空花括号总是初始化一整个成员
+ */
+template<typename Aggregate>
+consteval std::size_t braced_field_count() noexcept
+{
+  if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 16;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 15;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 14;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 13;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 12;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 11;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 10;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 9;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {}, {} }; })
+    return 8;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {}, {} }; })
+    return 7;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {}, {} }; })
+    return 6;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {}, {} }; })
+    return 5;
+  else if constexpr (requires { Aggregate{ {}, {}, {}, {} }; })
+    return 4;
+  else if constexpr (requires { Aggregate{ {}, {}, {} }; })
+    return 3;
+  else if constexpr (requires { Aggregate{ {}, {} }; })
+    return 2;
+  else if constexpr (requires { Aggregate{ {} }; })
+    return 1;
+  else
+    return 0;
+}
+
+template<typename T>
+concept reflectable = std::is_aggregate_v<T> && !std::is_array_v<T> &&
+                      field_count<T>() <= MAX_REFLECTED_FIELDS;
+
+/**
+ * @brief 把聚合的成员绑定成引用的tuple
+ *
+ * @tparam Aggregate 可以是const
+ */
+template<typename Aggregate>
+constexpr auto as_tuple(Aggregate& aggregate) noexcept
+{
+  constexpr auto COUNT = field_count<std::remove_const_t<Aggregate>>();
+  constexpr auto HAS_C_ARRAY = COUNT != braced_field_count<std::remove_const_t<Aggregate>>();
+  static_assert(!HAS_C_ARRAY, "aggregates with C array members are not serializable, use std::array");
+
+  if constexpr (HAS_C_ARRAY || COUNT == 0) {
+    return std::tie();
+  }
+  else if constexpr (COUNT == 1) {
+    auto& [f0] = aggregate;
+    return std::tie(f0);
+  }
+  else if constexpr (COUNT == 2) {
+    auto& [f0, f1] = aggregate;
+    return std::tie(f0, f1);
+  }
+  else if constexpr (COUNT == 3) {
+    auto& [f0, f1, f2] = aggregate;
+    return std::tie(f0, f1, f2);
+  }
+  else if constexpr (COUNT == 4) {
+    auto& [f0, f1, f2, f3] = aggregate;
+    return std::tie(f0, f1, f2, f3);
+  }
+  else if constexpr (COUNT == 5) {
+    auto& [f0, f1, f2, f3, f4] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4);
+  }
+  else if constexpr (COUNT == 6) {
+    auto& [f0, f1, f2, f3, f4, f5] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5);
+  }
+  else if constexpr (COUNT == 7) {
+    auto& [f0, f1, f2, f3, f4, f5, f6] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6);
+  }
+  else if constexpr (COUNT == 8) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+  }
+  else if constexpr (COUNT == 9) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+  }
+  else if constexpr (COUNT == 10) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+  }
+  else if constexpr (COUNT == 11) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+  }
+  else if constexpr (COUNT == 12) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+  }
+  else if constexpr (COUNT == 13) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+  }
+  else if constexpr (COUNT == 14) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+  }
+  else if constexpr (COUNT == 15) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+  }
+  else if constexpr (COUNT == 16) {
+    auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = aggregate;
+    return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+  }
+}
+
+/**
+ * @brief 按类型分派，所有分支在同一个类里，递归调用不依赖声明顺序
+ *
+ */
+struct Codec {
+  template<typename T>
+  static std::size_t size(const T& value) noexcept
+  {
+    if constexpr (custom_serializable<T>) {
+      return Serializer<T>::size(value);
+    }
+    else if constexpr (std::is_same_v<T, bool> || std::is_enum_v<T> ||
+                       std::is_integral_v<T> || std::is_floating_point_v<T>) {
+      return sizeof(T);
+    }
+    else if constexpr (is_varint<T>::value) {
+      return Writer::varint_length(zigzag(value.value));
+    }
+    else if constexpr (wire_string<T> || byte_span<T>) {
+      return Writer::varint_length(value.size()) + value.size();
+    }
+    else if constexpr (is_vector<T>::value) {
+      auto total = Writer::varint_length(value.size());
+      if constexpr (std::is_arithmetic_v<typename T::value_type>) {
+        total += value.size() * sizeof(typename T::value_type);
+      }
+      else {
+        for (auto&& element: value)
+          total += size(element);
+      }
+      return total;
+    }
+    else if constexpr (is_std_array<T>::value) {
+      std::size_t total = 0;
+      for (auto&& element: value)
+        total += size(element);
+      return total;
+    }
+    else if constexpr (is_optional<T>::value) {
+      return 1 + (value ? size(*value) : 0);
+    }
+    else if constexpr (tuple_like<T>) {
+      return std::apply([] (const auto&... elements) { return (std::size_t{ 0 } + ... + size(elements)); }, value);
+    }
+    else {
+      static_assert(reflectable<T>, "type is not serializable, specialize st::Serializer for it");
+      return size(as_tuple(value));
+    }
+  }
+
+  template<typename T>
+  static void write(Writer& writer, const T& value) noexcept
+  {
+    if constexpr (custom_serializable<T>) {
+      Serializer<T>::write(writer, value);
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+      writer.fixed(static_cast<std::uint8_t>(value));
+    }
+    else if constexpr (std::is_enum_v<T>) {
+      writer.fixed(static_cast<std::underlying_type_t<T>>(value));
+    }
+    else if constexpr (std::is_integral_v<T>) {
+      writer.fixed(value);
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+      writer.fixed(std::bit_cast<unsigned_of<T>>(value));
+    }
+    else if constexpr (is_varint<T>::value) {
+      writer.varint(zigzag(value.value));
+    }
+    else if constexpr (wire_string<T> || byte_span<T>) {
+      writer.varint(value.size());
+      writer.bytes(value.data(), value.size());
+    }
+    else if constexpr (is_vector<T>::value) {
+      using Element = typename T::value_type;
+      writer.varint(value.size());
+      if constexpr (std::is_integral_v<Element> && !std::is_same_v<Element, bool>) {
+        write_integers(writer, std::span<const Element>{ value });
+      }
+      else {
+        for (auto&& element: value)
+          write(writer, element);
+      }
+    }
+    else if constexpr (is_std_array<T>::value) {
+      for (auto&& element: value)
+        write(writer, element);
+    }
+    else if constexpr (is_optional<T>::value) {
+      writer.fixed(static_cast<std::uint8_t>(value.has_value()));
+      if (value)
+        write(writer, *value);
+    }
+    else if constexpr (tuple_like<T>) {
+      std::apply([&writer] (const auto&... elements) { (write(writer, elements), ...); }, value);
+    }
+    else {
+      static_assert(reflectable<T>, "type is not serializable, specialize st::Serializer for it");
+      write(writer, as_tuple(value));
+    }
+  }
+
+  template<typename T>
+  static void read(Reader& reader, T& value)
+  {
+    if constexpr (custom_serializable<T>) {
+      Serializer<T>::read(reader, value);
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+      std::uint8_t flag = 0;
+      if (reader.fixed(flag) && flag > 1)
+        reader.fail();
+      value = flag == 1;
+    }
+    else if constexpr (std::is_enum_v<T>) {
+      std::underlying_type_t<T> underlying{};
+      reader.fixed(underlying);
+      value = static_cast<T>(underlying);
+    }
+    else if constexpr (std::is_integral_v<T>) {
+      reader.fixed(value);
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+      unsigned_of<T> bits{};
+      reader.fixed(bits);
+      value = std::bit_cast<T>(bits);
+    }
+    else if constexpr (is_varint<T>::value) {
+      std::uint64_t encoded = 0;
+      if (!reader.varint(encoded))
+        return;
+
+      auto decoded = unzigzag<decltype(value.value)>(encoded);
+      // 超出目标类型的范围
+      if (zigzag(decoded) != encoded)
+        reader.fail();
+      value.value = decoded;
+    }
+    else if constexpr (wire_string<T> || byte_span<T>) {
+      std::uint64_t length = 0;
+      if (!reader.varint(length))
+        return;
+
+      if (length > reader.remaining()) {
+        reader.fail();
+        return;
+      }
+
+      auto data = reader.take(static_cast<std::size_t>(length));
+
+      // string_view和span直接指向输入，不拷贝
+      if constexpr (byte_span<T>)
+        value = T{ data, static_cast<std::size_t>(length) };
+      else
+        value = T{ reinterpret_cast<const char*>(data), static_cast<std::size_t>(length) };
+    }
+    else if constexpr (is_vector<T>::value) {
+      using Element = typename T::value_type;
+      std::uint64_t count = 0;
+      if (!reader.varint(count))
+        return;
+
+      // 每个元素至少1个字节，先用剩余长度挡住伪造的超大count
+      if (count > reader.remaining()) {
+        reader.fail();
+        return;
+      }
+
+      value.clear();
+      if constexpr (std::is_integral_v<Element> && !std::is_same_v<Element, bool>) {
+        value.resize(static_cast<std::size_t>(count));
+        read_integers(reader, std::span<Element>{ value });
+      }
+      else if constexpr (std::is_same_v<Element, bool>) {
+        // vector<bool>的元素是代理对象，不能直接绑定到bool&
+        value.reserve(static_cast<std::size_t>(count));
+        for (std::uint64_t i = 0; i < count && !reader.failed(); ++i) {
+          bool element = false;
+          read(reader, element);
+          value.push_back(element);
+        }
+      }
+      else {
+        value.reserve(static_cast<std::size_t>(count));
+        for (std::uint64_t i = 0; i < count && !reader.failed(); ++i)
+          read(reader, value.emplace_back());
+      }
+    }
+    else if constexpr (is_std_array<T>::value) {
+      for (auto&& element: value)
+        read(reader, element);
+    }
+    else if constexpr (is_optional<T>::value) {
+      bool present = false;
+      read(reader, present);
+      if (present)
+        read(reader, value.emplace());
+      else
+        value.reset();
+    }
+    else if constexpr (tuple_like<T>) {
+      std::apply([&reader] (auto&... elements) { (read(reader, elements), ...); }, value);
+    }
+    else {
+      static_assert(reflectable<T>, "type is not serializable, specialize st::Serializer for it");
+      auto fields = as_tuple(value);
+      read(reader, fields);
+    }
+  }
+
+private:
+  template<typename Float>
+  using unsigned_of = std::conditional_t<sizeof(Float) == 4, std::uint32_t, std::uint64_t>;
+
+  template<std::integral Integer>
+  constexpr static std::uint64_t zigzag(Integer integer) noexcept
+  {
+    if constexpr (std::is_signed_v<Integer>) {
+      auto value = static_cast<std::int64_t>(integer);
+      return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+    else {
+      return static_cast<std::uint64_t>(integer);
+    }
+  }
+
+  template<std::integral Integer>
+  constexpr static Integer unzigzag(std::uint64_t encoded) noexcept
+  {
+    if constexpr (std::is_signed_v<Integer>)
+      return static_cast<Integer>(static_cast<std::int64_t>((encoded >> 1) ^ (~(encoded & 1) + 1)));
+    else
+      return static_cast<Integer>(encoded);
+  }
+
+  // 整数数组整体拷贝后批量转换字节序，输出没有对齐时逐个转换
+  template<typename Integer>
+  static void write_integers(Writer& writer, std::span<const Integer> integers) noexcept
+  {
+    auto out = writer.reserve(integers.size_bytes());
+    if (out == nullptr || integers.empty())
+      return;
+
+    if (reinterpret_cast<std::uintptr_t>(out) % alignof(Integer) == 0) {
+      byte_order_cast<Net>(integers, std::span<Integer>{ reinterpret_cast<Integer*>(out), integers.size() });
+    }
+    else {
+      for (auto integer: integers) {
+        auto net = byte_order_cast<Net>(integer);
+        std::memcpy(out, &net, sizeof(net));
+        out += sizeof(net);
+      }
+    }
+  }
+
+  template<typename Integer>
+  static void read_integers(Reader& reader, std::span<Integer> integers) noexcept
+  {
+    if (reader.bytes(integers.data(), integers.size_bytes()))
+      byte_order_cast<Host>(integers);
+  }
+};
+
+} // namespace st::detail
+
+
+/**
+ * @brief 可以序列化的类型
+ *
+ * @details 整数、浮点数(网络序，固定长度)、bool、enum、Varint、std::string、std::string_view、
+ * std::span<const std::byte>(varint长度前缀)、std::vector、std::array、std::optional、
+ * std::pair/std::tuple、成员都可序列化且不超过16个成员的聚合(按声明顺序)，以及特化了Serializer的类型
+ */
+template<typename T>
+concept serializable = requires(const T& value, Writer& writer) {
+  detail::Codec::size(value);
+  detail::Codec::write(writer, value);
+};
+
+/**
+ * @brief 序列化后的字节数，用来预先分配缓冲区
+ *
+ */
+template<typename T>
+std::size_t serialized_size(const T& value) noexcept
+{
+  return detail::Codec::size(value);
+}
+
+/**
+ * @brief 把value写入buffer
+ * @example auto written = st::serialize(message, buffer);
+ *
+ * @return Result<std::size_t> 写入的字节数，空间不足时为ENOBUFS
+ */
+template<typename T>
+Result<std::size_t> serialize(const T& value, std::span<std::byte> buffer) noexcept
+{
+  Writer writer{ buffer };
+  detail::Codec::write(writer, value);
+  if (writer.failed())
+    return Error{ ENOBUFS };
+
+  return writer.offset();
+}
+
+/**
+ * @brief 从buffer中读出value
+ *
+ * @warning std::string_view和std::span<const std::byte>成员直接指向buffer，使用期间buffer必须有效
+ * @return Result<std::size_t> 读取的字节数，数据不完整或格式错误时为EBADMSG
+ */
+template<typename T>
+Result<std::size_t> deserialize(std::span<const std::byte> buffer, T& value)
+{
+  Reader reader{ buffer };
+  detail::Codec::read(reader, value);
+  if (reader.failed())
+    return Error{ EBADMSG };
+
+  return reader.offset();
+}
+
+/**
+ * @brief 从buffer中读出一个T
+ * @example auto message = st::deserialize<Message>(payload);
+ *
+ */
+template<std::default_initializable T>
+Result<T> deserialize(std::span<const std::byte> buffer)
+{
+  T value{};
+  auto res = deserialize(buffer, value);
+  if (!res)
+    return Error{ res.error() };
+
+  return value;
+}
+
+} // namespace st
+
+#endif // STUDY_TOUR_SERIALIZE_H
@@ -0,0 +1,824 @@
+/**
+ * @file Sort.h
+ * @author doom (1075101233doom@gmail.com)
+ * @brief 排序: pdqsort、基数排序、基于线程池的并行归并排序
+ * @version 0.1
+ * @date 2022-07-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#ifndef STUDY_TOUR_SORT_H
+#define STUDY_TOUR_SORT_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ST/ThreadPool.h"
+
+
+namespace st {
+
+namespace detail::sort {
+
+// 小于这个长度时插入排序
+constexpr std::ptrdiff_t INSERTION_SORT_THRESHOLD = 24;
+// 大于这个长度时用9个元素的中位数(ninther)选pivot
+constexpr std::ptrdiff_t NINTHER_THRESHOLD = 128;
+// 已经分区好的区间尝试插入排序，移动超过这么多元素就放弃
+constexpr std::size_t PARTIAL_INSERTION_SORT_LIMIT = 8;
+// 无分支分区每次处理的元素数，偏移量用unsigned char保存
+constexpr std::size_t BLOCK_SIZE = 64;
+
+template<typename Iterator, typename Compare>
+void insertion_sort(Iterator begin, Iterator end, Compare& comp)
+{
+  if (begin == end)
+    return;
+
+  for (auto current = begin + 1; current != end; ++current) {
+    auto sift = current;
+    auto sift_1 = current - 1;
+
+    if (comp(*sift, *sift_1)) {
+      auto value = std::move(*sift);
+      do {
+        *sift-- = std::move(*sift_1);
+      } while (sift != begin && comp(value, *--sift_1));
+
+      *sift = std::move(value);
+    }
+  }
+}
+
+// begin左边必须有一个不大于区间内所有元素的元素，省掉边界检查
+template<typename Iterator, typename Compare>
+void unguarded_insertion_sort(Iterator begin, Iterator end, Compare& comp)
+{
+  if (begin == end)
+    return;
+
+  for (auto current = begin + 1; current != end; ++current) {
+    auto sift = current;
+    auto sift_1 = current - 1;
+
+    if (comp(*sift, *sift_1)) {
+      auto value = std::move(*sift);
+      do {
+        *sift-- = std::move(*sift_1);
+      } while (comp(value, *--sift_1));
+
+      *sift = std::move(value);
+    }
+  }
+}
+
+// 移动的元素超过PARTIAL_INSERTION_SORT_LIMIT时放弃，返回false
+template<typename Iterator, typename Compare>
+bool partial_insertion_sort(Iterator begin, Iterator end, Compare& comp)
+{
+  if (begin == end)
+    return true;
+
+  std::size_t moved = 0;
+  for (auto current = begin + 1; current != end; ++current) {
+    auto sift = current;
+    auto sift_1 = current - 1;
+
+    if (comp(*sift, *sift_1)) {
+      auto value = std::move(*sift);
+      do {
+        *sift-- = std::move(*sift_1);
+      } while (sift != begin && comp(value, *--sift_1));
+
+      *sift = std::move(value);
+      moved += static_cast<std::size_t>(current - sift);
+    }
+
+    if (moved > PARTIAL_INSERTION_SORT_LIMIT)
+      return false;
+  }
+
+  return true;
+}
+
+template<typename Iterator, typename Compare>
+void sort2(Iterator a, Iterator b, Compare& comp)
+{
+  if (comp(*b, *a))
+    std::iter_swap(a, b);
+}
+
+template<typename Iterator, typename Compare>
+void sort3(Iterator a, Iterator b, Iterator c, Compare& comp)
+{
+  sort2(a, b, comp);
+  sort2(b, c, comp);
+  sort2(a, b, comp);
+}
+
+/**
+ * @brief 以*begin为pivot分区，等于pivot的元素放在右边
+ *
+ * @return std::pair<Iterator, bool> pivot的位置，区间是否本来就已经分区好
+ */
+template<typename Iterator, typename Compare>
+std::pair<Iterator, bool> partition_right(Iterator begin, Iterator end, Compare& comp)
+{
+  auto pivot = std::move(*begin);
+  auto first = begin;
+  auto last = end;
+
+  // pivot是三个数的中位数，保证左边一定能找到不小于pivot的元素
+  while (comp(*++first, pivot))
+    ;
+
+  if (first - 1 == begin)
+    while (first < last && !comp(*--last, pivot))
+      ;
+  else
+    while (!comp(*--last, pivot))
+      ;
+
+  bool already_partitioned = first >= last;
+  while (first < last) {
+    std::iter_swap(first, last);
+    while (comp(*++first, pivot))
+      ;
+    while (!comp(*--last, pivot))
+      ;
+  }
+
+  auto pivot_position = first - 1;
+  *begin = std::move(*pivot_position);
+  *pivot_position = std::move(pivot);
+
+  return { pivot_position, already_partitioned };
+}
+
+// 把offsets对应的左右元素两两交换，数量相等时用交换，否则用一次循环移位
+template<typename Iterator>
+void swap_offsets(Iterator first, Iterator last,
+                  unsigned char* offsets_l, unsigned char* offsets_r,
+                  std::size_t count, bool use_swaps)
+{
+  if (use_swaps) {
+    for (std::size_t i = 0; i < count; ++i)
+      std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+  }
+  else if (count > 0) {
+    auto l = first + offsets_l[0];
+    auto r = last - offsets_r[0];
+    auto value = std::move(*l);
+    *l = std::move(*r);
+    for (std::size_t i = 1; i < count; ++i) {
+      l = first + offsets_l[i];
+      *r = std::move(*l);
+      r = last - offsets_r[i];
+      *l = std::move(*r);
+    }
+    *r = std::move(value);
+  }
+}
+
+/**
+ * @brief partition_right的无分支版本(BlockQuicksort)
+ *
+ * @details 先把比较结果写成偏移量数组，再批量交换，比较本身不产生分支预测失败，
+ * 只适合比较开销很小的类型
+ */
+template<typename Iterator, typename Compare>
+std::pair<Iterator, bool> partition_right_branchless(Iterator begin, Iterator end, Compare& comp)
+{
+  auto pivot = std::move(*begin);
+  auto first = begin;
+  auto last = end;
+
+  while (comp(*++first, pivot))
+    ;
+
+  if (first - 1 == begin)
+    while (first < last && !comp(*--last, pivot))
+      ;
+  else
+    while (!comp(*--last, pivot))
+      ;
+
+  bool already_partitioned = first >= last;
+  if (!already_partitioned) {
+    std::iter_swap(first, last);
+    ++first;
+
+    alignas(64) unsigned char offsets_l_storage[BLOCK_SIZE];
+    alignas(64) unsigned char offsets_r_storage[BLOCK_SIZE];
+    auto offsets_l = offsets_l_storage;
+    auto offsets_r = offsets_r_storage;
+
+    auto offsets_l_base = first;
+    auto offsets_r_base = last;
+    std::size_t num_l = 0;
+    std::size_t num_r = 0;
+    std::size_t start_l = 0;
+    std::size_t start_r = 0;
+
+    while (first < last) {
+      // 只填充空了的一侧，两侧都空时平分剩余元素
+      auto num_unknown = static_cast<std::size_t>(last - first);
+      auto left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+      auto right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+      if (left_split >= BLOCK_SIZE) {
+        for (std::size_t i = 0; i < BLOCK_SIZE;) {
+          for (std::size_t unroll = 0; unroll < 8; ++unroll) {
+            offsets_l[num_l] = static_cast<unsigned char>(i++);
+            num_l += !comp(*first, pivot);
+            ++first;
+          }
+        }
+      }
+      else {
+        for (std::size_t i = 0; i < left_split;) {
+          offsets_l[num_l] = static_cast<unsigned char>(i++);
+          num_l += !comp(*first, pivot);
+          ++first;
+        }
+      }
+
+      if (right_split >= BLOCK_SIZE) {
+        for (std::size_t i = 0; i < BLOCK_SIZE;) {
+          for (std::size_t unroll = 0; unroll < 8; ++unroll) {
+            offsets_r[num_r] = static_cast<unsigned char>(++i);
+            num_r += comp(*--last, pivot);
+          }
+        }
+      }
+      else {
+        for (std::size_t i = 0; i < right_split;) {
+          offsets_r[num_r] = static_cast<unsigned char>(++i);
+          num_r += comp(*--last, pivot);
+        }
+      }
+
+      auto count = std::min(num_l, num_r);
+      swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, count, num_l == num_r);
+      num_l -= count;
+      num_r -= count;
+      start_l += count;
+      start_r += count;
+
+      if (num_l == 0) {
+        start_l = 0;
+        offsets_l_base = first;
+      }
+
+      if (num_r == 0) {
+        start_r = 0;
+        offsets_r_base = last;
+      }
+    }
+
+    // 剩下一侧还有没交换的元素，把它们移到中间
+    if (num_l != 0) {
+      offsets_l += start_l;
+      while (num_l-- != 0)
+        std::iter_swap(offsets_l_base + offsets_l[num_l], --last);
+      first = last;
+    }
+
+    if (num_r != 0) {
+      offsets_r += start_r;
+      while (num_r-- != 0) {
+        std::iter_swap(offsets_r_base - offsets_r[num_r], first);
+        ++first;
+      }
+      last = first;
+    }
+  }
+
+  auto pivot_position = first - 1;
+  *begin = std::move(*pivot_position);
+  *pivot_position = std::move(pivot);
+
+  return { pivot_position, already_partitioned };
+}
+
+/**
+ * @brief 以*begin为pivot分区，等于pivot的元素放在左边
+ *
+ * @details 左边界之外的元素等于pivot时使用，一次把所有等于pivot的元素排除掉，大量重复元素时是线性的
+ */
+template<typename Iterator, typename Compare>
+Iterator partition_left(Iterator begin, Iterator end, Compare& comp)
+{
+  auto pivot = std::move(*begin);
+  auto first = begin;
+  auto last = end;
+
+  while (comp(pivot, *--last))
+    ;
+
+  if (last + 1 == end)
+    while (first < last && !comp(pivot, *++first))
+      ;
+  else
+    while (!comp(pivot, *++first))
+      ;
+
+  while (first < last) {
+    std::iter_swap(first, last);
+    while (comp(pivot, *--last))
+      ;
+    while (!comp(pivot, *++first))
+      ;
+  }
+
+  auto pivot_position = last;
+  *begin = std::move(*pivot_position);
+  *pivot_position = std::move(pivot);
+
+  return pivot_position;
+}
+
+template<bool Branchless, typename Iterator, typename Compare>
+void pdqsort_loop(Iterator begin, Iterator end, Compare& comp, int bad_allowed, bool leftmost = true)
+{
+  for (;;) {
+    auto size = end - begin;
+
+    if (size < INSERTION_SORT_THRESHOLD) {
+      if (leftmost)
+        insertion_sort(begin, end, comp);
+      else
+        unguarded_insertion_sort(begin, end, comp);
+      return;
+    }
+
+    // pivot放到begin
+    auto half = size / 2;
+    if (size > NINTHER_THRESHOLD) {
+      sort3(begin, begin + half, end - 1, comp);
+      sort3(begin + 1, begin + (half - 1), end - 2, comp);
+      sort3(begin + 2, begin + (half + 1), end - 3, comp);
+      sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+      std::iter_swap(begin, begin + half);
+    }
+    else {
+      sort3(begin + half, begin, end - 1, comp);
+    }
+
+    // 左边的元素(上一次的pivot)等于当前pivot，说明有大量重复，等于pivot的元素都不用再排
+    if (!leftmost && !comp(*(begin - 1), *begin)) {
+      begin = partition_left(begin, end, comp) + 1;
+      continue;
+    }
+
+    auto [pivot_position, already_partitioned] = Branchless ?
+          partition_right_branchless(begin, end, comp) :
+          partition_right(begin, end, comp);
+
+    auto left_size = pivot_position - begin;
+    auto right_size = end - (pivot_position + 1);
+    bool highly_unbalanced = left_size < size / 8 || right_size < size / 8;
+
+    if (highly_unbalanced) {
+      // 不平衡的分区太多，退化成堆排序，保证O(n log n)
+      if (--bad_allowed == 0) {
+        std::make_heap(begin, end, comp);
+        std::sort_heap(begin, end, comp);
+        return;
+      }
+
+      // 打乱可能造成退化的模式
+      if (left_size >= INSERTION_SORT_THRESHOLD) {
+        std::iter_swap(begin, begin + left_size / 4);
+        std::iter_swap(pivot_position - 1, pivot_position - left_size / 4);
+
+        if (left_size > NINTHER_THRESHOLD) {
+          std::iter_swap(begin + 1, begin + (left_size / 4 + 1));
+          std::iter_swap(begin + 2, begin + (left_size / 4 + 2));
+          std::iter_swap(pivot_position - 2, pivot_position - (left_size / 4 + 1));
+          std::iter_swap(pivot_position - 3, pivot_position - (left_size / 4 + 2));
+        }
+      }
+
+      if (right_size >= INSERTION_SORT_THRESHOLD) {
+        std::iter_swap(pivot_position + 1, pivot_position + (1 + right_size / 4));
+        std::iter_swap(end - 1, end - right_size / 4);
+
+        if (right_size > NINTHER_THRESHOLD) {
+          std::iter_swap(pivot_position + 2, pivot_position + (2 + right_size / 4));
+          std::iter_swap(pivot_position + 3, pivot_position + (3 + right_size / 4));
+          std::iter_swap(end - 2, end - (1 + right_size / 4));
+          std::iter_swap(end - 3, end - (2 + right_size / 4));
+        }
+      }
+    }
+    else {
+      // 分区时没有交换任何元素，很可能已经基本有序
+      if (already_partitioned &&
+          partial_insertion_sort(begin, pivot_position, comp) &&
+          partial_insertion_sort(pivot_position + 1, end, comp))
+        return;
+    }
+
+    // 递归较小的一侧时栈深度才是O(log n)，这里递归左侧，坏的分区由bad_allowed兜底
+    pdqsort_loop<Branchless>(begin, pivot_position, comp, bad_allowed, leftmost);
+    begin = pivot_position + 1;
+    leftmost = false;
+  }
+}
+
+// 比较是否足够便宜，可以用无分支分区
+template<typename T, typename Compare>
+constexpr bool branchless_comparable = std::is_arithmetic_v<T> &&
+      (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>> ||
+       std::is_same_v<Compare, std::greater<T>> || std::is_same_v<Compare, std::greater<>> ||
+       std::is_same_v<Compare, std::ranges::less> || std::is_same_v<Compare, std::ranges::greater>);
+
+
+// 基数排序的键映射成无符号整数，保持大小顺序
+template<typename Key>
+constexpr auto radix_key(Key key) noexcept
+{
+  if constexpr (std::is_same_v<Key, bool>) {
+    return static_cast<std::uint8_t>(key);
+  }
+  else if constexpr (std::is_integral_v<Key>) {
+    using Unsigned = std::make_unsigned_t<Key>;
+    if constexpr (std::is_signed_v<Key>)
+      // 翻转符号位，负数排在前面
+      return static_cast<Unsigned>(static_cast<Unsigned>(key) ^ (Unsigned{ 1 } << (sizeof(Key) * 8 - 1)));
+    else
+      return static_cast<Unsigned>(key);
+  }
+  else {
+    static_assert(std::is_floating_point_v<Key> && (sizeof(Key) == 4 || sizeof(Key) == 8),
+                  "radix sort key must be an integer or a float/double");
+    using Unsigned = std::conditional_t<sizeof(Key) == 4, std::uint32_t, std::uint64_t>;
+    constexpr auto SIGN = Unsigned{ 1 } << (sizeof(Key) * 8 - 1);
+    // 正数翻转符号位，负数全部取反
+    auto bits = std::bit_cast<Unsigned>(key);
+    return static_cast<Unsigned>((bits & SIGN) ? ~bits : (bits | SIGN));
+  }
+}
+
+// 小于这个长度时不值得建直方图
+constexpr std::ptrdiff_t RADIX_SORT_THRESHOLD = 64;
+
+template<typename Iterator, typename Key>
+void lsd_radix_sort(Iterator first, Iterator last, Key& key)
+{
+  using Value = std::iter_value_t<Iterator>;
+  using Digits = decltype(radix_key(std::invoke(key, *first)));
+  constexpr std::size_t PASSES = sizeof(Digits);
+
+  auto size = static_cast<std::size_t>(last - first);
+
+  // 一次遍历得到所有字节的直方图
+  std::vector<std::array<std::size_t, 256>> counts(PASSES);
+  for (auto it = first; it != last; ++it) {
+    auto digits = radix_key(std::invoke(key, *it));
+    for (std::size_t pass = 0; pass < PASSES; ++pass)
+      ++counts[pass][(digits >> (pass * 8)) & 0xff];
+  }
+
+  std::vector<Value> buffer(size);
+  bool in_buffer = false;
+
+  for (std::size_t pass = 0; pass < PASSES; ++pass) {
+    auto& count = counts[pass];
+    // 所有元素这个字节都相同，跳过
+    if (std::find(count.begin(), count.end(), size) != count.end())
+      continue;
+
+    std::array<std::size_t, 256> offsets;
+    std::size_t offset = 0;
+    for (std::size_t digit = 0; digit < 256; ++digit) {
+      offsets[digit] = offset;
+      offset += count[digit];
+    }
+
+    auto scatter = [&key, &offsets, pass] (auto from, auto from_last, auto to) {
+      for (; from != from_last; ++from) {
+        auto digit = (radix_key(std::invoke(key, *from)) >> (pass * 8)) & 0xff;
+        to[offsets[digit]++] = std::move(*from);
+      }
+    };
+
+    if (in_buffer)
+      scatter(buffer.begin(), buffer.end(), first);
+    else
+      scatter(first, last, buffer.begin());
+    in_buffer = !in_buffer;
+  }
+
+  if (in_buffer)
+    std::move(buffer.begin(), buffer.end(), first);
+}
+
+// 字符串在depth处的字节，结束时为0，其他字节为1~256
+template<typename Value>
+std::size_t string_digit(const Value& value, std::size_t depth) noexcept
+{
+  std::string_view view{ value };
+  return depth < view.size() ? static_cast<unsigned char>(view[depth]) + std::size_t{ 1 } : 0;
+}
+
+/**
+ * @brief 字符串的MSD基数排序(American flag sort)，原地交换，用显式栈代替递归
+ *
+ */
+template<typename Iterator>
+void msd_radix_sort(Iterator first, Iterator last)
+{
+  using Value = std::iter_value_t<Iterator>;
+
+  struct Range {
+    Iterator first;
+    Iterator last;
+    std::size_t depth;
+  };
+
+  std::vector<Range> ranges{ { first, last, 0 } };
+  while (!ranges.empty()) {
+    auto [begin, end, depth] = ranges.back();
+    ranges.pop_back();
+
+    if (end - begin < RADIX_SORT_THRESHOLD) {
+      auto comp = [depth] (const Value& lhs, const Value& rhs) {
+        return std::string_view{ lhs }.substr(depth) < std::string_view{ rhs }.substr(depth);
+      };
+      insertion_sort(begin, end, comp);
+      continue;
+    }
+
+    std::array<std::size_t, 257> count{};
+    for (auto it = begin; it != end; ++it)
+      ++count[string_digit(*it, depth)];
+
+    std::array<std::ptrdiff_t, 257> heads;
+    std::array<std::ptrdiff_t, 257> tails;
+    std::ptrdiff_t offset = 0;
+    for (std::size_t digit = 0; digit < 257; ++digit) {
+      heads[digit] = offset;
+      offset += static_cast<std::ptrdiff_t>(count[digit]);
+      tails[digit] = offset;
+    }
+
+    // 把每个元素交换到它的桶里，直到每个桶的头追上尾
+    for (std::size_t digit = 0; digit < 257; ++digit) {
+      while (heads[digit] < tails[digit]) {
+        auto target = string_digit(begin[heads[digit]], depth);
+        if (target == digit)
+          ++heads[digit];
+        else
+          std::iter_swap(begin + heads[digit], begin + heads[target]++);
+      }
+    }
+
+    // 桶0的字符串在depth处结束，已经全部相等
+    std::ptrdiff_t bucket_begin = static_cast<std::ptrdiff_t>(count[0]);
+    for (std::size_t digit = 1; digit < 257; ++digit) {
+      auto bucket_end = bucket_begin + static_cast<std::ptrdiff_t>(count[digit]);
+      if (bucket_end - bucket_begin > 1)
+        ranges.push_back({ begin + bucket_begin, begin + bucket_end, depth + 1 });
+      bucket_begin = bucket_end;
+    }
+  }
+}
+
+
+/**
+ * @brief 归并路径划分: 合并a和b时，输出的前diagonal个元素中有多少来自a
+ *
+ * @details 相等时a中的元素在前，和std::merge一致，所以并行归并是稳定的
+ */
+template<typename IteratorA, typename IteratorB, typename Compare>
+std::ptrdiff_t merge_path(IteratorA a, std::ptrdiff_t a_size,
+                          IteratorB b, std::ptrdiff_t b_size,
+                          std::ptrdiff_t diagonal, Compare& comp)
+{
+  auto low = std::max<std::ptrdiff_t>(0, diagonal - b_size);
+  auto high = std::min(diagonal, a_size);
+
+  while (low < high) {
+    auto i = low + (high - low) / 2;
+    auto j = diagonal - i;
+    if (!comp(b[j - 1], a[i]))
+      low = i + 1;
+    else
+      high = i;
+  }
+
+  return low;
+}
+
+// 并行归并排序未指定粒度时，每块至少这么多元素
+constexpr std::size_t MIN_PARALLEL_SORT_GRAIN = std::size_t{ 1 } << 14;
+
+/**
+ * @brief 把from中每两个相邻的width长的有序段合并到to，每段输出按grain切成独立的块并行合并
+ *
+ */
+template<typename From, typename To, typename Compare>
+void parallel_merge_pass(ST::ThreadPool& pool, From from, To to, std::size_t size,
+                         std::size_t width, std::size_t grain, Compare& comp)
+{
+  auto pair_size = 2 * width;
+  auto pairs = (size + pair_size - 1) / pair_size;
+  auto pieces_per_pair = (pair_size + grain - 1) / grain;
+
+  pool.parallel_for(std::size_t{ 0 }, pairs * pieces_per_pair, [&] (std::size_t index) {
+    auto pair = index / pieces_per_pair;
+    auto piece = index % pieces_per_pair;
+
+    auto low = static_cast<std::ptrdiff_t>(pair * pair_size);
+    auto middle = static_cast<std::ptrdiff_t>(std::min(pair * pair_size + width, size));
+    auto high = static_cast<std::ptrdiff_t>(std::min(pair * pair_size + pair_size, size));
+    auto length = high - low;
+
+    auto output_begin = std::min(static_cast<std::ptrdiff_t>(piece * grain), length);
+    auto output_end = std::min(output_begin + static_cast<std::ptrdiff_t>(grain), length);
+    if (output_begin >= output_end)
+      return;
+
+    auto a = from + low;
+    auto b = from + middle;
+    auto a_size = middle - low;
+    auto b_size = high - middle;
+    auto a_begin = merge_path(a, a_size, b, b_size, output_begin, comp);
+    auto a_end = merge_path(a, a_size, b, b_size, output_end, comp);
+
+    std::merge(std::make_move_iterator(a + a_begin), std::make_move_iterator(a + a_end),
+               std::make_move_iterator(b + (output_begin - a_begin)), std::make_move_iterator(b + (output_end - a_end)),
+               to + (low + output_begin), comp);
+  }, 1);
+}
+
+template<bool Stable, typename Iterator, typename Compare>
+void parallel_merge_sort(ST::ThreadPool& pool, Iterator first, Iterator last, Compare& comp, std::size_t grain);
+
+} // namespace detail::sort
+
+
+/**
+ * @brief pattern-defeating quicksort，不稳定，最坏O(n log n)
+ *
+ * @details 和introsort一样不平衡的分区过多时退化为堆排序；另外能识别已经有序、逆序和大量重复的输入，
+ * 这些情况下是线性的；对算术类型和std::less/std::greater使用无分支的块分区
+ * @param comp 严格弱序
+ */
+template<std::random_access_iterator Iterator, typename Compare = std::less<>>
+void sort(Iterator first, Iterator last, Compare comp = {})
+{
+  using Value = std::iter_value_t<Iterator>;
+
+  auto size = last - first;
+  if (size < 2)
+    return;
+
+  auto bad_allowed = static_cast<int>(std::bit_width(static_cast<std::make_unsigned_t<decltype(size)>>(size)));
+  detail::sort::pdqsort_loop<detail::sort::branchless_comparable<Value, Compare>>(first, last, comp, bad_allowed);
+}
+
+template<std::ranges::random_access_range Range, typename Compare = std::less<>>
+void sort(Range&& range, Compare comp = {})
+{
+  st::sort(std::ranges::begin(range), std::ranges::end(range), std::move(comp));
+}
+
+
+/**
+ * @brief 按整数或浮点数键的LSD基数排序，稳定，O(n * sizeof(key))，需要n个元素的额外空间
+ * @example st::radix_sort(orders.begin(), orders.end(), &Order::id);
+ *
+ * @details 键的字节每8位一趟，所有元素某个字节都相同的趟会被跳过；元素很少时退化为插入排序
+ * @param key 可以是成员指针或返回键的函数
+ */
+template<std::random_access_iterator Iterator, typename Key>
+void radix_sort(Iterator first, Iterator last, Key key)
+{
+  if (last - first < detail::sort::RADIX_SORT_THRESHOLD) {
+    auto comp = [&key] (const auto& lhs, const auto& rhs) {
+      return detail::sort::radix_key(std::invoke(key, lhs)) < detail::sort::radix_key(std::invoke(key, rhs));
+    };
+    detail::sort::insertion_sort(first, last, comp);
+    return;
+  }
+
+  detail::sort::lsd_radix_sort(first, last, key);
+}
+
+/**
+ * @brief 对整数、浮点数或字符串本身做基数排序
+ *
+ * @details 字符串(可以转换为std::string_view的类型)使用MSD基数排序，按字节序比较，不稳定
+ */
+template<std::random_access_iterator Iterator>
+void radix_sort(Iterator first, Iterator last)
+{
+  using Value = std::iter_value_t<Iterator>;
+
+  if constexpr (std::is_convertible_v<const Value&, std::string_view>)
+    detail::sort::msd_radix_sort(first, last);
+  else
+    st::radix_sort(first, last, std::identity{});
+}
+
+template<std::ranges::random_access_range Range>
+void radix_sort(Range&& range)
+{
+  st::radix_sort(std::ranges::begin(range), std::ranges::end(range));
+}
+
+
+/**
+ * @brief 在线程池上并行排序，不稳定
+ *
+ * @details 区间切成grain大小的块，各块并行用st::sort排序，再逐轮两两归并；
+ * 每次归并按归并路径切分输出，所以最后一轮也是并行的；需要n个元素的额外空间
+ * @param grain 每块的元素数，为0时自动选择
+ */
+template<std::random_access_iterator Iterator, typename Compare = std::less<>>
+void parallel_sort(ST::ThreadPool& pool, Iterator first, Iterator last, Compare comp = {}, std::size_t grain = 0)
+{
+  detail::sort::parallel_merge_sort<false>(pool, first, last, comp, grain);
+}
+
+/**
+ * @brief 在线程池上并行排序，稳定
+ *
+ * @details 各块用std::stable_sort排序，归并时相等的元素保持原来的顺序
+ */
+template<std::random_access_iterator Iterator, typename Compare = std::less<>>
+void parallel_stable_sort(ST::ThreadPool& pool, Iterator first, Iterator last, Compare comp = {}, std::size_t grain = 0)
+{
+  detail::sort::parallel_merge_sort<true>(pool, first, last, comp, grain);
+}
+
+
+namespace detail::sort {
+
+template<bool Stable, typename Iterator, typename Compare>
+void parallel_merge_sort(ST::ThreadPool& pool, Iterator first, Iterator last, Compare& comp, std::size_t grain)
+{
+  using Value = std::iter_value_t<Iterator>;
+
+  auto size = static_cast<std::size_t>(last - first);
+  if (grain == 0)
+    grain = std::max(MIN_PARALLEL_SORT_GRAIN, size / (pool.size() * 4 + 1));
+
+  auto sort_chunk = [&comp] (Iterator begin, Iterator end) {
+    if constexpr (Stable)
+      std::stable_sort(begin, end, comp);
+    else
+      st::sort(begin, end, comp);
+  };
+
+  if (size <= grain || pool.size() <= 1) {
+    sort_chunk(first, last);
+    return;
+  }
+
+  auto chunks = (size + grain - 1) / grain;
+  pool.parallel_for(std::size_t{ 0 }, chunks, [&] (std::size_t chunk) {
+    auto begin = first + static_cast<std::ptrdiff_t>(chunk * grain);
+    auto end = first + static_cast<std::ptrdiff_t>(std::min(chunk * grain + grain, size));
+    sort_chunk(begin, end);
+  }, 1);
+
+  std::vector<Value> buffer(size);
+  bool in_buffer = false;
+  for (auto width = grain; width < size; width *= 2) {
+    if (in_buffer)
+      parallel_merge_pass(pool, buffer.begin(), first, size, width, grain, comp);
+    else
+      parallel_merge_pass(pool, first, buffer.begin(), size, width, grain, comp);
+    in_buffer = !in_buffer;
+  }
+
+  if (in_buffer) {
+    pool.parallel_for(std::size_t{ 0 }, chunks, [&] (std::size_t chunk) {
+      auto begin = static_cast<std::ptrdiff_t>(chunk * grain);
+      auto end = static_cast<std::ptrdiff_t>(std::min(chunk * grain + grain, size));
+      std::move(buffer.begin() + begin, buffer.begin() + end, first + begin);
+    }, 1);
+  }
+}
+
+} // namespace detail::sort
+
+} // namespace st
+
+#endif // STUDY_TOUR_SORT_H
@@ -1,5 +1,5 @@
-#ifndef STUDY_TOUR_TYPE_TRAITS_H
-#define STUDY_TOUR_TYPE_TRAITS_H
+#ifndef STUDY_TOUR_ST_TYPE_TRAITS_H
+#define STUDY_TOUR_ST_TYPE_TRAITS_H
 
 #include <type_traits>
 #include <cstddef>
@@ -99,4 +99,4 @@ static constexpr bool is_system_clock_v = is_system_clock<Clock>::value;
 
 } // namespace st
 
-#endif // STUDY_TOUR_TYPE_TRAITS_H
\ No newline at end of file
+#endif // STUDY_TOUR_ST_TYPE_TRAITS_H
\ No newline at end of file
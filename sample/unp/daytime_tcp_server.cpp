@@ -1,16 +1,40 @@
 #include <time.h>
 #include <string.h>
 #include <stdio.h>
+#include <signal.h>
+#include <sys/epoll.h>
 
+#include <csignal>
 #include <cstdlib>
 
 #include <fmt/core.h>
 
 #include "ST/Net/Socket.h"
+#include "ST/Net/Poller.h"
+
+
+namespace {
+
+volatile std::sig_atomic_t stopped = 0;
+
+void on_terminate(int)
+{
+  stopped = 1;
+}
+
+} // namespace
 
 
 int main(int argc, char* argv[])
 {
+  struct sigaction sa;
+  sa.sa_handler = on_terminate;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0;
+  sigaction(SIGTERM, &sa, nullptr);
+  sigaction(SIGINT, &sa, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
   ST::Net::Socket socket{};
 
   socket.bind(13);
@@ -18,13 +42,21 @@ int main(int argc, char* argv[])
 
   time_t ticks;
   char buffer[ST::MAX_LINE];
-  while (true) {
+  ST::Net::Poller poller{};
+  poller.add(socket.fd(), EPOLLIN, [&] (std::uint32_t) {
     auto conneting_socket = socket.accept();
 
     ticks = time(nullptr);
     snprintf(buffer, ST::MAX_LINE, "%.24s\r\n", ctime(&ticks));
-    conneting_socket.write(buffer, ST::MAX_LINE);
-  }
+    conneting_socket.write(buffer, strlen(buffer));
+    // 半关闭，客户端读到EOF后自行关闭
+    conneting_socket.shutdown(SHUT_WR);
+  });
+
+  // 收到SIGTERM/SIGINT后停止accept，而不是被直接杀死
+  while (!stopped)
+    poller.poll(100);
 
+  fmt::print("daytime-tcp-server stopped\n");
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+#include <signal.h>
+
+#include <cstdlib>
+
+#include <fmt/core.h>
+
+#include "ST/Net/Socket.h"
+#include "ST/Net/Poller.h"
+#include "ST/Net/Server.h"
+
+
+namespace {
+
+ST::Net::Server* server = nullptr;
+
+void on_terminate(int)
+{
+  if (server != nullptr)
+    server->stop();
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2) {
+    fmt::print("usage: echo-tcp-server <port>\n");
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+
+  ST::Net::Socket listener{};
+  listener.set_option<ST::Net::Option::ReuseAddress>(true);
+  listener.bind(static_cast<in_port_t>(std::atoi(argv[1])));
+  listener.listen();
+
+  ST::Net::Poller poller{};
+  ST::Net::Server echo_server{ poller, std::move(listener) };
+  echo_server.profile(ST::Net::SocketProfile::low_latency());
+  echo_server.on_message([] (ST::Net::Channel& channel, std::span<const std::byte> payload, std::pmr::memory_resource&) {
+    channel.send(payload);
+  });
+
+  server = &echo_server;
+  struct sigaction sa;
+  sa.sa_handler = on_terminate;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0;
+  sigaction(SIGTERM, &sa, nullptr);
+  sigaction(SIGINT, &sa, nullptr);
+
+  echo_server.start();
+  // 收到SIGTERM后停止accept，在途的连接最多等待5秒
+  auto graceful = echo_server.run(std::chrono::seconds{ 5 });
+
+  fmt::print("echo-tcp-server stopped, graceful = {}\n", graceful);
+  return graceful ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,14 +1,14 @@
 #include "ST/APUE.h"
 
+#include <algorithm>
+
+#include "ST/Daemon.h"
+
 
 void daemonize(const char* cmd)
 {
   umask(0);
 
-  struct rlimit rl;
-  if (getrlimit(RLIMIT_NOFILE, &rl) < 0)
-    err_quit("%s: can't get file limit", cmd);
-
   pid_t pid;
   if ((pid = fork()) < 0)
     err_quit("%s: can't fork", cmd);
@@ -25,16 +25,14 @@ void daemonize(const char* cmd)
 
   if ((pid = fork()) < 0)
     err_quit("%s: can't fork", cmd);
-  else if (pid == 0)
+  else if (pid != 0)
     exit(EXIT_SUCCESS);
 
   if (chdir("/") < 0)
     err_quit("%s: can't change directory to /", cmd);
 
-  if (rl.rlim_max == RLIM_INFINITY)
-    rl.rlim_max = 1024;
-  for (int i = 0; i < rl.rlim_max; ++i)
-    close(i);
+  // rlim_max可能非常大(甚至无限)，逐个close很慢也关不全
+  ST::Daemon::close_fds(0);
 
   auto fd0 = open("/dev/null", O_RDWR);
   auto fd1 = dup(0);
@@ -47,12 +45,15 @@ void daemonize(const char* cmd)
   }
 }
 
-ssize_t readn(int fd, char* buf, size_t nbytes)
+ssize_t readn(int fd, void* buf, size_t nbytes)
 {
+  auto ptr = static_cast<char*>(buf);
   auto nleft = nbytes;
   ssize_t nread;
   while (nleft > 0) {
-    if ((nread = read(fd, buf, nleft)) < 0) {
+    if ((nread = read(fd, ptr, nleft)) < 0) {
+      if (errno == EINTR)
+        continue;
       if (nleft == nbytes)
         return -1;
       else
@@ -63,29 +64,30 @@ ssize_t readn(int fd, char* buf, size_t nbytes)
     }
 
     nleft -= nread;
-    buf += nread;
+    ptr += nread;
   }
 
   return nbytes - nleft;
 }
 
-ssize_t writen(int fd, char* buf, size_t nbytes)
+ssize_t writen(int fd, const void* buf, size_t nbytes)
 {
+  auto ptr = static_cast<const char*>(buf);
   auto nleft = nbytes;
   ssize_t nwritten;
   while (nleft > 0) {
-    if ((nwritten = write(fd, buf, nleft)) < 0) {
+    // 写入0字节不是EOF，继续写
+    if ((nwritten = write(fd, ptr, nleft)) < 0) {
+      if (errno == EINTR)
+        continue;
       if (nleft == nbytes)
         return -1;
       else
         break;
     }
-    else if (nwritten == 0) {
-      break;
-    }
 
     nleft -= nwritten;
-    buf += nwritten;
+    ptr += nwritten;
   }
 
   return nbytes - nleft;
@@ -95,15 +97,18 @@ static void err_doit(int errno_flag, int error_no, const char* fmt, va_list ap)
 {
   char buffer[MAX_LINE];
 
-  vsnprintf(buffer, MAX_LINE - 1, fmt, ap);
-  if (errno_flag)
-    snprintf(buffer + strlen(buffer), MAX_LINE - strlen(buffer) - 1,
-          ": %s", strerror(error_no));
+  // vsnprintf返回的是完整长度，截断时以实际写入的为准，避免再用strlen/strcat扫描
+  auto size = std::min(vsnprintf(buffer, MAX_LINE - 1, fmt, ap), MAX_LINE - 2);
+  if (errno_flag && size >= 0)
+    size += std::min(snprintf(buffer + size, MAX_LINE - 1 - size, ": %s", strerror(error_no)),
+                     MAX_LINE - 2 - size);
+  if (size < 0)
+    return;
+  buffer[size++] = '\n';
 
-  strcat(buffer, "\n");
+  // 只需要保证stdout中已有的输出在错误信息之前，不必刷新所有流
   fflush(stdout);
-  fputs(buffer, stderr);
-  fflush(nullptr);
+  writen(STDERR_FILENO, buffer, size);
 }
 
 void err_ret(const char* fmt, ...)
@@ -180,16 +185,19 @@ static void log_doit(int errno_flag, int error_no, int priority, const char* fmt
 {
   char buffer[MAX_LINE];
 
-  vsnprintf(buffer, MAX_LINE - 1, fmt, ap);
-  if (errno_flag)
-    snprintf(buffer + strlen(buffer), MAX_LINE - strlen(buffer) - 1,
-          ": %s", strerror(error_no));
+  // 留出一个字节给换行，写stderr时使用
+  auto size = std::min(vsnprintf(buffer, MAX_LINE - 1, fmt, ap), MAX_LINE - 2);
+  if (errno_flag && size >= 0)
+    size += std::min(snprintf(buffer + size, MAX_LINE - 1 - size, ": %s", strerror(error_no)),
+                     MAX_LINE - 2 - size);
+  if (size < 0)
+    return;
 
-  strcat(buffer, "\n");
   if (log_to_stderr) {
+    // 同步写，不经过Logger的后台线程：daemon和fork出的子进程中没有这个线程，交给它的日志会丢失
+    buffer[size++] = '\n';
     fflush(stdout);
-    fputs(buffer, stderr);
-    fflush(nullptr);
+    writen(STDERR_FILENO, buffer, size);
   }
   else {
     syslog(priority, "%s", buffer);
@@ -0,0 +1,321 @@
+#include "ST/Daemon.h"
+
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <system_error>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "ST/Net/Socket.h"
+
+
+namespace ST {
+
+namespace {
+
+bool under_systemd() noexcept
+{
+  return ::getenv("NOTIFY_SOCKET") != nullptr || ::getenv("INVOCATION_ID") != nullptr;
+}
+
+/**
+ * @brief 关闭[first, last]，优先使用close_range(Linux 5.9)
+ *
+ * @return false 内核不支持close_range
+ */
+bool close_range(unsigned int first, unsigned int last) noexcept
+{
+#ifdef SYS_close_range
+  if (::syscall(SYS_close_range, first, last, 0) == 0)
+    return true;
+#endif
+  return false;
+}
+
+/**
+ * @brief 不支持close_range时遍历/proc/self/fd，只关闭实际打开的fd
+ *
+ */
+void close_fds_by_proc(int first, std::span<const int> keep)
+{
+  auto directory = ::opendir("/proc/self/fd");
+  if (directory == nullptr) {
+    SPDLOG_ERROR("can't open /proc/self/fd: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't list open fds" };
+  }
+
+  // 先收集再关闭，避免关闭正在遍历的目录fd
+  std::vector<int> fds{};
+  auto directory_fd = ::dirfd(directory);
+  while (auto entry = ::readdir(directory)) {
+    if (entry->d_name[0] == '.')
+      continue;
+
+    auto fd = std::atoi(entry->d_name);
+    if (fd >= first && fd != directory_fd && std::find(keep.begin(), keep.end(), fd) == keep.end())
+      fds.push_back(fd);
+  }
+  ::closedir(directory);
+
+  for (auto fd: fds)
+    ::close(fd);
+}
+
+} // namespace
+
+
+Daemon::Daemon(std::string name)
+  : name_{ std::move(name) },
+    mode_{ DaemonMode::Auto },
+    pid_file_{},
+    working_directory_{ "/" },
+    mask_{ 0 },
+    keep_fds_{},
+    locked_pid_file_{}
+{}
+
+Daemon::Daemon(Daemon&& other) noexcept
+  : name_{ std::move(other.name_) },
+    mode_{ other.mode_ },
+    pid_file_{ std::exchange(other.pid_file_, std::nullopt) },
+    working_directory_{ std::move(other.working_directory_) },
+    mask_{ other.mask_ },
+    keep_fds_{ std::move(other.keep_fds_) },
+    locked_pid_file_{ std::exchange(other.locked_pid_file_, std::nullopt) }
+{}
+
+Daemon::~Daemon()
+{
+  if (!locked_pid_file_ || !pid_file_)
+    return;
+
+  // 先删除再关闭，关闭时锁被释放，避免删掉新实例的PID文件
+  ::unlink(pid_file_->c_str());
+  ::close(locked_pid_file_->fd());
+}
+
+
+Daemon& Daemon::mode(DaemonMode mode)
+{
+  mode_ = mode;
+  return *this;
+}
+
+Daemon& Daemon::pid_file(std::string path)
+{
+  pid_file_ = std::move(path);
+  return *this;
+}
+
+Daemon& Daemon::working_directory(std::string path)
+{
+  working_directory_ = std::move(path);
+  return *this;
+}
+
+Daemon& Daemon::file_mode_mask(mode_t mask)
+{
+  mask_ = mask;
+  return *this;
+}
+
+Daemon& Daemon::keep_fds(std::vector<int> fds)
+{
+  keep_fds_ = std::move(fds);
+  return *this;
+}
+
+void Daemon::start()
+{
+  if (mode_ == DaemonMode::Auto)
+    mode_ = under_systemd() ? DaemonMode::Foreground : DaemonMode::Fork;
+
+  SPDLOG_INFO("starting daemon {}, foreground = {}", name_, is_foreground());
+
+  if (mode_ == DaemonMode::Fork)
+    fork_and_detach();
+
+  ::umask(mask_);
+  if (::chdir(working_directory_.c_str()) == -1) {
+    SPDLOG_ERROR("can't change directory to {}: {}", working_directory_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't change working directory" };
+  }
+
+  // Foreground模式下标准输出输入由supervisor接管(journal)，保留
+  close_fds(STDERR_FILENO + 1, keep_fds_);
+  if (mode_ == DaemonMode::Fork)
+    redirect_standard_streams();
+
+  if (pid_file_)
+    lock_pid_file();
+
+  SPDLOG_INFO("started daemon {}, pid = {}", name_, getpid());
+}
+
+void Daemon::ready()
+{
+  notify("READY=1\nMAINPID=" + std::to_string(getpid()));
+}
+
+void Daemon::reloading()
+{
+  notify("RELOADING=1");
+}
+
+void Daemon::stopping()
+{
+  notify("STOPPING=1");
+}
+
+void Daemon::status(std::string_view message)
+{
+  notify(std::string{ "STATUS=" }.append(message));
+}
+
+bool Daemon::notify(std::string_view state)
+{
+  auto path = ::getenv("NOTIFY_SOCKET");
+  if (path == nullptr || path[0] == '\0')
+    return false;
+
+  SPDLOG_INFO("notifying {}: {}", path, state);
+
+  // systemd用'@'表示abstract namespace，和UnixAddress的约定一致
+  Net::Socket socket{ Net::Family::Unix, Net::Type::UDP };
+  socket.connect(std::string{ path });
+  if (socket.write(state.data(), state.size()) != static_cast<ssize_t>(state.size())) {
+    SPDLOG_ERROR("can't notify {}: {}", path, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't notify supervisor" };
+  }
+
+  SPDLOG_INFO("notified {}", path);
+  return true;
+}
+
+void Daemon::close_fds(int first, std::span<const int> keep)
+{
+  SPDLOG_INFO("closing fds from {}, keeping {}", first, keep.size());
+
+  std::vector<int> kept{};
+  for (auto fd: keep) {
+    if (fd >= first)
+      kept.push_back(fd);
+  }
+  std::sort(kept.begin(), kept.end());
+  kept.erase(std::unique(kept.begin(), kept.end()), kept.end());
+
+  // 按保留的fd切分为若干区间，每个区间一次close_range
+  auto low = static_cast<unsigned int>(first);
+  auto supported = true;
+  for (auto fd: kept) {
+    auto high = static_cast<unsigned int>(fd);
+    if (low < high && !close_range(low, high - 1)) {
+      supported = false;
+      break;
+    }
+    low = high + 1;
+  }
+  if (supported)
+    supported = close_range(low, UINT_MAX);
+
+  if (!supported) {
+    SPDLOG_WARN("close_range is unavailable, fallback to /proc/self/fd");
+    close_fds_by_proc(first, kept);
+  }
+
+  SPDLOG_INFO("closed fds from {}", first);
+}
+
+
+void Daemon::fork_and_detach()
+{
+  auto pid = ::fork();
+  if (pid == -1) {
+    SPDLOG_ERROR("can't fork: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't fork" };
+  }
+  if (pid != 0)
+    ::_exit(EXIT_SUCCESS);
+
+  // 成为新会话的首进程，脱离控制终端
+  ::setsid();
+
+  // 会话首进程退出时，会话中的进程会收到SIGHUP
+  struct sigaction action{};
+  action.sa_handler = SIG_IGN;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(SIGHUP, &action, nullptr);
+
+  // 不再是会话首进程，之后打开终端设备也不会成为控制终端
+  pid = ::fork();
+  if (pid == -1) {
+    SPDLOG_ERROR("can't fork: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't fork" };
+  }
+  if (pid != 0)
+    ::_exit(EXIT_SUCCESS);
+
+  // 恢复SIGHUP，守护进程惯例用它重新加载配置
+  action.sa_handler = SIG_DFL;
+  ::sigaction(SIGHUP, &action, nullptr);
+}
+
+void Daemon::redirect_standard_streams()
+{
+  auto null = ::open("/dev/null", O_RDWR);
+  if (null == -1) {
+    SPDLOG_ERROR("can't open /dev/null: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't open /dev/null" };
+  }
+
+  for (auto fd: { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO }) {
+    if (null != fd && ::dup2(null, fd) == -1) {
+      SPDLOG_ERROR("can't redirect fd {} to /dev/null: {}", fd, strerror(errno));
+      throw std::system_error{ errno, std::generic_category(), "can't redirect to /dev/null" };
+    }
+  }
+
+  if (null > STDERR_FILENO)
+    ::close(null);
+}
+
+void Daemon::lock_pid_file()
+{
+  SPDLOG_INFO("locking pid file {}", *pid_file_);
+
+  FileSystem::File file{ *pid_file_ };
+  file.open(O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  // 记录锁在进程退出时自动释放，不会因为崩溃留下失效的锁
+  try {
+    file.write_lock();
+  }
+  catch (const std::system_error& e) {
+    file.close();
+    if (e.code().value() == EAGAIN || e.code().value() == EACCES) {
+      SPDLOG_ERROR("daemon {} is already running, pid file {} is locked", name_, *pid_file_);
+      throw std::runtime_error{ "daemon is already running" };
+    }
+    throw;
+  }
+
+  file.resize(0);
+  auto pid = std::to_string(getpid()) + "\n";
+  file.write(pid.data(), pid.size());
+
+  locked_pid_file_ = std::move(file);
+
+  SPDLOG_INFO("locked pid file {}", *pid_file_);
+}
+
+} // namespace ST
@@ -0,0 +1,94 @@
+#include "ST/EventFd.h"
+
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <system_error>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+EventFd::EventFd(unsigned int initial, int flags)
+  : fd_{ -1 }
+{
+  SPDLOG_INFO("creating eventfd, initial = {}, flags = {:#x}", initial, flags);
+
+  fd_ = ::eventfd(initial, flags);
+  if (fd_ == -1) {
+    SPDLOG_ERROR("can't create eventfd: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't create eventfd" };
+  }
+
+  SPDLOG_INFO("created eventfd {}", fd_);
+}
+
+EventFd::EventFd(EventFd&& other) noexcept
+  : fd_{ std::exchange(other.fd_, -1) }
+{}
+
+EventFd& EventFd::operator=(EventFd&& other) noexcept
+{
+  std::swap(fd_, other.fd_);
+  return *this;
+}
+
+EventFd::~EventFd()
+{
+  if (fd_ != -1)
+    ::close(fd_);
+}
+
+
+void EventFd::notify(std::uint64_t count)
+{
+  for (;;) {
+    auto res = ::write(fd_, &count, sizeof(count));
+    if (res != -1 || errno == EAGAIN)
+      return;
+
+    if (errno != EINTR) {
+      SPDLOG_ERROR("can't notify eventfd {}: {}", fd_, strerror(errno));
+      throw std::system_error{ errno, std::generic_category(), "can't notify eventfd" };
+    }
+  }
+}
+
+std::uint64_t EventFd::consume()
+{
+  std::uint64_t count = 0;
+  for (;;) {
+    auto res = ::read(fd_, &count, sizeof(count));
+    if (res != -1)
+      return count;
+
+    if (errno == EAGAIN)
+      return 0;
+
+    if (errno != EINTR) {
+      SPDLOG_ERROR("can't read eventfd {}: {}", fd_, strerror(errno));
+      throw std::system_error{ errno, std::generic_category(), "can't read eventfd" };
+    }
+  }
+}
+
+bool EventFd::wait(std::chrono::milliseconds timeout)
+{
+  pollfd target{ fd_, POLLIN, 0 };
+  auto res = ::poll(&target, 1, timeout.count() < 0 ? -1 : static_cast<int>(timeout.count()));
+  if (res == -1) {
+    if (errno == EINTR)
+      return false;
+
+    SPDLOG_ERROR("can't wait on eventfd {}: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't wait on eventfd" };
+  }
+
+  return res > 0;
+}
+
+} // namespace ST
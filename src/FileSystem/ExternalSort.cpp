@@ -0,0 +1,190 @@
+#include "ST/FileSystem/ExternalSort.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <system_error>
+
+#include <fmt/format.h>
+
+
+namespace ST::FileSystem::detail {
+
+namespace {
+
+std::atomic<std::size_t> next_temporary_file{ 0 };
+
+std::size_t page_size() noexcept
+{
+  static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+} // namespace
+
+
+std::size_t file_size(const File& file)
+{
+  struct stat status{};
+  if (::fstat(file.fd(), &status) == -1) {
+    SPDLOG_ERROR("can't get file[{}] size", file.file_name());
+    throw std::system_error{ errno, std::generic_category(), "can't get file size" };
+  }
+
+  return static_cast<std::size_t>(status.st_size);
+}
+
+void read_exactly(const File& file, void* buffer, std::size_t n_bytes, off_t offset)
+{
+  auto bytes = static_cast<std::byte*>(buffer);
+  while (n_bytes > 0) {
+    auto readed = file.pread(bytes, n_bytes, offset, std::nothrow);
+    if (!readed) {
+      if (readed.error() == EINTR)
+        continue;
+
+      SPDLOG_ERROR("can't read {} bytes at {} from {}", n_bytes, offset, file.file_name());
+      throw std::system_error{ readed.error(), std::generic_category(), "can't read file" };
+    }
+
+    if (*readed == 0) {
+      SPDLOG_ERROR("{} ended while {} bytes at {} are still expected", file.file_name(), n_bytes, offset);
+      throw std::system_error{ EIO, std::generic_category(), "unexpected end of file" };
+    }
+
+    bytes += *readed;
+    n_bytes -= *readed;
+    offset += static_cast<off_t>(*readed);
+  }
+}
+
+void write_exactly(File& file, const void* buffer, std::size_t n_bytes, off_t offset)
+{
+  auto bytes = static_cast<const std::byte*>(buffer);
+  while (n_bytes > 0) {
+    auto written = file.pwrite(bytes, n_bytes, offset, std::nothrow);
+    if (!written) {
+      if (written.error() == EINTR)
+        continue;
+
+      SPDLOG_ERROR("can't write {} bytes at {} to {}", n_bytes, offset, file.file_name());
+      throw std::system_error{ written.error(), std::generic_category(), "can't write file" };
+    }
+
+    bytes += *written;
+    n_bytes -= *written;
+    offset += static_cast<off_t>(*written);
+  }
+}
+
+
+TemporaryFile::TemporaryFile(const std::string& directory)
+  : file_{ File::tmpfile(fmt::format("{}/st-external-sort-{}-{}", directory, ::getpid(),
+                                     next_temporary_file.fetch_add(1, std::memory_order_relaxed)).c_str(),
+                         O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR) }
+{}
+
+TemporaryFile& TemporaryFile::operator=(TemporaryFile&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    file_ = std::move(other.file_);
+  }
+
+  return *this;
+}
+
+TemporaryFile::~TemporaryFile()
+{
+  release();
+}
+
+void TemporaryFile::release() noexcept
+{
+  if (!file_.opened())
+    return;
+
+  try {
+    file_.close();
+  }
+  catch (const std::exception& e) {
+    SPDLOG_WARN("can't close temporary file[{}]: {}", file_.file_name(), e.what());
+  }
+}
+
+
+MappedFile::MappedFile(const File& file, std::size_t size)
+  : data_{ nullptr }, size_{ size }
+{
+  auto data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+  if (data == MAP_FAILED) {
+    auto error = errno;
+    SPDLOG_ERROR("can't map file[{}, {} bytes]: {}", file.file_name(), size_, strerror(error));
+    throw std::system_error{ error, std::generic_category(), "can't map file" };
+  }
+
+  data_ = static_cast<std::byte*>(data);
+  ::madvise(data_, size_, MADV_SEQUENTIAL);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_{ std::exchange(other.data_, nullptr) },
+    size_{ std::exchange(other.size_, 0) }
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+
+  return *this;
+}
+
+MappedFile::~MappedFile()
+{
+  release();
+}
+
+/**
+ * @details madvise要求起始地址按页对齐，起点向下取整，多预读一点没有影响
+ *
+ */
+void MappedFile::will_need(std::size_t offset, std::size_t length) const noexcept
+{
+  length = std::min(length, size_ - std::min(offset, size_));
+  if (length == 0)
+    return;
+
+  auto begin = offset / page_size() * page_size();
+  ::madvise(data_ + begin, offset + length - begin, MADV_WILLNEED);
+}
+
+/**
+ * @details 只释放完全落在区间内的页，起点向上取整、终点向下取整，和下一块共享的页保留
+ *
+ */
+void MappedFile::discard(std::size_t offset, std::size_t length) const noexcept
+{
+  auto begin = (offset + page_size() - 1) / page_size() * page_size();
+  auto end = std::min(offset + length, size_) / page_size() * page_size();
+  if (begin < end)
+    ::madvise(data_ + begin, end - begin, MADV_DONTNEED);
+}
+
+void MappedFile::release() noexcept
+{
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+    data_ = nullptr;
+  }
+}
+
+} // namespace ST::FileSystem::detail
@@ -13,13 +13,17 @@
 
 #include "ST/Common.h"
 #include "ST/FileSystem/FileStatus.h"
+#include "ST/Metrics.h"
 
 
 namespace ST::FileSystem {
 
 File::File(const std::string& file_name, int fd)
   : fd_{ fd }, file_name_{ file_name }
-{}
+{
+  // noexcept的读写路径只查找不构造埋点，在这里提前构造
+  FileMetrics::instance();
+}
 
 /**
  * @details 复制语义自动调用dup，也就是说每个File对象都保存的不同fd<br/>
@@ -64,7 +68,9 @@ File::File(File&& other) noexcept
  */
 File& File::operator=(File&& other) noexcept
 {
-  std::swap(*this, other);
+  // std::swap(*this, other)会再次调用移动赋值，无限递归
+  std::swap(fd_, other.fd_);
+  std::swap(file_name_, other.file_name_);
   return *this;
 }
 
@@ -263,14 +269,14 @@ ssize_t File::read(void* buffer, size_t n_bytes) const
 
   SPDLOG_INFO("reading {} bytes from {}", n_bytes, file_name_);
 
-  auto readed = ::read(fd_, buffer, n_bytes);
-  if (readed == -1) {
+  auto readed = read(buffer, n_bytes, std::nothrow);
+  if (!readed) {
     SPDLOG_ERROR("can't read from file {}", file_name_);
-    throw std::system_error{ errno, std::generic_category(), "can't read file" };
+    throw std::system_error{ readed.error(), std::generic_category(), "can't read file" };
   }
 
-  SPDLOG_INFO("readed {} bytes from file {}", readed, file_name_);
-  return readed;
+  SPDLOG_INFO("readed {} bytes from file {}", *readed, file_name_);
+  return static_cast<ssize_t>(*readed);
 }
 
 ssize_t File::write(const void* buffer, size_t n_bytes)
@@ -282,14 +288,14 @@ ssize_t File::write(const void* buffer, size_t n_bytes)
 
   SPDLOG_INFO("writing {} bytes to {}", n_bytes, file_name_);
 
-  auto writted = ::write(fd_, buffer, n_bytes);
-  if (writted == -1) {
+  auto writted = write(buffer, n_bytes, std::nothrow);
+  if (!writted) {
     SPDLOG_ERROR("can't write to file {}", file_name_);
-    throw std::system_error{ errno, std::generic_category(), "can't write file" };
+    throw std::system_error{ writted.error(), std::generic_category(), "can't write file" };
   }
 
-  SPDLOG_INFO("writted {} bytes to {}", n_bytes, file_name_);
-  return writted;
+  SPDLOG_INFO("writted {} bytes to {}", *writted, file_name_);
+  return static_cast<ssize_t>(*writted);
 }
 
 ssize_t File::pread(void* buffer, size_t n_bytes, off_t offset) const
@@ -301,14 +307,14 @@ ssize_t File::pread(void* buffer, size_t n_bytes, off_t offset) const
 
   SPDLOG_INFO("reading {} bytes from {} offset = {}", n_bytes, file_name_, offset);
 
-  auto readed = ::pread(fd_, buffer, n_bytes, offset);
-  if (readed == -1) {
+  auto readed = pread(buffer, n_bytes, offset, std::nothrow);
+  if (!readed) {
     SPDLOG_ERROR("can't read from file {}", file_name_);
-    throw std::system_error{ errno, std::generic_category(), "can't read file" };
+    throw std::system_error{ readed.error(), std::generic_category(), "can't read file" };
   }
 
-  SPDLOG_INFO("readed {} bytes from {} offset = {}", n_bytes, file_name_, offset);
-  return readed;
+  SPDLOG_INFO("readed {} bytes from {} offset = {}", *readed, file_name_, offset);
+  return static_cast<ssize_t>(*readed);
 }
 
 ssize_t File::pwrite(const void* buffer, size_t n_bytes, off_t offset)
@@ -320,14 +326,78 @@ ssize_t File::pwrite(const void* buffer, size_t n_bytes, off_t offset)
 
   SPDLOG_INFO("writing {} bytes to {} offset = {}", n_bytes, file_name_, offset);
 
-  auto writted = ::pwrite(fd_, buffer, n_bytes, offset);
-  if (writted == -1) {
+  auto writted = pwrite(buffer, n_bytes, offset, std::nothrow);
+  if (!writted) {
     SPDLOG_ERROR("can't write to file {}", file_name_);
-    throw std::system_error{ errno, std::generic_category(), "can't write file" };
+    throw std::system_error{ writted.error(), std::generic_category(), "can't write file" };
   }
 
-  SPDLOG_INFO("writted {} bytes to {} offset = {}", n_bytes, file_name_, offset);
-  return writted;
+  SPDLOG_INFO("writted {} bytes to {} offset = {}", *writted, file_name_, offset);
+  return static_cast<ssize_t>(*writted);
+}
+
+st::Result<std::size_t> File::read(void* buffer, size_t n_bytes, std::nothrow_t) const noexcept
+{
+  if (!opened())
+    return st::Error{ EBADF };
+
+  auto start = Histogram::Clock::now();
+  auto readed = ::read(fd_, buffer, n_bytes);
+  auto error = errno;
+  if (auto metrics = FileMetrics::find())
+    metrics->read.record(readed, start);
+  if (readed == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(readed);
+}
+
+st::Result<std::size_t> File::write(const void* buffer, size_t n_bytes, std::nothrow_t) noexcept
+{
+  if (!opened())
+    return st::Error{ EBADF };
+
+  auto start = Histogram::Clock::now();
+  auto writted = ::write(fd_, buffer, n_bytes);
+  auto error = errno;
+  if (auto metrics = FileMetrics::find())
+    metrics->write.record(writted, start);
+  if (writted == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(writted);
+}
+
+st::Result<std::size_t> File::pread(void* buffer, size_t n_bytes, off_t offset, std::nothrow_t) const noexcept
+{
+  if (!opened())
+    return st::Error{ EBADF };
+
+  auto start = Histogram::Clock::now();
+  auto readed = ::pread(fd_, buffer, n_bytes, offset);
+  auto error = errno;
+  if (auto metrics = FileMetrics::find())
+    metrics->read.record(readed, start);
+  if (readed == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(readed);
+}
+
+st::Result<std::size_t> File::pwrite(const void* buffer, size_t n_bytes, off_t offset, std::nothrow_t) noexcept
+{
+  if (!opened())
+    return st::Error{ EBADF };
+
+  auto start = Histogram::Clock::now();
+  auto writted = ::pwrite(fd_, buffer, n_bytes, offset);
+  auto error = errno;
+  if (auto metrics = FileMetrics::find())
+    metrics->write.record(writted, start);
+  if (writted == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(writted);
 }
 
 void File::synchronize()
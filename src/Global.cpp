@@ -15,6 +15,8 @@ int to_int(Family family)
     return AF_INET;
   case Family::IPv6:
     return AF_INET6;
+  case Family::Unix:
+    return AF_UNIX;
   default:    // never happen
     throw UndefinedFamilyException{ "undifiend family type" };
   }
@@ -48,6 +50,8 @@ std::string to_string(Family family)
     return "IPv4";
   case Family::IPv6:
     return "IPv6";
+  case Family::Unix:
+    return "Unix";
   default:    // never happen
     throw UndefinedFamilyException{ "undifiend family type" };
   }
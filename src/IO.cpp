@@ -0,0 +1,219 @@
+#include "ST/IO.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+
+#include <algorithm>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+namespace {
+
+/**
+ * @brief 非阻塞fd在EAGAIN之后等待就绪
+ *
+ */
+void wait_ready(int fd, short events)
+{
+  pollfd target{ fd, events, 0 };
+  while (::poll(&target, 1, -1) == -1) {
+    if (errno != EINTR) {
+      SPDLOG_ERROR("can't poll fd {}: {}", fd, strerror(errno));
+      throw std::system_error{ errno, std::generic_category(), "can't poll" };
+    }
+  }
+}
+
+bool would_block() noexcept
+{
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+/**
+ * @brief 对socket用MSG_NOSIGNAL发送，对端重置时返回EPIPE而不是触发SIGPIPE；
+ * 不是socket(ENOTSOCK)时退回write，并记在is_socket里避免之后每次都多一次系统调用
+ *
+ */
+ssize_t write_some(int fd, const std::byte* data, std::size_t size, bool& is_socket) noexcept
+{
+  if (is_socket) {
+    auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (n != -1 || errno != ENOTSOCK)
+      return n;
+    is_socket = false;
+  }
+  return ::write(fd, data, size);
+}
+
+ssize_t writev_some(int fd, const iovec* buffers, int count, bool& is_socket) noexcept
+{
+  if (is_socket) {
+    msghdr message{};
+    message.msg_iov = const_cast<iovec*>(buffers);
+    message.msg_iovlen = static_cast<std::size_t>(count);
+    auto n = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+    if (n != -1 || errno != ENOTSOCK)
+      return n;
+    is_socket = false;
+  }
+  return ::writev(fd, buffers, count);
+}
+
+/**
+ * @brief 前移已经处理过的n个字节，返回第一个没有处理完的iovec
+ *
+ */
+std::span<iovec> advance(std::span<iovec> buffers, std::size_t n) noexcept
+{
+  std::size_t i = 0;
+  for (; i < buffers.size() && n >= buffers[i].iov_len; ++i) {
+    n -= buffers[i].iov_len;
+    buffers[i].iov_base = static_cast<std::byte*>(buffers[i].iov_base) + buffers[i].iov_len;
+    buffers[i].iov_len = 0;
+  }
+
+  if (i < buffers.size()) {
+    buffers[i].iov_base = static_cast<std::byte*>(buffers[i].iov_base) + n;
+    buffers[i].iov_len -= n;
+  }
+
+  return buffers.subspan(i);
+}
+
+// 跳过开头长度为0的iovec，否则全是空buffer时readv返回0会被当成EOF
+std::span<iovec> skip_empty(std::span<iovec> buffers) noexcept
+{
+  auto first = std::find_if(buffers.begin(), buffers.end(), [] (const iovec& v) { return v.iov_len != 0; });
+  return buffers.subspan(static_cast<std::size_t>(first - buffers.begin()));
+}
+
+} // namespace
+
+
+std::size_t read_exact(int fd, std::span<std::byte> buffer)
+{
+  SPDLOG_INFO("reading exactly {} bytes from fd {}", buffer.size(), fd);
+
+  std::size_t total = 0;
+  while (total < buffer.size()) {
+    auto n = ::read(fd, buffer.data() + total, buffer.size() - total);
+    if (n > 0) {
+      total += static_cast<std::size_t>(n);
+      continue;
+    }
+    if (n == 0)
+      break;
+
+    if (errno == EINTR)
+      continue;
+    if (would_block()) {
+      wait_ready(fd, POLLIN);
+      continue;
+    }
+
+    SPDLOG_ERROR("can't read from fd {}: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't read" };
+  }
+
+  SPDLOG_INFO("read {} bytes from fd {}", total, fd);
+  return total;
+}
+
+std::size_t write_all(int fd, std::span<const std::byte> buffer)
+{
+  SPDLOG_INFO("writing all {} bytes to fd {}", buffer.size(), fd);
+
+  std::size_t total = 0;
+  bool is_socket = true;
+  while (total < buffer.size()) {
+    // 写入0字节不代表EOF，继续写
+    auto n = write_some(fd, buffer.data() + total, buffer.size() - total, is_socket);
+    if (n >= 0) {
+      total += static_cast<std::size_t>(n);
+      continue;
+    }
+
+    if (errno == EINTR)
+      continue;
+    if (would_block()) {
+      wait_ready(fd, POLLOUT);
+      continue;
+    }
+
+    SPDLOG_ERROR("can't write to fd {}: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't write" };
+  }
+
+  SPDLOG_INFO("wrote {} bytes to fd {}", total, fd);
+  return total;
+}
+
+std::size_t read_exact(int fd, std::span<iovec> buffers)
+{
+  SPDLOG_INFO("reading {} buffers from fd {}", buffers.size(), fd);
+
+  std::size_t total = 0;
+  for (auto rest = skip_empty(buffers); !rest.empty(); rest = skip_empty(rest)) {
+    auto count = static_cast<int>(std::min<std::size_t>(rest.size(), IOV_MAX));
+    auto n = ::readv(fd, rest.data(), count);
+    if (n > 0) {
+      total += static_cast<std::size_t>(n);
+      rest = advance(rest, static_cast<std::size_t>(n));
+      continue;
+    }
+    if (n == 0)
+      break;
+
+    if (errno == EINTR)
+      continue;
+    if (would_block()) {
+      wait_ready(fd, POLLIN);
+      continue;
+    }
+
+    SPDLOG_ERROR("can't readv from fd {}: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't readv" };
+  }
+
+  SPDLOG_INFO("read {} bytes from fd {}", total, fd);
+  return total;
+}
+
+std::size_t write_all(int fd, std::span<iovec> buffers)
+{
+  SPDLOG_INFO("writing {} buffers to fd {}", buffers.size(), fd);
+
+  std::size_t total = 0;
+  bool is_socket = true;
+  for (auto rest = skip_empty(buffers); !rest.empty(); rest = skip_empty(rest)) {
+    auto count = static_cast<int>(std::min<std::size_t>(rest.size(), IOV_MAX));
+    auto n = writev_some(fd, rest.data(), count, is_socket);
+    if (n >= 0) {
+      total += static_cast<std::size_t>(n);
+      rest = advance(rest, static_cast<std::size_t>(n));
+      continue;
+    }
+
+    if (errno == EINTR)
+      continue;
+    if (would_block()) {
+      wait_ready(fd, POLLOUT);
+      continue;
+    }
+
+    SPDLOG_ERROR("can't writev to fd {}: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't writev" };
+  }
+
+  SPDLOG_INFO("wrote {} bytes to fd {}", total, fd);
+  return total;
+}
+
+} // namespace ST
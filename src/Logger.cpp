@@ -0,0 +1,338 @@
+#include "ST/Logger.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <algorithm>
+#include <bit>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/details/null_mutex.h>
+
+
+namespace ST {
+
+namespace {
+
+// 每个Logger的唯一编号，线程的缓冲区按编号查找，不会因为Logger地址被复用而找错
+std::atomic<std::uint64_t> next_logger_id{ 0 };
+
+/**
+ * @brief 转发给Logger的spdlog sink，调用线程只做拷贝
+ *
+ * @details Logger本身是线程安全的，所以不需要sink的锁
+ */
+class SpdlogSink: public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+public:
+  explicit SpdlogSink(Logger& logger) : logger_{ logger } {}
+
+protected:
+  void sink_it_(const spdlog::details::log_msg& message) override
+  {
+    // 两者的级别顺序一致
+    logger_.write(static_cast<LogLevel>(message.level),
+                  std::string_view{ message.payload.data(), message.payload.size() });
+  }
+
+  void flush_() override { logger_.flush(); }
+
+private:
+  Logger& logger_;
+};
+
+/**
+ * @brief 写入"[2022-07-19 12:00:00.123456] "，同一秒内复用格式化好的前缀
+ *
+ * @details 只在后台线程调用
+ */
+void format_time(std::chrono::system_clock::time_point time, fmt::memory_buffer& out)
+{
+  thread_local std::time_t cached_second = -1;
+  thread_local char cached[32];
+  thread_local std::size_t cached_size = 0;
+
+  auto since_epoch = time.time_since_epoch();
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+  auto micros = std::chrono::duration_cast<std::chrono::microseconds>(since_epoch - seconds).count();
+
+  if (seconds.count() != cached_second) {
+    cached_second = seconds.count();
+    struct tm local;
+    ::localtime_r(&cached_second, &local);
+    cached_size = ::strftime(cached, sizeof(cached), "[%Y-%m-%d %H:%M:%S.", &local);
+  }
+
+  out.append(cached, cached + cached_size);
+  fmt::format_to(fmt::appender{ out }, "{:06}] ", micros);
+}
+
+} // namespace
+
+
+thread_local Logger::ThreadRings Logger::thread_rings_{};
+thread_local bool Logger::in_backend_ = false;
+
+
+std::string_view to_string(LogLevel level) noexcept
+{
+  switch (level) {
+  case LogLevel::Trace:
+    return "trace";
+  case LogLevel::Debug:
+    return "debug";
+  case LogLevel::Info:
+    return "info";
+  case LogLevel::Warn:
+    return "warn";
+  case LogLevel::Error:
+    return "error";
+  case LogLevel::Critical:
+    return "critical";
+  case LogLevel::Off:
+  default:
+    return "off";
+  }
+}
+
+
+Logger::Ring::Ring(std::size_t capacity)
+  : buffer_{},
+    capacity_{ std::bit_ceil(std::max(capacity, sizeof(Record) * 64)) },
+    tid_{ static_cast<pid_t>(::syscall(SYS_gettid)) },
+    retired_{ false },
+    head_{ 0 },
+    pending_{ 0 },
+    cached_tail_{ 0 },
+    tail_{ 0 }
+{
+  buffer_ = std::make_unique<std::byte[]>(capacity_);
+}
+
+std::byte* Logger::Ring::reserve(std::size_t size) noexcept
+{
+  auto head = head_.load(std::memory_order_relaxed);
+  auto offset = head & (capacity_ - 1);
+  // 记录必须连续，末尾放不下时跳过剩余部分
+  auto padding = capacity_ - offset < size ? capacity_ - offset : 0;
+  auto needed = padding + size;
+
+  if (needed > capacity_ - (head - cached_tail_)) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (needed > capacity_ - (head - cached_tail_))
+      return nullptr;
+  }
+
+  // 剩余部分连Record都放不下时消费者会自己跳过
+  if (padding >= sizeof(Record))
+    new (buffer_.get() + offset) Record{ static_cast<std::uint32_t>(padding), LogLevel::Off, nullptr, nullptr, 0, {} };
+
+  pending_ = head + needed;
+  return buffer_.get() + ((head + padding) & (capacity_ - 1));
+}
+
+template<typename Function>
+std::size_t Logger::Ring::consume(Function&& f)
+{
+  auto tail = tail_.load(std::memory_order_relaxed);
+  auto head = head_.load(std::memory_order_acquire);
+
+  std::size_t count = 0;
+  while (tail != head) {
+    auto offset = tail & (capacity_ - 1);
+    auto remaining = capacity_ - offset;
+    if (remaining < sizeof(Record)) {
+      tail += remaining;
+      continue;
+    }
+
+    auto record = reinterpret_cast<const Record*>(buffer_.get() + offset);
+    if (record->decode == nullptr) {
+      tail += remaining;
+      continue;
+    }
+
+    f(*record, reinterpret_cast<const std::byte*>(record + 1));
+    tail += record->size;
+    ++count;
+  }
+
+  tail_.store(tail, std::memory_order_release);
+  return count;
+}
+
+
+Logger::ThreadRings::~ThreadRings()
+{
+  // 剩下的记录由后台线程写完后再释放
+  for (auto& [id, ring]: rings)
+    ring->retire();
+}
+
+
+Logger::Logger(FileSystem::File sink, std::size_t ring_size)
+  : id_{ next_logger_id.fetch_add(1, std::memory_order_relaxed) },
+    sink_{ std::move(sink) },
+    ring_size_{ ring_size },
+    level_{ LogLevel::Info },
+    dropped_{ 0 },
+    mutex_{},
+    wakeup_{},
+    flushed_{},
+    rings_{},
+    flush_requested_{ 0 },
+    flush_completed_{ 0 },
+    previous_spdlog_{},
+    backend_{ [this] (std::stop_token token) { run(token); } }
+{}
+
+Logger::~Logger()
+{
+  if (previous_spdlog_)
+    spdlog::set_default_logger(std::move(previous_spdlog_));
+
+  backend_.request_stop();
+  backend_.join();
+}
+
+Logger& Logger::instance()
+{
+  static Logger logger{};
+  return logger;
+}
+
+void Logger::flush()
+{
+  // 后台线程自己等自己会死锁
+  if (in_backend_)
+    return;
+
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  auto ticket = ++flush_requested_;
+  wakeup_.notify_one();
+  flushed_.wait(lock, [this, ticket] { return flush_completed_ >= ticket; });
+}
+
+void Logger::install_spdlog()
+{
+  SPDLOG_INFO("installing async logger as spdlog default logger");
+
+  auto previous = spdlog::default_logger();
+  auto logger = std::make_shared<spdlog::logger>(previous->name(), std::make_shared<SpdlogSink>(*this));
+  logger->set_level(previous->level());
+  spdlog::set_default_logger(std::move(logger));
+
+  // 重复install时保留最初的logger
+  if (!previous_spdlog_)
+    previous_spdlog_ = std::move(previous);
+}
+
+
+Logger::Ring& Logger::local_ring()
+{
+  for (auto& [id, ring]: thread_rings_.rings) {
+    if (id == id_)
+      return *ring;
+  }
+
+  auto ring = std::make_shared<Ring>(ring_size_);
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    rings_.push_back(ring);
+  }
+  thread_rings_.rings.emplace_back(id_, ring);
+
+  return *ring;
+}
+
+void Logger::run(std::stop_token token)
+{
+  // 后台线程写文件时File::write本身也会打日志，全部忽略，避免自己喂自己
+  in_backend_ = true;
+
+  fmt::memory_buffer batch{};
+  std::uint64_t reported = 0;
+  for (;;) {
+    std::uint64_t requested;
+    {
+      std::lock_guard<std::mutex> lock{ mutex_ };
+      requested = flush_requested_;
+    }
+
+    auto drained = drain(batch);
+
+    auto dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported) {
+      format_time(std::chrono::system_clock::now(), batch);
+      fmt::format_to(fmt::appender{ batch }, "[warn] dropped {} log messages, ring buffer is full\n", dropped - reported);
+      reported = dropped;
+    }
+    write_batch(batch);
+
+    std::unique_lock<std::mutex> lock{ mutex_ };
+    if (flush_completed_ != requested) {
+      flush_completed_ = requested;
+      flushed_.notify_all();
+    }
+
+    if (drained == 0) {
+      if (token.stop_requested())
+        break;
+
+      wakeup_.wait_for(lock, token, LOG_IDLE_INTERVAL, [this] { return flush_requested_ != flush_completed_; });
+    }
+  }
+}
+
+std::size_t Logger::drain(fmt::memory_buffer& batch)
+{
+  std::vector<std::shared_ptr<Ring>> rings{};
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    rings = rings_;
+  }
+
+  std::size_t drained = 0;
+  for (auto& ring: rings) {
+    // 先看是否退休再消费，退休之后所属线程不会再写
+    auto retired = ring->retired();
+
+    drained += ring->consume([&] (const Record& record, const std::byte* arguments) {
+      format_time(record.time, batch);
+      fmt::format_to(fmt::appender{ batch }, "[{}] [{}] ", to_string(record.level), ring->tid());
+      record.decode(std::string_view{ record.format, record.format_size }, arguments, batch);
+      batch.push_back('\n');
+
+      if (batch.size() >= LOG_BATCH_SIZE)
+        write_batch(batch);
+    });
+
+    if (retired) {
+      std::lock_guard<std::mutex> lock{ mutex_ };
+      std::erase(rings_, ring);
+    }
+  }
+
+  return drained;
+}
+
+void Logger::write_batch(fmt::memory_buffer& batch) noexcept
+{
+  std::size_t written = 0;
+  try {
+    while (written < batch.size()) {
+      auto n = sink_.write(batch.data() + written, batch.size() - written);
+      if (n <= 0)
+        break;
+      written += static_cast<std::size_t>(n);
+    }
+  }
+  catch (...) {
+    // 日志本身写不出去时没有地方可以报告
+  }
+
+  batch.clear();
+}
+
+} // namespace ST
@@ -0,0 +1,275 @@
+#include "ST/Memory.h"
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "ST/Singleton.h"
+
+
+namespace ST {
+
+namespace {
+
+// 线程缓存，线程退出后留给之后的线程复用
+struct ThreadCache {
+  std::array<detail::FreeList, detail::SIZE_CLASSES> lists{};
+};
+
+// 每次和中心链表交换的块数，小对象一批多一些，一批最多占SLAB_SIZE的1/4
+constexpr std::size_t batch_size(std::size_t size_class) noexcept
+{
+  return std::clamp<std::size_t>(SLAB_SIZE / 4 / detail::class_size(size_class), 4, 64);
+}
+
+// 把slab切成size_class级的块，全部放进list
+void carve(void* slab, std::size_t size_class, detail::FreeList& list) noexcept
+{
+  auto size = detail::class_size(size_class);
+  auto bytes = static_cast<std::byte*>(slab);
+  // 倒序放入，分配时按地址递增的顺序取出
+  for (auto offset = SLAB_SIZE / size * size; offset >= size; offset -= size)
+    list.push(bytes + offset - size);
+}
+
+} // namespace
+
+
+MonotonicArena::MonotonicArena(std::size_t initial_size, std::pmr::memory_resource* upstream)
+  : upstream_{ upstream },
+    initial_{},
+    chunks_{ nullptr },
+    spare_{ nullptr },
+    current_{ nullptr },
+    end_{ nullptr },
+    next_size_{ std::max<std::size_t>(initial_size, sizeof(Chunk) + SMALL_ALIGNMENT) },
+    allocated_{ 0 }
+{}
+
+MonotonicArena::MonotonicArena(std::span<std::byte> buffer, std::pmr::memory_resource* upstream)
+  : upstream_{ upstream },
+    initial_{ buffer },
+    chunks_{ nullptr },
+    spare_{ nullptr },
+    current_{ buffer.data() },
+    end_{ buffer.data() + buffer.size() },
+    next_size_{ std::max<std::size_t>(buffer.size() * 2, DEFAULT_ARENA_SIZE) },
+    allocated_{ 0 }
+{}
+
+MonotonicArena::~MonotonicArena()
+{
+  release();
+}
+
+/**
+ * @details 新申请的块比之前的大，但grow()可能在大块之后又复用了较小的备用块，
+ * 所以链表头部不一定最大；遍历所有块和原来的备用块，留下最大的一块作为备用，
+ * 之后先用完调用者提供的buffer，再使用备用的块
+ */
+void MonotonicArena::reset() noexcept
+{
+  for (auto chunk = std::exchange(chunks_, nullptr); chunk != nullptr; ) {
+    auto next = chunk->next;
+    if (spare_ == nullptr || chunk->size > spare_->size)
+      std::swap(chunk, spare_);
+    if (chunk != nullptr)
+      upstream_->deallocate(chunk, chunk->size, alignof(Chunk));
+    chunk = next;
+  }
+  if (spare_ != nullptr)
+    spare_->next = nullptr;
+
+  allocated_ = 0;
+  current_ = initial_.data();
+  end_ = initial_.data() + initial_.size();
+}
+
+void MonotonicArena::release() noexcept
+{
+  reset();
+
+  if (spare_ != nullptr) {
+    upstream_->deallocate(spare_, spare_->size, alignof(Chunk));
+    spare_ = nullptr;
+  }
+}
+
+void* MonotonicArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  void* p = current_;
+  auto space = static_cast<std::size_t>(end_ - current_);
+  if (current_ == nullptr || std::align(alignment, bytes, p, space) == nullptr) {
+    grow(bytes, alignment);
+    p = current_;
+    space = static_cast<std::size_t>(end_ - current_);
+    std::align(alignment, bytes, p, space);
+  }
+
+  current_ = static_cast<std::byte*>(p) + bytes;
+  allocated_ += bytes;
+  return p;
+}
+
+void MonotonicArena::do_deallocate(void*, std::size_t, std::size_t)
+{
+  // 只在reset/release时整体释放
+}
+
+bool MonotonicArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+void MonotonicArena::grow(std::size_t bytes, std::size_t alignment)
+{
+  auto required = sizeof(Chunk) + bytes + alignment;
+
+  Chunk* chunk;
+  if (spare_ != nullptr && spare_->size >= required) {
+    chunk = std::exchange(spare_, nullptr);
+  }
+  else {
+    auto size = std::max(next_size_, required);
+    chunk = static_cast<Chunk*>(upstream_->allocate(size, alignof(Chunk)));
+    chunk->size = size;
+    next_size_ = size * 2;
+  }
+
+  chunk->next = chunks_;
+  chunks_ = chunk;
+
+  current_ = reinterpret_cast<std::byte*>(chunk) + sizeof(Chunk);
+  end_ = reinterpret_cast<std::byte*>(chunk) + chunk->size;
+}
+
+
+SlabPool::SlabPool(std::pmr::memory_resource* upstream)
+  : upstream_{ upstream }, slabs_{}
+{}
+
+SlabPool::~SlabPool()
+{
+  release();
+}
+
+void SlabPool::release() noexcept
+{
+  for (auto slab: slabs_)
+    upstream_->deallocate(slab, SLAB_SIZE, SMALL_ALIGNMENT);
+
+  slabs_.clear();
+  free_ = {};
+}
+
+void* SlabPool::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  if (!detail::is_small(bytes, alignment))
+    return upstream_->allocate(bytes, alignment);
+
+  auto size_class = detail::size_class(bytes);
+  auto& list = free_[size_class];
+  if (list.head == nullptr) [[unlikely]]
+    refill(size_class);
+
+  return list.pop();
+}
+
+void SlabPool::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+  if (!detail::is_small(bytes, alignment)) {
+    upstream_->deallocate(p, bytes, alignment);
+    return;
+  }
+
+  free_[detail::size_class(bytes)].push(p);
+}
+
+bool SlabPool::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+void SlabPool::refill(std::size_t size_class)
+{
+  slabs_.reserve(slabs_.size() + 1);
+  auto slab = upstream_->allocate(SLAB_SIZE, SMALL_ALIGNMENT);
+  slabs_.push_back(slab);
+  carve(slab, size_class, free_[size_class]);
+}
+
+
+ThreadCachingResource& ThreadCachingResource::global()
+{
+  // 故意不析构也不登记到ShutdownRegistry：allocate_shared的Address等对象可能在静态析构之后才释放
+  static auto resource = new ThreadCachingResource{};
+  return *resource;
+}
+
+std::size_t ThreadCachingResource::central_free_bytes() const
+{
+  std::size_t bytes = 0;
+  for (std::size_t size_class = 0; size_class < detail::SIZE_CLASSES; ++size_class) {
+    std::lock_guard<std::mutex> lock{ central_[size_class].mutex };
+    bytes += central_[size_class].list.size * detail::class_size(size_class);
+  }
+
+  return bytes;
+}
+
+void* ThreadCachingResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  if (!detail::is_small(bytes, alignment))
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+
+  auto size_class = detail::size_class(bytes);
+  auto& cache = PerThread<ThreadCache, ThreadCachingResource>::local().lists[size_class];
+  if (cache.head == nullptr) [[unlikely]]
+    refill(cache, size_class);
+
+  return cache.pop();
+}
+
+void ThreadCachingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+  if (!detail::is_small(bytes, alignment)) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    return;
+  }
+
+  auto size_class = detail::size_class(bytes);
+  auto& cache = PerThread<ThreadCache, ThreadCachingResource>::local().lists[size_class];
+  cache.push(p);
+
+  // 留一批给之后的分配，多出来的一批还给中心链表，其他线程可以取用
+  if (cache.size >= 2 * batch_size(size_class)) [[unlikely]]
+    flush(cache, size_class, batch_size(size_class));
+}
+
+bool ThreadCachingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+void ThreadCachingResource::refill(detail::FreeList& cache, std::size_t size_class)
+{
+  auto& central = central_[size_class];
+  std::lock_guard<std::mutex> lock{ central.mutex };
+
+  if (central.list.head == nullptr)
+    carve(std::pmr::new_delete_resource()->allocate(SLAB_SIZE, SMALL_ALIGNMENT), size_class, central.list);
+
+  for (auto count = batch_size(size_class); count > 0 && central.list.head != nullptr; --count)
+    cache.push(central.list.pop());
+}
+
+void ThreadCachingResource::flush(detail::FreeList& cache, std::size_t size_class, std::size_t count)
+{
+  auto& central = central_[size_class];
+  std::lock_guard<std::mutex> lock{ central.mutex };
+
+  for (; count > 0; --count)
+    central.list.push(cache.pop());
+}
+
+} // namespace ST
@@ -0,0 +1,279 @@
+#include "ST/Metrics.h"
+
+#include <errno.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "ST/Exception.h"
+
+
+namespace ST {
+
+namespace detail {
+
+namespace {
+
+std::atomic<std::size_t> next_metric_shard{ 0 };
+
+constinit thread_local std::size_t local_metric_shard = METRIC_SHARDS;
+
+} // namespace
+
+std::size_t metric_shard() noexcept
+{
+  auto shard = local_metric_shard;
+  if (shard == METRIC_SHARDS) [[unlikely]] {
+    shard = next_metric_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    local_metric_shard = shard;
+  }
+
+  return shard;
+}
+
+} // namespace detail
+
+
+namespace {
+
+// 导出的分位数
+constexpr std::pair<const char*, double> PERCENTILES[] = {
+  { "p50", 0.5 },
+  { "p90", 0.9 },
+  { "p99", 0.99 },
+  { "p999", 0.999 }
+};
+
+template<typename T>
+constexpr const char* kind_name() noexcept
+{
+  if constexpr (std::is_same_v<T, Counter>)
+    return "counter";
+  else if constexpr (std::is_same_v<T, Gauge>)
+    return "gauge";
+  else
+    return "histogram";
+}
+
+} // namespace
+
+
+std::uint64_t Counter::value() const noexcept
+{
+  std::uint64_t sum = 0;
+  for (auto& shard: shards_)
+    sum += shard.value.load(std::memory_order_relaxed);
+
+  return sum;
+}
+
+void Counter::reset() noexcept
+{
+  for (auto& shard: shards_)
+    shard.value.store(0, std::memory_order_relaxed);
+}
+
+
+std::uint64_t Histogram::Snapshot::percentile(double quantile) const noexcept
+{
+  if (count == 0)
+    return 0;
+
+  auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+  rank = std::max<std::uint64_t>(rank, 1);
+
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return std::min(bucket_upper_bound(i), max);
+  }
+
+  return max;
+}
+
+
+Histogram::Histogram()
+  : shards_{ std::make_unique<Shard[]>(METRIC_SHARDS) }
+{}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+  Snapshot snapshot{};
+  snapshot.buckets.resize(BUCKETS);
+  snapshot.min = UINT64_MAX;
+
+  for (std::size_t i = 0; i < METRIC_SHARDS; ++i) {
+    auto& shard = shards_[i];
+    snapshot.count += shard.count.load(std::memory_order_relaxed);
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    snapshot.min = std::min(snapshot.min, shard.min.load(std::memory_order_relaxed));
+    snapshot.max = std::max(snapshot.max, shard.max.load(std::memory_order_relaxed));
+    for (std::size_t bucket = 0; bucket < BUCKETS; ++bucket)
+      snapshot.buckets[bucket] += shard.buckets[bucket].load(std::memory_order_relaxed);
+  }
+
+  if (snapshot.count == 0)
+    snapshot.min = 0;
+
+  return snapshot;
+}
+
+void Histogram::reset() noexcept
+{
+  for (std::size_t i = 0; i < METRIC_SHARDS; ++i) {
+    auto& shard = shards_[i];
+    shard.count.store(0, std::memory_order_relaxed);
+    shard.sum.store(0, std::memory_order_relaxed);
+    shard.min.store(UINT64_MAX, std::memory_order_relaxed);
+    shard.max.store(0, std::memory_order_relaxed);
+    for (auto& bucket: shard.buckets)
+      bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+
+Counter& MetricRegistry::counter(const std::string& name, std::string_view help)
+{
+  return get_or_create<Counter>(name, help);
+}
+
+Gauge& MetricRegistry::gauge(const std::string& name, std::string_view help)
+{
+  return get_or_create<Gauge>(name, help);
+}
+
+Histogram& MetricRegistry::histogram(const std::string& name, std::string_view help)
+{
+  return get_or_create<Histogram>(name, help);
+}
+
+std::string MetricRegistry::to_json(int indent) const
+{
+  auto json = nlohmann::json::object();
+
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  for (auto& [name, entry]: metrics_) {
+    if (auto counter = std::get_if<std::unique_ptr<Counter>>(&entry.metric)) {
+      json[name] = (*counter)->value();
+    }
+    else if (auto gauge = std::get_if<std::unique_ptr<Gauge>>(&entry.metric)) {
+      json[name] = (*gauge)->value();
+    }
+    else {
+      auto snapshot = std::get<std::unique_ptr<Histogram>>(entry.metric)->snapshot();
+      auto& histogram = json[name];
+      histogram["count"] = snapshot.count;
+      histogram["sum"] = snapshot.sum;
+      histogram["min"] = snapshot.min;
+      histogram["max"] = snapshot.max;
+      histogram["mean"] = snapshot.mean();
+      for (auto [label, quantile]: PERCENTILES)
+        histogram[label] = snapshot.percentile(quantile);
+    }
+  }
+
+  return json.dump(indent);
+}
+
+std::string MetricRegistry::to_text() const
+{
+  fmt::memory_buffer out{};
+
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  for (auto& [name, entry]: metrics_) {
+    if (!entry.help.empty())
+      fmt::format_to(fmt::appender{ out }, "# {}\n", entry.help);
+
+    if (auto counter = std::get_if<std::unique_ptr<Counter>>(&entry.metric)) {
+      fmt::format_to(fmt::appender{ out }, "{} {}\n", name, (*counter)->value());
+    }
+    else if (auto gauge = std::get_if<std::unique_ptr<Gauge>>(&entry.metric)) {
+      fmt::format_to(fmt::appender{ out }, "{} {}\n", name, (*gauge)->value());
+    }
+    else {
+      auto snapshot = std::get<std::unique_ptr<Histogram>>(entry.metric)->snapshot();
+      fmt::format_to(fmt::appender{ out }, "{}.count {}\n{}.sum {}\n{}.min {}\n{}.max {}\n",
+                     name, snapshot.count, name, snapshot.sum, name, snapshot.min, name, snapshot.max);
+      for (auto [label, quantile]: PERCENTILES)
+        fmt::format_to(fmt::appender{ out }, "{}.{} {}\n", name, label, snapshot.percentile(quantile));
+    }
+  }
+
+  return fmt::to_string(out);
+}
+
+void MetricRegistry::reset()
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  for (auto& [name, entry]: metrics_)
+    std::visit([] (auto& metric) { metric->reset(); }, entry.metric);
+}
+
+std::size_t MetricRegistry::size() const
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return metrics_.size();
+}
+
+template<typename T>
+T& MetricRegistry::get_or_create(const std::string& name, std::string_view help)
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+
+  auto it = metrics_.find(name);
+  if (it == metrics_.end()) {
+    SPDLOG_INFO("registering {} {}", kind_name<T>(), name);
+    it = metrics_.emplace(name, Entry{ std::string{ help }, std::make_unique<T>() }).first;
+  }
+
+  auto metric = std::get_if<std::unique_ptr<T>>(&it->second.metric);
+  if (metric == nullptr) {
+    SPDLOG_ERROR("metric {} is already registered with another type", name);
+    throw MetricTypeMismatchException{ "metric {} is not a {}", name, kind_name<T>() };
+  }
+
+  return **metric;
+}
+
+
+IOMetrics::IOMetrics(MetricRegistry& registry, const std::string& prefix)
+  : calls{ registry.counter(prefix + ".calls", "system calls") },
+    bytes{ registry.counter(prefix + ".bytes", "bytes transferred") },
+    errors{ registry.counter(prefix + ".errors", "failed system calls, EAGAIN excluded") },
+    latency{ registry.histogram(prefix + ".latency_ns", "system call latency in nanoseconds") }
+{}
+
+void IOMetrics::record(ssize_t result, Histogram::Clock::time_point start) noexcept
+{
+  // 调用者之后还要用errno报告错误
+  auto error = errno;
+  latency.record_since(start);
+  calls.add();
+
+  if (result > 0)
+    bytes.add(static_cast<std::uint64_t>(result));
+  else if (result < 0 && error != EAGAIN && error != EWOULDBLOCK)
+    errors.add();
+
+  errno = error;
+}
+
+
+SocketMetrics::SocketMetrics(MetricRegistry& registry)
+  : read{ registry, "socket.read" },
+    write{ registry, "socket.write" },
+    accepts{ registry.counter("socket.accept.calls", "accepted connections") },
+    accept_errors{ registry.counter("socket.accept.errors", "failed accepts, EAGAIN excluded") }
+{}
+
+FileMetrics::FileMetrics(MetricRegistry& registry)
+  : read{ registry, "file.read" },
+    write{ registry, "file.write" }
+{}
+
+} // namespace ST
@@ -0,0 +1,103 @@
+#include "ST/Net/Buffer.h"
+
+#include <sys/uio.h>
+#include <string.h>
+
+#include <cstring>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+#include "ST/Net/Socket.h"
+
+
+namespace ST::Net {
+
+Buffer::Buffer(std::size_t initial_size, std::pmr::memory_resource* resource)
+  : buffer_(initial_size, resource), read_index_{ 0 }, write_index_{ 0 }
+{}
+
+
+void Buffer::retrieve(std::size_t n_bytes) noexcept
+{
+  if (n_bytes >= readable_bytes()) {
+    retrieve_all();
+    return;
+  }
+
+  read_index_ += n_bytes;
+}
+
+void Buffer::retrieve_all() noexcept
+{
+  read_index_ = 0;
+  write_index_ = 0;
+}
+
+void Buffer::append(const void* data, std::size_t n_bytes)
+{
+  ensure_writable(n_bytes);
+  std::memcpy(begin_write(), data, n_bytes);
+  has_written(n_bytes);
+}
+
+void Buffer::ensure_writable(std::size_t n_bytes)
+{
+  if (writable_bytes() >= n_bytes)
+    return;
+
+  // 前面已读取的空间足够时，将可读数据挪到开头，避免扩容
+  if (writable_bytes() + read_index_ >= n_bytes) {
+    auto readable = readable_bytes();
+    std::memmove(buffer_.data(), peek(), readable);
+    read_index_ = 0;
+    write_index_ = readable;
+    return;
+  }
+
+  buffer_.resize(write_index_ + n_bytes);
+}
+
+ssize_t Buffer::read_from(Socket& socket)
+{
+  auto read_bytes = read_from(socket, std::nothrow);
+  if (read_bytes.would_block())
+    return -1;
+
+  if (!read_bytes) {
+    SPDLOG_ERROR("readv from [{}] error: {}", socket.fd(), strerror(read_bytes.error()));
+    throw std::system_error{ read_bytes.error(), std::generic_category(), "can't readv" };
+  }
+
+  return static_cast<ssize_t>(*read_bytes);
+}
+
+st::Result<std::size_t> Buffer::read_from(Socket& socket, std::nothrow_t)
+{
+  std::byte extra_buffer[EXTRA_BUFFER_SIZE];
+
+  auto writable = writable_bytes();
+  iovec vec[2];
+  vec[0].iov_base = begin_write();
+  vec[0].iov_len = writable;
+  vec[1].iov_base = extra_buffer;
+  vec[1].iov_len = sizeof(extra_buffer);
+
+  // 可写空间足够大时不再使用额外缓冲区
+  auto count = writable < sizeof(extra_buffer) ? 2 : 1;
+  auto read_bytes = socket.readv(vec, count, std::nothrow);
+  if (!read_bytes || *read_bytes == 0)
+    return read_bytes;
+
+  if (*read_bytes <= writable) {
+    has_written(*read_bytes);
+  }
+  else {
+    write_index_ = buffer_.size();
+    append(extra_buffer, *read_bytes - writable);
+  }
+
+  return read_bytes;
+}
+
+} // namespace ST::Net
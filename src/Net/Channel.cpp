@@ -0,0 +1,291 @@
+#include "ST/Net/Channel.h"
+
+#include <sys/epoll.h>
+#include <string.h>
+#include <errno.h>
+
+#include <exception>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST::Net {
+
+Channel::Channel(std::shared_ptr<Socket> self, std::shared_ptr<Socket> other,
+                 LengthFieldCodec codec, std::pmr::memory_resource* resource)
+  : self_{ std::move(self) },
+    other_{ std::move(other) },
+    codec_{ codec },
+    input_{ DEFAULT_BUFFER_SIZE, resource },
+    output_{ DEFAULT_BUFFER_SIZE, resource },
+    poller_{ nullptr },
+    on_frame_{},
+    writing_{ false },
+    low_watermark_{ DEFAULT_LOW_WATERMARK },
+    high_watermark_{ DEFAULT_HIGH_WATERMARK },
+    paused_{ false },
+    closed_{ false },
+    shutting_down_{ false },
+    write_shutdown_{ false },
+    on_high_watermark_{},
+    on_low_watermark_{},
+    on_closed_{}
+{}
+
+Channel::~Channel()
+{
+  unwatch();
+}
+
+
+ssize_t Channel::send(std::span<const std::byte> frame)
+{
+  return send(std::span<const std::span<const std::byte>>{ &frame, 1 });
+}
+
+ssize_t Channel::send(std::span<const std::span<const std::byte>> frames)
+{
+  SPDLOG_INFO("sending {} frames", frames.size());
+
+  // abort()之后fd已经是-1，再写会得到EBADF
+  if (closed_) {
+    SPDLOG_WARN("channel is closed, dropped {} frames", frames.size());
+    return 0;
+  }
+
+  if (shutting_down_) {
+    SPDLOG_WARN("fd: {} is shutting down, dropped {} frames", socket().fd(), frames.size());
+    return 0;
+  }
+
+  ssize_t written = 0;
+  if (output_.readable_bytes() == 0) {
+    written = codec_.encode(socket(), frames);
+
+    // 发送缓冲区已满，没写完的部分进入输出缓冲区
+    if (static_cast<std::size_t>(written) < LengthFieldCodec::encoded_length(frames, codec_.checksum()))
+      codec_.encode(output_, frames, written);
+  }
+  else {
+    // 已经有数据在排队，必须排在它们后面保证顺序
+    codec_.encode(output_, frames);
+  }
+
+  if (output_.readable_bytes() > 0) {
+    enable_writing(true);
+    check_watermarks();
+  }
+
+  SPDLOG_INFO("sent {} frames, {} bytes, {} bytes pending", frames.size(), written, output_.readable_bytes());
+  return written;
+}
+
+ssize_t Channel::receive()
+{
+  SPDLOG_INFO("receiving from fd: {}", socket().fd());
+
+  auto read_bytes = input_.read_from(socket());
+
+  SPDLOG_INFO("received {} bytes, {} bytes buffered", read_bytes, input_.readable_bytes());
+  return read_bytes;
+}
+
+void Channel::watch(Poller& poller, FrameCallback on_frame)
+{
+  SPDLOG_INFO("watching fd: {}", socket().fd());
+
+  socket().set_nonblocking();
+  on_frame_ = std::move(on_frame);
+  poller_ = &poller;
+  writing_ = output_.readable_bytes() > 0;
+
+  auto events = EPOLLIN | EPOLLRDHUP | (writing_ ? std::uint32_t{ EPOLLOUT } : 0u);
+  poller.add(socket().fd(), events, [this] (std::uint32_t events) { handle_events(events); });
+
+  SPDLOG_INFO("watched fd: {}", socket().fd());
+}
+
+void Channel::unwatch()
+{
+  if (poller_ == nullptr)
+    return;
+
+  SPDLOG_INFO("unwatching fd: {}", socket().fd());
+
+  if (poller_->contains(socket().fd()))
+    poller_->remove(socket().fd());
+  poller_ = nullptr;
+  writing_ = false;
+
+  SPDLOG_INFO("unwatched fd: {}", socket().fd());
+}
+
+void Channel::handle_read()
+{
+  while (!closed_) {
+    auto read_bytes = input_.read_from(socket(), std::nothrow);
+    if (read_bytes.would_block())
+      return;
+
+    if (read_bytes.error() == EINTR)
+      continue;
+
+    // ECONNRESET等说明对端已经不在了，和EOF一样按正常关闭处理
+    if (!read_bytes) {
+      SPDLOG_INFO("fd: {} read error: {}, closing", socket().fd(), strerror(read_bytes.error()));
+      handle_close();
+      return;
+    }
+
+    codec_.decode(input_, on_frame_);
+
+    if (*read_bytes == 0) {
+      SPDLOG_INFO("peer of fd: {} closed", socket().fd());
+      handle_close();
+      return;
+    }
+  }
+}
+
+void Channel::handle_write()
+{
+  while (output_.readable_bytes() > 0) {
+    auto written = socket().write(output_.peek(), output_.readable_bytes(), std::nothrow);
+    if (written.would_block())
+      break;
+
+    if (written.error() == EINTR)
+      continue;
+
+    if (!written) {
+      fail(strerror(written.error()));
+      return;
+    }
+
+    output_.retrieve(*written);
+  }
+
+  if (output_.readable_bytes() == 0)
+    enable_writing(false);
+
+  check_watermarks();
+  shutdown_write_if_drained();
+}
+
+void Channel::shutdown()
+{
+  if (shutting_down_ || closed_)
+    return;
+
+  SPDLOG_INFO("shutting down fd: {}, {} bytes pending", socket().fd(), output_.readable_bytes());
+
+  shutting_down_ = true;
+  shutdown_write_if_drained();
+
+  SPDLOG_INFO("shutting down fd: {} requested", socket().fd());
+}
+
+void Channel::abort()
+{
+  SPDLOG_INFO("aborting channel, {} bytes pending dropped", output_.readable_bytes());
+
+  unwatch();
+  socket().abort();
+  output_.retrieve_all();
+  closed_ = true;
+
+  SPDLOG_INFO("aborted channel");
+}
+
+void Channel::watermarks(std::size_t low, std::size_t high)
+{
+  SPDLOG_INFO("setting watermarks low = {}, high = {}", low, high);
+
+  low_watermark_ = low;
+  high_watermark_ = high;
+}
+
+std::shared_ptr<Socket> Channel::self() const noexcept
+{
+  return self_;
+}
+
+std::shared_ptr<Socket> Channel::other() const noexcept
+{
+  return other_;
+}
+
+void Channel::handle_events(std::uint32_t events)
+{
+  // 一个连接上的错误(非法帧、校验失败、回调抛出的异常)只关闭这个连接，不影响同一个poller上的其他连接
+  try {
+    if (events & EPOLLOUT)
+      handle_write();
+
+    if (!closed_ && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+      handle_read();
+  }
+  catch (const std::exception& error) {
+    fail(error.what());
+  }
+}
+
+void Channel::handle_close()
+{
+  closed_ = true;
+  unwatch();
+  if (on_closed_)
+    on_closed_(*this);
+}
+
+void Channel::fail(const char* reason)
+{
+  if (closed_)
+    return;
+
+  SPDLOG_ERROR("fd: {} failed: {}, aborting", socket().fd(), reason);
+  abort();
+  if (on_closed_)
+    on_closed_(*this);
+}
+
+void Channel::enable_writing(bool enable)
+{
+  if (poller_ == nullptr || writing_ == enable)
+    return;
+
+  writing_ = enable;
+  poller_->modify(socket().fd(), EPOLLIN | EPOLLRDHUP | (enable ? std::uint32_t{ EPOLLOUT } : 0u));
+}
+
+void Channel::check_watermarks()
+{
+  auto pending = output_.readable_bytes();
+
+  if (!paused_ && pending >= high_watermark_) {
+    SPDLOG_WARN("fd: {} reached high watermark, {} bytes pending", socket().fd(), pending);
+    paused_ = true;
+    if (on_high_watermark_)
+      on_high_watermark_(*this);
+  }
+  else if (paused_ && pending <= low_watermark_) {
+    SPDLOG_INFO("fd: {} drained to low watermark, {} bytes pending", socket().fd(), pending);
+    paused_ = false;
+    if (on_low_watermark_)
+      on_low_watermark_(*this);
+  }
+}
+
+void Channel::shutdown_write_if_drained()
+{
+  if (!shutting_down_ || write_shutdown_ || output_.readable_bytes() > 0)
+    return;
+
+  write_shutdown_ = true;
+  // 对端已经断开时为ENOTCONN，没有必要再等它关闭
+  auto res = socket().shutdown(SHUT_WR, std::nothrow);
+  if (!res)
+    fail(strerror(res.error()));
+}
+
+} // namespace ST::Net
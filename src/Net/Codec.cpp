@@ -0,0 +1,132 @@
+#include "ST/Net/Codec.h"
+
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "ST/Net/Socket.h"
+
+
+namespace ST::Net {
+
+ssize_t LengthFieldCodec::encode(Socket& socket, std::span<const std::span<const std::byte>> frames) const
+{
+  SPDLOG_INFO("encoding {} frames to fd: {}", frames.size(), socket.fd());
+
+  // 每帧占两个Header的位置，不校验时第二个不发送
+  std::vector<Header> headers;
+  headers.reserve(frames.size() * 2);
+  for (auto frame: frames) {
+    headers.push_back(make_header(frame.size()));
+    headers.push_back(checksum_ == FrameChecksum::CRC32C ? make_checksum(frame) : 0);
+  }
+
+  auto header_size = header_length();
+  std::vector<iovec> vec;
+  vec.reserve(frames.size() * 2);
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    vec.push_back({ &headers[2 * i], header_size });
+    if (!frames[i].empty())
+      vec.push_back({ const_cast<std::byte*>(frames[i].data()), frames[i].size() });
+  }
+
+  ssize_t total = 0;
+  std::size_t index = 0;
+  while (index < vec.size()) {
+    auto count = static_cast<int>(std::min<std::size_t>(vec.size() - index, IOV_MAX));
+    auto res = socket.writev(vec.data() + index, count);
+    // 非阻塞socket的发送缓冲区已满，剩余部分由调用者处理
+    if (res == -1)
+      break;
+
+    auto written = static_cast<std::size_t>(res);
+    total += res;
+
+    // 跳过已经写完的iovec，部分写入的那个调整起点后继续写
+    while (written > 0 && index < vec.size()) {
+      if (written >= vec[index].iov_len) {
+        written -= vec[index].iov_len;
+        ++index;
+      }
+      else {
+        vec[index].iov_base = static_cast<std::byte*>(vec[index].iov_base) + written;
+        vec[index].iov_len -= written;
+        written = 0;
+      }
+    }
+  }
+
+  SPDLOG_INFO("encoded {} frames, {} bytes to fd: {}", frames.size(), total, socket.fd());
+  return total;
+}
+
+void LengthFieldCodec::encode(Buffer& buffer, std::span<const std::span<const std::byte>> frames) const
+{
+  buffer.ensure_writable(encoded_length(frames, checksum_));
+
+  for (auto frame: frames) {
+    auto header = make_header(frame.size());
+    buffer.append(&header, HEADER_LENGTH);
+    if (checksum_ == FrameChecksum::CRC32C) {
+      auto checksum = make_checksum(frame);
+      buffer.append(&checksum, CHECKSUM_LENGTH);
+    }
+    buffer.append(frame.data(), frame.size());
+  }
+}
+
+void LengthFieldCodec::encode(Buffer& buffer, std::span<const std::span<const std::byte>> frames, std::size_t skip) const
+{
+  auto header_size = header_length();
+
+  // 跳过已经完整发送的帧
+  while (!frames.empty() && skip >= header_size + frames.front().size()) {
+    skip -= header_size + frames.front().size();
+    frames = frames.subspan(1);
+  }
+
+  if (skip > 0) {
+    buffer.ensure_writable(encoded_length(frames, checksum_) - skip);
+
+    // 和encode(socket)一样，帧头和校验值连续存放
+    auto frame = frames.front();
+    Header headers[2]{ make_header(frame.size()), checksum_ == FrameChecksum::CRC32C ? make_checksum(frame) : 0 };
+    if (skip < header_size) {
+      buffer.append(reinterpret_cast<const std::byte*>(headers) + skip, header_size - skip);
+      skip = 0;
+    }
+    else {
+      skip -= header_size;
+    }
+    buffer.append(frame.data() + skip, frame.size() - skip);
+    frames = frames.subspan(1);
+  }
+
+  encode(buffer, frames);
+}
+
+std::size_t LengthFieldCodec::encoded_length(std::span<const std::span<const std::byte>> frames,
+                                             FrameChecksum checksum) noexcept
+{
+  auto header_size = header_length(checksum);
+  std::size_t total = 0;
+  for (auto frame: frames)
+    total += header_size + frame.size();
+
+  return total;
+}
+
+LengthFieldCodec::Header LengthFieldCodec::make_header(std::size_t length) const
+{
+  if (length > max_frame_length_ || length > std::numeric_limits<Header>::max()) {
+    SPDLOG_ERROR("frame length {} exceeds limit {}", length, max_frame_length_);
+    throw FrameTooLongException{ "frame length {} exceeds limit {}", length, max_frame_length_ };
+  }
+
+  return st::byte_order_cast<st::Net>(static_cast<Header>(length));
+}
+
+} // namespace ST::Net
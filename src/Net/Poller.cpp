@@ -0,0 +1,108 @@
+#include "ST/Net/Poller.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST::Net {
+
+Poller::Poller(int max_events)
+  : fd_{ -1 }, events_(max_events), handlers_{}
+{
+  fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  if (fd_ == -1) {
+    SPDLOG_ERROR("can't create epoll: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't create epoll" };
+  }
+}
+
+Poller::~Poller()
+{
+  auto res = ::close(fd_);
+  if (res == -1)
+    SPDLOG_ERROR("can't close epoll[fd = {}]", fd_);
+
+  fd_ = -1;
+}
+
+
+void Poller::add(int fd, std::uint32_t events, Handler handler)
+{
+  SPDLOG_INFO("adding fd: {} with events {:#x}", fd, events);
+
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  auto res = ::epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &event);
+  if (res == -1) {
+    SPDLOG_ERROR("can't add fd: {} to epoll: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't add fd to epoll" };
+  }
+
+  handlers_[fd] = std::make_shared<Handler>(std::move(handler));
+
+  SPDLOG_INFO("added fd: {} with events {:#x}", fd, events);
+}
+
+void Poller::modify(int fd, std::uint32_t events)
+{
+  SPDLOG_INFO("modifying fd: {} to events {:#x}", fd, events);
+
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  auto res = ::epoll_ctl(fd_, EPOLL_CTL_MOD, fd, &event);
+  if (res == -1) {
+    SPDLOG_ERROR("can't modify fd: {} in epoll: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't modify fd in epoll" };
+  }
+
+  SPDLOG_INFO("modified fd: {} to events {:#x}", fd, events);
+}
+
+void Poller::remove(int fd)
+{
+  SPDLOG_INFO("removing fd: {}", fd);
+
+  auto res = ::epoll_ctl(fd_, EPOLL_CTL_DEL, fd, nullptr);
+  if (res == -1) {
+    SPDLOG_ERROR("can't remove fd: {} from epoll: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't remove fd from epoll" };
+  }
+
+  handlers_.erase(fd);
+
+  SPDLOG_INFO("removed fd: {}", fd);
+}
+
+int Poller::poll(int timeout)
+{
+  auto ready = ::epoll_wait(fd_, events_.data(), static_cast<int>(events_.size()), timeout);
+  if (ready == -1) {
+    if (errno == EINTR)
+      return 0;
+
+    SPDLOG_ERROR("epoll wait error: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't wait on epoll" };
+  }
+
+  for (int i = 0; i < ready; ++i) {
+    // handler中可能remove自己或其他fd，所以每次都重新查找
+    auto it = handlers_.find(events_[i].data.fd);
+    if (it == handlers_.end())
+      continue;
+
+    // 持有一份引用，防止handler在执行过程中被remove析构
+    auto handler = it->second;
+    (*handler)(events_[i].events);
+  }
+
+  return ready;
+}
+
+} // namespace ST::Net
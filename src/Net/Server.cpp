@@ -0,0 +1,166 @@
+#include "ST/Net/Server.h"
+
+#include <sys/epoll.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <exception>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST::Net {
+
+Server::Server(Poller& poller, Socket listener)
+  : poller_{ poller },
+    listener_{ std::make_shared<Socket>(std::move(listener)) },
+    connection_memory_{},
+    request_memory_{},
+    channels_{},
+    closed_{},
+    stopping_{ false },
+    profile_{},
+    on_connection_{},
+    on_message_{}
+{}
+
+Server::~Server()
+{
+  for (auto& [fd, channel]: channels_)
+    channel->unwatch();
+
+  if (listener_->opened() && poller_.contains(listener_->fd()))
+    poller_.remove(listener_->fd());
+}
+
+
+void Server::start()
+{
+  SPDLOG_INFO("starting server on fd: {}", listener_->fd());
+
+  listener_->set_nonblocking();
+  poller_.add(listener_->fd(), EPOLLIN, [this] (std::uint32_t) { handle_accept(); });
+
+  SPDLOG_INFO("started server on fd: {}", listener_->fd());
+}
+
+bool Server::run(std::chrono::milliseconds grace)
+{
+  SPDLOG_INFO("running server");
+
+  while (!is_stopping()) {
+    poller_.poll(static_cast<int>(DEFAULT_POLL_TICK.count()));
+    remove_closed();
+    request_memory_.reset();
+  }
+
+  auto graceful = shutdown(grace);
+
+  SPDLOG_INFO("server stopped");
+  return graceful;
+}
+
+bool Server::shutdown(std::chrono::milliseconds grace)
+{
+  SPDLOG_INFO("shutting down server, {} connections, grace period {}ms", channels_.size(), grace.count());
+
+  stop();
+  stop_accepting();
+
+  for (auto& [fd, channel]: channels_)
+    channel->shutdown();
+
+  auto deadline = std::chrono::steady_clock::now() + grace;
+  while (!channels_.empty()) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+      break;
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+    poller_.poll(static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining.count(), 1)));
+    remove_closed();
+    request_memory_.reset();
+  }
+
+  auto graceful = channels_.empty();
+  if (!graceful)
+    SPDLOG_WARN("grace period expired, aborting {} connections", channels_.size());
+
+  for (auto& [fd, channel]: channels_)
+    channel->abort();
+  channels_.clear();
+
+  SPDLOG_INFO("shut down server, graceful = {}", graceful);
+  return graceful;
+}
+
+void Server::handle_accept()
+{
+  // 水平触发，一次只接受一个连接，剩余的连接下一轮继续
+  auto connecting_socket = listener_->accept(std::nothrow);
+  if (!connecting_socket) {
+    // EAGAIN/EINTR/ECONNABORTED之外(比如EMFILE)也只跳过这一次，不能让整个服务器退出
+    if (!connecting_socket.would_block() && connecting_socket.error() != EINTR)
+      SPDLOG_WARN("can't accept on fd: {}: {}", listener_->fd(), strerror(connecting_socket.error()));
+    return;
+  }
+
+  // 选项设置失败(比如对端已经断开)时拒绝这个连接
+  try {
+    profile_.apply(*connecting_socket);
+  }
+  catch (const std::system_error& error) {
+    SPDLOG_WARN("can't apply profile to fd: {}: {}, rejected", connecting_socket->fd(), error.what());
+    connecting_socket->abort();
+    return;
+  }
+
+  auto fd = connecting_socket->fd();
+  auto channel = std::make_unique<Channel>(listener_, std::make_shared<Socket>(std::move(*connecting_socket)),
+                                           codec_, &connection_memory_);
+  auto& ref = *channel;
+  channels_[fd] = std::move(channel);
+
+  ref.on_closed([this, fd] (Channel&) { closed_.push_back(fd); });
+  ref.watch(poller_, [this, &ref] (std::span<const std::byte> payload) {
+    if (on_message_)
+      on_message_(ref, payload, request_memory_);
+  });
+
+  if (!on_connection_)
+    return;
+
+  try {
+    on_connection_(ref);
+  }
+  catch (const std::exception& error) {
+    SPDLOG_ERROR("connection callback on fd: {} failed: {}, aborting", fd, error.what());
+    ref.abort();
+    closed_.push_back(fd);
+  }
+}
+
+void Server::stop_accepting()
+{
+  if (!listener_->opened())
+    return;
+
+  if (poller_.contains(listener_->fd()))
+    poller_.remove(listener_->fd());
+  listener_->close();
+}
+
+void Server::remove_closed()
+{
+  // 强制关闭的连接立即释放fd，同一轮中accept的新连接可能复用了它，只移除确实已关闭的
+  for (auto fd: closed_) {
+    auto it = channels_.find(fd);
+    if (it != channels_.end() && it->second->is_closed())
+      channels_.erase(it);
+  }
+  closed_.clear();
+}
+
+} // namespace ST::Net
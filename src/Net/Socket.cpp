@@ -2,17 +2,52 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <optional>
+#include <stdexcept>
+#include <utility>
 
 #include <spdlog/spdlog.h>
 
 #include "ST/Net/IPv4Address.h"
 #include "ST/Net/IPv6Address.h"
+#include "ST/Net/UnixAddress.h"
 #include "ST/Exception.h"
+#include "ST/Memory.h"
+#include "ST/Metrics.h"
 
 
 namespace ST::Net {
 
+namespace {
+
+void record_accept(int fd, int error) noexcept
+{
+  auto metrics = SocketMetrics::find();
+  if (metrics == nullptr)
+    return;
+
+  if (fd != -1)
+    metrics->accepts.add();
+  else if (error != EAGAIN && error != EWOULDBLOCK && error != EINTR)
+    metrics->accept_errors.add();
+}
+
+// 地址和控制块在同一次分配中，来自线程缓存，socket可以在其他线程析构
+template<typename T, typename... Args>
+std::shared_ptr<Address> make_address(Args&&... args)
+{
+  return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>{ &ThreadCachingResource::global() },
+                                 std::forward<Args>(args)...);
+}
+
+} // namespace
+
+
 Socket::Socket(Family family, Type type, Protocol protocol)
   : fd_{ -1 },
     family_{ family },
@@ -27,10 +62,47 @@ Socket::Socket(Family family, Type type, Protocol protocol)
           to_string(family), to_string(type), to_string(protocol));
     throw std::system_error{ errno, std::generic_category(), "can't open socket" };
   }
+
+  // noexcept的读写路径只查找不构造埋点，在这里提前构造
+  SocketMetrics::instance();
+}
+
+Socket::Socket(int fd, Family family, Type type, Protocol protocol)
+  : fd_{ fd },
+    family_{ family },
+    type_{ type },
+    protocol_{ protocol },
+    connect_address_{ nullptr },
+    bind_address_{ nullptr }
+{}
+
+Socket::Socket(Socket&& other) noexcept
+  : fd_{ std::exchange(other.fd_, -1) },
+    family_{ other.family_ },
+    type_{ other.type_ },
+    protocol_{ other.protocol_ },
+    connect_address_{ std::move(other.connect_address_) },
+    bind_address_{ std::move(other.bind_address_) }
+{}
+
+Socket& Socket::operator=(Socket&& other) noexcept
+{
+  std::swap(fd_, other.fd_);
+  std::swap(family_, other.family_);
+  std::swap(type_, other.type_);
+  std::swap(protocol_, other.protocol_);
+  std::swap(connect_address_, other.connect_address_);
+  std::swap(bind_address_, other.bind_address_);
+
+  return *this;
 }
 
 Socket::~Socket()
 {
+  // 已经被移动
+  if (fd_ == -1)
+    return;
+
   auto res = ::close(fd_);
   if (res == -1)
     SPDLOG_ERROR("can't close socket[fd = {}]", fd_);
@@ -39,21 +111,52 @@ Socket::~Socket()
 }
 
 
+std::pair<Socket, Socket> Socket::pair(Type type)
+{
+  SPDLOG_INFO("creating socket pair[type = {}]", to_string(type));
+
+  int fds[2];
+  auto res = ::socketpair(AF_UNIX, to_int(type), 0, fds);
+  if (res == -1) {
+    SPDLOG_ERROR("can't create socket pair: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't create socket pair" };
+  }
+
+  SocketMetrics::instance();
+
+  SPDLOG_INFO("created socket pair[{}, {}]", fds[0], fds[1]);
+  return { Socket{ fds[0], Family::Unix, type, Protocol::Undefined },
+           Socket{ fds[1], Family::Unix, type, Protocol::Undefined } };
+}
+
 void Socket::connect(const std::string& address, in_port_t port)
 {
   std::shared_ptr<Address> connect_address;
   switch (family_) {
   case Family::IPv4: default:
-    connect_address = std::make_shared<IPv4Address>(address, port);
+    connect_address = make_address<IPv4Address>(address, port);
     break;
   case Family::IPv6:
-    connect_address = std::make_shared<IPv6Address>(address, port);
+    connect_address = make_address<IPv6Address>(address, port);
+    break;
+  case Family::Unix:
+    connect_address = make_address<UnixAddress>(address);
     break;
   }
 
   connect(connect_address);
 }
 
+void Socket::connect(const std::string& path)
+{
+  if (family_ != Family::Unix) {
+    SPDLOG_ERROR("can't connect {} socket to path[{}]", to_string(family_), path);
+    throw UndefinedFamilyException{ "can't connect {} socket to path[{}]", to_string(family_), path };
+  }
+
+  connect(make_address<UnixAddress>(path));
+}
+
 void Socket::connect(std::shared_ptr<Address> address)
 {
   SPDLOG_INFO("connecting to address[]", address->to_string());
@@ -75,25 +178,42 @@ void Socket::bind(const std::string& address, in_port_t port)
   std::shared_ptr<Address> bind_address;
   switch (family_) {
   case Family::IPv4: default:
-    bind_address = std::make_shared<IPv4Address>(address, port);
+    bind_address = make_address<IPv4Address>(address, port);
     break;
   case Family::IPv6:
-    bind_address = std::make_shared<IPv6Address>(address, port);
+    bind_address = make_address<IPv6Address>(address, port);
+    break;
+  case Family::Unix:
+    bind_address = make_address<UnixAddress>(address);
     break;
   }
 
   bind(bind_address);
 }
 
+void Socket::bind(const std::string& path)
+{
+  if (family_ != Family::Unix) {
+    SPDLOG_ERROR("can't bind {} socket to path[{}]", to_string(family_), path);
+    throw UndefinedFamilyException{ "can't bind {} socket to path[{}]", to_string(family_), path };
+  }
+
+  bind(make_address<UnixAddress>(path));
+}
+
 void Socket::bind(in_port_t port)
 {
   std::shared_ptr<Address> bind_address;
   switch (family_) {
   case Family::IPv4: default:
-    bind_address = std::make_shared<IPv4Address>(port);
+    bind_address = make_address<IPv4Address>(port);
     break;
   case Family::IPv6:
-    bind_address = std::make_shared<IPv6Address>(port);
+    bind_address = make_address<IPv6Address>(port);
+    break;
+  case Family::Unix:
+    // 只有family的地址，由内核自动分配一个abstract namespace地址
+    bind_address = make_address<UnixAddress>();
     break;
   }
 
@@ -134,49 +254,378 @@ Socket Socket::accept()
 {
   SPDLOG_INFO("accepting");
 
-  auto connecting_fd = ::accept(fd_, nullptr, nullptr);
-  if (connecting_fd == -1) {
-    SPDLOG_ERROR("accept error: {}", strerror(errno));
-    throw std::system_error{ errno, std::generic_category(),
+  auto connecting_socket = accept(std::nothrow);
+  if (!connecting_socket) {
+    SPDLOG_ERROR("accept error: {}", strerror(connecting_socket.error()));
+    throw std::system_error{ connecting_socket.error(), std::generic_category(),
           "can't accept" };
   }
 
-  Socket connecting_socket { family_, type_, protocol_ };
-  connecting_socket.set_fd(connecting_fd);
-
   SPDLOG_INFO("accepted");
+  return *std::move(connecting_socket);
+}
+
+Socket Socket::accept(const SocketProfile& profile)
+{
+  auto connecting_socket = accept();
+  profile.apply(connecting_socket);
+
   return connecting_socket;
 }
 
+std::optional<Socket> Socket::try_accept()
+{
+  SPDLOG_INFO("try accepting");
+
+  auto connecting_socket = accept(std::nothrow);
+  if (connecting_socket.would_block() || connecting_socket.error() == EINTR) {
+    SPDLOG_INFO("no pending connection on fd: {}", fd_);
+    return std::nullopt;
+  }
+
+  if (!connecting_socket) {
+    SPDLOG_ERROR("accept error: {}", strerror(connecting_socket.error()));
+    throw std::system_error{ connecting_socket.error(), std::generic_category(),
+          "can't accept" };
+  }
+
+  SPDLOG_INFO("accepted");
+  return *std::move(connecting_socket);
+}
+
+st::Result<Socket> Socket::accept(std::nothrow_t) noexcept
+{
+  auto connecting_fd = ::accept(fd_, nullptr, nullptr);
+  auto error = errno;
+  record_accept(connecting_fd, error);
+  if (connecting_fd == -1)
+    return st::Error{ error };
+
+  return Socket{ connecting_fd, family_, type_, protocol_ };
+}
+
+void Socket::shutdown(int how)
+{
+  SPDLOG_INFO("shutting down fd: {}, how = {}", fd_, how);
+
+  auto res = shutdown(how, std::nothrow);
+  if (!res) {
+    SPDLOG_ERROR("can't shutdown fd: {}: {}", fd_, strerror(res.error()));
+    throw std::system_error{ res.error(), std::generic_category(), "can't shutdown socket" };
+  }
+
+  SPDLOG_INFO("shut down fd: {}, how = {}", fd_, how);
+}
+
+st::Result<void> Socket::shutdown(int how, std::nothrow_t) noexcept
+{
+  if (::shutdown(fd_, how) == -1)
+    return st::Error{ errno };
+
+  return {};
+}
+
+void Socket::close()
+{
+  if (fd_ == -1)
+    return;
+
+  SPDLOG_INFO("closing fd: {}", fd_);
+
+  auto fd = std::exchange(fd_, -1);
+  auto res = ::close(fd);
+  if (res == -1) {
+    SPDLOG_ERROR("can't close socket[fd = {}]: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't close socket" };
+  }
+
+  SPDLOG_INFO("closed fd: {}", fd);
+}
+
+void Socket::abort()
+{
+  if (fd_ == -1)
+    return;
+
+  SPDLOG_INFO("aborting fd: {}", fd_);
+
+  // linger超时为0时close直接发送RST，丢弃未发送的数据
+  try {
+    set_option<Option::Linger>(std::chrono::seconds{ 0 });
+  }
+  catch (const std::system_error& error) {
+    SPDLOG_WARN("can't set SO_LINGER on fd: {}: {}", fd_, error.what());
+  }
+
+  close();
+
+  SPDLOG_INFO("aborted");
+}
+
+void Socket::send_fds(std::span<const int> fds)
+{
+  SPDLOG_INFO("sending {} fds through fd: {}", fds.size(), fd_);
+
+  if (fds.empty() || fds.size() > DEFAULT_MAX_PASSED_FDS) {
+    SPDLOG_ERROR("can't send {} fds, must be in [1, {}]", fds.size(), DEFAULT_MAX_PASSED_FDS);
+    throw std::length_error{ "invalid number of fds to send" };
+  }
+
+  char data = 0;
+  iovec vec{ &data, sizeof(data) };
+
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+  msghdr message{};
+  message.msg_iov = &vec;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+
+  auto header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+  memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+
+  auto res = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+  if (res == -1) {
+    SPDLOG_ERROR("can't send fds through fd: {}: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't send fds" };
+  }
+
+  SPDLOG_INFO("sent {} fds through fd: {}", fds.size(), fd_);
+}
+
+std::vector<int> Socket::receive_fds(std::size_t max_fds)
+{
+  SPDLOG_INFO("receiving at most {} fds from fd: {}", max_fds, fd_);
+
+  char data;
+  iovec vec{ &data, sizeof(data) };
+
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * max_fds));
+  msghdr message{};
+  message.msg_iov = &vec;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+
+  // 收到的fd自动设置close-on-exec，避免泄漏到exec出的子进程
+  auto res = ::recvmsg(fd_, &message, MSG_CMSG_CLOEXEC);
+  if (res == -1) {
+    SPDLOG_ERROR("can't receive fds from fd: {}: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't receive fds" };
+  }
+
+  std::vector<int> fds;
+  for (auto header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    auto count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    auto first = fds.size();
+    fds.resize(first + count);
+    memcpy(fds.data() + first, CMSG_DATA(header), sizeof(int) * count);
+  }
+
+  if (message.msg_flags & MSG_CTRUNC)
+    SPDLOG_WARN("control message truncated, some fds from fd: {} are lost", fd_);
+
+  SPDLOG_INFO("received {} fds from fd: {}", fds.size(), fd_);
+  return fds;
+}
+
+int Socket::receive_fd()
+{
+  auto fds = receive_fds(1);
+  return fds.empty() ? -1 : fds.front();
+}
+
+std::optional<Socket> Socket::receive_socket(Family family, Type type)
+{
+  auto fd = receive_fd();
+  if (fd == -1)
+    return std::nullopt;
+
+  return Socket{ fd, family, type, Protocol::Undefined };
+}
+
+void Socket::set_nonblocking(bool nonblocking)
+{
+  SPDLOG_INFO("setting fd: {} nonblocking = {}", fd_, nonblocking);
+
+  auto flags = ::fcntl(fd_, F_GETFL, 0);
+  if (flags == -1) {
+    SPDLOG_ERROR("can't get fd: {} flags: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't get socket flags" };
+  }
+
+  flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+  auto res = ::fcntl(fd_, F_SETFL, flags);
+  if (res == -1) {
+    SPDLOG_ERROR("can't set fd: {} flags: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't set socket flags" };
+  }
+
+  SPDLOG_INFO("set fd: {} nonblocking = {}", fd_, nonblocking);
+}
+
 ssize_t Socket::read(void* buffer, size_t size)
 {
   SPDLOG_INFO("try to read {} bytes from fd: {}", size, fd_);
 
-  auto read_bytes = ::read(fd_, buffer, size);
-  if (read_bytes == -1) {
-    SPDLOG_ERROR("read from [{}] error: {}", fd_, strerror(errno));
-    throw std::system_error{ errno, std::generic_category(),
+  auto read_bytes = read(buffer, size, std::nothrow);
+  if (read_bytes.would_block()) {
+    SPDLOG_INFO("fd: {} would block", fd_);
+    return -1;
+  }
+
+  if (!read_bytes) {
+    SPDLOG_ERROR("read from [{}] error: {}", fd_, strerror(read_bytes.error()));
+    throw std::system_error{ read_bytes.error(), std::generic_category(),
           "can't read" };
   }
 
-  SPDLOG_INFO("readed {} bytes from fd: {}", read_bytes, fd_);
-  return read_bytes;
+  SPDLOG_INFO("readed {} bytes from fd: {}", *read_bytes, fd_);
+  return static_cast<ssize_t>(*read_bytes);
 }
 
 ssize_t Socket::write(const void* buffer, size_t size)
 {
   SPDLOG_INFO("try to write {} bytes to fd: {}", size, fd_);
 
-  auto write_bytes = ::write(fd_, buffer, size);
-  if (write_bytes == -1) {
-    SPDLOG_ERROR("write to [{}] error: {}", fd_, strerror(errno));
-    throw std::system_error{ errno, std::generic_category(),
-          "can't read" };
+  auto write_bytes = write(buffer, size, std::nothrow);
+  if (write_bytes.would_block()) {
+    SPDLOG_INFO("fd: {} would block", fd_);
+    return -1;
+  }
+
+  if (!write_bytes) {
+    SPDLOG_ERROR("write to [{}] error: {}", fd_, strerror(write_bytes.error()));
+    throw std::system_error{ write_bytes.error(), std::generic_category(),
+          "can't write" };
+  }
+
+  SPDLOG_INFO("write {} bytes to fd: {}", *write_bytes, fd_);
+  return static_cast<ssize_t>(*write_bytes);
+}
+
+ssize_t Socket::readv(const iovec* vec, int count)
+{
+  SPDLOG_INFO("try to read {} buffers from fd: {}", count, fd_);
+
+  auto read_bytes = readv(vec, count, std::nothrow);
+  if (read_bytes.would_block()) {
+    SPDLOG_INFO("fd: {} would block", fd_);
+    return -1;
   }
 
-  SPDLOG_INFO("write {} bytes to fd: {}", write_bytes, fd_);
-  return write_bytes;
+  if (!read_bytes) {
+    SPDLOG_ERROR("readv from [{}] error: {}", fd_, strerror(read_bytes.error()));
+    throw std::system_error{ read_bytes.error(), std::generic_category(),
+          "can't readv" };
+  }
+
+  SPDLOG_INFO("readed {} bytes from fd: {}", *read_bytes, fd_);
+  return static_cast<ssize_t>(*read_bytes);
 }
 
+ssize_t Socket::writev(const iovec* vec, int count)
+{
+  SPDLOG_INFO("try to write {} buffers to fd: {}", count, fd_);
+
+  auto write_bytes = writev(vec, count, std::nothrow);
+  if (write_bytes.would_block()) {
+    SPDLOG_INFO("fd: {} would block", fd_);
+    return -1;
+  }
+
+  if (!write_bytes) {
+    SPDLOG_ERROR("writev to [{}] error: {}", fd_, strerror(write_bytes.error()));
+    throw std::system_error{ write_bytes.error(), std::generic_category(),
+          "can't writev" };
+  }
+
+  SPDLOG_INFO("write {} bytes to fd: {}", *write_bytes, fd_);
+  return static_cast<ssize_t>(*write_bytes);
+}
+
+st::Result<std::size_t> Socket::read(void* buffer, size_t size, std::nothrow_t) noexcept
+{
+  auto start = Histogram::Clock::now();
+  auto read_bytes = ::read(fd_, buffer, size);
+  auto error = errno;
+  if (auto metrics = SocketMetrics::find())
+    metrics->read.record(read_bytes, start);
+  if (read_bytes == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(read_bytes);
+}
+
+st::Result<std::size_t> Socket::write(const void* buffer, size_t size, std::nothrow_t) noexcept
+{
+  auto start = Histogram::Clock::now();
+  auto write_bytes = ::send(fd_, buffer, size, MSG_NOSIGNAL);
+  auto error = errno;
+  if (auto metrics = SocketMetrics::find())
+    metrics->write.record(write_bytes, start);
+  if (write_bytes == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(write_bytes);
+}
+
+st::Result<std::size_t> Socket::readv(const iovec* vec, int count, std::nothrow_t) noexcept
+{
+  auto start = Histogram::Clock::now();
+  auto read_bytes = ::readv(fd_, vec, count);
+  auto error = errno;
+  if (auto metrics = SocketMetrics::find())
+    metrics->read.record(read_bytes, start);
+  if (read_bytes == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(read_bytes);
+}
+
+st::Result<std::size_t> Socket::writev(const iovec* vec, int count, std::nothrow_t) noexcept
+{
+  auto start = Histogram::Clock::now();
+  msghdr message{};
+  message.msg_iov = const_cast<iovec*>(vec);
+  message.msg_iovlen = static_cast<std::size_t>(count);
+  auto write_bytes = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+  auto error = errno;
+  if (auto metrics = SocketMetrics::find())
+    metrics->write.record(write_bytes, start);
+  if (write_bytes == -1)
+    return st::Error{ error };
+
+  return static_cast<std::size_t>(write_bytes);
+}
+
+
+void Socket::set_raw_option(int level, int name, const void* value, socklen_t length)
+{
+  SPDLOG_INFO("setting fd: {} option[level = {}, name = {}]", fd_, level, name);
+
+  auto res = ::setsockopt(fd_, level, name, value, length);
+  if (res == -1) {
+    SPDLOG_ERROR("can't set fd: {} option[level = {}, name = {}]: {}", fd_, level, name, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't set socket option" };
+  }
+
+  SPDLOG_INFO("set fd: {} option[level = {}, name = {}]", fd_, level, name);
+}
+
+void Socket::get_raw_option(int level, int name, void* value, socklen_t* length) const
+{
+  auto res = ::getsockopt(fd_, level, name, value, length);
+  if (res == -1) {
+    SPDLOG_ERROR("can't get fd: {} option[level = {}, name = {}]: {}", fd_, level, name, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't get socket option" };
+  }
+}
 
 } // namespace ST::Net
\ No newline at end of file
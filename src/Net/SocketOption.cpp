@@ -0,0 +1,62 @@
+#include "ST/Net/SocketOption.h"
+
+#include <spdlog/spdlog.h>
+
+#include "ST/Net/Socket.h"
+
+
+namespace ST::Net {
+
+void SocketProfile::apply(Socket& socket) const
+{
+  SPDLOG_INFO("applying socket profile to fd: {}", socket.fd());
+
+  // IPPROTO_TCP的选项只对TCP socket有效，Unix域socket和UDP上setsockopt会失败
+  if (socket.family() != Family::Unix && socket.type() == Type::TCP) {
+    if (no_delay)
+      socket.set_option<Option::NoDelay>(*no_delay);
+    if (cork)
+      socket.set_option<Option::Cork>(*cork);
+    if (keep_alive_idle)
+      socket.set_option<Option::KeepAliveIdle>(*keep_alive_idle);
+    if (keep_alive_interval)
+      socket.set_option<Option::KeepAliveInterval>(*keep_alive_interval);
+    if (keep_alive_count)
+      socket.set_option<Option::KeepAliveCount>(*keep_alive_count);
+  }
+
+  if (keep_alive)
+    socket.set_option<Option::KeepAlive>(*keep_alive);
+  if (receive_buffer)
+    socket.set_option<Option::ReceiveBuffer>(*receive_buffer);
+  if (send_buffer)
+    socket.set_option<Option::SendBuffer>(*send_buffer);
+  if (busy_poll)
+    socket.set_option<Option::BusyPoll>(*busy_poll);
+
+  SPDLOG_INFO("applied socket profile to fd: {}", socket.fd());
+}
+
+SocketProfile SocketProfile::low_latency()
+{
+  SocketProfile profile{};
+  profile.no_delay = true;
+  profile.keep_alive = true;
+  profile.keep_alive_idle = std::chrono::seconds{ 60 };
+  profile.keep_alive_interval = std::chrono::seconds{ 10 };
+  profile.keep_alive_count = 3;
+
+  return profile;
+}
+
+SocketProfile SocketProfile::bulk_transfer()
+{
+  SocketProfile profile{};
+  profile.no_delay = false;
+  profile.receive_buffer = 4 * 1024 * 1024;
+  profile.send_buffer = 4 * 1024 * 1024;
+
+  return profile;
+}
+
+} // namespace ST::Net
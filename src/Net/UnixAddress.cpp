@@ -0,0 +1,51 @@
+#include "ST/Net/UnixAddress.h"
+
+#include <string.h>
+#include <stddef.h>
+
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST::Net {
+
+UnixAddress::UnixAddress()
+  : address_{}, length_{ sizeof(sa_family_t) }
+{
+  bzero(&address_, sizeof(address_));
+  address_.sun_family = AF_UNIX;
+}
+
+UnixAddress::UnixAddress(const std::string& path)
+  : address_{}, length_{ 0 }
+{
+  bzero(&address_, sizeof(address_));
+  address_.sun_family = AF_UNIX;
+
+  // abstract namespace不需要结尾的'\0'，普通路径需要
+  auto abstract = !path.empty() && path[0] == '@';
+  auto max_length = sizeof(address_.sun_path) - (abstract ? 0 : 1);
+  if (path.size() > max_length) {
+    SPDLOG_ERROR("unix socket path[{}] is too long, max length is {}", path, max_length);
+    throw std::length_error{ "unix socket path is too long" };
+  }
+
+  memcpy(address_.sun_path, path.data(), path.size());
+  if (abstract)
+    address_.sun_path[0] = '\0';
+
+  length_ = offsetof(sockaddr_un, sun_path) + path.size() + (abstract ? 0 : 1);
+}
+
+
+std::string UnixAddress::to_string() const noexcept
+{
+  auto path_length = length_ - offsetof(sockaddr_un, sun_path);
+  if (is_abstract())
+    return fmt::format("type: Unix, address: @{}", std::string{ address_.sun_path + 1, path_length - 1 });
+
+  return fmt::format("type: Unix, address: {}", address_.sun_path);
+}
+
+} // namespace ST::Net
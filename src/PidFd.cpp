@@ -0,0 +1,147 @@
+#include "ST/PidFd.h"
+
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <system_error>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+// glibc 2.36之前的<sys/wait.h>没有P_PIDFD
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+
+namespace ST {
+
+namespace {
+
+/**
+ * @brief pidfd_open(Linux 5.3)
+ *
+ * @details 编译时的内核头文件太旧、没有系统调用号时，和运行时内核不支持一样返回ENOSYS
+ */
+int pidfd_open([[maybe_unused]] pid_t pid) noexcept
+{
+#ifdef SYS_pidfd_open
+  return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int pidfd_send_signal([[maybe_unused]] int fd, [[maybe_unused]] int signal) noexcept
+{
+#ifdef SYS_pidfd_send_signal
+  return static_cast<int>(::syscall(SYS_pidfd_send_signal, fd, signal, nullptr, 0));
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+} // namespace
+
+
+PidFd::PidFd(pid_t pid)
+  : fd_{ -1 }, pid_{ pid }
+{
+  SPDLOG_INFO("opening pidfd for process {}", pid);
+
+  fd_ = pidfd_open(pid);
+  if (fd_ == -1) {
+    SPDLOG_ERROR("can't open pidfd for process[{}]: {}", pid, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't open pidfd" };
+  }
+  // pidfd_open默认就是close-on-exec
+
+  SPDLOG_INFO("opened pidfd {} for process {}", fd_, pid);
+}
+
+PidFd::PidFd(int fd, pid_t pid) noexcept
+  : fd_{ fd }, pid_{ pid }
+{}
+
+PidFd::PidFd(PidFd&& other) noexcept
+  : fd_{ std::exchange(other.fd_, -1) }, pid_{ std::exchange(other.pid_, -1) }
+{}
+
+PidFd& PidFd::operator=(PidFd&& other) noexcept
+{
+  std::swap(fd_, other.fd_);
+  std::swap(pid_, other.pid_);
+  return *this;
+}
+
+PidFd::~PidFd()
+{
+  if (fd_ != -1)
+    ::close(fd_);
+}
+
+
+std::optional<PidFd> PidFd::open(pid_t pid) noexcept
+{
+  auto fd = pidfd_open(pid);
+  if (fd == -1) {
+    SPDLOG_WARN("pidfd is unavailable for process[{}]: {}", pid, strerror(errno));
+    return std::nullopt;
+  }
+
+  return PidFd{ fd, pid };
+}
+
+void PidFd::send_signal(int signal)
+{
+  SPDLOG_INFO("sending signal {} to process {} through pidfd", signal, pid_);
+
+  auto res = pidfd_send_signal(fd_, signal);
+  if (res == -1) {
+    SPDLOG_ERROR("can't send signal {} to process[{}]: {}", signal, pid_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't send signal through pidfd" };
+  }
+
+  SPDLOG_INFO("sent signal {} to process {} through pidfd", signal, pid_);
+}
+
+std::optional<ProcessResult> PidFd::try_wait()
+{
+  return wait_id(WEXITED | WNOHANG);
+}
+
+ProcessResult PidFd::wait()
+{
+  SPDLOG_INFO("waiting for process {} through pidfd", pid_);
+
+  auto result = wait_id(WEXITED);
+
+  SPDLOG_INFO("waited for process {} through pidfd", pid_);
+  return std::move(*result);
+}
+
+std::optional<ProcessResult> PidFd::wait_id(int options)
+{
+  siginfo_t info{};
+  int res;
+  do {
+    res = ::waitid(static_cast<idtype_t>(P_PIDFD), static_cast<id_t>(fd_), &info, options);
+  } while (res == -1 && errno == EINTR);
+
+  if (res == -1) {
+    SPDLOG_ERROR("wait for process[{}] error: {}", pid_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "wait for process error" };
+  }
+
+  // WNOHANG且进程仍在运行时si_pid为0
+  if (info.si_pid == 0)
+    return std::nullopt;
+
+  return ProcessResult::from(info);
+}
+
+} // namespace ST
@@ -16,6 +16,26 @@ ProcessResult::ProcessResult(int status)
   : status_{ status }, initialized_{ true }
 {}
 
+ProcessResult ProcessResult::from(const siginfo_t& info) noexcept
+{
+  // 转换为waitpid的status格式
+  switch (info.si_code) {
+    case CLD_EXITED:
+      return ProcessResult{ W_EXITCODE(info.si_status, 0) };
+    case CLD_KILLED:
+      return ProcessResult{ W_EXITCODE(0, info.si_status) };
+    case CLD_DUMPED:
+      return ProcessResult{ W_EXITCODE(0, info.si_status) | WCOREFLAG };
+    case CLD_STOPPED:
+    case CLD_TRAPPED:
+      return ProcessResult{ W_STOPCODE(info.si_status) };
+    case CLD_CONTINUED:
+      return ProcessResult{ 0xffff };
+  }
+
+  return ProcessResult{ 0 };
+}
+
 
 ProcessResult Process::wait()
 {
@@ -24,27 +44,77 @@ ProcessResult Process::wait()
     throw InvalidProcessWaitException{ "invalid process waiting because process is not runnnig" };
   }
 
-  if (waited_ == false) {
+  if (waited_) {
     SPDLOG_ERROR("you can't wait for a process twice or more");
     throw InvalidProcessWaitException{ "you can't wait for a process twice or more" };
   }
 
   SPDLOG_INFO("waiting for process {}", pid_);
 
+  auto process_result = wait(std::nothrow);
+  if (!process_result) {
+    SPDLOG_ERROR("wait for process[{}] error: {}", pid_, strerror(process_result.error()));
+    throw std::system_error{ process_result.error(), std::generic_category(), "wait for process error" };
+  }
+
+  SPDLOG_INFO("waited for process {}", pid_);
+  return *std::move(process_result);
+}
+
+st::Result<ProcessResult> Process::wait(std::nothrow_t) noexcept
+{
+  if (pid_ == -1 || waited_)
+    return st::Error{ ECHILD };
+
   int process_status;
   auto res = ::waitpid(pid_, &process_status, 0);
+  if (res == -1)
+    return st::Error{ errno };
+
+  waited_ = true;
+  return ProcessResult{ process_status };
+}
+
+std::optional<ProcessResult> Process::try_wait()
+{
+  if (pid_ == -1 || waited_) {
+    SPDLOG_ERROR("invalid process waiting, pid = {}, waited = {}", pid_, waited_);
+    throw InvalidProcessWaitException{ "invalid process waiting, pid = {}, waited = {}", pid_, waited_ };
+  }
+
+  int process_status;
+  auto res = ::waitpid(pid_, &process_status, WNOHANG);
   if (res == -1) {
     SPDLOG_ERROR("wait for process[{}] error: {}", pid_, strerror(errno));
     throw std::system_error{ errno, std::generic_category(), "wait for process error" };
   }
 
-  waited_ = true;
-  ProcessResult process_result{ process_status };
+  if (res == 0)
+    return std::nullopt;
 
+  waited_ = true;
   SPDLOG_INFO("waited for process {}", pid_);
-  return process_result;
+  return ProcessResult{ process_status };
 }
 
+void Process::kill(int signal)
+{
+  // kill(-1, signal)会发给所有有权限的进程，回收之后pid也可能已经被复用
+  if (pid_ == -1 || waited_) {
+    SPDLOG_ERROR("invalid process killing, pid = {}, waited = {}", pid_, waited_);
+    throw InvalidProcessKillException{ "invalid process killing, pid = {}, waited = {}", pid_, waited_ };
+  }
+
+  SPDLOG_INFO("sending signal {} to process {}", signal, pid_);
+
+  auto res = ::kill(pid_, signal);
+  if (res == -1) {
+    SPDLOG_ERROR("can't send signal {} to process[{}]: {}", signal, pid_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't send signal" };
+  }
+
+  SPDLOG_INFO("sent signal {} to process {}", signal, pid_);
+}
 
 namespace ThisProcess {
 
@@ -0,0 +1,372 @@
+#include "ST/ProcessPool.h"
+
+#include <sys/epoll.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+// 不支持pidfd时轮询worker是否退出的间隔
+constexpr static std::chrono::milliseconds EXIT_POLL_INTERVAL{ 10 };
+
+ProcessPool::ProcessPool(std::size_t size, Worker worker, RestartPolicy policy)
+  : slots_(size),
+    worker_{ std::move(worker) },
+    policy_{ policy },
+    poller_{},
+    restarts_{ 0 },
+    stopping_{ false },
+    reload_requested_{ false }
+{}
+
+ProcessPool::~ProcessPool()
+{
+  if (running() > 0)
+    terminate();
+}
+
+
+void ProcessPool::start()
+{
+  SPDLOG_INFO("starting process pool, {} workers", slots_.size());
+
+  for (std::size_t index = 0; index < slots_.size(); ++index)
+    spawn(index);
+
+  SPDLOG_INFO("started process pool, {} workers", slots_.size());
+}
+
+void ProcessPool::run(std::chrono::milliseconds grace)
+{
+  SPDLOG_INFO("running process pool");
+
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    if (reload_requested_.exchange(false, std::memory_order_relaxed))
+      reload(grace);
+
+    supervise();
+  }
+
+  terminate(grace);
+
+  SPDLOG_INFO("process pool stopped");
+}
+
+void ProcessPool::supervise(std::chrono::milliseconds timeout)
+{
+  // 退出事件通过pidfd的handler分发到reap()
+  poller_.poll(static_cast<int>(timeout.count()));
+
+  for (std::size_t index = 0; index < slots_.size(); ++index) {
+    auto& slot = slots_[index];
+    if (slot.process && !slot.pidfd)
+      reap(index);
+  }
+}
+
+void ProcessPool::handle_signals()
+{
+  SPDLOG_INFO("handling signals of process pool");
+
+  signals_ = std::make_unique<SignalSet>(std::initializer_list<int>{ SIGTERM, SIGINT, SIGHUP });
+  signals_->watch(poller_, [this] (const signalfd_siginfo& info) {
+    SPDLOG_INFO("process pool received signal {}", info.ssi_signo);
+
+    if (info.ssi_signo == SIGHUP)
+      request_reload();
+    else
+      stop();
+  });
+
+  SPDLOG_INFO("handled signals of process pool");
+}
+
+void ProcessPool::terminate(std::chrono::milliseconds grace)
+{
+  SPDLOG_INFO("terminating {} workers, grace period {}ms", running(), grace.count());
+
+  for (auto& slot: slots_) {
+    if (!slot.process)
+      continue;
+
+    // 先从poller中移除，worker退出时不再被当作崩溃重启
+    if (slot.pidfd && poller_.contains(slot.pidfd->fd()))
+      poller_.remove(slot.pidfd->fd());
+    signal(slot, SIGTERM);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + grace;
+  for (auto& slot: slots_) {
+    if (!slot.process)
+      continue;
+
+    auto remaining = std::max(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()),
+                              std::chrono::milliseconds::zero());
+    if (!wait_exit(slot, remaining)) {
+      SPDLOG_WARN("worker[{}] didn't exit in grace period, killing it", slot.process->get_pid());
+      signal(slot, SIGKILL);
+      slot.process->wait();
+    }
+
+    detach(slot);
+  }
+
+  SPDLOG_INFO("terminated all workers");
+}
+
+void ProcessPool::reload(std::chrono::milliseconds grace)
+{
+  SPDLOG_INFO("reloading {} workers", slots_.size());
+
+  for (std::size_t index = 0; index < slots_.size(); ++index) {
+    auto& slot = slots_[index];
+
+    Slot old{};
+    if (slot.process) {
+      if (slot.pidfd && poller_.contains(slot.pidfd->fd()))
+        poller_.remove(slot.pidfd->fd());
+
+      old = std::move(slot);
+      slot.process.reset();
+      slot.pidfd.reset();
+    }
+
+    // 新worker先开始accept，旧worker再退出，监听socket上始终有worker
+    spawn(index);
+
+    if (!old.process)
+      continue;
+
+    signal(old, SIGTERM);
+    if (!wait_exit(old, grace)) {
+      SPDLOG_WARN("old worker[{}] didn't exit in grace period, killing it", old.process->get_pid());
+      signal(old, SIGKILL);
+      old.process->wait();
+    }
+  }
+
+  SPDLOG_INFO("reloaded {} workers", slots_.size());
+}
+
+Process ProcessPool::upgrade(const std::string& path,
+                             const std::vector<std::string>& arguments,
+                             std::span<const int> inherited_fds)
+{
+  SPDLOG_INFO("upgrading master to {}, {} inherited fds", path, inherited_fds.size());
+
+  std::string fds{};
+  for (auto fd: inherited_fds) {
+    if (!fds.empty())
+      fds += ',';
+    fds += std::to_string(fd);
+  }
+
+  // exec之前在父进程中准备好argv和envp，子进程中只做async-signal-safe的调用
+  std::vector<char*> argv{};
+  argv.reserve(arguments.size() + 1);
+  for (auto& argument: arguments)
+    argv.push_back(const_cast<char*>(argument.c_str()));
+  argv.push_back(nullptr);
+
+  // 复制当前环境，替换掉可能从上一次升级继承下来的同名变量
+  auto variable = std::string{ INHERITED_FDS_ENV } + '=' + fds;
+  std::string_view prefix{ variable.data(), variable.size() - fds.size() };
+  std::vector<char*> envp{};
+  for (auto env = environ; *env != nullptr; ++env) {
+    if (!std::string_view{ *env }.starts_with(prefix))
+      envp.push_back(*env);
+  }
+  envp.push_back(variable.data());
+  envp.push_back(nullptr);
+
+  Process master{ [&] {
+    for (auto fd: inherited_fds) {
+      auto flags = ::fcntl(fd, F_GETFD);
+      if (flags == -1 || ::fcntl(fd, F_SETFD, flags & ~FD_CLOEXEC) == -1)
+        ::_exit(127);
+    }
+
+    ::execve(path.c_str(), argv.data(), envp.data());
+    // 和shell一样用127表示无法exec，不能抛异常或者调用exit
+    ::_exit(127);
+  } };
+
+  SPDLOG_INFO("upgraded master to {}, pid = {}", path, master.get_pid());
+  return master;
+}
+
+std::vector<int> ProcessPool::inherited_fds()
+{
+  std::vector<int> fds{};
+
+  auto value = ::getenv(INHERITED_FDS_ENV);
+  if (value == nullptr)
+    return fds;
+
+  std::string_view rest{ value };
+  while (!rest.empty()) {
+    auto comma = rest.find(',');
+    auto token = rest.substr(0, comma);
+
+    int fd;
+    auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), fd);
+    if (error != std::errc{} || end != token.data() + token.size()) {
+      SPDLOG_ERROR("invalid inherited fds: {}", value);
+      throw std::invalid_argument{ "invalid inherited fds" };
+    }
+    fds.push_back(fd);
+
+    if (comma == std::string_view::npos)
+      break;
+    rest.remove_prefix(comma + 1);
+  }
+
+  // 不再传给以后fork的worker
+  ::unsetenv(INHERITED_FDS_ENV);
+  return fds;
+}
+
+std::size_t ProcessPool::running() const noexcept
+{
+  return std::count_if(slots_.begin(), slots_.end(), [] (const Slot& slot) { return slot.process.has_value(); });
+}
+
+std::vector<pid_t> ProcessPool::pids() const
+{
+  std::vector<pid_t> result{};
+  for (auto& slot: slots_) {
+    if (slot.process)
+      result.push_back(slot.process->get_pid());
+  }
+  return result;
+}
+
+
+void ProcessPool::spawn(std::size_t index)
+{
+  auto& slot = slots_[index];
+
+  slot.process.emplace([this, index] {
+    // 兄弟worker的pidfd、master的epoll和signalfd对worker没有意义
+    for (auto& other: slots_) {
+      if (other.pidfd)
+        ::close(other.pidfd->fd());
+    }
+    ::close(poller_.fd());
+    if (signals_)
+      ::close(signals_->fd());
+
+    // 屏蔽字会被fork继承，worker需要能收到SIGTERM
+    SignalSet::unblock_all();
+
+    worker_(index);
+  });
+
+  auto pid = slot.process->get_pid();
+  slot.pidfd = PidFd::open(pid);
+  if (slot.pidfd)
+    poller_.add(slot.pidfd->fd(), EPOLLIN, [this, index] (std::uint32_t) { reap(index); });
+
+  SPDLOG_INFO("spawned worker {}, pid = {}, pidfd = {}", index, pid, slot.pidfd ? slot.pidfd->fd() : -1);
+}
+
+void ProcessPool::reap(std::size_t index)
+{
+  auto& slot = slots_[index];
+  if (!slot.process)
+    return;
+
+  // pidfd可读时进程已经退出；不阻塞，防止同一批事件中fd被复用后误判
+  auto result = slot.process->try_wait();
+  if (!result)
+    return;
+
+  auto pid = slot.process->get_pid();
+  if (result->terminated())
+    SPDLOG_WARN("worker {}[{}] was killed by signal {}", index, pid, result->terminated_by());
+  else
+    SPDLOG_INFO("worker {}[{}] exited with status {}", index, pid, result->exit_status());
+
+  auto restart = should_restart(*result) && !stopping_.load(std::memory_order_relaxed);
+  detach(slot);
+
+  if (restart) {
+    ++restarts_;
+    spawn(index);
+  }
+}
+
+void ProcessPool::detach(Slot& slot)
+{
+  if (slot.pidfd && poller_.contains(slot.pidfd->fd()))
+    poller_.remove(slot.pidfd->fd());
+
+  slot.pidfd.reset();
+  slot.process.reset();
+}
+
+bool ProcessPool::should_restart(const ProcessResult& result) const noexcept
+{
+  switch (policy_) {
+    case RestartPolicy::Never:
+      return false;
+    case RestartPolicy::OnFailure:
+      return result.terminated() || (result.normal_exited() && result.exit_status() != EXIT_SUCCESS);
+    case RestartPolicy::Always:
+      return true;
+  }
+
+  return false;
+}
+
+void ProcessPool::signal(Slot& slot, int signal)
+{
+  // pidfd不受pid复用影响
+  if (slot.pidfd)
+    slot.pidfd->send_signal(signal);
+  else
+    slot.process->kill(signal);
+}
+
+bool ProcessPool::wait_exit(Slot& slot, std::chrono::milliseconds timeout)
+{
+  auto& process = *slot.process;
+  if (slot.pidfd) {
+    pollfd event{ slot.pidfd->fd(), POLLIN, 0 };
+    int res;
+    do {
+      res = ::poll(&event, 1, static_cast<int>(timeout.count()));
+    } while (res == -1 && errno == EINTR);
+
+    if (res <= 0)
+      return false;
+
+    process.wait();
+    return true;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!process.try_wait()) {
+    if (std::chrono::steady_clock::now() >= deadline)
+      return false;
+
+    std::this_thread::sleep_for(EXIT_POLL_INTERVAL);
+  }
+
+  return true;
+}
+
+} // namespace ST
@@ -0,0 +1,147 @@
+#include "ST/SharedMemory.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <system_error>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+SharedMemory::SharedMemory(FileSystem::File file, std::size_t size)
+  : file_{ std::move(file) }, data_{ MAP_FAILED }, size_{ size }
+{
+  data_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file_.fd(), 0);
+  if (data_ == MAP_FAILED) {
+    auto error = errno;
+    SPDLOG_ERROR("can't map shared memory[{}, {} bytes]: {}", file_.file_name(), size_, strerror(error));
+    ::close(file_.fd());
+    throw std::system_error{ error, std::generic_category(), "can't map shared memory" };
+  }
+}
+
+SharedMemory::SharedMemory(SharedMemory&& other) noexcept
+  : file_{ std::move(other.file_) },
+    data_{ std::exchange(other.data_, MAP_FAILED) },
+    size_{ std::exchange(other.size_, 0) }
+{}
+
+SharedMemory& SharedMemory::operator=(SharedMemory&& other) noexcept
+{
+  std::swap(file_, other.file_);
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+SharedMemory::~SharedMemory()
+{
+  release();
+}
+
+
+SharedMemory SharedMemory::anonymous(const std::string& name, std::size_t size)
+{
+  SPDLOG_INFO("creating anonymous shared memory {}, {} bytes", name, size);
+
+  auto fd = ::memfd_create(name.c_str(), MFD_CLOEXEC);
+  if (fd == -1) {
+    SPDLOG_ERROR("can't create memfd {}: {}", name, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't create memfd" };
+  }
+
+  FileSystem::File file{ name, fd };
+  try {
+    file.resize(static_cast<off_t>(size));
+  }
+  catch (...) {
+    file.close();
+    throw;
+  }
+
+  SharedMemory memory{ std::move(file), size };
+
+  SPDLOG_INFO("created anonymous shared memory {}, {} bytes", name, size);
+  return memory;
+}
+
+SharedMemory SharedMemory::open(const std::string& name, std::size_t size, bool create)
+{
+  SPDLOG_INFO("opening shared memory {}, {} bytes", name, size);
+
+  auto fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0600);
+  if (fd == -1) {
+    SPDLOG_ERROR("can't open shared memory {}: {}", name, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't open shared memory" };
+  }
+
+  FileSystem::File file{ name, fd };
+  try {
+    if (size != 0)
+      file.resize(static_cast<off_t>(size));
+  }
+  catch (...) {
+    file.close();
+    throw;
+  }
+
+  if (size == 0)
+    return attach(fd);
+
+  SharedMemory memory{ std::move(file), size };
+
+  SPDLOG_INFO("opened shared memory {}, {} bytes", name, size);
+  return memory;
+}
+
+void SharedMemory::unlink(const std::string& name)
+{
+  SPDLOG_INFO("unlinking shared memory {}", name);
+
+  if (::shm_unlink(name.c_str()) == -1) {
+    SPDLOG_ERROR("can't unlink shared memory {}: {}", name, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't unlink shared memory" };
+  }
+
+  SPDLOG_INFO("unlinked shared memory {}", name);
+}
+
+SharedMemory SharedMemory::attach(int fd)
+{
+  SPDLOG_INFO("attaching shared memory on fd {}", fd);
+
+  struct stat status;
+  if (::fstat(fd, &status) == -1) {
+    SPDLOG_ERROR("can't get size of shared memory on fd {}: {}", fd, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't get size of shared memory" };
+  }
+
+  SharedMemory memory{ FileSystem::File{ fmt::format("fd:{}", fd), fd }, static_cast<std::size_t>(status.st_size) };
+
+  SPDLOG_INFO("attached shared memory on fd {}, {} bytes", fd, memory.size());
+  return memory;
+}
+
+void SharedMemory::release() noexcept
+{
+  if (data_ != MAP_FAILED) {
+    ::munmap(data_, size_);
+    data_ = MAP_FAILED;
+  }
+
+  if (file_.opened()) {
+    try {
+      file_.close();
+    }
+    catch (const std::exception& e) {
+      SPDLOG_WARN("can't close shared memory[{}]: {}", file_.file_name(), e.what());
+    }
+  }
+}
+
+} // namespace ST
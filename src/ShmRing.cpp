@@ -0,0 +1,419 @@
+#include "ST/ShmRing.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+constexpr static std::size_t CACHE_LINE_SIZE = 64;
+// "STRING01"，attach时校验
+constexpr static std::uint64_t RING_MAGIC = 0x5354'5249'4e47'3031;
+// 阻塞之前自旋尝试的次数
+constexpr static int SPIN_LIMIT = 128;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory ring requires lock free 64 bit atomics");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared memory ring requires lock free 32 bit atomics");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex word must be 32 bit");
+
+struct ShmRing::Header {
+  std::uint64_t magic;
+  std::uint64_t capacity;
+  std::uint64_t message_size;
+  std::uint64_t slot_stride;
+  RingMode mode;
+
+  // 生产者和消费者的位置放在不同的cache line上，避免false sharing
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> tail;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> head;
+
+  // futex word，每次有消息可读/有空位可写且有等待者时加1
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> readable;
+  std::atomic<std::uint32_t> readers_waiting;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> writable;
+  std::atomic<std::uint32_t> writers_waiting;
+};
+
+namespace {
+
+// slot布局：| sequence(8) | length(4) | padding(4) | payload(message_size) |，按cache line对齐
+constexpr std::size_t LENGTH_OFFSET = sizeof(std::atomic<std::uint64_t>);
+constexpr std::size_t PAYLOAD_OFFSET = 16;
+// Header之后第一个slot的偏移
+constexpr std::size_t HEADER_SIZE = CACHE_LINE_SIZE * 8;
+
+constexpr std::size_t slot_stride(std::size_t message_size) noexcept
+{
+  return (PAYLOAD_OFFSET + message_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+std::atomic<std::uint64_t>& sequence_of(std::byte* slot) noexcept
+{
+  return *std::launder(reinterpret_cast<std::atomic<std::uint64_t>*>(slot));
+}
+
+std::uint32_t* length_of(std::byte* slot) noexcept
+{
+  return reinterpret_cast<std::uint32_t*>(slot + LENGTH_OFFSET);
+}
+
+std::byte* payload_of(std::byte* slot) noexcept
+{
+  return slot + PAYLOAD_OFFSET;
+}
+
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* timeout)
+{
+  // 共享内存跨进程，不能用FUTEX_WAIT_PRIVATE
+  auto res = ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+  if (res == -1 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+    SPDLOG_ERROR("futex wait error: {}", strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "futex wait error" };
+  }
+}
+
+void futex_wake(std::atomic<std::uint32_t>& word) noexcept
+{
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+/**
+ * @brief 对端状态改变后调用，只有在有等待者时才进入内核
+ *
+ * @details 和wait_until()中的waiting.fetch_add(seq_cst)配对：
+ * 要么等待者在重试时能看到刚发布的slot，要么这里能看到waiting > 0
+ */
+void notify(std::atomic<std::uint32_t>& word, std::atomic<std::uint32_t>& waiting) noexcept
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load(std::memory_order_relaxed) == 0)
+    return;
+
+  word.fetch_add(1, std::memory_order_relaxed);
+  futex_wake(word);
+}
+
+/**
+ * @brief 先自旋再在futex上睡眠，直到attempt成功或超时
+ *
+ * @param attempt 成功时返回true/有值
+ * @return 超时时返回值初始化的结果(false/nullopt)
+ */
+template<typename Attempt>
+auto wait_until(Attempt attempt,
+                std::atomic<std::uint32_t>& word,
+                std::atomic<std::uint32_t>& waiting,
+                std::optional<std::chrono::steady_clock::time_point> deadline) -> decltype(attempt())
+{
+  for (int i = 0; i < SPIN_LIMIT; ++i) {
+    if (auto result = attempt())
+      return result;
+    cpu_relax();
+  }
+
+  for (;;) {
+    waiting.fetch_add(1, std::memory_order_seq_cst);
+    auto seen = word.load(std::memory_order_seq_cst);
+
+    if (auto result = attempt()) {
+      waiting.fetch_sub(1, std::memory_order_relaxed);
+      return result;
+    }
+
+    timespec timeout{};
+    const timespec* timeout_pointer = nullptr;
+    if (deadline) {
+      auto remaining = *deadline - std::chrono::steady_clock::now();
+      if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+        return {};
+      }
+
+      auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+      timeout.tv_sec = seconds.count();
+      timeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count();
+      timeout_pointer = &timeout;
+    }
+
+    try {
+      futex_wait(word, seen, timeout_pointer);
+    }
+    catch (...) {
+      waiting.fetch_sub(1, std::memory_order_relaxed);
+      throw;
+    }
+    waiting.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+} // namespace
+
+
+ShmRing::ShmRing(SharedMemory memory, std::size_t capacity, std::size_t message_size)
+  : memory_{ std::move(memory) },
+    header_{ static_cast<Header*>(memory_.data()) },
+    slots_{ static_cast<std::byte*>(memory_.data()) + HEADER_SIZE },
+    capacity_{ capacity },
+    message_size_{ message_size },
+    slot_stride_{ slot_stride(message_size) }
+{
+  static_assert(sizeof(Header) <= HEADER_SIZE, "ring header doesn't fit in reserved space");
+}
+
+
+ShmRing ShmRing::create(std::size_t capacity, std::size_t message_size, RingMode mode)
+{
+  auto memory = SharedMemory::anonymous("st-shm-ring", required_size(std::bit_ceil(capacity), message_size));
+  return initialize(std::move(memory), capacity, message_size, mode);
+}
+
+ShmRing ShmRing::create(const std::string& name, std::size_t capacity, std::size_t message_size, RingMode mode)
+{
+  auto memory = SharedMemory::open(name, required_size(std::bit_ceil(capacity), message_size));
+  return initialize(std::move(memory), capacity, message_size, mode);
+}
+
+ShmRing ShmRing::attach(SharedMemory memory)
+{
+  SPDLOG_INFO("attaching shared memory ring on fd {}", memory.fd());
+
+  if (memory.size() < HEADER_SIZE) {
+    SPDLOG_ERROR("shared memory is too small for a ring: {} bytes", memory.size());
+    throw std::invalid_argument{ "shared memory is too small for a ring" };
+  }
+
+  // header可能来自不可信的对端，先读出来校验，之后只使用校验过的值
+  auto header = static_cast<const Header*>(memory.data());
+  std::uint64_t capacity = header->capacity;
+  std::uint64_t message_size = header->message_size;
+  auto valid = header->magic == RING_MAGIC &&
+               std::has_single_bit(capacity) &&
+               message_size != 0 && message_size <= UINT32_MAX &&
+               header->slot_stride == slot_stride(message_size) &&
+               capacity <= (memory.size() - HEADER_SIZE) / slot_stride(message_size);
+  if (!valid) {
+    SPDLOG_ERROR("shared memory on fd {} isn't a valid ring, capacity = {}, message size = {}, slot stride = {}",
+                 memory.fd(), capacity, message_size, header->slot_stride);
+    throw std::invalid_argument{ "shared memory isn't an initialized ring" };
+  }
+
+  ShmRing ring{ std::move(memory), capacity, message_size };
+
+  SPDLOG_INFO("attached shared memory ring, capacity = {}, message size = {}", capacity, message_size);
+  return ring;
+}
+
+bool ShmRing::try_push(std::span<const std::byte> message)
+{
+  auto header = header_;
+  if (message.size() > message_size_) {
+    SPDLOG_ERROR("message is too long: {} bytes, max is {}", message.size(), message_size_);
+    throw std::length_error{ "message is too long for shared memory ring" };
+  }
+
+  auto position = header->tail.load(std::memory_order_relaxed);
+  std::byte* slot;
+  for (;;) {
+    slot = slot_at(position);
+    auto sequence = sequence_of(slot).load(std::memory_order_acquire);
+    auto difference = static_cast<std::int64_t>(sequence - position);
+
+    if (difference == 0) {
+      if (header->mode == RingMode::SPSC) {
+        header->tail.store(position + 1, std::memory_order_relaxed);
+        break;
+      }
+      if (header->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (difference < 0) {
+      // 消费者还没有释放这个slot，队列已满
+      return false;
+    }
+    else {
+      position = header->tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  *length_of(slot) = static_cast<std::uint32_t>(message.size());
+  std::memcpy(payload_of(slot), message.data(), message.size());
+  sequence_of(slot).store(position + 1, std::memory_order_release);
+
+  notify(header->readable, header->readers_waiting);
+  return true;
+}
+
+void ShmRing::push(std::span<const std::byte> message)
+{
+  wait_writable(message, std::nullopt);
+}
+
+bool ShmRing::push(std::span<const std::byte> message, std::chrono::milliseconds timeout)
+{
+  return wait_writable(message, std::chrono::steady_clock::now() + timeout);
+}
+
+std::optional<std::size_t> ShmRing::try_pop(std::span<std::byte> buffer)
+{
+  if (buffer.size() < message_size_) {
+    SPDLOG_ERROR("buffer is too small: {} bytes, need {}", buffer.size(), message_size_);
+    throw std::length_error{ "buffer is too small for shared memory ring" };
+  }
+
+  auto claim = claim_read();
+  if (!claim)
+    return std::nullopt;
+
+  std::memcpy(buffer.data(), claim->payload.data(), claim->payload.size());
+  release_read(*claim);
+  return claim->payload.size();
+}
+
+std::size_t ShmRing::pop(std::span<std::byte> buffer)
+{
+  return *wait_readable(buffer, std::nullopt);
+}
+
+std::optional<std::size_t> ShmRing::pop(std::span<std::byte> buffer, std::chrono::milliseconds timeout)
+{
+  return wait_readable(buffer, std::chrono::steady_clock::now() + timeout);
+}
+
+std::size_t ShmRing::capacity() const noexcept
+{
+  return capacity_;
+}
+
+std::size_t ShmRing::message_size() const noexcept
+{
+  return message_size_;
+}
+
+RingMode ShmRing::mode() const noexcept
+{
+  return header_->mode;
+}
+
+std::size_t ShmRing::size() const noexcept
+{
+  auto head = header_->head.load(std::memory_order_relaxed);
+  auto tail = header_->tail.load(std::memory_order_relaxed);
+  return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+}
+
+
+ShmRing ShmRing::initialize(SharedMemory memory, std::size_t capacity, std::size_t message_size, RingMode mode)
+{
+  capacity = std::bit_ceil(capacity);
+  SPDLOG_INFO("creating shared memory ring, capacity = {}, message size = {}", capacity, message_size);
+
+  if (capacity == 0 || message_size == 0 || message_size > UINT32_MAX) {
+    SPDLOG_ERROR("invalid ring capacity {} or message size {}", capacity, message_size);
+    throw std::invalid_argument{ "invalid ring capacity or message size" };
+  }
+
+  ShmRing ring{ std::move(memory), capacity, message_size };
+
+  auto header = new (ring.memory_.data()) Header{};
+  header->capacity = capacity;
+  header->message_size = message_size;
+  header->slot_stride = slot_stride(message_size);
+  header->mode = mode;
+
+  // 位置i的slot初始sequence为i，表示第一轮可写
+  for (std::uint64_t i = 0; i < capacity; ++i)
+    new (ring.slot_at(i)) std::atomic<std::uint64_t>{ i };
+
+  header->magic = RING_MAGIC;
+
+  SPDLOG_INFO("created shared memory ring on fd {}", ring.fd());
+  return ring;
+}
+
+std::size_t ShmRing::required_size(std::size_t capacity, std::size_t message_size) noexcept
+{
+  return HEADER_SIZE + capacity * slot_stride(message_size);
+}
+
+std::byte* ShmRing::slot_at(std::uint64_t position) const noexcept
+{
+  return slots_ + (position & (capacity_ - 1)) * slot_stride_;
+}
+
+std::optional<ShmRing::ReadClaim> ShmRing::claim_read() noexcept
+{
+  auto header = header_;
+  auto position = header->head.load(std::memory_order_relaxed);
+  std::byte* slot;
+  for (;;) {
+    slot = slot_at(position);
+    auto sequence = sequence_of(slot).load(std::memory_order_acquire);
+    auto difference = static_cast<std::int64_t>(sequence - (position + 1));
+
+    if (difference == 0) {
+      if (header->mode == RingMode::SPSC) {
+        header->head.store(position + 1, std::memory_order_relaxed);
+        break;
+      }
+      if (header->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (difference < 0) {
+      // 生产者还没有写完这个slot，队列为空
+      return std::nullopt;
+    }
+    else {
+      position = header->head.load(std::memory_order_relaxed);
+    }
+  }
+
+  // 长度由对端写入，有bug或者恶意的对端可能写入超过slot的值
+  std::size_t length = *length_of(slot);
+  if (length > message_size_) {
+    SPDLOG_ERROR("message length {} in slot exceeds message size {}, truncated", length, message_size_);
+    length = message_size_;
+  }
+
+  return ReadClaim{ slot, position, { payload_of(slot), length } };
+}
+
+void ShmRing::release_read(const ReadClaim& claim) noexcept
+{
+  // 下一轮生产者在position + capacity处写这个slot
+  sequence_of(claim.slot).store(claim.position + capacity_, std::memory_order_release);
+  notify(header_->writable, header_->writers_waiting);
+}
+
+bool ShmRing::wait_writable(std::span<const std::byte> message, std::optional<std::chrono::steady_clock::time_point> deadline)
+{
+  return wait_until([&] { return try_push(message); }, header_->writable, header_->writers_waiting, deadline);
+}
+
+std::optional<std::size_t> ShmRing::wait_readable(std::span<std::byte> buffer, std::optional<std::chrono::steady_clock::time_point> deadline)
+{
+  return wait_until([&] { return try_pop(buffer); }, header_->readable, header_->readers_waiting, deadline);
+}
+
+} // namespace ST
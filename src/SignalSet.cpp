@@ -0,0 +1,147 @@
+#include "ST/SignalSet.h"
+
+#include <sys/epoll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+SignalSet::SignalSet(std::initializer_list<int> signals)
+  : fd_{ -1 }, signals_{}, previous_mask_{}, poller_{ nullptr }, handler_{}
+{
+  SPDLOG_INFO("creating signal set of {} signals", signals.size());
+
+  sigemptyset(&signals_);
+  for (auto signal: signals)
+    sigaddset(&signals_, signal);
+
+  // 先阻塞再创建signalfd，中间到达的信号也会排队
+  auto res = ::pthread_sigmask(SIG_BLOCK, &signals_, &previous_mask_);
+  if (res != 0) {
+    SPDLOG_ERROR("can't block signals: {}", strerror(res));
+    throw std::system_error{ res, std::generic_category(), "can't block signals" };
+  }
+
+  fd_ = ::signalfd(-1, &signals_, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (fd_ == -1) {
+    auto error = errno;
+    SPDLOG_ERROR("can't create signalfd: {}", strerror(error));
+    ::pthread_sigmask(SIG_SETMASK, &previous_mask_, nullptr);
+    throw std::system_error{ error, std::generic_category(), "can't create signalfd" };
+  }
+
+  SPDLOG_INFO("created signal set on fd {}", fd_);
+}
+
+SignalSet::~SignalSet()
+{
+  unwatch();
+  ::close(fd_);
+  ::pthread_sigmask(SIG_SETMASK, &previous_mask_, nullptr);
+}
+
+
+void SignalSet::add(int signal)
+{
+  sigaddset(&signals_, signal);
+  update();
+}
+
+void SignalSet::remove(int signal)
+{
+  sigdelset(&signals_, signal);
+  update();
+
+  // 从signalfd移除之后不再屏蔽，恢复默认/原来的处理方式
+  if (!sigismember(&previous_mask_, signal)) {
+    sigset_t unblock;
+    sigemptyset(&unblock);
+    sigaddset(&unblock, signal);
+    ::pthread_sigmask(SIG_UNBLOCK, &unblock, nullptr);
+  }
+}
+
+bool SignalSet::contains(int signal) const noexcept
+{
+  return sigismember(&signals_, signal) == 1;
+}
+
+std::optional<signalfd_siginfo> SignalSet::read()
+{
+  signalfd_siginfo info;
+  auto n = ::read(fd_, &info, sizeof(info));
+  if (n == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return std::nullopt;
+
+    SPDLOG_ERROR("can't read signalfd {}: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't read signalfd" };
+  }
+
+  return info;
+}
+
+void SignalSet::watch(Net::Poller& poller, Handler handler)
+{
+  SPDLOG_INFO("watching signal set on fd {}", fd_);
+
+  unwatch();
+  poller_ = &poller;
+  handler_ = std::move(handler);
+  poller.add(fd_, EPOLLIN, [this] (std::uint32_t) { handle_read(); });
+
+  SPDLOG_INFO("watched signal set on fd {}", fd_);
+}
+
+void SignalSet::unwatch()
+{
+  if (poller_ == nullptr)
+    return;
+
+  if (poller_->contains(fd_))
+    poller_->remove(fd_);
+  poller_ = nullptr;
+}
+
+void SignalSet::unblock_all()
+{
+  sigset_t empty;
+  sigemptyset(&empty);
+  ::pthread_sigmask(SIG_SETMASK, &empty, nullptr);
+}
+
+
+void SignalSet::update()
+{
+  SPDLOG_INFO("updating signal set on fd {}", fd_);
+
+  auto res = ::pthread_sigmask(SIG_BLOCK, &signals_, nullptr);
+  if (res != 0) {
+    SPDLOG_ERROR("can't block signals: {}", strerror(res));
+    throw std::system_error{ res, std::generic_category(), "can't block signals" };
+  }
+
+  if (::signalfd(fd_, &signals_, 0) == -1) {
+    SPDLOG_ERROR("can't update signalfd {}: {}", fd_, strerror(errno));
+    throw std::system_error{ errno, std::generic_category(), "can't update signalfd" };
+  }
+
+  SPDLOG_INFO("updated signal set on fd {}", fd_);
+}
+
+void SignalSet::handle_read()
+{
+  // 同一个信号多次到达时只排队一次，读到没有为止
+  while (auto info = read()) {
+    if (handler_)
+      handler_(*info);
+  }
+}
+
+} // namespace ST
@@ -0,0 +1,68 @@
+#include "ST/Singleton.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+namespace {
+
+struct ShutdownEntry {
+  int order;
+  std::function<void()> shutdown;
+};
+
+// 常量初始化，任何静态对象构造时都可以安全地登记
+constinit std::mutex shutdown_mutex{};
+constinit std::vector<ShutdownEntry>* shutdown_entries = nullptr;
+
+} // namespace
+
+
+void ShutdownRegistry::add(int order, std::function<void()> shutdown)
+{
+  std::lock_guard<std::mutex> lock{ shutdown_mutex };
+  // 故意不释放，静态析构阶段仍然可以登记和shutdown
+  if (shutdown_entries == nullptr)
+    shutdown_entries = new std::vector<ShutdownEntry>{};
+
+  shutdown_entries->push_back(ShutdownEntry{ order, std::move(shutdown) });
+}
+
+void ShutdownRegistry::shutdown()
+{
+  SPDLOG_INFO("shutting down {} registered instances", size());
+
+  for (;;) {
+    std::vector<ShutdownEntry> entries{};
+    {
+      std::lock_guard<std::mutex> lock{ shutdown_mutex };
+      if (shutdown_entries == nullptr || shutdown_entries->empty())
+        break;
+      entries.swap(*shutdown_entries);
+    }
+
+    // 值大的先执行，相同时后登记的先执行
+    std::reverse(entries.begin(), entries.end());
+    std::stable_sort(entries.begin(), entries.end(), [] (const ShutdownEntry& lhs, const ShutdownEntry& rhs) {
+      return lhs.order > rhs.order;
+    });
+
+    // 不持有锁，销毁函数里可以再登记
+    for (auto& entry: entries)
+      entry.shutdown();
+  }
+
+  SPDLOG_INFO("shut down all registered instances");
+}
+
+std::size_t ShutdownRegistry::size()
+{
+  std::lock_guard<std::mutex> lock{ shutdown_mutex };
+  return shutdown_entries == nullptr ? 0 : shutdown_entries->size();
+}
+
+} // namespace ST
@@ -0,0 +1,392 @@
+#include "ST/Spawn.h"
+
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <array>
+#include <utility>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+extern char** environ;
+
+
+namespace ST {
+
+constexpr static std::size_t OUTPUT_CHUNK_SIZE = 4096;
+
+namespace {
+
+/**
+ * @brief spawn过程中创建的管道，出错时自动关闭
+ *
+ */
+class Pipe {
+public:
+  Pipe() : fds_{ -1, -1 } {}
+
+  Pipe(const Pipe& other) = delete;
+  Pipe& operator=(const Pipe& other) = delete;
+
+  ~Pipe()
+  {
+    for (auto fd: fds_) {
+      if (fd != -1)
+        ::close(fd);
+    }
+  }
+
+  void open()
+  {
+    // O_CLOEXEC：只有dup2到0/1/2的那一端会留在子进程里
+    if (::pipe2(fds_.data(), O_CLOEXEC) == -1) {
+      SPDLOG_ERROR("can't create pipe: {}", strerror(errno));
+      throw std::system_error{ errno, std::generic_category(), "can't create pipe" };
+    }
+  }
+
+  int read_end() const noexcept { return fds_[0]; }
+  int write_end() const noexcept { return fds_[1]; }
+
+  int release_read_end() noexcept { return std::exchange(fds_[0], -1); }
+  int release_write_end() noexcept { return std::exchange(fds_[1], -1); }
+
+private:
+  std::array<int, 2> fds_;
+};
+
+void check(int error, const char* message)
+{
+  // posix_spawn系列函数直接返回错误码，不设置errno
+  if (error != 0) {
+    SPDLOG_ERROR("{}: {}", message, strerror(error));
+    throw std::system_error{ error, std::generic_category(), message };
+  }
+}
+
+/**
+ * @brief 为子进程的target(0/1/2)设置重定向
+ *
+ * @param child_end 管道中留给子进程的一端
+ */
+void redirect(posix_spawn_file_actions_t& actions, Stdio stdio, int target, int child_end)
+{
+  switch (stdio) {
+    case Stdio::Inherit:
+      break;
+    case Stdio::Pipe:
+      check(::posix_spawn_file_actions_adddup2(&actions, child_end, target), "can't redirect to pipe");
+      break;
+    case Stdio::Null:
+      check(::posix_spawn_file_actions_addopen(&actions, target, "/dev/null", target == STDIN_FILENO ? O_RDONLY : O_WRONLY, 0),
+            "can't redirect to /dev/null");
+      break;
+  }
+}
+
+std::vector<char*> to_pointers(const std::vector<std::string>& strings)
+{
+  std::vector<char*> pointers{};
+  pointers.reserve(strings.size() + 1);
+  for (auto& string: strings)
+    pointers.push_back(const_cast<char*>(string.c_str()));
+  pointers.push_back(nullptr);
+
+  return pointers;
+}
+
+} // namespace
+
+
+Child::Child(Process process, std::optional<PidFd> pidfd, int input, int output, int error)
+  : process_{ std::move(process) },
+    pidfd_{ std::move(pidfd) },
+    input_{ "stdin", input },
+    output_{ "stdout", output },
+    error_{ "stderr", error }
+{}
+
+Child::Child(Child&& other) noexcept
+  : process_{ std::move(other.process_) },
+    pidfd_{ std::move(other.pidfd_) },
+    input_{ std::move(other.input_) },
+    output_{ std::move(other.output_) },
+    error_{ std::move(other.error_) }
+{}
+
+Child::~Child()
+{
+  close_all();
+}
+
+
+void Child::close_input()
+{
+  if (input_.opened())
+    input_.close();
+}
+
+ProcessResult Child::wait()
+{
+  close_input();
+  return process_.wait();
+}
+
+void Child::kill(int signal)
+{
+  if (pidfd_)
+    pidfd_->send_signal(signal);
+  else
+    process_.kill(signal);
+}
+
+void Child::close_all() noexcept
+{
+  for (auto file: { &input_, &output_, &error_ }) {
+    if (file->opened()) {
+      try {
+        file->close();
+      }
+      catch (const std::exception& e) {
+        SPDLOG_WARN("can't close pipe of child[{}]: {}", pid(), e.what());
+      }
+    }
+  }
+
+  pidfd_.reset();
+}
+
+
+Command::Command(std::string program)
+  : program_{ std::move(program) },
+    arguments_{},
+    environment_{},
+    clear_environment_{ false },
+    directory_{},
+    input_{},
+    output_{},
+    error_{}
+{
+  arguments_.push_back(program_);
+}
+
+Command& Command::argument(std::string argument)
+{
+  arguments_.push_back(std::move(argument));
+  return *this;
+}
+
+Command& Command::arguments(const std::vector<std::string>& arguments)
+{
+  arguments_.insert(arguments_.end(), arguments.begin(), arguments.end());
+  return *this;
+}
+
+Command& Command::environment(const std::string& key, std::string value)
+{
+  environment_[key] = std::move(value);
+  return *this;
+}
+
+Command& Command::remove_environment(const std::string& key)
+{
+  environment_[key] = std::nullopt;
+  return *this;
+}
+
+Command& Command::clear_environment()
+{
+  clear_environment_ = true;
+  return *this;
+}
+
+Command& Command::directory(std::string path)
+{
+  directory_ = std::move(path);
+  return *this;
+}
+
+Command& Command::standard_input(Stdio stdio)
+{
+  input_ = stdio;
+  return *this;
+}
+
+Command& Command::standard_output(Stdio stdio)
+{
+  output_ = stdio;
+  return *this;
+}
+
+Command& Command::standard_error(Stdio stdio)
+{
+  error_ = stdio;
+  return *this;
+}
+
+Child Command::spawn() const
+{
+  SPDLOG_INFO("spawning {}", program_);
+
+  auto input = input_.value_or(Stdio::Inherit);
+  auto output = output_.value_or(Stdio::Inherit);
+  auto error = error_.value_or(Stdio::Inherit);
+
+  Pipe input_pipe{}, output_pipe{}, error_pipe{};
+  if (input == Stdio::Pipe)
+    input_pipe.open();
+  if (output == Stdio::Pipe)
+    output_pipe.open();
+  if (error == Stdio::Pipe)
+    error_pipe.open();
+
+  posix_spawn_file_actions_t actions;
+  check(::posix_spawn_file_actions_init(&actions), "can't init spawn file actions");
+  posix_spawnattr_t attributes;
+  check(::posix_spawnattr_init(&attributes), "can't init spawn attributes");
+
+  pid_t pid = -1;
+  int res = 0;
+  try {
+    redirect(actions, input, STDIN_FILENO, input_pipe.read_end());
+    redirect(actions, output, STDOUT_FILENO, output_pipe.write_end());
+    redirect(actions, error, STDERR_FILENO, error_pipe.write_end());
+
+    if (directory_)
+      check(::posix_spawn_file_actions_addchdir_np(&actions, directory_->c_str()), "can't set working directory");
+
+    // 子进程恢复默认的信号处理和空的信号屏蔽字，不继承父进程的设置
+    sigset_t mask;
+    sigemptyset(&mask);
+    check(::posix_spawnattr_setsigmask(&attributes, &mask), "can't set signal mask");
+    sigset_t defaults;
+    sigfillset(&defaults);
+    check(::posix_spawnattr_setsigdefault(&attributes, &defaults), "can't set signal defaults");
+    check(::posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF),
+          "can't set spawn flags");
+
+    auto argv = to_pointers(arguments_);
+    auto environment = make_environment();
+    auto envp = to_pointers(environment);
+
+    // 不包含'/'时和shell一样在PATH中查找
+    auto spawner = program_.find('/') == std::string::npos ? ::posix_spawnp : ::posix_spawn;
+    res = spawner(&pid, program_.c_str(), &actions, &attributes, argv.data(), envp.data());
+  }
+  catch (...) {
+    ::posix_spawn_file_actions_destroy(&actions);
+    ::posix_spawnattr_destroy(&attributes);
+    throw;
+  }
+
+  ::posix_spawn_file_actions_destroy(&actions);
+  ::posix_spawnattr_destroy(&attributes);
+
+  if (res != 0) {
+    SPDLOG_ERROR("can't spawn {}: {}", program_, strerror(res));
+    throw std::system_error{ res, std::generic_category(), "can't spawn process" };
+  }
+
+  Child child{ Process::adopt(pid),
+               PidFd::open(pid),
+               input_pipe.release_write_end(),
+               output_pipe.release_read_end(),
+               error_pipe.release_read_end() };
+
+  SPDLOG_INFO("spawned {}, pid = {}", program_, pid);
+  return child;
+}
+
+Output Command::output() const
+{
+  SPDLOG_INFO("running {}", program_);
+
+  auto command = *this;
+  command.input_ = input_.value_or(Stdio::Null);
+  command.output_ = Stdio::Pipe;
+  command.error_ = Stdio::Pipe;
+
+  auto child = command.spawn();
+  child.close_input();
+
+  std::string output{}, error{};
+  std::array<pollfd, 2> events{
+    pollfd{ child.standard_output().fd(), POLLIN, 0 },
+    pollfd{ child.standard_error().fd(), POLLIN, 0 }
+  };
+  std::array<std::string*, 2> sinks{ &output, &error };
+
+  // 同时读两个管道，否则子进程可能阻塞在写满的另一个管道上
+  std::array<char, OUTPUT_CHUNK_SIZE> chunk;
+  auto open_pipes = events.size();
+  while (open_pipes > 0) {
+    if (::poll(events.data(), events.size(), -1) == -1) {
+      if (errno == EINTR)
+        continue;
+
+      SPDLOG_ERROR("can't poll output of {}: {}", program_, strerror(errno));
+      throw std::system_error{ errno, std::generic_category(), "can't poll child output" };
+    }
+
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      if (events[i].fd == -1 || events[i].revents == 0)
+        continue;
+
+      auto n = ::read(events[i].fd, chunk.data(), chunk.size());
+      if (n == -1 && errno == EINTR)
+        continue;
+      if (n == -1) {
+        SPDLOG_ERROR("can't read output of {}: {}", program_, strerror(errno));
+        throw std::system_error{ errno, std::generic_category(), "can't read child output" };
+      }
+
+      if (n == 0) {
+        // 负数的fd会被poll忽略
+        events[i].fd = -1;
+        --open_pipes;
+        continue;
+      }
+
+      sinks[i]->append(chunk.data(), static_cast<std::size_t>(n));
+    }
+  }
+
+  auto status = child.wait();
+
+  SPDLOG_INFO("ran {}, {} bytes output, {} bytes error", program_, output.size(), error.size());
+  return Output{ std::move(status), std::move(output), std::move(error) };
+}
+
+std::vector<std::string> Command::make_environment() const
+{
+  std::map<std::string, std::string> variables{};
+  if (!clear_environment_) {
+    for (auto variable = environ; *variable != nullptr; ++variable) {
+      std::string_view entry{ *variable };
+      auto equal = entry.find('=');
+      if (equal == std::string_view::npos)
+        continue;
+
+      variables.emplace(entry.substr(0, equal), entry.substr(equal + 1));
+    }
+  }
+
+  for (auto& [key, value]: environment_) {
+    if (value)
+      variables[key] = *value;
+    else
+      variables.erase(key);
+  }
+
+  std::vector<std::string> result{};
+  result.reserve(variables.size());
+  for (auto& [key, value]: variables)
+    result.push_back(key + "=" + value);
+
+  return result;
+}
+
+} // namespace ST
@@ -0,0 +1,457 @@
+#include "ST/ThreadPool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+
+namespace ST {
+
+// Chase-Lev队列初始容量，满时翻倍
+constexpr static std::size_t INITIAL_DEQUE_CAPACITY = 256;
+// 睡眠之前自旋查找任务的次数
+constexpr static int SPIN_LIMIT = 64;
+
+namespace {
+
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+
+/**
+ * @brief 解析"0-3,8,10-11"格式的CPU列表
+ *
+ */
+std::vector<int> parse_cpu_list(const std::string& list)
+{
+  std::vector<int> cpus{};
+
+  std::size_t position = 0;
+  while (position < list.size()) {
+    auto comma = list.find(',', position);
+    auto token = list.substr(position, comma == std::string::npos ? std::string::npos : comma - position);
+    if (!token.empty()) {
+      auto dash = token.find('-');
+      auto first = std::stoi(token.substr(0, dash));
+      auto last = dash == std::string::npos ? first : std::stoi(token.substr(dash + 1));
+      for (auto cpu = first; cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    }
+
+    if (comma == std::string::npos)
+      break;
+    position = comma + 1;
+  }
+
+  return cpus;
+}
+
+/**
+ * @brief 每个CPU所属的NUMA节点，读取失败(没有/sys或不是NUMA机器)时为空
+ *
+ */
+std::map<int, int> numa_nodes()
+{
+  std::map<int, int> nodes{};
+
+  std::error_code error;
+  std::filesystem::directory_iterator directory{ "/sys/devices/system/node", error };
+  if (error)
+    return nodes;
+
+  for (auto& entry: directory) {
+    auto name = entry.path().filename().string();
+    if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4])))
+      continue;
+
+    std::ifstream cpulist{ entry.path() / "cpulist" };
+    std::string list;
+    if (!std::getline(cpulist, list))
+      continue;
+
+    auto node = std::stoi(name.substr(4));
+    for (auto cpu: parse_cpu_list(list))
+      nodes[cpu] = node;
+  }
+
+  return nodes;
+}
+
+/**
+ * @brief 当前进程允许运行的CPU(考虑taskset/cgroup)
+ *
+ */
+std::vector<int> allowed_cpus()
+{
+  std::vector<int> cpus{};
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof(set), &set) == -1) {
+    SPDLOG_WARN("can't get cpu affinity: {}", strerror(errno));
+    return cpus;
+  }
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &set))
+      cpus.push_back(cpu);
+  }
+
+  return cpus;
+}
+
+void pin_to(std::thread::native_handle_type thread, int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  auto res = ::pthread_setaffinity_np(thread, sizeof(set), &set);
+  if (res != 0)
+    SPDLOG_WARN("can't pin thread to cpu {}: {}", cpu, strerror(res));
+}
+
+} // namespace
+
+
+/**
+ * @brief Chase-Lev work stealing deque
+ *
+ * @details 按照Lê等人"Correct and Efficient Work-Stealing for Weak Memory Models"的C11版本：
+ * 只有owner在bottom端push/take，其他线程在top端steal；容量不足时换成两倍大的数组，
+ * 旧数组可能仍在被steal读取，保留到析构时再释放
+ */
+class ThreadPool::Deque {
+public:
+  Deque()
+    : top_{ 0 }, bottom_{ 0 }, array_{ nullptr }, retired_{}
+  {
+    retired_.push_back(std::make_unique<Array>(INITIAL_DEQUE_CAPACITY));
+    array_.store(retired_.back().get(), std::memory_order_relaxed);
+  }
+
+  ~Deque()
+  {
+    // 析构时所有worker都已经退出
+    while (auto task = take())
+      delete task;
+  }
+
+  void push(Task* task)
+  {
+    auto bottom = bottom_.load(std::memory_order_relaxed);
+    auto top = top_.load(std::memory_order_acquire);
+    auto array = array_.load(std::memory_order_relaxed);
+
+    if (bottom - top > static_cast<std::int64_t>(array->capacity()) - 1)
+      array = grow(array, top, bottom);
+
+    array->put(bottom, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  Task* take()
+  {
+    auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    auto array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto top = top_.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      // 队列为空
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    auto task = array->get(bottom);
+    if (top == bottom) {
+      // 最后一个元素，和steal竞争
+      if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        task = nullptr;
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return task;
+  }
+
+  Task* steal()
+  {
+    auto top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto bottom = bottom_.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+      return nullptr;
+
+    auto array = array_.load(std::memory_order_acquire);
+    auto task = array->get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return nullptr;
+
+    return task;
+  }
+
+private:
+  class Array {
+  public:
+    explicit Array(std::size_t capacity)
+      : mask_{ capacity - 1 }, slots_{ std::make_unique<std::atomic<Task*>[]>(capacity) }
+    {}
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    Task* get(std::int64_t index) const noexcept
+    {
+      return slots_[static_cast<std::size_t>(index) & mask_].load(std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t index, Task* task) noexcept
+    {
+      slots_[static_cast<std::size_t>(index) & mask_].store(task, std::memory_order_relaxed);
+    }
+
+  private:
+    std::size_t mask_;
+    std::unique_ptr<std::atomic<Task*>[]> slots_;
+  };
+
+  alignas(64) std::atomic<std::int64_t> top_;
+  alignas(64) std::atomic<std::int64_t> bottom_;
+  std::atomic<Array*> array_;
+  // 只有owner修改
+  std::vector<std::unique_ptr<Array>> retired_;
+
+  Array* grow(Array* array, std::int64_t top, std::int64_t bottom)
+  {
+    auto bigger = std::make_unique<Array>(array->capacity() * 2);
+    for (auto i = top; i < bottom; ++i)
+      bigger->put(i, array->get(i));
+
+    auto result = bigger.get();
+    retired_.push_back(std::move(bigger));
+    array_.store(result, std::memory_order_release);
+    return result;
+  }
+};
+
+
+ThreadPool::ThreadPool(std::size_t size, Affinity affinity)
+  : workers_{},
+    global_mutex_{},
+    global_{},
+    global_size_{ 0 },
+    epoch_{ 0 },
+    sleeping_{ 0 }
+{
+  auto cpus = allowed_cpus();
+  if (size == 0)
+    size = cpus.empty() ? std::max(1U, std::thread::hardware_concurrency()) : cpus.size();
+
+  SPDLOG_INFO("starting thread pool, {} workers", size);
+
+  // 同一节点的CPU排在一起，相邻编号的worker在同一节点上
+  auto nodes = numa_nodes();
+  auto node_of = [&nodes] (int cpu) { auto it = nodes.find(cpu); return it == nodes.end() ? 0 : it->second; };
+  std::stable_sort(cpus.begin(), cpus.end(), [&] (int lhs, int rhs) { return node_of(lhs) < node_of(rhs); });
+
+  workers_.resize(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    workers_[i].deque = std::make_unique<Deque>();
+    if (affinity == Affinity::Pinned && !cpus.empty())
+      workers_[i].cpu = cpus[i % cpus.size()];
+  }
+
+  for (std::size_t i = 0; i < size; ++i) {
+    auto node = node_of(workers_[i].cpu);
+    auto& victims = workers_[i].victims;
+    // 从自己的下一个开始轮转，避免所有worker都先偷同一个
+    for (std::size_t offset = 1; offset < size; ++offset) {
+      auto victim = (i + offset) % size;
+      if (node_of(workers_[victim].cpu) == node)
+        victims.push_back(victim);
+    }
+    for (std::size_t offset = 1; offset < size; ++offset) {
+      auto victim = (i + offset) % size;
+      if (node_of(workers_[victim].cpu) != node)
+        victims.push_back(victim);
+    }
+  }
+
+  // 所有worker的队列都创建好之后再启动线程
+  for (std::size_t i = 0; i < size; ++i) {
+    workers_[i].thread = std::jthread{ [this, i] (std::stop_token token) { run(token, i); } };
+    if (workers_[i].cpu != -1)
+      pin_to(workers_[i].thread.native_handle(), workers_[i].cpu);
+  }
+
+  std::set<int> distinct_nodes{};
+  for (auto& worker: workers_)
+    distinct_nodes.insert(node_of(worker.cpu));
+
+  SPDLOG_INFO("started thread pool, {} workers on {} numa nodes", size, distinct_nodes.size());
+}
+
+ThreadPool::~ThreadPool()
+{
+  SPDLOG_INFO("stopping thread pool, {} workers", workers_.size());
+
+  for (auto& worker: workers_)
+    worker.thread.request_stop();
+
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  epoch_.notify_all();
+
+  for (auto& worker: workers_)
+    worker.thread.join();
+
+  SPDLOG_INFO("stopped thread pool");
+}
+
+
+std::ptrdiff_t ThreadPool::worker_index() const noexcept
+{
+  return current_pool == this ? static_cast<std::ptrdiff_t>(current_index) : -1;
+}
+
+std::vector<int> ThreadPool::cpus() const
+{
+  std::vector<int> result{};
+  for (auto& worker: workers_) {
+    if (worker.cpu != -1)
+      result.push_back(worker.cpu);
+  }
+  return result;
+}
+
+void ThreadPool::schedule(Task* task)
+{
+  if (current_pool == this) {
+    workers_[current_index].deque->push(task);
+  }
+  else {
+    std::lock_guard<std::mutex> lock{ global_mutex_ };
+    global_.push_back(task);
+    global_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  wake_one();
+}
+
+void ThreadPool::run(std::stop_token token, std::size_t index)
+{
+  current_pool = this;
+  current_index = index;
+
+  for (;;) {
+    if (auto task = find_task(index)) {
+      execute(task);
+      continue;
+    }
+
+    auto found = false;
+    for (int i = 0; i < SPIN_LIMIT && !found; ++i) {
+      if (auto task = find_task(index)) {
+        execute(task);
+        found = true;
+      }
+      else {
+        std::this_thread::yield();
+      }
+    }
+    if (found)
+      continue;
+
+    // 和wake_one()配对：要么这里重新查找时能看到新任务，要么提交者能看到sleeping_ > 0
+    sleeping_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto epoch = epoch_.load(std::memory_order_seq_cst);
+
+    if (auto task = find_task(index)) {
+      sleeping_.fetch_sub(1, std::memory_order_relaxed);
+      execute(task);
+      continue;
+    }
+
+    // 先执行完所有已提交的任务再退出
+    if (token.stop_requested()) {
+      sleeping_.fetch_sub(1, std::memory_order_relaxed);
+      break;
+    }
+
+    epoch_.wait(epoch, std::memory_order_seq_cst);
+    sleeping_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  current_pool = nullptr;
+}
+
+ThreadPool::Task* ThreadPool::find_task(std::size_t index)
+{
+  auto& worker = workers_[index];
+  if (auto task = worker.deque->take())
+    return task;
+
+  if (auto task = pop_global())
+    return task;
+
+  for (auto victim: worker.victims) {
+    if (auto task = workers_[victim].deque->steal())
+      return task;
+  }
+
+  return nullptr;
+}
+
+ThreadPool::Task* ThreadPool::pop_global()
+{
+  // 大部分时候全局队列为空，不需要加锁
+  if (global_size_.load(std::memory_order_relaxed) == 0)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock{ global_mutex_ };
+  if (global_.empty())
+    return nullptr;
+
+  auto task = global_.front();
+  global_.pop_front();
+  global_size_.fetch_sub(1, std::memory_order_relaxed);
+  return task;
+}
+
+void ThreadPool::wake_one() noexcept
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed) == 0)
+    return;
+
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  epoch_.notify_one();
+}
+
+void ThreadPool::execute(Task* task) noexcept
+{
+  // submit的任务异常已经被packaged_task保存，这里只是兜底
+  try {
+    task->run();
+  }
+  catch (const std::exception& e) {
+    SPDLOG_ERROR("thread pool task threw: {}", e.what());
+  }
+  catch (...) {
+    SPDLOG_ERROR("thread pool task threw unknown exception");
+  }
+
+  delete task;
+}
+
+} // namespace ST
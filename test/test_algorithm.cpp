@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "st/Alogorithm.h"
+#include "ST/ThreadPool.h"
+
+
+namespace {
+
+std::vector<std::int64_t> random_values(std::size_t size, unsigned seed)
+{
+  std::mt19937 engine{ seed };
+  std::vector<std::int64_t> values(size);
+  for (auto& value: values)
+    value = static_cast<std::int64_t>(engine() % 2001) - 1000;
+
+  return values;
+}
+
+// 不能默认构造，也不满足交换律
+struct Word {
+  explicit Word(std::string text) : text{ std::move(text) } {}
+  std::string text;
+};
+
+} // namespace
+
+
+TEST_CASE("parallel reduce keeps the order of a non-commutative op", "[algorithm]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  auto values = random_values(100000, 1);
+  REQUIRE(st::parallel_reduce(pool, values.begin(), values.end(), std::int64_t{ 0 }, std::plus<>{}, 1000) ==
+          std::accumulate(values.begin(), values.end(), std::int64_t{ 0 }));
+
+  std::vector<std::string> letters{};
+  for (int i = 0; i < 5000; ++i)
+    letters.push_back(std::string(1, static_cast<char>('a' + i % 26)));
+  auto expected = std::accumulate(letters.begin(), letters.end(), std::string{ ">" });
+  REQUIRE(st::parallel_reduce(pool, letters.begin(), letters.end(), std::string{ ">" }, std::plus<>{}, 37) == expected);
+
+  std::vector<int> empty{};
+  REQUIRE(st::parallel_reduce(pool, empty.begin(), empty.end(), 7) == 7);
+
+  auto squares = st::parallel_transform_reduce(pool, values.begin(), values.end(), std::int64_t{ 0 }, std::plus<>{},
+                                               [] (std::int64_t value) { return value * value; }, 999);
+  REQUIRE(squares == std::transform_reduce(values.begin(), values.end(), std::int64_t{ 0 }, std::plus<>{},
+                                           [] (std::int64_t value) { return value * value; }));
+}
+
+TEST_CASE("parallel scans match std scans, including in place", "[algorithm]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  for (std::size_t size: { 0, 1, 999, 1000, 1001, 123457 }) {
+    auto values = random_values(size, static_cast<unsigned>(size));
+
+    std::vector<std::int64_t> expected(size);
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+    std::vector<std::int64_t> actual(size);
+    auto end = st::parallel_inclusive_scan(pool, values.begin(), values.end(), actual.begin(), std::plus<>{}, 1000);
+    REQUIRE(end == actual.end());
+    REQUIRE(actual == expected);
+
+    std::exclusive_scan(values.begin(), values.end(), expected.begin(), std::int64_t{ 5 });
+    st::parallel_exclusive_scan(pool, values.begin(), values.end(), values.begin(), std::int64_t{ 5 }, std::plus<>{}, 1000);
+    REQUIRE(values == expected);
+  }
+
+  std::vector<std::string> letters(3000, "x");
+  std::vector<std::string> prefixes(letters.size());
+  st::parallel_exclusive_scan(pool, letters.begin(), letters.end(), prefixes.begin(), std::string{}, std::plus<>{}, 100);
+  for (std::size_t i = 0; i < prefixes.size(); ++i)
+    REQUIRE(prefixes[i].size() == i);
+}
+
+TEST_CASE("parallel stable partition keeps relative order", "[algorithm]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  auto values = random_values(200000, 3);
+  std::vector<std::pair<std::int64_t, std::size_t>> indexed{};
+  for (std::size_t i = 0; i < values.size(); ++i)
+    indexed.emplace_back(values[i], i);
+
+  auto negative = [] (const std::pair<std::int64_t, std::size_t>& item) { return item.first < 0; };
+  auto expected = indexed;
+  auto expected_middle = std::stable_partition(expected.begin(), expected.end(), negative);
+
+  auto middle = st::parallel_stable_partition(pool, indexed.begin(), indexed.end(), negative, 3000);
+  REQUIRE(middle - indexed.begin() == expected_middle - expected.begin());
+  REQUIRE(indexed == expected);
+
+  // 不能默认构造的元素退化为std::stable_partition
+  std::vector<Word> words{};
+  for (int i = 0; i < 100; ++i)
+    words.emplace_back(std::to_string(i));
+  auto even = st::parallel_stable_partition(pool, words.begin(), words.end(),
+                                            [] (const Word& word) { return (word.text.back() - '0') % 2 == 0; }, 10);
+  REQUIRE(even - words.begin() == 50);
+  REQUIRE(words.front().text == "0");
+  REQUIRE(even->text == "1");
+}
+
+TEST_CASE("loser tree merges runs stably", "[algorithm]") {
+  using Run = std::vector<std::pair<int, int>>;
+  // second为所在run的编号
+  std::vector<Run> runs{
+    { { 1, 0 }, { 3, 0 }, { 3, 0 }, { 9, 0 } },
+    {},
+    { { 0, 2 }, { 3, 2 }, { 10, 2 } },
+    { { 3, 3 } },
+    { { 2, 4 }, { 4, 4 } }
+  };
+
+  std::vector<std::pair<Run::const_iterator, Run::const_iterator>> ranges{};
+  Run expected{};
+  for (auto& run: runs) {
+    ranges.emplace_back(run.begin(), run.end());
+    expected.insert(expected.end(), run.begin(), run.end());
+  }
+  auto by_key = [] (const std::pair<int, int>& lhs, const std::pair<int, int>& rhs) { return lhs.first < rhs.first; };
+  std::stable_sort(expected.begin(), expected.end(), by_key);
+
+  Run merged{};
+  st::kway_merge(ranges, std::back_inserter(merged), by_key);
+  REQUIRE(merged == expected);
+
+  std::vector<std::pair<Run::const_iterator, Run::const_iterator>> none{};
+  Run nothing{};
+  st::kway_merge(none, std::back_inserter(nothing), by_key);
+  REQUIRE(nothing.empty());
+
+  // 各种k，包括不是2的幂
+  std::mt19937 engine{ 11 };
+  for (std::size_t k = 1; k <= 17; ++k) {
+    std::vector<std::vector<int>> sorted_runs(k);
+    std::vector<int> all{};
+    for (auto& run: sorted_runs) {
+      run.resize(engine() % 50);
+      for (auto& value: run)
+        value = static_cast<int>(engine() % 100);
+      std::sort(run.begin(), run.end());
+      all.insert(all.end(), run.begin(), run.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    std::vector<std::pair<std::vector<int>::iterator, std::vector<int>::iterator>> heads{};
+    for (auto& run: sorted_runs)
+      heads.emplace_back(run.begin(), run.end());
+
+    std::vector<int> out(all.size());
+    REQUIRE(st::kway_merge(heads, out.begin()) == out.end());
+    REQUIRE(out == all);
+  }
+}
+
+TEST_CASE("parallel top k returns the k smallest in order", "[algorithm]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  auto values = random_values(100000, 5);
+  auto sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+
+  for (std::size_t k: { 0, 1, 10, 1000 }) {
+    auto top = st::parallel_top_k(pool, values.begin(), values.end(), k, std::less<>{}, 2000);
+    REQUIRE(top == std::vector<std::int64_t>(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(k)));
+  }
+
+  auto largest = st::parallel_top_k(pool, values.begin(), values.end(), 5, std::greater<>{});
+  REQUIRE(largest == std::vector<std::int64_t>(sorted.rbegin(), sorted.rbegin() + 5));
+
+  std::vector<int> few{ 3, 1, 2 };
+  REQUIRE(st::parallel_top_k(ST::ThreadPool::global(), few.begin(), few.end(), 10) == std::vector<int>{ 1, 2, 3 });
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "st/Cast.h"
+
+
+namespace {
+
+template<typename Integer>
+std::vector<Integer> random_integers(std::size_t count)
+{
+  std::mt19937_64 engine{ count };
+  std::vector<Integer> integers(count);
+  for (auto& integer: integers)
+    integer = static_cast<Integer>(engine());
+
+  return integers;
+}
+
+template<typename Integer>
+void check_all_levels()
+{
+  std::vector<st::detail::SimdLevel> levels{ st::detail::SimdLevel::Scalar };
+  if (st::detail::simd_level() >= st::detail::SimdLevel::SSSE3)
+    levels.push_back(st::detail::SimdLevel::SSSE3);
+  if (st::detail::simd_level() >= st::detail::SimdLevel::AVX2)
+    levels.push_back(st::detail::SimdLevel::AVX2);
+
+  // 覆盖不足一个向量、刚好整数个向量和带尾部的长度
+  for (std::size_t count: { 0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 64, 1000 }) {
+    auto host = random_integers<Integer>(count);
+    std::vector<Integer> expected(count);
+    for (std::size_t i = 0; i < count; ++i)
+      expected[i] = st::byte_order_cast<st::Net>(host[i]);
+
+    for (auto level: levels) {
+      std::vector<Integer> net(count);
+      st::detail::byteswap(host.data(), net.data(), count, level);
+      REQUIRE(net == expected);
+
+      // 原地转换
+      auto in_place = host;
+      st::detail::byteswap(in_place.data(), in_place.data(), count, level);
+      REQUIRE(in_place == expected);
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("single value byte order cast is constexpr", "[cast]") {
+  static_assert(st::byte_order_cast<st::Net>(std::uint16_t{ 0x1234 }) == 0x3412);
+  static_assert(st::byte_order_cast<st::Net>(std::uint32_t{ 0x12345678 }) == 0x78563412);
+  static_assert(st::byte_order_cast<st::Host>(std::uint64_t{ 0x0102030405060708 }) == 0x0807060504030201);
+  static_assert(st::byte_order_cast<st::Net>(std::uint8_t{ 0x12 }) == 0x12);
+
+  REQUIRE(st::byte_order_cast<st::Net>(std::uint32_t{ 0x12345678 }) == htonl(0x12345678));
+  REQUIRE(st::byte_order_cast<st::Host>(std::int16_t{ -2 }) == static_cast<std::int16_t>(ntohs(0xfffe)));
+}
+
+TEST_CASE("bulk byte order cast matches the scalar conversion", "[cast]") {
+  check_all_levels<std::uint16_t>();
+  check_all_levels<std::uint32_t>();
+  check_all_levels<std::uint64_t>();
+  check_all_levels<std::int32_t>();
+}
+
+TEST_CASE("span overloads convert whole arrays", "[cast]") {
+  std::vector<std::uint32_t> host(100);
+  std::iota(host.begin(), host.end(), 0x01020300);
+
+  std::vector<std::uint32_t> net(host.size());
+  st::byte_order_cast<st::Net>(std::span{ host }, std::span{ net });
+  for (std::size_t i = 0; i < host.size(); ++i)
+    REQUIRE(net[i] == htonl(host[i]));
+
+  st::byte_order_cast<st::Host>(std::span{ net });
+  REQUIRE(net == host);
+
+  std::uint16_t fixed[3]{ 0x0102, 0x0304, 0x0506 };
+  st::byte_order_cast<st::Net>(std::span{ fixed });
+  REQUIRE(fixed[2] == 0x0605);
+
+  std::vector<std::uint32_t> shorter(host.size() - 1);
+  REQUIRE_THROWS_AS(st::byte_order_cast<st::Net>(std::span{ host }, std::span{ shorter }), std::length_error);
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ST/Net/Buffer.h"
+#include "ST/Net/Codec.h"
+
+
+namespace {
+
+std::span<const std::byte> as_bytes(std::string_view text)
+{
+  return std::as_bytes(std::span{ text.data(), text.size() });
+}
+
+std::string to_string(std::span<const std::byte> bytes)
+{
+  return { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+}
+
+} // namespace
+
+
+TEST_CASE("length field codec decodes complete frames", "[codec]") {
+  ST::Net::LengthFieldCodec codec{};
+  ST::Net::Buffer buffer{};
+
+  std::vector<std::span<const std::byte>> frames{ as_bytes("hello"), as_bytes(""), as_bytes("world!") };
+  codec.encode(buffer, frames);
+  REQUIRE(buffer.readable_bytes() == 3 * ST::Net::LengthFieldCodec::HEADER_LENGTH + 11);
+
+  std::vector<std::string> decoded;
+  auto count = codec.decode(buffer, [&](std::span<const std::byte> payload) {
+    decoded.push_back(to_string(payload));
+  });
+
+  REQUIRE(count == 3);
+  REQUIRE(decoded == std::vector<std::string>{ "hello", "", "world!" });
+  REQUIRE(buffer.readable_bytes() == 0);
+}
+
+TEST_CASE("length field codec reassembles partial frames", "[codec]") {
+  ST::Net::LengthFieldCodec codec{};
+  ST::Net::Buffer encoded{};
+  std::vector<std::span<const std::byte>> frames{ as_bytes("partial frame") };
+  codec.encode(encoded, frames);
+  auto bytes = encoded.readable();
+
+  ST::Net::Buffer buffer{ 8 };
+  std::vector<std::string> decoded;
+  auto on_frame = [&](std::span<const std::byte> payload) { decoded.push_back(to_string(payload)); };
+
+  // 每次只喂入一个字节，直到最后一个字节之前都不应该解出帧
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    buffer.append(bytes.data() + i, 1);
+    auto count = codec.decode(buffer, on_frame);
+    REQUIRE(count == (i + 1 == bytes.size() ? 1 : 0));
+  }
+
+  REQUIRE(decoded == std::vector<std::string>{ "partial frame" });
+}
+
+TEST_CASE("length field codec skips bytes already sent", "[codec]") {
+  std::vector<std::span<const std::byte>> frames{ as_bytes("hello"), as_bytes(""), as_bytes("world!") };
+
+  for (auto checksum: { ST::Net::FrameChecksum::None, ST::Net::FrameChecksum::CRC32C }) {
+    ST::Net::LengthFieldCodec codec{ ST::Net::DEFAULT_MAX_FRAME_LENGTH, checksum };
+    ST::Net::Buffer encoded{};
+    codec.encode(encoded, frames);
+    auto bytes = encoded.readable();
+
+    // 任意位置截断后，剩余部分和完整编码的尾部一致
+    for (std::size_t skip = 0; skip <= bytes.size(); ++skip) {
+      ST::Net::Buffer rest{};
+      codec.encode(rest, frames, skip);
+      auto tail = bytes.subspan(skip);
+      REQUIRE(std::vector<std::byte>(rest.readable().begin(), rest.readable().end()) ==
+              std::vector<std::byte>(tail.begin(), tail.end()));
+    }
+  }
+}
+
+TEST_CASE("length field codec rejects oversized frames", "[codec]") {
+  ST::Net::LengthFieldCodec codec{ 4 };
+  ST::Net::Buffer buffer{};
+  std::vector<std::span<const std::byte>> frames{ as_bytes("too long") };
+
+  REQUIRE_THROWS_AS(codec.encode(buffer, frames), ST::FrameTooLongException);
+
+  ST::Net::LengthFieldCodec relaxed{};
+  relaxed.encode(buffer, frames);
+  REQUIRE_THROWS_AS(codec.decode(buffer, [](std::span<const std::byte>) {}), ST::FrameTooLongException);
+}
+
+TEST_CASE("length field codec verifies frame checksums", "[codec]") {
+  ST::Net::LengthFieldCodec codec{ ST::Net::DEFAULT_MAX_FRAME_LENGTH, ST::Net::FrameChecksum::CRC32C };
+  REQUIRE(codec.header_length() == ST::Net::LengthFieldCodec::HEADER_LENGTH + ST::Net::LengthFieldCodec::CHECKSUM_LENGTH);
+
+  ST::Net::Buffer buffer{};
+  std::vector<std::span<const std::byte>> frames{ as_bytes("checked"), as_bytes("") };
+  codec.encode(buffer, frames);
+  REQUIRE(buffer.readable_bytes() == ST::Net::LengthFieldCodec::encoded_length(frames, ST::Net::FrameChecksum::CRC32C));
+
+  std::vector<std::string> decoded;
+  REQUIRE(codec.decode(buffer, [&](std::span<const std::byte> payload) { decoded.push_back(to_string(payload)); }) == 2);
+  REQUIRE(decoded == std::vector<std::string>{ "checked", "" });
+
+  // 翻转负载中的一位
+  codec.encode(buffer, frames);
+  std::vector<std::byte> bytes{ buffer.readable().begin(), buffer.readable().end() };
+  bytes[codec.header_length() + 3] ^= std::byte{ 0x10 };
+  ST::Net::Buffer corrupted{};
+  corrupted.append(bytes.data(), bytes.size());
+  REQUIRE_THROWS_AS(codec.decode(corrupted, [](std::span<const std::byte>) {}), ST::FrameChecksumException);
+}
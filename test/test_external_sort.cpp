@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ST/Exception.h"
+#include "ST/FileSystem/ExternalSort.h"
+#include "ST/ThreadPool.h"
+
+
+namespace {
+
+using ST::FileSystem::File;
+
+struct Entry {
+  std::uint64_t key;
+  std::uint64_t order;
+};
+
+// 12字节，块边界和页边界不对齐
+struct Packed {
+  std::uint32_t key;
+  std::uint32_t order;
+  std::uint32_t check;
+};
+
+auto by_key = [] (const auto& lhs, const auto& rhs) { return lhs.key < rhs.key; };
+
+template<typename Record>
+std::vector<Record> entries(std::size_t size, std::uint32_t keys)
+{
+  std::mt19937 engine{ static_cast<unsigned>(size) };
+  std::vector<Record> records(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    records[i].key = static_cast<decltype(Record::key)>(engine() % keys);
+    records[i].order = static_cast<decltype(Record::order)>(i);
+    if constexpr (requires { records[i].check; })
+      records[i].check = records[i].key ^ records[i].order;
+  }
+
+  return records;
+}
+
+template<typename Record>
+File file_of(const std::vector<Record>& records)
+{
+  auto file = File::tmpfile("/tmp/st-test-external-sort", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  ST::FileSystem::detail::write_exactly(file, records.data(), records.size() * sizeof(Record), 0);
+  return file;
+}
+
+template<typename Record>
+std::vector<Record> records_of(const File& file)
+{
+  std::vector<Record> records(ST::FileSystem::detail::file_size(file) / sizeof(Record));
+  ST::FileSystem::detail::read_exactly(file, records.data(), records.size() * sizeof(Record), 0);
+  return records;
+}
+
+// 相等的key之间不保证顺序，比较排序后的key和记录集合
+template<typename Record>
+void require_sorted_permutation(std::vector<Record> actual, std::vector<Record> expected)
+{
+  REQUIRE(actual.size() == expected.size());
+  REQUIRE(std::is_sorted(actual.begin(), actual.end(), by_key));
+
+  auto by_order = [] (const Record& lhs, const Record& rhs) { return lhs.order < rhs.order; };
+  std::sort(actual.begin(), actual.end(), by_order);
+  std::sort(expected.begin(), expected.end(), by_order);
+  REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin(), [] (const Record& lhs, const Record& rhs) {
+    return lhs.key == rhs.key && lhs.order == rhs.order;
+  }));
+}
+
+} // namespace
+
+
+TEST_CASE("external sort in memory and with a single merge", "[external_sort]") {
+  auto input = entries<Entry>(100000, 1000);
+  auto in = file_of(input);
+  auto out = File::tmpfile("/tmp/st-test-external-sort", O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  auto stats = ST::FileSystem::external_sort<Entry>(in, out, by_key, { .memory = 4 << 20 });
+  REQUIRE(stats.records == input.size());
+  REQUIRE(stats.runs == 1);
+  REQUIRE(stats.merge_passes == 0);
+  require_sorted_permutation(records_of<Entry>(out), input);
+
+  // 16个run，一轮归并
+  stats = ST::FileSystem::external_sort<Entry>(in, out, by_key, { .memory = 100000, .read_buffer = 2048, .write_buffer = 8192 });
+  REQUIRE(stats.runs == 16);
+  REQUIRE(stats.merge_passes == 1);
+  require_sorted_permutation(records_of<Entry>(out), input);
+
+  in.close();
+  out.close();
+}
+
+TEST_CASE("external sort merges in several passes with a thread pool", "[external_sort]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  auto input = entries<Entry>(200000, 50000);
+  auto in = file_of(input);
+  auto out = File::tmpfile("/tmp/st-test-external-sort", O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  // 有pool时每个run占三分之一的内存: 3125条，64个run，每轮最多归并3个: 64 -> 22 -> 8 -> 3 -> 1
+  auto stats = ST::FileSystem::external_sort<Entry>(in, out, by_key, {
+    .memory = 150000, .read_buffer = 1000, .write_buffer = 3000, .fan_in = 3, .pool = &pool
+  });
+  REQUIRE(stats.runs == 64);
+  REQUIRE(stats.merge_passes == 4);
+  require_sorted_permutation(records_of<Entry>(out), input);
+
+  in.close();
+  out.close();
+}
+
+TEST_CASE("external sort reads runs through mmap", "[external_sort]") {
+  ST::ThreadPool pool{ 2, ST::Affinity::None };
+
+  auto input = entries<Packed>(300007, 1 << 20);
+  auto in = file_of(input);
+  auto out = File::tmpfile("/tmp/st-test-external-sort", O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  for (auto worker: { static_cast<ST::ThreadPool*>(nullptr), &pool }) {
+    auto stats = ST::FileSystem::external_sort<Packed>(in, out, by_key, {
+      .memory = 1 << 19, .read_buffer = 10000, .fan_in = 4, .pool = worker, .mmap = true
+    });
+    REQUIRE(stats.merge_passes >= 2);
+
+    auto output = records_of<Packed>(out);
+    REQUIRE(std::all_of(output.begin(), output.end(), [] (const Packed& record) {
+      return record.check == (record.key ^ record.order);
+    }));
+    require_sorted_permutation(output, input);
+  }
+
+  in.close();
+  out.close();
+}
+
+TEST_CASE("external sort rejects truncated records and accepts empty input", "[external_sort]") {
+  std::vector<char> bytes(sizeof(Entry) * 3 + 1);
+  auto in = file_of(bytes);
+  auto out = File::tmpfile("/tmp/st-test-external-sort", O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  REQUIRE_THROWS_AS(ST::FileSystem::external_sort<Entry>(in, out, by_key), ST::TruncatedRecordException);
+
+  in.resize(0);
+  auto stats = ST::FileSystem::external_sort<Entry>(in, out, by_key);
+  REQUIRE(stats.records == 0);
+  REQUIRE(stats.runs == 0);
+  REQUIRE(ST::FileSystem::detail::file_size(out) == 0);
+
+  in.close();
+  out.close();
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "st/Hash.h"
+#include "st/HashMap.h"
+
+
+namespace {
+
+// xxHash官方sanity test使用的输入
+std::vector<std::byte> sanity_buffer(std::size_t size)
+{
+  std::vector<std::byte> buffer(size);
+  std::uint64_t generator = 2654435761U;
+  for (auto& byte: buffer) {
+    byte = static_cast<std::byte>(generator >> 56);
+    generator *= 11400714785074694797ULL;
+  }
+
+  return buffer;
+}
+
+std::vector<std::byte> random_buffer(std::size_t size)
+{
+  std::mt19937_64 engine{ 42 };
+  std::vector<std::byte> buffer(size);
+  for (auto& byte: buffer)
+    byte = static_cast<std::byte>(engine());
+
+  return buffer;
+}
+
+} // namespace
+
+
+TEST_CASE("crc32c matches the check value and can be chained", "[hash]") {
+  REQUIRE(st::hash::crc32c("") == 0);
+  REQUIRE(st::hash::crc32c("123456789") == 0xE3069283);
+  // RFC 3720 B.4: 32个0x00和32个0xFF
+  REQUIRE(st::hash::crc32c(std::string(32, '\0')) == 0x8A9136AA);
+  REQUIRE(st::hash::crc32c(std::string(32, '\xFF')) == 0x62A8AB43);
+
+  auto buffer = random_buffer(100000);
+  auto whole = st::hash::crc32c(buffer);
+  std::span<const std::byte> data{ buffer };
+  REQUIRE(st::hash::crc32c(data.subspan(777), st::hash::crc32c(data.first(777))) == whole);
+}
+
+TEST_CASE("crc32c kernels agree at every length and alignment", "[hash]") {
+  using st::hash::detail::CrcLevel;
+  auto buffer = random_buffer(3 * 8192 * 3 + 100);
+
+  std::vector<CrcLevel> levels{ CrcLevel::Software };
+  if (st::hash::detail::crc_level() >= CrcLevel::SSE42)
+    levels.push_back(CrcLevel::SSE42);
+  if (st::hash::detail::crc_level() >= CrcLevel::PCLMUL)
+    levels.push_back(CrcLevel::PCLMUL);
+
+  for (std::size_t offset = 0; offset < 8; ++offset) {
+    for (std::size_t size = 0; size + offset <= buffer.size(); size += 1 + size / 5) {
+      auto expected = st::hash::detail::crc32c(~0U, buffer.data() + offset, size, CrcLevel::Software);
+      for (auto level: levels)
+        REQUIRE(st::hash::detail::crc32c(~0U, buffer.data() + offset, size, level) == expected);
+    }
+  }
+}
+
+TEST_CASE("xxh64 matches the reference implementation", "[hash]") {
+  auto buffer = sanity_buffer(222);
+  std::span<const std::byte> data{ buffer };
+
+  REQUIRE(st::hash::xxh64(data.first(0)) == 0xEF46DB3751D8E999ULL);
+  REQUIRE(st::hash::xxh64(data.first(0), 2654435761U) == 0xAC75FDA2929B17EFULL);
+  REQUIRE(st::hash::xxh64(data.first(1)) == 0xE934A84ADB052768ULL);
+  REQUIRE(st::hash::xxh64(data.first(1), 2654435761U) == 0x5014607643A9B4C3ULL);
+  REQUIRE(st::hash::xxh64(data.first(14)) == 0x8282DCC4994E35C8ULL);
+  REQUIRE(st::hash::xxh64(data.first(222)) == 0xB641AE8CB691C174ULL);
+}
+
+TEST_CASE("xxh3 matches the reference implementation on every kernel", "[hash]") {
+  using st::hash::detail::XxhLevel;
+  struct Vector {
+    std::size_t size;
+    std::uint64_t seed;
+    std::uint64_t hash;
+  };
+
+  constexpr std::uint64_t SEED = 11400714785074694797ULL;
+  // 覆盖0-16、17-128、129-240和长输入的各个分支
+  std::vector<Vector> vectors{
+    { 0, 0, 0x2D06800538D394C2ULL },
+    { 1, 0, 0xC44BDFF4074EECDBULL },
+    { 6, 0, 0x27B56A84CD2D7325ULL },
+    { 12, 0, 0xA713DAF0DFBB77E7ULL },
+    { 24, 0, 0xA3FE70BF9D3510EBULL },
+    { 48, 0, 0x397DA259ECBA1F11ULL },
+    { 80, 0, 0xBCDEFBBB2C47C90AULL },
+    { 195, 0, 0xCD94217EE362EC3AULL },
+    { 403, 0, 0xCDEB804D65C6DEA4ULL },
+    { 512, 0, 0x617E49599013CB6BULL },
+    { 2048, 0, 0xDD59E2C3A5F038E0ULL },
+    { 2240, 0, 0x6E73A90539CF2948ULL },
+    { 2367, 0, 0xCB37AEB9E5D361EDULL },
+    { 0, SEED, 0xA8A6B918B2F0364AULL },
+    { 1, SEED, 0x032BE332DD766EF8ULL },
+    { 6, SEED, 0x84589C116AB59AB9ULL },
+    { 12, SEED, 0xE7303E1B2336DE0EULL },
+    { 24, SEED, 0x850E80FC35BDD690ULL },
+    { 403, SEED, 0x6259F6ECFD6443FDULL },
+  };
+
+  std::vector<XxhLevel> levels{ XxhLevel::Scalar };
+  if (st::hash::detail::xxh3_level() >= XxhLevel::SSE2)
+    levels.push_back(XxhLevel::SSE2);
+  if (st::hash::detail::xxh3_level() >= XxhLevel::AVX2)
+    levels.push_back(XxhLevel::AVX2);
+
+  auto buffer = sanity_buffer(2367);
+  for (auto [size, seed, hash]: vectors) {
+    for (auto level: levels)
+      REQUIRE(st::hash::detail::xxh3(buffer.data(), size, seed, level) == hash);
+  }
+
+  REQUIRE(st::hash::xxh3(std::span<const std::byte>{ buffer }) == 0xCB37AEB9E5D361EDULL);
+}
+
+TEST_CASE("string keys hash with xxh3 and look up heterogeneously", "[hash]") {
+  std::string key = "a string key longer than sixteen bytes";
+  REQUIRE(st::Hash<std::string>{}(key) == st::hash::xxh3(key));
+  REQUIRE(st::Hash<std::string_view>{}(key) == st::Hash<std::string>{}(key));
+
+  st::FlatHashMap<std::string, int> map{};
+  map.emplace(key, 1);
+  map.emplace("short", 2);
+  REQUIRE(map.find(std::string_view{ "short" }) != map.end());
+  REQUIRE(map.find("a string key longer than sixteen bytes")->second == 1);
+}
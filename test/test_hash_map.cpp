@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "st/HashMap.h"
+
+
+namespace {
+
+// 所有key哈希到同一个位置，每次查找都要走完整个簇
+struct CollidingHash {
+  std::size_t operator()(int) const noexcept { return 42; }
+};
+
+} // namespace
+
+
+TEST_CASE("flat hash map matches std::unordered_map under random operations", "[hash_map]") {
+  st::FlatHashMap<std::uint64_t, std::uint64_t> map{};
+  std::unordered_map<std::uint64_t, std::uint64_t> expected{};
+
+  std::mt19937_64 engine{ 2022 };
+  for (int i = 0; i < 200000; ++i) {
+    auto key = engine() % 5000;
+    switch (engine() % 4) {
+    case 0:
+    case 1:
+      REQUIRE(map.insert_or_assign(key, i).second == expected.insert_or_assign(key, i).second);
+      break;
+    case 2:
+      REQUIRE(map.erase(key) == expected.erase(key));
+      break;
+    default:
+      REQUIRE(map.contains(key) == expected.contains(key));
+      break;
+    }
+  }
+
+  REQUIRE(map.size() == expected.size());
+  REQUIRE(map.load_factor() <= map.max_load_factor());
+  for (auto& [key, value]: expected)
+    REQUIRE(map.at(key) == value);
+
+  std::size_t visited = 0;
+  for (auto& [key, value]: map) {
+    REQUIRE(expected.at(key) == value);
+    ++visited;
+  }
+  REQUIRE(visited == expected.size());
+  REQUIRE_THROWS_AS(map.at(5000), std::out_of_range);
+}
+
+TEST_CASE("backward shift deletion keeps colliding keys reachable", "[hash_map]") {
+  st::FlatHashSet<int, CollidingHash> set{};
+  for (int i = 0; i < 100; ++i)
+    REQUIRE(set.insert(i).second);
+  REQUIRE_FALSE(set.insert(7).second);
+
+  // 从簇的中间删除，后面的元素前移
+  for (int i = 0; i < 100; i += 3)
+    REQUIRE(set.erase(i) == 1);
+
+  for (int i = 0; i < 100; ++i)
+    REQUIRE(set.contains(i) == (i % 3 != 0));
+
+  // erase_if每个元素只访问一次
+  std::size_t calls = 0;
+  auto erased = erase_if(set, [&calls] (int value) { ++calls; return value % 2 == 0; });
+  REQUIRE(calls == 66);
+  REQUIRE(erased == 33);
+  REQUIRE(set.size() == 33);
+  for (auto value: set)
+    REQUIRE(value % 2 == 1);
+
+  auto capacity = set.capacity();
+  set.clear();
+  REQUIRE(set.empty());
+  REQUIRE(set.capacity() == capacity);
+  REQUIRE(set.begin() == set.end());
+}
+
+TEST_CASE("flat hash map supports heterogeneous lookup and move-only values", "[hash_map]") {
+  st::FlatHashMap<std::string, std::unique_ptr<int>> map{};
+  for (int i = 0; i < 1000; ++i)
+    map.try_emplace("key-" + std::to_string(i), std::make_unique<int>(i));
+
+  std::string_view view{ "key-500" };
+  REQUIRE(map.contains(view));
+  REQUIRE(*map.find(view)->second == 500);
+  REQUIRE(*map.at("key-999") == 999);
+  REQUIRE_FALSE(map.contains("key-1000"));
+  REQUIRE(map.erase(std::string_view{ "key-0" }) == 1);
+
+  // try_emplace在key已存在时不移动参数
+  auto value = std::make_unique<int>(-1);
+  REQUIRE_FALSE(map.try_emplace("key-1", std::move(value)).second);
+  REQUIRE(value != nullptr);
+
+  map["key-new"] = std::make_unique<int>(7);
+  REQUIRE(map.size() == 1000);
+
+  auto moved = std::move(map);
+  REQUIRE(map.empty());
+  REQUIRE(*moved.at("key-new") == 7);
+
+  auto it = moved.find("key-2");
+  moved.erase(it);
+  REQUIRE_FALSE(moved.contains("key-2"));
+}
+
+TEST_CASE("flat hash map copies and allocates from a memory resource", "[hash_map]") {
+  std::pmr::monotonic_buffer_resource resource{};
+  st::pmr::FlatHashMap<int, std::pmr::string> map{ &resource };
+  for (int i = 0; i < 100; ++i)
+    map.emplace(i, std::string(40, static_cast<char>('a' + i % 26)));
+
+  REQUIRE(map.get_allocator().resource() == &resource);
+
+  st::pmr::FlatHashMap<int, std::pmr::string> copy{ map };
+  REQUIRE(copy == map);
+  copy[0] = "changed";
+  REQUIRE_FALSE(copy == map);
+
+  st::FlatHashMap<int, int> small{ { 1, 2 }, { 3, 4 } };
+  small.reserve(1000);
+  REQUIRE(small.capacity() >= 1024);
+  small.rehash(0);
+  REQUIRE(small.capacity() == 16);
+  REQUIRE(small.at(3) == 4);
+}
+
+TEST_CASE("concurrent flat hash map counts from several threads", "[hash_map]") {
+  st::ConcurrentFlatHashMap<std::string, int> map{ 8 };
+  REQUIRE(map.shards() == 8);
+
+  constexpr int THREADS = 4;
+  constexpr int KEYS = 1000;
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&map] {
+      for (int i = 0; i < KEYS; ++i)
+        map.try_emplace_or_visit(std::to_string(i), [] (auto& value) { ++value.second; }, 1);
+    });
+  }
+  for (auto& thread: threads)
+    thread.join();
+
+  REQUIRE(map.size() == KEYS);
+  map.cfor_each([&] (const auto& value) { REQUIRE(value.second == THREADS); });
+  REQUIRE(map.get("10") == THREADS);
+  REQUIRE(map.get(std::string_view{ "1000" }) == std::nullopt);
+
+  REQUIRE(map.visit("10", [] (auto& value) { value.second = 0; }));
+  REQUIRE(map.get("10") == 0);
+  REQUIRE(map.erase("10") == 1);
+  REQUIRE_FALSE(map.contains("10"));
+
+  REQUIRE(erase_if(map, [] (const auto& value) { return value.first.size() == 1; }) == 10);
+  REQUIRE(map.size() == KEYS - 11);
+}
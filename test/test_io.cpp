@@ -0,0 +1,148 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "ST/IO.h"
+#include "ST/FileSystem/File.h"
+#include "ST/Net/Socket.h"
+
+
+using namespace std::chrono_literals;
+
+namespace {
+
+void ignore_signal(int) {}
+
+} // namespace
+
+TEST_CASE("write_all and read_exact move large buffers through a non-blocking socket", "[io]") {
+  auto [writer, reader] = ST::Net::Socket::pair();
+  writer.set_nonblocking();
+  reader.set_nonblocking();
+
+  // 远大于socket缓冲区，写端必然遇到EAGAIN和部分写
+  std::vector<std::uint32_t> sent(1 << 20);
+  std::iota(sent.begin(), sent.end(), 0);
+
+  std::thread producer{ [&writer, &sent] {
+    REQUIRE(ST::write_all(writer, std::span{ sent }) == sent.size() * sizeof(std::uint32_t));
+  } };
+
+  std::vector<std::uint32_t> received(sent.size());
+  REQUIRE(ST::read_exact(reader, std::span{ received }) == received.size() * sizeof(std::uint32_t));
+  producer.join();
+
+  REQUIRE(received == sent);
+}
+
+TEST_CASE("read_exact stops at EOF", "[io]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  ST::FileSystem::File reader{ "pipe", fds[0] };
+
+  std::string message{ "short" };
+  REQUIRE(ST::write_all(fds[1], std::span{ message }) == message.size());
+  ::close(fds[1]);
+
+  std::string buffer(64, '\0');
+  REQUIRE(ST::read_exact(reader, std::span{ buffer }) == message.size());
+  REQUIRE(buffer.substr(0, message.size()) == message);
+  reader.close();
+}
+
+TEST_CASE("vectored write_all advances iovecs in place", "[io]") {
+  auto [writer, reader] = ST::Net::Socket::pair();
+  writer.set_nonblocking();
+
+  std::string first(300000, 'a');
+  std::string second{ "" };
+  std::string third(200000, 'c');
+  std::vector<iovec> buffers{
+    { first.data(), first.size() },
+    { second.data(), second.size() },
+    { third.data(), third.size() }
+  };
+
+  std::string received(first.size() + third.size(), '\0');
+  std::thread consumer{ [&reader, &received] {
+    REQUIRE(ST::read_exact(reader, std::span{ received }) == received.size());
+  } };
+
+  REQUIRE(ST::write_all(writer, std::span{ buffers }) == first.size() + third.size());
+  consumer.join();
+
+  for (auto& buffer: buffers)
+    REQUIRE(buffer.iov_len == 0);
+  REQUIRE(received == first + third);
+}
+
+TEST_CASE("write_all reports a closed peer instead of raising SIGPIPE", "[io]") {
+  auto [writer, reader] = ST::Net::Socket::pair();
+  reader = ST::Net::Socket{ ST::Net::Family::Unix };
+
+  // 没有忽略SIGPIPE，如果用write进程会直接被杀死
+  std::string message{ "nobody listens" };
+  REQUIRE_THROWS_AS(ST::write_all(writer, std::span{ message }), std::system_error);
+
+  std::vector<iovec> buffers{ { message.data(), message.size() } };
+  REQUIRE_THROWS_AS(ST::write_all(writer, std::span{ buffers }), std::system_error);
+}
+
+TEST_CASE("vectored read_exact fills every buffer", "[io]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+
+  std::string message{ "headerpayload" };
+  REQUIRE(ST::write_all(fds[1], std::span{ message }) == message.size());
+
+  char header[6];
+  char payload[7];
+  std::vector<iovec> buffers{ { header, sizeof(header) }, { payload, sizeof(payload) } };
+  REQUIRE(ST::read_exact(fds[0], std::span{ buffers }) == message.size());
+  REQUIRE(std::string(header, sizeof(header)) == "header");
+  REQUIRE(std::string(payload, sizeof(payload)) == "payload");
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_CASE("read_exact retries after EINTR", "[io]") {
+  // 不设置SA_RESTART，阻塞的read会被打断返回EINTR
+  struct sigaction action{};
+  struct sigaction previous{};
+  action.sa_handler = ignore_signal;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(SIGUSR1, &action, &previous);
+
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+
+  auto reader_thread = ::pthread_self();
+  std::thread interrupter{ [reader_thread, fd = fds[1]] {
+    std::this_thread::sleep_for(50ms);
+    ::pthread_kill(reader_thread, SIGUSR1);
+    std::this_thread::sleep_for(50ms);
+    ::write(fd, "done", 4);
+  } };
+
+  char buffer[4];
+  REQUIRE(ST::read_exact(fds[0], std::span{ buffer }) == sizeof(buffer));
+  REQUIRE(std::string(buffer, sizeof(buffer)) == "done");
+
+  interrupter.join();
+  ::sigaction(SIGUSR1, &previous, nullptr);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "ST/Logger.h"
+
+
+namespace {
+
+std::string read_all(ST::FileSystem::File& file)
+{
+  std::string content(1 << 20, '\0');
+  auto n = file.pread(content.data(), content.size(), 0);
+  content.resize(n > 0 ? static_cast<std::size_t>(n) : 0);
+  return content;
+}
+
+std::size_t count_lines(const std::string& content, const std::string& pattern)
+{
+  std::size_t count = 0;
+  for (auto pos = content.find(pattern); pos != std::string::npos; pos = content.find(pattern, pos + 1))
+    ++count;
+  return count;
+}
+
+struct Point {
+  int x;
+  int y;
+};
+
+// 按引用语义格式化，后台线程格式化时指向的值可能已经变了
+struct Counter {
+  const int* value;
+};
+
+} // namespace
+
+template<>
+struct fmt::formatter<Point>: fmt::formatter<std::string_view> {
+  template<typename FormatContext>
+  auto format(const Point& point, FormatContext& ctx) const
+  {
+    return fmt::format_to(ctx.out(), "({}, {})", point.x, point.y);
+  }
+};
+
+template<>
+struct fmt::formatter<Counter>: fmt::formatter<std::string_view> {
+  template<typename FormatContext>
+  auto format(const Counter& counter, FormatContext& ctx) const
+  {
+    return fmt::format_to(ctx.out(), "counter {}", *counter.value);
+  }
+};
+
+TEST_CASE("logger formats arguments on the backend thread", "[logger]") {
+  auto file = ST::FileSystem::File::tmpfile("/tmp/st-test-logger", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  {
+    ST::Logger logger{ ST::FileSystem::File{ "log", file.fd() } };
+
+    std::string owned{ "owned" };
+    const char* null = nullptr;
+    logger.info("int {} double {:.2f} string {} {} {}", 42, 3.14159, owned, "literal", null);
+    logger.warn("point {} vector size {}", Point{ 1, 2 }, std::vector<int>{ 1, 2, 3 }.size());
+    logger.debug("filtered out");
+    int value = 1;
+    logger.info("{}", Counter{ &value });
+    value = 2;
+    logger.flush();
+
+    auto content = read_all(file);
+    REQUIRE(content.find("[info]") != std::string::npos);
+    REQUIRE(content.find("int 42 double 3.14 string owned literal (null)\n") != std::string::npos);
+    REQUIRE(content.find("[warn]") != std::string::npos);
+    REQUIRE(content.find("point (1, 2) vector size 3\n") != std::string::npos);
+    REQUIRE(content.find("filtered out") == std::string::npos);
+    // 非算术类型在调用线程格式化
+    REQUIRE(content.find("counter 1\n") != std::string::npos);
+
+    logger.level(ST::LogLevel::Debug);
+    logger.debug("now visible");
+  }
+
+  // 析构时写完剩余的日志
+  REQUIRE(read_all(file).find("now visible") != std::string::npos);
+  file.close();
+}
+
+TEST_CASE("logger collects messages from many threads", "[logger]") {
+  auto file = ST::FileSystem::File::tmpfile("/tmp/st-test-logger", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  constexpr int threads = 4;
+  constexpr int messages = 2000;
+  {
+    ST::Logger logger{ ST::FileSystem::File{ "log", file.fd() } };
+
+    std::vector<std::jthread> writers{};
+    for (int t = 0; t < threads; ++t) {
+      writers.emplace_back([&logger, t] {
+        for (int i = 0; i < messages; ++i)
+          logger.info("thread {} message {}", t, i);
+      });
+    }
+    writers.clear();
+
+    logger.flush();
+    REQUIRE(logger.dropped() == 0);
+  }
+
+  auto content = read_all(file);
+  REQUIRE(count_lines(content, "] thread ") == threads * messages);
+  REQUIRE(content.find("thread 3 message 1999\n") != std::string::npos);
+  file.close();
+}
+
+TEST_CASE("logger drops messages instead of blocking when the ring is full", "[logger]") {
+  auto file = ST::FileSystem::File::tmpfile("/tmp/st-test-logger", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  {
+    ST::Logger logger{ ST::FileSystem::File{ "log", file.fd() }, 4096 };
+
+    std::string payload(1000, 'x');
+    for (int i = 0; i < 1000; ++i)
+      logger.info("{}", payload);
+
+    logger.flush();
+    REQUIRE(logger.dropped() > 0);
+  }
+
+  REQUIRE(read_all(file).find("log messages, ring buffer is full") != std::string::npos);
+  file.close();
+}
+
+TEST_CASE("spdlog default logger writes through the async logger", "[logger]") {
+  auto file = ST::FileSystem::File::tmpfile("/tmp/st-test-logger", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  auto previous = spdlog::default_logger();
+  {
+    ST::Logger logger{ ST::FileSystem::File{ "log", file.fd() } };
+    logger.install_spdlog();
+
+    SPDLOG_WARN("from spdlog {}", 7);
+    logger.flush();
+
+    REQUIRE(read_all(file).find("[warn]") != std::string::npos);
+    REQUIRE(read_all(file).find("from spdlog 7\n") != std::string::npos);
+  }
+
+  REQUIRE(spdlog::default_logger() == previous);
+  file.close();
+}
@@ -0,0 +1,209 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ST/Memory.h"
+#include "ST/Net/Buffer.h"
+
+
+namespace {
+
+// 记录经过的上游分配次数和当前未释放的字节数
+class CountingResource: public std::pmr::memory_resource {
+public:
+  std::size_t allocations = 0;
+  std::size_t outstanding = 0;
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    ++allocations;
+    outstanding += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+  {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+bool aligned(void* p, std::size_t alignment)
+{
+  return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+} // namespace
+
+
+TEST_CASE("size classes cover every small size", "[memory]") {
+  for (std::size_t bytes = 0; bytes <= ST::MAX_SMALL_SIZE; ++bytes) {
+    auto size_class = ST::detail::size_class(bytes);
+    REQUIRE(size_class < ST::detail::SIZE_CLASSES);
+    REQUIRE(ST::detail::class_size(size_class) >= bytes);
+    if (size_class > 0)
+      REQUIRE(ST::detail::class_size(size_class - 1) < std::max<std::size_t>(bytes, 1));
+  }
+}
+
+TEST_CASE("monotonic arena reuses its largest chunk after reset", "[memory]") {
+  CountingResource upstream{};
+  ST::MonotonicArena arena{ 256, &upstream };
+
+  for (int round = 0; round < 3; ++round) {
+    std::pmr::vector<std::pmr::string> strings{ &arena };
+    for (int i = 0; i < 100; ++i)
+      strings.emplace_back("a string that does not fit into the small string buffer");
+
+    auto p = arena.allocate(8, 64);
+    REQUIRE(aligned(p, 64));
+    REQUIRE(arena.allocated() > 100 * 50);
+
+    strings.clear();
+    strings.shrink_to_fit();
+    arena.reset();
+    REQUIRE(arena.allocated() == 0);
+  }
+
+  // 第一轮之后只剩最大的一块，之后的轮次不再访问上游
+  auto allocations = upstream.allocations;
+  {
+    std::pmr::vector<int> values{ &arena };
+    values.resize(100);
+  }
+  REQUIRE(upstream.allocations == allocations);
+
+  arena.release();
+  REQUIRE(upstream.outstanding == 0);
+
+  // 大块用满之后复用较小的备用块，链表头部就不是最大的块
+  ST::MonotonicArena mixed{ 256, &upstream };
+  REQUIRE(mixed.allocate(100, 8) != nullptr);
+  mixed.reset();
+  REQUIRE(mixed.allocate(10000, 8) != nullptr);
+  REQUIRE(mixed.allocate(100, 8) != nullptr);
+  mixed.reset();
+  allocations = upstream.allocations;
+  REQUIRE(mixed.allocate(10000, 8) != nullptr);
+  REQUIRE(upstream.allocations == allocations);
+  mixed.release();
+  REQUIRE(upstream.outstanding == 0);
+
+  std::byte buffer[128];
+  ST::MonotonicArena stack{ std::span{ buffer }, &upstream };
+  auto first = stack.allocate(64, 16);
+  REQUIRE(static_cast<std::byte*>(first) >= buffer);
+  REQUIRE(static_cast<std::byte*>(first) < buffer + sizeof(buffer));
+  REQUIRE(stack.allocate(128, 16) != nullptr);
+  REQUIRE(upstream.outstanding > 0);
+  stack.reset();
+  REQUIRE(stack.allocate(64, 16) == first);
+}
+
+TEST_CASE("slab pool recycles blocks and forwards large allocations", "[memory]") {
+  CountingResource upstream{};
+
+  {
+    ST::SlabPool pool{ &upstream };
+
+    auto a = pool.allocate(24, 8);
+    auto b = pool.allocate(24, 8);
+    REQUIRE(a != b);
+    REQUIRE(aligned(a, ST::SMALL_ALIGNMENT));
+    REQUIRE(pool.slabs() == 1);
+
+    pool.deallocate(a, 24, 8);
+    REQUIRE(pool.allocate(30, 8) == a);
+
+    // 不同的级使用不同的slab
+    REQUIRE(pool.allocate(1000, 8) != nullptr);
+    REQUIRE(pool.slabs() == 2);
+
+    auto allocations = upstream.allocations;
+    auto large = pool.allocate(ST::MAX_SMALL_SIZE + 1, 8);
+    auto overaligned = pool.allocate(64, 64);
+    REQUIRE(aligned(overaligned, 64));
+    REQUIRE(upstream.allocations == allocations + 2);
+    pool.deallocate(large, ST::MAX_SMALL_SIZE + 1, 8);
+    pool.deallocate(overaligned, 64, 64);
+
+    // 一个slab用完再申请下一个
+    std::vector<void*> blocks{};
+    for (std::size_t i = 0; i < ST::SLAB_SIZE / 4096 + 1; ++i)
+      blocks.push_back(pool.allocate(4096, 16));
+    REQUIRE(pool.slabs() == 4);
+  }
+
+  REQUIRE(upstream.outstanding == 0);
+}
+
+TEST_CASE("thread caching resource can free on another thread", "[memory]") {
+  auto& resource = ST::ThreadCachingResource::global();
+  REQUIRE(&resource == &ST::ThreadCachingResource::global());
+
+  constexpr std::size_t COUNT = 10000;
+  std::vector<void*> blocks(COUNT);
+
+  std::thread producer{ [&] {
+    for (std::size_t i = 0; i < COUNT; ++i) {
+      blocks[i] = resource.allocate(48, 16);
+      *static_cast<std::size_t*>(blocks[i]) = i;
+    }
+  } };
+  producer.join();
+
+  for (std::size_t i = 0; i < COUNT; ++i)
+    REQUIRE(*static_cast<std::size_t*>(blocks[i]) == i);
+
+  std::thread consumer{ [&] {
+    for (auto block: blocks)
+      resource.deallocate(block, 48, 16);
+  } };
+  consumer.join();
+
+  // 消费者线程的缓存只留一批，其余的都还给了中心链表
+  REQUIRE(resource.central_free_bytes() >= (COUNT - 2 * 64) * 48);
+
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&resource, t] {
+      std::pmr::vector<std::pmr::string> strings{ &resource };
+      for (int i = 0; i < 20000; ++i) {
+        strings.emplace_back(static_cast<std::size_t>(16 + (i * 7 + t) % 300), 'x');
+        if (strings.size() > 64)
+          strings.erase(strings.begin(), strings.begin() + 32);
+      }
+    });
+  }
+  for (auto& thread: threads)
+    thread.join();
+}
+
+TEST_CASE("buffer allocates from its memory resource", "[memory]") {
+  CountingResource upstream{};
+
+  {
+    ST::SlabPool pool{ &upstream };
+    ST::Net::Buffer buffer{ 1024, &pool };
+    REQUIRE(buffer.resource() == &pool);
+    REQUIRE(pool.slabs() == 1);
+
+    std::string data(5000, 'a');
+    buffer.append(data.data(), data.size());
+    REQUIRE(buffer.readable_bytes() == data.size());
+
+    auto copy = buffer;
+    REQUIRE(copy.resource() == std::pmr::get_default_resource());
+    REQUIRE(copy.readable_bytes() == data.size());
+  }
+
+  REQUIRE(upstream.outstanding == 0);
+}
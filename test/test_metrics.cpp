@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fcntl.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "ST/Metrics.h"
+#include "ST/Exception.h"
+#include "ST/FileSystem/File.h"
+#include "ST/Net/Socket.h"
+
+
+TEST_CASE("sharded counter sums every thread", "[metrics]") {
+  ST::Counter counter{};
+  {
+    std::vector<std::jthread> threads{};
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back([&counter] {
+        for (int j = 0; j < 10000; ++j)
+          counter.add();
+      });
+    }
+  }
+
+  REQUIRE(counter.value() == 80000);
+  counter.reset();
+  REQUIRE(counter.value() == 0);
+}
+
+TEST_CASE("gauge goes up and down", "[metrics]") {
+  ST::Gauge gauge{};
+  gauge.add(5);
+  gauge.sub(2);
+  REQUIRE(gauge.value() == 3);
+  gauge.set(-1);
+  REQUIRE(gauge.value() == -1);
+}
+
+TEST_CASE("histogram buckets are log-linear", "[metrics]") {
+  using ST::Histogram;
+
+  for (std::uint64_t value = 0; value < 4096; ++value) {
+    auto bucket = Histogram::bucket_of(value);
+    REQUIRE(Histogram::bucket_upper_bound(bucket) >= value);
+    if (bucket > 0)
+      REQUIRE(Histogram::bucket_upper_bound(bucket - 1) < value);
+  }
+
+  REQUIRE(Histogram::bucket_of(UINT64_MAX) == Histogram::BUCKETS - 1);
+  REQUIRE(Histogram::bucket_upper_bound(Histogram::BUCKETS - 1) == UINT64_MAX);
+}
+
+TEST_CASE("histogram percentiles are within bucket precision", "[metrics]") {
+  ST::Histogram histogram{};
+  for (std::uint64_t value = 1; value <= 10000; ++value)
+    histogram.record(value);
+
+  auto snapshot = histogram.snapshot();
+  REQUIRE(snapshot.count == 10000);
+  REQUIRE(snapshot.min == 1);
+  REQUIRE(snapshot.max == 10000);
+  REQUIRE(snapshot.sum == 10000ULL * 10001 / 2);
+
+  auto p50 = snapshot.percentile(0.5);
+  REQUIRE(p50 >= 5000);
+  REQUIRE(p50 <= 5000 + 5000 / 8);
+  REQUIRE(snapshot.percentile(1.0) == 10000);
+
+  histogram.reset();
+  REQUIRE(histogram.snapshot().count == 0);
+}
+
+TEST_CASE("registry exports json and rejects type mismatch", "[metrics]") {
+  ST::MetricRegistry registry{};
+  registry.counter("requests", "handled requests").add(3);
+  registry.gauge("connections").set(2);
+  registry.histogram("latency").record(100);
+
+  REQUIRE(&registry.counter("requests") == &registry.counter("requests"));
+  REQUIRE_THROWS_AS(registry.gauge("requests"), ST::MetricTypeMismatchException);
+
+  auto json = nlohmann::json::parse(registry.to_json());
+  REQUIRE(json["requests"] == 3);
+  REQUIRE(json["connections"] == 2);
+  REQUIRE(json["latency"]["count"] == 1);
+  REQUIRE(json["latency"]["p99"] == 100);
+
+  auto text = registry.to_text();
+  REQUIRE(text.find("# handled requests\nrequests 3\n") != std::string::npos);
+  REQUIRE(text.find("latency.max 100\n") != std::string::npos);
+}
+
+TEST_CASE("socket and file I/O are instrumented", "[metrics]") {
+  auto& socket_metrics = ST::SocketMetrics::instance();
+  auto calls = socket_metrics.write.calls.value();
+  auto bytes = socket_metrics.write.bytes.value();
+  auto read_bytes = socket_metrics.read.bytes.value();
+
+  auto [left, right] = ST::Net::Socket::pair();
+  REQUIRE(left.write("hello", 5) == 5);
+  char buffer[5];
+  REQUIRE(right.read(buffer, sizeof(buffer)) == 5);
+
+  REQUIRE(socket_metrics.write.calls.value() == calls + 1);
+  REQUIRE(socket_metrics.write.bytes.value() == bytes + 5);
+  REQUIRE(socket_metrics.read.bytes.value() == read_bytes + 5);
+  REQUIRE(socket_metrics.write.latency.snapshot().count >= 1);
+
+  right.set_nonblocking();
+  auto errors = socket_metrics.read.errors.value();
+  REQUIRE(right.read(buffer, sizeof(buffer)) == -1);
+  REQUIRE(socket_metrics.read.errors.value() == errors);
+
+  auto& file_metrics = ST::FileMetrics::instance();
+  auto file_bytes = file_metrics.write.bytes.value();
+  auto file = ST::FileSystem::File::tmpfile("/tmp/st-test-metrics", O_RDWR | O_CREAT | O_TRUNC, 0600);
+  file.write("abc", 3);
+  file.close();
+  REQUIRE(file_metrics.write.bytes.value() == file_bytes + 3);
+
+  auto json = nlohmann::json::parse(ST::MetricRegistry::global().to_json());
+  REQUIRE(json.contains("socket.write.bytes"));
+  REQUIRE(json.contains("file.read.latency_ns"));
+}
@@ -0,0 +1,338 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <stdlib.h>
+#include <fcntl.h>
+
+#include <chrono>
+#include <fstream>
+#include <span>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ST/Process.h"
+#include "ST/Daemon.h"
+#include "ST/PidFd.h"
+#include "ST/ProcessPool.h"
+#include "ST/SignalSet.h"
+#include "ST/Spawn.h"
+#include "ST/Net/Socket.h"
+
+
+using namespace std::chrono_literals;
+
+void wait_for_signal(std::size_t)
+{
+  ::pause();
+}
+
+// 测试框架在每个测试中安装了SIGTERM处理函数，fork出的子进程会继承，恢复默认行为
+void use_default_sigterm()
+{
+  ::signal(SIGTERM, SIG_DFL);
+}
+
+TEST_CASE("process can be polled and killed", "[process]") {
+  ST::Process process{ wait_for_signal, 0 };
+
+  REQUIRE_FALSE(process.try_wait());
+
+  process.kill(SIGKILL);
+  auto result = process.wait();
+  REQUIRE(result.terminated());
+  REQUIRE(result.terminated_by() == SIGKILL);
+  REQUIRE_THROWS_AS(process.wait(), ST::InvalidProcessWaitException);
+  REQUIRE_THROWS_AS(process.kill(SIGKILL), ST::InvalidProcessKillException);
+}
+
+TEST_CASE("moved-from process can't be killed", "[process]") {
+  ST::Process process{ wait_for_signal, 0 };
+  auto moved = std::move(process);
+
+  REQUIRE_THROWS_AS(process.kill(SIGKILL), ST::InvalidProcessKillException);
+
+  moved.kill(SIGKILL);
+  REQUIRE(moved.wait().terminated_by() == SIGKILL);
+}
+
+TEST_CASE("process exits with failure on uncaught exception", "[process]") {
+  ST::Process process{ [] { throw std::runtime_error{ "boom" }; } };
+
+  auto result = process.wait();
+  REQUIRE(result.normal_exited());
+  REQUIRE(result.exit_status() == EXIT_FAILURE);
+}
+
+TEST_CASE("process pool restarts crashed workers", "[process][pool]") {
+  use_default_sigterm();
+  ST::ProcessPool pool{ 2, wait_for_signal };
+  pool.start();
+  REQUIRE(pool.running() == 2);
+
+  auto crashed = pool.pids().front();
+  ::kill(crashed, SIGKILL);
+
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (pool.restarts() == 0 && std::chrono::steady_clock::now() < deadline)
+    pool.supervise(50ms);
+
+  REQUIRE(pool.restarts() == 1);
+  REQUIRE(pool.running() == 2);
+  REQUIRE(pool.pids().front() != crashed);
+
+  pool.terminate(1s);
+  REQUIRE(pool.running() == 0);
+}
+
+TEST_CASE("process pool doesn't restart cleanly exited workers", "[process][pool]") {
+  ST::ProcessPool pool{ 1, [] (std::size_t) {} };
+  pool.start();
+
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (pool.running() > 0 && std::chrono::steady_clock::now() < deadline)
+    pool.supervise(50ms);
+
+  REQUIRE(pool.running() == 0);
+  REQUIRE(pool.restarts() == 0);
+}
+
+TEST_CASE("process pool reload replaces every worker", "[process][pool]") {
+  use_default_sigterm();
+  ST::ProcessPool pool{ 2, wait_for_signal };
+  pool.start();
+
+  auto before = pool.pids();
+  pool.reload(1s);
+  auto after = pool.pids();
+
+  REQUIRE(after.size() == 2);
+  REQUIRE(after[0] != before[0]);
+  REQUIRE(after[1] != before[1]);
+  REQUIRE(pool.restarts() == 0);
+
+  pool.terminate(1s);
+}
+
+TEST_CASE("inherited fds are parsed from environment", "[process][pool]") {
+  ::setenv(ST::INHERITED_FDS_ENV, "3,7,12", 1);
+  auto fds = ST::ProcessPool::inherited_fds();
+  REQUIRE(fds == std::vector<int>{ 3, 7, 12 });
+  REQUIRE(::getenv(ST::INHERITED_FDS_ENV) == nullptr);
+
+  REQUIRE(ST::ProcessPool::inherited_fds().empty());
+}
+
+TEST_CASE("upgrade execs the new master with inherited fds", "[process][pool]") {
+  int pipe_fds[2];
+  REQUIRE(::pipe2(pipe_fds, O_CLOEXEC) == 0);
+
+  // 上一次升级留下的值要被替换
+  ::setenv(ST::INHERITED_FDS_ENV, "99", 1);
+  auto fd = std::to_string(pipe_fds[1]);
+  auto master = ST::ProcessPool::upgrade("/bin/sh", {
+    "sh", "-c", "test \"$ST_INHERITED_FDS\" = " + fd + " && echo ok >&" + fd
+  }, std::span{ &pipe_fds[1], 1 });
+  ::unsetenv(ST::INHERITED_FDS_ENV);
+  ::close(pipe_fds[1]);
+
+  REQUIRE(master.wait().exit_status() == 0);
+  char buffer[3]{};
+  REQUIRE(::read(pipe_fds[0], buffer, sizeof(buffer)) == 3);
+  REQUIRE(std::string{ buffer, 2 } == "ok");
+  ::close(pipe_fds[0]);
+
+  auto missing = ST::ProcessPool::upgrade("/nonexistent/master", { "master" }, {});
+  REQUIRE(missing.wait().exit_status() == 127);
+}
+
+TEST_CASE("spawned command output is collected", "[process][spawn]") {
+  auto output = ST::Command{ "sh" }
+                  .arguments({ "-c", "echo \"$GREETING\"; pwd; echo oops >&2; exit 3" })
+                  .environment("GREETING", "hello")
+                  .directory("/")
+                  .output();
+
+  REQUIRE(output.status.normal_exited());
+  REQUIRE(output.status.exit_status() == 3);
+  REQUIRE(output.output == "hello\n/\n");
+  REQUIRE(output.error == "oops\n");
+}
+
+TEST_CASE("spawned command reads from stdin pipe", "[process][spawn]") {
+  auto child = ST::Command{ "cat" }
+                 .standard_input(ST::Stdio::Pipe)
+                 .standard_output(ST::Stdio::Pipe)
+                 .spawn();
+
+  std::string message{ "through the pipe" };
+  child.standard_input().write(message.data(), message.size());
+  child.close_input();
+
+  std::string received(message.size(), '\0');
+  REQUIRE(child.standard_output().read(received.data(), received.size()) == static_cast<ssize_t>(message.size()));
+  REQUIRE(received == message);
+
+  auto result = child.wait();
+  REQUIRE(result.normal_exited());
+  REQUIRE(result.exit_status() == 0);
+}
+
+TEST_CASE("spawned child notifies exit through pidfd", "[process][spawn]") {
+  auto child = ST::Command{ "sleep" }.argument("10").spawn();
+  REQUIRE(child.pidfd() != -1);
+
+  ST::Net::Poller poller{};
+  auto exited = false;
+  poller.add(child.pidfd(), EPOLLIN, [&] (std::uint32_t) { exited = true; });
+
+  REQUIRE(poller.poll(0) == 0);
+  child.kill(SIGKILL);
+  REQUIRE(poller.poll(1000) == 1);
+  REQUIRE(exited);
+
+  poller.remove(child.pidfd());
+  REQUIRE(child.wait().terminated_by() == SIGKILL);
+  // 回收之后pidfd不再指向任何进程，pid即使被复用也不会收到信号
+  REQUIRE_THROWS_AS(child.kill(SIGKILL), std::system_error);
+}
+
+TEST_CASE("spawning a missing program throws", "[process][spawn]") {
+  REQUIRE_THROWS_AS(ST::Command{ "/nonexistent/program" }.spawn(), std::system_error);
+}
+
+TEST_CASE("pidfd signals and reaps a child", "[process][pidfd]") {
+  ST::Process process{ wait_for_signal, 0 };
+  ST::PidFd pidfd{ process.get_pid() };
+  REQUIRE(pidfd.pid() == process.get_pid());
+  REQUIRE_FALSE(pidfd.try_wait());
+
+  pidfd.send_signal(SIGKILL);
+  auto result = pidfd.wait();
+  REQUIRE(result.terminated());
+  REQUIRE(result.terminated_by() == SIGKILL);
+}
+
+TEST_CASE("pidfd reports exit status", "[process][pidfd]") {
+  ST::Process process{ [] { exit(7); } };
+  ST::PidFd pidfd{ process.get_pid() };
+
+  auto result = pidfd.wait();
+  REQUIRE(result.normal_exited());
+  REQUIRE(result.exit_status() == 7);
+}
+
+TEST_CASE("signal set delivers signals through poller", "[process][signal]") {
+  ST::Net::Poller poller{};
+  std::vector<int> received{};
+  {
+    ST::SignalSet signals{ SIGUSR1 };
+    signals.add(SIGUSR2);
+    REQUIRE(signals.contains(SIGUSR1));
+    REQUIRE(signals.contains(SIGUSR2));
+
+    signals.watch(poller, [&] (const signalfd_siginfo& info) { received.push_back(static_cast<int>(info.ssi_signo)); });
+
+    ::raise(SIGUSR1);
+    ::raise(SIGUSR2);
+    REQUIRE(poller.poll(1000) == 1);
+  }
+
+  REQUIRE(received == std::vector<int>{ SIGUSR1, SIGUSR2 });
+  REQUIRE(poller.size() == 0);
+}
+
+TEST_CASE("process pool stops on SIGTERM through signalfd", "[process][pool][signal]") {
+  use_default_sigterm();
+  ST::ProcessPool pool{ 2, wait_for_signal };
+  pool.handle_signals();
+  pool.start();
+
+  ::kill(::getpid(), SIGTERM);
+  pool.run(1s);
+
+  REQUIRE(pool.running() == 0);
+  REQUIRE(pool.restarts() == 0);
+}
+
+TEST_CASE("daemon closes all fds except kept ones", "[process][daemon]") {
+  // 在子进程中关闭，不影响测试进程自己的fd
+  ST::Process process{ [] {
+    int kept[2];
+    int closed[2];
+    if (::pipe(kept) == -1 || ::pipe(closed) == -1)
+      ::_exit(2);
+
+    int keep[] = { kept[1] };
+    ST::Daemon::close_fds(STDERR_FILENO + 1, keep);
+
+    auto is_open = [] (int fd) { return ::fcntl(fd, F_GETFD) != -1; };
+    auto ok = is_open(STDIN_FILENO) && is_open(kept[1]) &&
+              !is_open(kept[0]) && !is_open(closed[0]) && !is_open(closed[1]);
+    ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+  } };
+
+  auto result = process.wait();
+  REQUIRE(result.normal_exited());
+  REQUIRE(result.exit_status() == EXIT_SUCCESS);
+}
+
+TEST_CASE("daemon notifies readiness through NOTIFY_SOCKET", "[process][daemon]") {
+  ::unsetenv("NOTIFY_SOCKET");
+  REQUIRE_FALSE(ST::Daemon::notify("READY=1"));
+
+  auto path = "@st-test-notify-" + std::to_string(::getpid());
+  ST::Net::Socket supervisor{ ST::Net::Family::Unix, ST::Net::Type::UDP };
+  supervisor.bind(path);
+  ::setenv("NOTIFY_SOCKET", path.c_str(), 1);
+
+  ST::Daemon::ready();
+  char buffer[128]{};
+  auto n = supervisor.read(buffer, sizeof(buffer));
+  REQUIRE(std::string(buffer, n) == "READY=1\nMAINPID=" + std::to_string(::getpid()));
+
+  ST::Daemon::status("serving");
+  n = supervisor.read(buffer, sizeof(buffer));
+  REQUIRE(std::string(buffer, n) == "STATUS=serving");
+
+  ::unsetenv("NOTIFY_SOCKET");
+}
+
+TEST_CASE("daemon pid file allows a single instance", "[process][daemon]") {
+  use_default_sigterm();
+  auto pid_file = "/tmp/st-test-daemon-" + std::to_string(::getpid()) + ".pid";
+
+  int ready[2];
+  REQUIRE(::pipe(ready) == 0);
+  ST::Process first{ [&] {
+    ST::Daemon daemon{ "first" };
+    daemon.mode(ST::DaemonMode::Foreground).pid_file(pid_file).keep_fds({ ready[1] });
+    daemon.start();
+    ::write(ready[1], "1", 1);
+    ::pause();
+  } };
+  ::close(ready[1]);
+  char c;
+  REQUIRE(::read(ready[0], &c, 1) == 1);
+  ::close(ready[0]);
+
+  std::ifstream in{ pid_file };
+  pid_t recorded = 0;
+  in >> recorded;
+  REQUIRE(recorded == first.get_pid());
+
+  ST::Process second{ [&] {
+    ST::Daemon daemon{ "second" };
+    daemon.mode(ST::DaemonMode::Foreground).pid_file(pid_file);
+    daemon.start();
+  } };
+  auto result = second.wait();
+  REQUIRE(result.normal_exited());
+  REQUIRE(result.exit_status() == EXIT_FAILURE);
+
+  first.kill(SIGTERM);
+  first.wait();
+  ::unlink(pid_file.c_str());
+}
@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ST/EventFd.h"
+#include "ST/Queue.h"
+#include "ST/WakeupQueue.h"
+#include "ST/Net/Poller.h"
+
+
+using namespace std::chrono_literals;
+
+
+TEST_CASE("mpmc queue delivers every element exactly once", "[queue]") {
+  ST::MPMCQueue<std::uint64_t> queue{ 100 };
+  REQUIRE(queue.capacity() == 128);
+
+  constexpr std::uint64_t PRODUCERS = 4;
+  constexpr std::uint64_t CONSUMERS = 4;
+  constexpr std::uint64_t COUNT = 100000;
+
+  std::vector<std::atomic<int>> seen(PRODUCERS * COUNT);
+  std::atomic<std::uint64_t> consumed{ 0 };
+
+  std::vector<std::thread> threads{};
+  for (std::uint64_t p = 0; p < PRODUCERS; ++p) {
+    threads.emplace_back([&queue, p] {
+      for (std::uint64_t i = 0; i < COUNT; ++i)
+        while (!queue.try_push(p * COUNT + i))
+          std::this_thread::yield();
+    });
+  }
+  for (std::uint64_t c = 0; c < CONSUMERS; ++c) {
+    threads.emplace_back([&] {
+      while (consumed.load() < PRODUCERS * COUNT) {
+        if (auto value = queue.try_pop()) {
+          seen[*value].fetch_add(1);
+          consumed.fetch_add(1);
+        }
+        else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread: threads)
+    thread.join();
+
+  for (auto& count: seen)
+    REQUIRE(count.load() == 1);
+  REQUIRE(queue.empty());
+  REQUIRE_FALSE(queue.try_pop());
+}
+
+TEST_CASE("mpmc queue reports full and destroys what is left", "[queue]") {
+  auto counter = std::make_shared<int>(0);
+  {
+    ST::MPMCQueue<std::shared_ptr<int>> queue{ 4 };
+    for (int i = 0; i < 4; ++i)
+      REQUIRE(queue.try_push(counter));
+    REQUIRE_FALSE(queue.try_push(counter));
+    REQUIRE(queue.size() == 4);
+    REQUIRE(counter.use_count() == 5);
+
+    REQUIRE(queue.try_pop() == counter);
+    REQUIRE(queue.try_emplace(counter));
+  }
+  REQUIRE(counter.use_count() == 1);
+}
+
+TEST_CASE("spsc queue keeps order across threads", "[queue]") {
+  ST::SPSCQueue<std::unique_ptr<std::uint64_t>> queue{ 64 };
+  constexpr std::uint64_t COUNT = 200000;
+
+  std::thread producer{ [&queue] {
+    for (std::uint64_t i = 0; i < COUNT; ++i)
+      while (!queue.try_emplace(std::make_unique<std::uint64_t>(i)))
+        std::this_thread::yield();
+  } };
+
+  for (std::uint64_t expected = 0; expected < COUNT; ) {
+    auto value = queue.front();
+    if (value == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    REQUIRE(**value == expected);
+    queue.pop();
+    ++expected;
+  }
+  producer.join();
+
+  REQUIRE(queue.try_pop() == std::nullopt);
+  for (std::uint64_t i = 0; i < queue.capacity(); ++i)
+    REQUIRE(queue.try_emplace(std::make_unique<std::uint64_t>(i)));
+  REQUIRE_FALSE(queue.try_emplace(nullptr));
+}
+
+TEST_CASE("eventfd counts notifications until consumed", "[queue]") {
+  ST::EventFd event{};
+  REQUIRE(event.consume() == 0);
+  REQUIRE_FALSE(event.wait(1ms));
+
+  event.notify();
+  event.notify(2);
+  REQUIRE(event.wait(0ms));
+  REQUIRE(event.consume() == 3);
+  REQUIRE_FALSE(event.wait(0ms));
+
+  auto moved = std::move(event);
+  REQUIRE(moved.fd() != -1);
+  REQUIRE(event.fd() == -1);
+}
+
+TEST_CASE("wakeup queue hands tasks to an event loop", "[queue]") {
+  ST::Net::Poller poller{};
+  ST::WakeupQueue<ST::MPMCQueue<std::function<void()>>> tasks{ 1024 };
+
+  // 注册之前入队的任务也要执行
+  int executed = 0;
+  REQUIRE(tasks.try_push([&executed] { ++executed; }));
+
+  tasks.watch(poller, [] (std::function<void()>&& task) { task(); });
+
+  constexpr int PRODUCERS = 3;
+  constexpr int COUNT = 2000;
+  std::vector<std::thread> producers{};
+  for (int p = 0; p < PRODUCERS; ++p) {
+    producers.emplace_back([&tasks, &executed] {
+      for (int i = 0; i < COUNT; ++i) {
+        // 任务在事件循环线程中执行，不需要同步
+        while (!tasks.try_push([&executed] { ++executed; }))
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (executed < PRODUCERS * COUNT + 1 && std::chrono::steady_clock::now() < deadline)
+    poller.poll(100);
+
+  for (auto& producer: producers)
+    producer.join();
+
+  REQUIRE(executed == PRODUCERS * COUNT + 1);
+  tasks.unwatch(poller);
+  REQUIRE_FALSE(poller.contains(tasks.fd()));
+}
+
+TEST_CASE("wakeup queue pop blocks until a producer pushes", "[queue]") {
+  ST::WakeupQueue<ST::SPSCQueue<int>> queue{ 16 };
+  REQUIRE(queue.pop(5ms) == std::nullopt);
+
+  std::thread producer{ [&queue] {
+    std::this_thread::sleep_for(20ms);
+    REQUIRE(queue.try_push(42));
+  } };
+
+  REQUIRE(queue.pop(5s) == 42);
+  producer.join();
+
+  REQUIRE(queue.try_push(1));
+  REQUIRE(queue.try_push(2));
+  std::vector<int> drained{};
+  REQUIRE(queue.drain([&drained] (int value) { drained.push_back(value); }) == 2);
+  REQUIRE(drained == std::vector<int>{ 1, 2 });
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+
+#include "st/Result.h"
+#include "ST/FileSystem/File.h"
+#include "ST/Net/Socket.h"
+#include "ST/Process.h"
+
+
+TEST_CASE("result holds either a value or an errno", "[result]") {
+  st::Result<std::string> ok{ std::string{ "value" } };
+  REQUIRE(ok);
+  REQUIRE(ok.error() == 0);
+  REQUIRE(*ok == "value");
+  REQUIRE(ok->size() == 5);
+
+  st::Result<std::string> failed{ st::Error{ ECONNRESET } };
+  REQUIRE_FALSE(failed);
+  REQUIRE(failed.error() == ECONNRESET);
+  REQUIRE(failed.error_code() == std::errc::connection_reset);
+  REQUIRE(failed.value_or("fallback") == "fallback");
+  REQUIRE_THROWS_AS(failed.value(), std::system_error);
+
+  // 赋值在值和错误之间切换
+  failed = ok;
+  REQUIRE(failed.value() == "value");
+  ok = st::Error{ EAGAIN };
+  REQUIRE(ok.would_block());
+
+  st::Result<std::unique_ptr<int>> moved{ std::make_unique<int>(42) };
+  auto pointer = *std::move(moved);
+  REQUIRE(*pointer == 42);
+
+  st::Result<void> done{};
+  REQUIRE(done);
+  REQUIRE_NOTHROW(done.value());
+  REQUIRE_THROWS_AS(st::Result<void>{ st::Error{ EPIPE } }.value(), std::system_error);
+}
+
+TEST_CASE("nothrow socket calls report errno instead of throwing", "[result]") {
+  auto [writer, reader] = ST::Net::Socket::pair();
+  reader.set_nonblocking();
+
+  char buffer[16];
+  auto empty = reader.read(buffer, sizeof(buffer), std::nothrow);
+  REQUIRE(empty.would_block());
+  // 抛异常的版本在EAGAIN时仍然返回-1
+  REQUIRE(reader.read(buffer, sizeof(buffer)) == -1);
+
+  auto written = writer.write("ping", 4, std::nothrow);
+  REQUIRE(written);
+  REQUIRE(*written == 4);
+  REQUIRE(reader.read(buffer, sizeof(buffer), std::nothrow).value() == 4);
+
+  reader.set_nonblocking(false);
+  ST::Net::Socket listener{ ST::Net::Family::Unix };
+  listener.set_nonblocking();
+  listener.bind("@st-test-result");
+  listener.listen();
+  REQUIRE(listener.accept(std::nothrow).would_block());
+  REQUIRE_FALSE(listener.try_accept());
+}
+
+TEST_CASE("nothrow file calls report errno instead of throwing", "[result]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  ST::FileSystem::File read_end{ "pipe", fds[0] };
+  ST::FileSystem::File write_end{ "pipe", fds[1] };
+
+  char buffer[16];
+  REQUIRE(write_end.read(buffer, sizeof(buffer), std::nothrow).error() == EBADF);
+  REQUIRE_THROWS_AS(write_end.read(buffer, sizeof(buffer)), std::system_error);
+  REQUIRE(read_end.pread(buffer, sizeof(buffer), 0, std::nothrow).error() == ESPIPE);
+
+  REQUIRE(write_end.write("data", 4, std::nothrow).value() == 4);
+  REQUIRE(read_end.read(buffer, sizeof(buffer), std::nothrow).value() == 4);
+
+  read_end.close();
+  write_end.close();
+  REQUIRE(write_end.write("data", 4, std::nothrow).error() == EBADF);
+}
+
+TEST_CASE("nothrow wait reports ECHILD for invalid waits", "[result]") {
+  auto pid = ::fork();
+  REQUIRE(pid != -1);
+  if (pid == 0)
+    ::_exit(3);
+
+  auto process = ST::Process::adopt(pid);
+  auto result = process.wait(std::nothrow);
+  REQUIRE(result);
+  REQUIRE(result->exit_status() == 3);
+  REQUIRE(process.wait(std::nothrow).error() == ECHILD);
+}
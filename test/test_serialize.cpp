@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <errno.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "st/Serialize.h"
+
+
+namespace {
+
+enum class Side : std::uint8_t {
+  Buy,
+  Sell
+};
+
+struct Level {
+  std::int64_t price;
+  std::uint32_t quantity;
+
+  bool operator==(const Level&) const = default;
+};
+
+struct Quote {
+  st::Varint<std::uint64_t> sequence;
+  std::string_view symbol;
+  Side side;
+  double ratio;
+  std::vector<Level> levels;
+  std::vector<std::uint32_t> ids;
+  std::optional<std::string> note;
+  std::array<std::int16_t, 2> flags;
+  std::pair<bool, st::Varint<std::int32_t>> delta;
+};
+
+// 自定义格式: 只写一个varint
+struct Timestamp {
+  std::uint64_t nanoseconds;
+};
+
+} // namespace
+
+template<>
+struct st::Serializer<Timestamp> {
+  static std::size_t size(const Timestamp& timestamp) { return Writer::varint_length(timestamp.nanoseconds); }
+  static void write(Writer& writer, const Timestamp& timestamp) { writer.varint(timestamp.nanoseconds); }
+  static void read(Reader& reader, Timestamp& timestamp) { reader.varint(timestamp.nanoseconds); }
+};
+
+TEST_CASE("aggregates round trip and strings are read as views", "[serialize]") {
+  Quote quote{
+    300, "AAPL", Side::Sell, 0.25,
+    { { 100, 5 }, { -101, 7 } },
+    { 1, 2, 3, 0xdeadbeef },
+    std::string{ "note" },
+    { 1, -1 },
+    { true, -64 }
+  };
+
+  std::vector<std::byte> buffer(st::serialized_size(quote));
+  auto written = st::serialize(quote, std::span{ buffer });
+  REQUIRE(written);
+  REQUIRE(*written == buffer.size());
+
+  auto decoded = st::deserialize<Quote>(buffer);
+  REQUIRE(decoded);
+  REQUIRE(decoded->sequence == quote.sequence);
+  REQUIRE(decoded->symbol == "AAPL");
+  // 不拷贝，直接指向输入
+  REQUIRE(reinterpret_cast<const std::byte*>(decoded->symbol.data()) > buffer.data());
+  REQUIRE(reinterpret_cast<const std::byte*>(decoded->symbol.data()) < buffer.data() + buffer.size());
+  REQUIRE(decoded->side == Side::Sell);
+  REQUIRE(decoded->ratio == 0.25);
+  REQUIRE(decoded->levels == quote.levels);
+  REQUIRE(decoded->ids == quote.ids);
+  REQUIRE(decoded->note == quote.note);
+  REQUIRE(decoded->flags == quote.flags);
+  REQUIRE(decoded->delta.first);
+  REQUIRE(decoded->delta.second == -64);
+}
+
+TEST_CASE("wire format is big endian with varint length prefixes", "[serialize]") {
+  std::tuple<std::uint32_t, st::Varint<std::uint32_t>, std::string_view, Timestamp> message{ 0x01020304, 300, "hi", { 1 } };
+
+  std::array<std::byte, 32> buffer{};
+  auto written = st::serialize(message, std::span{ buffer });
+  REQUIRE(written.value() == 4 + 2 + 1 + 2 + 1);
+
+  std::array<std::uint8_t, 10> expected{ 0x01, 0x02, 0x03, 0x04, 0xac, 0x02, 0x02, 'h', 'i', 0x01 };
+  for (std::size_t i = 0; i < expected.size(); ++i)
+    REQUIRE(std::to_integer<std::uint8_t>(buffer[i]) == expected[i]);
+
+  // 有符号varint用zigzag，-1只占1个字节
+  REQUIRE(st::serialized_size(st::Varint<std::int64_t>{ -1 }) == 1);
+}
+
+TEST_CASE("integer arrays survive unaligned output", "[serialize]") {
+  // 前面的1字节bool让数组落在奇数地址
+  std::pair<bool, std::vector<std::uint64_t>> message{ true, {} };
+  for (std::uint64_t i = 0; i < 100; ++i)
+    message.second.push_back(i * 0x0101010101010101);
+
+  std::vector<std::byte> buffer(st::serialized_size(message) + 1);
+  std::span<std::byte> unaligned{ buffer.data() + 1, buffer.size() - 1 };
+  REQUIRE(st::serialize(message, unaligned));
+
+  auto decoded = st::deserialize<decltype(message)>(unaligned);
+  REQUIRE(decoded);
+  REQUIRE(decoded->second == message.second);
+}
+
+TEST_CASE("vectors of bool round trip", "[serialize]") {
+  std::pair<std::vector<bool>, std::array<bool, 3>> message{ { true, false, true, true }, { false, true, false } };
+
+  std::vector<std::byte> buffer(st::serialized_size(message));
+  REQUIRE(buffer.size() == 1 + 4 + 3);
+  REQUIRE(st::serialize(message, std::span{ buffer }));
+
+  auto decoded = st::deserialize<decltype(message)>(buffer);
+  REQUIRE(decoded);
+  REQUIRE(*decoded == message);
+}
+
+TEST_CASE("C array members are detected", "[serialize]") {
+  struct WithArray {
+    std::int32_t values[2];
+    std::int32_t last;
+  };
+
+  // 花括号省略让数组的每个元素都算作一个成员，as_tuple据此拒绝这种类型
+  STATIC_REQUIRE(st::detail::field_count<WithArray>() == 3);
+  STATIC_REQUIRE(st::detail::braced_field_count<WithArray>() == 2);
+  STATIC_REQUIRE(st::detail::braced_field_count<Quote>() == st::detail::field_count<Quote>());
+}
+
+TEST_CASE("errors are reported through Result", "[serialize]") {
+  Level level{ 1, 2 };
+  std::array<std::byte, 8> small{};
+  REQUIRE(st::serialize(level, std::span{ small }).error() == ENOBUFS);
+
+  std::array<std::byte, 12> buffer{};
+  REQUIRE(st::serialize(level, std::span{ buffer }));
+  REQUIRE(st::deserialize<Level>(std::span{ buffer }.first(11)).error() == EBADMSG);
+
+  // 长度前缀超过剩余数据
+  std::array<std::byte, 2> truncated{ std::byte{ 5 }, std::byte{ 'a' } };
+  REQUIRE(st::deserialize<std::string_view>(truncated).error() == EBADMSG);
+
+  // varint超过目标类型的范围
+  std::array<std::byte, 3> wide{};
+  REQUIRE(st::serialize(st::Varint<std::uint32_t>{ 70000 }, std::span{ wide }));
+  REQUIRE(st::deserialize<st::Varint<std::uint16_t>>(wide).error() == EBADMSG);
+
+  // 永不结束的varint
+  std::array<std::byte, 11> endless{};
+  endless.fill(std::byte{ 0xff });
+  REQUIRE(st::deserialize<st::Varint<std::uint64_t>>(endless).error() == EBADMSG);
+
+  // 伪造的超大元素个数
+  std::array<std::byte, 2> huge{ std::byte{ 0x7f }, std::byte{ 0 } };
+  REQUIRE(st::deserialize<std::vector<Level>>(huge).error() == EBADMSG);
+}
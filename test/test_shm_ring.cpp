@@ -0,0 +1,185 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "ST/Process.h"
+#include "ST/SharedMemory.h"
+#include "ST/ShmRing.h"
+
+
+using namespace std::chrono_literals;
+
+namespace {
+
+std::span<const std::byte> as_bytes(const std::uint64_t& value)
+{
+  return std::as_bytes(std::span{ &value, 1 });
+}
+
+std::uint64_t to_value(std::span<const std::byte> bytes)
+{
+  std::uint64_t value;
+  std::memcpy(&value, bytes.data(), sizeof(value));
+  return value;
+}
+
+} // namespace
+
+TEST_CASE("anonymous shared memory is zeroed and shared after fork", "[shm]") {
+  auto memory = ST::SharedMemory::anonymous("test", 4096);
+  REQUIRE(memory.size() == 4096);
+  REQUIRE(static_cast<unsigned char*>(memory.data())[100] == 0);
+
+  ST::Process child{ [&] { static_cast<unsigned char*>(memory.data())[100] = 42; } };
+  child.wait();
+
+  REQUIRE(static_cast<unsigned char*>(memory.data())[100] == 42);
+}
+
+TEST_CASE("ring wraps around and reports full and empty", "[shm][ring]") {
+  auto ring = ST::ShmRing::create(3, sizeof(std::uint64_t), ST::RingMode::SPSC);
+  REQUIRE(ring.capacity() == 4);
+  REQUIRE(ring.empty());
+
+  std::array<std::byte, sizeof(std::uint64_t)> buffer;
+  for (std::uint64_t round = 0; round < 3; ++round) {
+    for (std::uint64_t i = 0; i < 4; ++i) {
+      auto value = round * 10 + i;
+      REQUIRE(ring.try_push(as_bytes(value)));
+    }
+    std::uint64_t extra = 99;
+    REQUIRE_FALSE(ring.try_push(as_bytes(extra)));
+    REQUIRE(ring.size() == 4);
+
+    for (std::uint64_t i = 0; i < 4; ++i) {
+      REQUIRE(ring.try_pop(buffer) == sizeof(std::uint64_t));
+      REQUIRE(to_value(buffer) == round * 10 + i);
+    }
+    REQUIRE_FALSE(ring.try_pop(buffer));
+  }
+}
+
+TEST_CASE("ring rejects oversized messages and times out when empty", "[shm][ring]") {
+  auto ring = ST::ShmRing::create(4, 8);
+
+  std::array<std::byte, 9> oversized{};
+  REQUIRE_THROWS_AS(ring.try_push(oversized), std::length_error);
+
+  std::array<std::byte, 8> buffer;
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE_FALSE(ring.pop(buffer, 20ms));
+  REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+}
+
+TEST_CASE("ring consumes messages without copying", "[shm][ring]") {
+  auto ring = ST::ShmRing::create(4, 16);
+
+  std::string_view message{ "zero copy" };
+  REQUIRE(ring.try_push(std::as_bytes(std::span{ message })));
+
+  std::string received{};
+  REQUIRE(ring.try_consume([&] (std::span<const std::byte> payload) {
+    received.assign(reinterpret_cast<const char*>(payload.data()), payload.size());
+  }));
+  REQUIRE(received == message);
+  REQUIRE_FALSE(ring.try_consume([] (std::span<const std::byte>) {}));
+}
+
+TEST_CASE("ring carries messages from multiple producer processes", "[shm][ring]") {
+  constexpr std::uint64_t producers = 3;
+  constexpr std::uint64_t messages = 20000;
+
+  // 容量远小于消息总数，生产者会阻塞在队列满上
+  auto ring = ST::ShmRing::create(64, sizeof(std::uint64_t), ST::RingMode::MPMC);
+
+  std::vector<ST::Process> children{};
+  for (std::uint64_t producer = 0; producer < producers; ++producer) {
+    children.emplace_back([&ring, producer] {
+      for (std::uint64_t i = 1; i <= messages; ++i) {
+        auto value = producer * messages + i;
+        ring.push(as_bytes(value));
+      }
+    });
+  }
+
+  std::uint64_t sum = 0, received = 0;
+  std::array<std::byte, sizeof(std::uint64_t)> buffer;
+  while (received < producers * messages && ring.pop(buffer, 5s)) {
+    sum += to_value(buffer);
+    ++received;
+  }
+
+  for (auto& child: children)
+    REQUIRE(child.wait().exit_status() == 0);
+
+  auto total = producers * messages;
+  REQUIRE(received == total);
+  REQUIRE(sum == total * (total + 1) / 2);
+  REQUIRE(ring.empty());
+}
+
+TEST_CASE("ring can be attached through its fd", "[shm][ring]") {
+  auto ring = ST::ShmRing::create(8, 32, ST::RingMode::SPSC);
+  std::uint64_t value = 7;
+  REQUIRE(ring.try_push(as_bytes(value)));
+
+  auto attached = ST::ShmRing::attach(ST::SharedMemory::attach(::dup(ring.fd())));
+  REQUIRE(attached.capacity() == 8);
+  REQUIRE(attached.message_size() == 32);
+  REQUIRE(attached.mode() == ST::RingMode::SPSC);
+
+  std::array<std::byte, 32> buffer;
+  REQUIRE(attached.try_pop(buffer) == sizeof(std::uint64_t));
+  REQUIRE(to_value(buffer) == 7);
+  REQUIRE(ring.empty());
+
+  auto plain = ST::SharedMemory::anonymous("not-a-ring", 4096);
+  REQUIRE_THROWS_AS(ST::ShmRing::attach(std::move(plain)), std::invalid_argument);
+}
+
+TEST_CASE("ring doesn't trust the layout in shared memory", "[shm][ring]") {
+  // 和ShmRing.cpp中的布局一致: header中capacity和slot_stride的偏移，第一个slot中length的偏移
+  constexpr std::size_t CAPACITY_OFFSET = 8;
+  constexpr std::size_t STRIDE_OFFSET = 24;
+  constexpr std::size_t FIRST_LENGTH_OFFSET = 512 + 8;
+
+  auto ring = ST::ShmRing::create(8, 32, ST::RingMode::SPSC);
+  auto raw = ST::SharedMemory::attach(::dup(ring.fd()));
+  auto bytes = static_cast<std::byte*>(raw.data());
+  auto poke = [bytes] (std::size_t offset, auto value) {
+    auto old = value;
+    std::memcpy(&old, bytes + offset, sizeof(old));
+    std::memcpy(bytes + offset, &value, sizeof(value));
+    return old;
+  };
+
+  // 对端写入超过message_size的长度，不能越过调用者的缓冲区
+  std::uint64_t value = 7;
+  REQUIRE(ring.try_push(as_bytes(value)));
+  poke(FIRST_LENGTH_OFFSET, std::uint32_t{ 1 << 20 });
+  std::array<std::byte, 32> buffer;
+  REQUIRE(ring.try_pop(buffer) == buffer.size());
+
+  auto attach = [&ring] { return ST::ShmRing::attach(ST::SharedMemory::attach(::dup(ring.fd()))); };
+
+  auto capacity = poke(CAPACITY_OFFSET, std::uint64_t{ 6 });
+  REQUIRE_THROWS_AS(attach(), std::invalid_argument);
+  poke(CAPACITY_OFFSET, std::uint64_t{ 1 } << 40);
+  REQUIRE_THROWS_AS(attach(), std::invalid_argument);
+  poke(CAPACITY_OFFSET, capacity);
+
+  auto stride = poke(STRIDE_OFFSET, std::uint64_t{ 1 << 20 });
+  REQUIRE_THROWS_AS(attach(), std::invalid_argument);
+  poke(STRIDE_OFFSET, stride);
+
+  REQUIRE(attach().capacity() == 8);
+}
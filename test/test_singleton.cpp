@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ST/Singleton.h"
+
+
+namespace {
+
+std::vector<std::string> destroyed{};
+
+struct Config {
+  std::string name;
+
+  explicit Config(std::string n = "default") : name{ std::move(n) } {}
+  Config(const Config&) = delete;
+  ~Config() { destroyed.push_back("config"); }
+};
+
+struct Database {
+  ~Database() { destroyed.push_back("database"); }
+};
+
+struct Counter {
+  std::atomic<std::uint64_t> value{ 0 };
+};
+
+struct RequestTag {};
+
+} // namespace
+
+// Database依赖Config，先销毁
+template<>
+constexpr int ST::singleton_shutdown_order<Database> = 10;
+
+TEST_CASE("singleton is created once and can be recreated after destroy", "[singleton]") {
+  REQUIRE_FALSE(ST::Singleton<Config>::created());
+
+  auto& config = ST::Singleton<Config>::create("first");
+  REQUIRE(&ST::Singleton<Config>::instance() == &config);
+  REQUIRE(ST::Singleton<Config>::create("ignored").name == "first");
+  REQUIRE(ST::Singleton<Config>::get().name == "first");
+
+  ST::Singleton<Config>::destroy();
+  REQUIRE_FALSE(ST::Singleton<Config>::created());
+  REQUIRE(ST::Singleton<Config>::instance().name == "default");
+
+  ST::ShutdownRegistry::shutdown();
+  REQUIRE_FALSE(ST::Singleton<Config>::created());
+}
+
+TEST_CASE("shutdown destroys instances in order", "[singleton]") {
+  destroyed.clear();
+
+  ST::Singleton<Config>::instance();
+  ST::Singleton<Database>::instance();
+  ST::ShutdownRegistry::shutdown();
+
+  REQUIRE(destroyed == std::vector<std::string>{ "database", "config" });
+  REQUIRE(ST::ShutdownRegistry::size() == 0);
+}
+
+TEST_CASE("per-thread instances are aggregated and reused", "[singleton]") {
+  constexpr int threads = 4;
+  constexpr int increments = 10000;
+
+  auto run = [] {
+    std::vector<std::jthread> workers{};
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([] {
+        for (int j = 0; j < increments; ++j)
+          ST::PerThread<Counter, RequestTag>::local().value.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+  };
+  run();
+
+  std::uint64_t total = 0;
+  ST::PerThread<Counter, RequestTag>::for_each([&] (Counter& counter) { total += counter.value.load(); });
+  REQUIRE(total == threads * increments);
+
+  // 同时存在的线程数取决于调度，实例数最多等于线程数
+  auto instances = ST::PerThread<Counter, RequestTag>::size();
+  REQUIRE(instances <= threads);
+  run();
+  REQUIRE(ST::PerThread<Counter, RequestTag>::size() <= threads);
+
+  // 逐个启动并等待线程退出，每个新线程都复用已退出线程的实例
+  instances = ST::PerThread<Counter, RequestTag>::size();
+  for (int i = 0; i < threads; ++i)
+    std::jthread{ [] { ST::PerThread<Counter, RequestTag>::local().value.fetch_add(1, std::memory_order_relaxed); } }.join();
+  REQUIRE(ST::PerThread<Counter, RequestTag>::size() == instances);
+
+  // 不同Tag互不影响
+  ST::PerThread<Counter>::local().value = 1;
+  REQUIRE(&ST::PerThread<Counter>::local() != &ST::PerThread<Counter, RequestTag>::local());
+
+  ST::ShutdownRegistry::shutdown();
+  REQUIRE(ST::PerThread<Counter, RequestTag>::size() == 0);
+}
+
+TEST_CASE("per-thread instances survive destroy while threads are alive", "[singleton]") {
+  std::binary_semaphore attached{ 0 };
+  std::binary_semaphore destroyed_all{ 0 };
+
+  std::jthread worker{ [&] {
+    ST::PerThread<Counter, RequestTag>::local().value = 1;
+    attached.release();
+    destroyed_all.acquire();
+
+    // 旧实例已经释放，重新创建一个
+    auto& counter = ST::PerThread<Counter, RequestTag>::local();
+    counter.value.fetch_add(1, std::memory_order_relaxed);
+  } };
+
+  attached.acquire();
+  ST::PerThread<Counter, RequestTag>::destroy();
+  REQUIRE(ST::PerThread<Counter, RequestTag>::size() == 0);
+  destroyed_all.release();
+  worker.join();
+
+  std::uint64_t total = 0;
+  ST::PerThread<Counter, RequestTag>::for_each([&] (Counter& counter) { total += counter.value.load(); });
+  REQUIRE(total == 1);
+
+  // 线程退出时交还的是新一代的实例，可以被复用
+  std::jthread{ [] { ST::PerThread<Counter, RequestTag>::local(); } }.join();
+  REQUIRE(ST::PerThread<Counter, RequestTag>::size() == 1);
+
+  ST::PerThread<Counter, RequestTag>::destroy();
+}
+
+TEST_CASE("per-cpu instances cover every cpu", "[singleton]") {
+  constexpr int threads = 4;
+  constexpr int increments = 10000;
+
+  {
+    std::vector<std::jthread> workers{};
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([] {
+        for (int j = 0; j < increments; ++j)
+          ST::PerCpu<Counter>::local().value.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+  }
+
+  REQUIRE(ST::PerCpu<Counter>::size() >= 1);
+  std::uint64_t total = 0;
+  ST::PerCpu<Counter>::for_each([&] (Counter& counter) { total += counter.value.load(); });
+  REQUIRE(total == threads * increments);
+
+  ST::ShutdownRegistry::shutdown();
+  REQUIRE(ST::PerCpu<Counter>::size() == 0);
+}
@@ -0,0 +1,328 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ST/Net/Socket.h"
+#include "ST/Net/SocketOption.h"
+#include "ST/Net/Channel.h"
+#include "ST/Net/Poller.h"
+#include "ST/Net/Server.h"
+
+
+using namespace std::chrono_literals;
+
+TEST_CASE("boolean socket options round trip", "[socket][option]") {
+  ST::Net::Socket socket{};
+
+  socket.set_option<ST::Net::Option::NoDelay>(true);
+  REQUIRE(socket.get_option<ST::Net::Option::NoDelay>());
+
+  socket.set_option<ST::Net::Option::NoDelay>(false);
+  REQUIRE_FALSE(socket.get_option<ST::Net::Option::NoDelay>());
+
+  socket.set_option<ST::Net::Option::ReuseAddress>(true);
+  REQUIRE(socket.get_option<ST::Net::Option::ReuseAddress>());
+}
+
+TEST_CASE("integer and duration socket options round trip", "[socket][option]") {
+  ST::Net::Socket socket{};
+
+  socket.set_option<ST::Net::Option::KeepAliveIdle>(42s);
+  REQUIRE(socket.get_option<ST::Net::Option::KeepAliveIdle>() == 42s);
+
+  socket.set_option<ST::Net::Option::KeepAliveCount>(5);
+  REQUIRE(socket.get_option<ST::Net::Option::KeepAliveCount>() == 5);
+
+  // 内核会将缓冲区大小翻倍
+  socket.set_option<ST::Net::Option::ReceiveBuffer>(64 * 1024);
+  REQUIRE(socket.get_option<ST::Net::Option::ReceiveBuffer>() >= 64 * 1024);
+
+  socket.set_option<ST::Net::Option::Linger>(3s);
+  REQUIRE(socket.get_option<ST::Net::Option::Linger>() == 3s);
+}
+
+TEST_CASE("socket profile applies only the options it sets", "[socket][option]") {
+  ST::Net::Socket socket{};
+  socket.set_option<ST::Net::Option::KeepAliveCount>(7);
+
+  ST::Net::SocketProfile profile{};
+  profile.no_delay = true;
+  profile.apply(socket);
+
+  REQUIRE(socket.get_option<ST::Net::Option::NoDelay>());
+  REQUIRE(socket.get_option<ST::Net::Option::KeepAliveCount>() == 7);
+
+  ST::Net::SocketProfile::low_latency().apply(socket);
+  REQUIRE(socket.get_option<ST::Net::Option::KeepAlive>());
+  REQUIRE(socket.get_option<ST::Net::Option::KeepAliveCount>() == 3);
+}
+
+TEST_CASE("socket profile skips tcp options on unix sockets", "[socket][option]") {
+  auto [first, second] = ST::Net::Socket::pair();
+
+  ST::Net::SocketProfile::low_latency().apply(first);
+  REQUIRE(first.get_option<ST::Net::Option::KeepAlive>());
+}
+
+TEST_CASE("socket pair is connected in both directions", "[socket][unix]") {
+  auto [first, second] = ST::Net::Socket::pair();
+  REQUIRE(first.family() == ST::Net::Family::Unix);
+
+  std::string_view ping = "ping";
+  REQUIRE(first.write(ping.data(), ping.size()) == 4);
+
+  char buffer[8]{};
+  REQUIRE(second.read(buffer, sizeof(buffer)) == 4);
+  REQUIRE(std::string_view{ buffer, 4 } == ping);
+}
+
+TEST_CASE("file descriptors can be passed through a unix socket", "[socket][unix]") {
+  auto [master, worker] = ST::Net::Socket::pair();
+
+  int pipe_fds[2];
+  REQUIRE(::pipe(pipe_fds) == 0);
+
+  master.send_fd(pipe_fds[1]);
+  ::close(pipe_fds[1]);
+
+  auto received = worker.receive_fd();
+  REQUIRE(received >= 0);
+
+  // 收到的fd和原来的fd指向同一个管道
+  REQUIRE(::write(received, "x", 1) == 1);
+  ::close(received);
+
+  char c = 0;
+  REQUIRE(::read(pipe_fds[0], &c, 1) == 1);
+  REQUIRE(c == 'x');
+  ::close(pipe_fds[0]);
+}
+
+TEST_CASE("accepted sockets can be handed over to another socket", "[socket][unix]") {
+  auto [master, worker] = ST::Net::Socket::pair();
+  auto [client, connection] = ST::Net::Socket::pair();
+
+  master.send_fd(connection.fd());
+  connection.close();
+
+  auto handed = worker.receive_socket(ST::Net::Family::Unix);
+  REQUIRE(handed.has_value());
+
+  REQUIRE(client.write("hi", 2) == 2);
+  char buffer[2];
+  REQUIRE(handed->read(buffer, 2) == 2);
+}
+
+TEST_CASE("unix stream sockets in abstract namespace", "[socket][unix]") {
+  auto path = "@st-test-" + std::to_string(::getpid());
+
+  ST::Net::Socket listener{ ST::Net::Family::Unix };
+  listener.bind(path);
+  listener.listen();
+
+  ST::Net::Socket client{ ST::Net::Family::Unix };
+  client.connect(path);
+  auto connection = listener.accept();
+
+  REQUIRE(connection.write("ok", 2) == 2);
+  char buffer[2];
+  REQUIRE(client.read(buffer, 2) == 2);
+
+  ST::Net::Socket ipv4{};
+  REQUIRE_THROWS_AS(ipv4.bind(path), ST::UndefinedFamilyException);
+}
+
+TEST_CASE("channel frames travel over a socket pair", "[socket][channel]") {
+  auto [first, second] = ST::Net::Socket::pair();
+  ST::Net::Channel sender{ std::make_shared<ST::Net::Socket>(std::move(first)), nullptr };
+  ST::Net::Channel receiver{ std::make_shared<ST::Net::Socket>(std::move(second)), nullptr };
+
+  std::string_view a = "first", b = "second";
+  std::vector<std::span<const std::byte>> frames{
+    std::as_bytes(std::span{ a.data(), a.size() }),
+    std::as_bytes(std::span{ b.data(), b.size() })
+  };
+  REQUIRE(sender.send(frames) == static_cast<ssize_t>(ST::Net::LengthFieldCodec::encoded_length(frames)));
+
+  std::vector<std::string> received;
+  while (received.size() < 2)
+    receiver.on_received([&](std::span<const std::byte> payload) {
+      received.emplace_back(reinterpret_cast<const char*>(payload.data()), payload.size());
+    });
+
+  REQUIRE(received == std::vector<std::string>{ "first", "second" });
+}
+
+namespace {
+
+std::span<const std::byte> as_bytes(std::string_view text)
+{
+  return std::as_bytes(std::span{ text.data(), text.size() });
+}
+
+// 阻塞读取一帧
+std::string receive_frame(ST::Net::Channel& channel)
+{
+  std::vector<std::string> frames;
+  while (frames.empty()) {
+    if (channel.on_received([&](std::span<const std::byte> payload) {
+          frames.emplace_back(reinterpret_cast<const char*>(payload.data()), payload.size());
+        }) == 0)
+      break;
+  }
+
+  return frames.empty() ? std::string{} : frames.front();
+}
+
+} // namespace
+
+TEST_CASE("channel queues the unsent part of a partial write", "[socket][channel]") {
+  auto [first, second] = ST::Net::Socket::pair();
+  first.set_nonblocking();
+  ST::Net::Channel sender{ std::make_shared<ST::Net::Socket>(std::move(first)), nullptr };
+  ST::Net::Channel receiver{ std::make_shared<ST::Net::Socket>(std::move(second)), nullptr };
+
+  // 大于socket发送缓冲区，一次写不完
+  std::string large(4 << 20, 'x');
+  for (std::size_t i = 0; i < large.size(); i += 4096)
+    large[i] = static_cast<char>('a' + i / 4096 % 26);
+  std::vector<std::span<const std::byte>> frames{ as_bytes(large), as_bytes("tail") };
+
+  auto written = sender.send(frames);
+  REQUIRE(written > 0);
+  REQUIRE(sender.pending_bytes() + written == ST::Net::LengthFieldCodec::encoded_length(frames));
+
+  std::vector<std::string> received;
+  while (received.size() < 2) {
+    sender.handle_write();
+    receiver.on_received([&](std::span<const std::byte> payload) {
+      received.emplace_back(reinterpret_cast<const char*>(payload.data()), payload.size());
+    });
+  }
+
+  REQUIRE(sender.pending_bytes() == 0);
+  REQUIRE(received == std::vector<std::string>{ large, "tail" });
+}
+
+TEST_CASE("channel drops frames after it was aborted", "[socket][channel]") {
+  auto [first, second] = ST::Net::Socket::pair();
+  ST::Net::Channel channel{ std::make_shared<ST::Net::Socket>(std::move(first)), nullptr };
+
+  channel.abort();
+  REQUIRE(channel.is_closed());
+  REQUIRE(channel.send(as_bytes("late")) == 0);
+  REQUIRE(channel.pending_bytes() == 0);
+}
+
+TEST_CASE("server survives misbehaving connections", "[socket][server]") {
+  auto path = "@st-server-test-" + std::to_string(::getpid());
+  ST::Net::Socket listener{ ST::Net::Family::Unix };
+  listener.bind(path);
+  listener.listen();
+
+  ST::Net::Poller poller{};
+  ST::Net::Server server{ poller, std::move(listener) };
+  server.on_connection([](ST::Net::Channel& channel) { channel.send(as_bytes("hello")); });
+  server.on_message([](ST::Net::Channel& channel, std::span<const std::byte> payload, std::pmr::memory_resource& memory) {
+    // 回复从这一轮的临时内存中分配
+    std::pmr::string echo{ reinterpret_cast<const char*>(payload.data()), payload.size(), &memory };
+    channel.send(as_bytes(echo));
+  });
+  server.start();
+
+  bool graceful = false;
+  std::thread loop{ [&] { graceful = server.run(1s); } };
+
+  auto connect = [&path] {
+    auto socket = std::make_shared<ST::Net::Socket>(ST::Net::Family::Unix);
+    socket->connect(path);
+    return socket;
+  };
+
+  ST::Net::Channel good{ connect(), nullptr };
+  REQUIRE(receive_frame(good) == "hello");
+
+  // 不读服务器发来的数据就关闭，服务器读到ECONNRESET
+  {
+    auto reset = connect();
+    pollfd target{ reset->fd(), POLLIN, 0 };
+    REQUIRE(::poll(&target, 1, 5000) == 1);
+    reset->abort();
+  }
+
+  // 长度字段超过上限
+  {
+    ST::Net::Channel oversized{ connect(), nullptr };
+    REQUIRE(receive_frame(oversized) == "hello");
+    std::uint32_t header = 0xFFFFFFFF;
+    REQUIRE(oversized.self()->write(&header, sizeof(header)) == sizeof(header));
+    REQUIRE(receive_frame(oversized).empty());
+  }
+
+  good.send(as_bytes("still alive"));
+  REQUIRE(receive_frame(good) == "still alive");
+
+  good.self()->close();
+  server.stop();
+  loop.join();
+  REQUIRE(graceful);
+}
+
+TEST_CASE("server drops only the connection with a corrupted frame", "[socket][server]") {
+  auto path = "@st-checksum-test-" + std::to_string(::getpid());
+  ST::Net::Socket listener{ ST::Net::Family::Unix };
+  listener.bind(path);
+  listener.listen();
+
+  ST::Net::LengthFieldCodec codec{ ST::Net::DEFAULT_MAX_FRAME_LENGTH, ST::Net::FrameChecksum::CRC32C };
+  ST::Net::Poller poller{};
+  ST::Net::Server server{ poller, std::move(listener) };
+  server.codec(codec);
+  server.on_message([](ST::Net::Channel& channel, std::span<const std::byte> payload, std::pmr::memory_resource&) {
+    channel.send(payload);
+  });
+  server.start();
+
+  bool graceful = false;
+  std::thread loop{ [&] { graceful = server.run(1s); } };
+
+  auto connect = [&path] {
+    auto socket = std::make_shared<ST::Net::Socket>(ST::Net::Family::Unix);
+    socket->connect(path);
+    return socket;
+  };
+
+  ST::Net::Channel good{ connect(), nullptr, codec };
+  good.send(as_bytes("first"));
+  REQUIRE(receive_frame(good) == "first");
+
+  // 编码正确的帧，发送前翻转负载中的一位
+  {
+    ST::Net::Channel corrupted{ connect(), nullptr, codec };
+    ST::Net::Buffer frame{};
+    std::span<const std::byte> payload = as_bytes("tampered");
+    codec.encode(frame, std::span<const std::span<const std::byte>>{ &payload, 1 });
+    std::vector<std::byte> bytes{ frame.readable().begin(), frame.readable().end() };
+    bytes.back() ^= std::byte{ 0x01 };
+    REQUIRE(corrupted.self()->write(bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+    REQUIRE(receive_frame(corrupted).empty());
+  }
+
+  good.send(as_bytes("second"));
+  REQUIRE(receive_frame(good) == "second");
+
+  good.self()->close();
+  server.stop();
+  loop.join();
+  REQUIRE(graceful);
+}
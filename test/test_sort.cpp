@@ -0,0 +1,162 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "st/Alogorithm.h"
+#include "st/Sort.h"
+#include "ST/ThreadPool.h"
+
+
+namespace {
+
+// 常见的会让快速排序退化的输入
+std::vector<std::vector<int>> patterns(std::size_t size)
+{
+  std::mt19937 engine{ static_cast<unsigned>(size) };
+  std::vector<std::vector<int>> inputs;
+  // 下面保留了元素的引用，不能重新分配
+  inputs.reserve(7);
+
+  auto& random = inputs.emplace_back(size);
+  for (auto& value: random)
+    value = static_cast<int>(engine());
+
+  auto& ascending = inputs.emplace_back(size);
+  std::iota(ascending.begin(), ascending.end(), -static_cast<int>(size / 2));
+
+  inputs.emplace_back(ascending.rbegin(), ascending.rend());
+  inputs.emplace_back(size, 42);
+
+  auto& few_values = inputs.emplace_back(size);
+  for (auto& value: few_values)
+    value = static_cast<int>(engine() % 4);
+
+  auto& organ_pipe = inputs.emplace_back(size);
+  for (std::size_t i = 0; i < size; ++i)
+    organ_pipe[i] = static_cast<int>(std::min(i, size - i));
+
+  auto& nearly_sorted = inputs.emplace_back(ascending);
+  for (std::size_t i = 0; i < size / 100; ++i)
+    std::swap(nearly_sorted[engine() % size], nearly_sorted[engine() % size]);
+
+  return inputs;
+}
+
+struct Record {
+  std::int32_t key;
+  std::size_t order;
+};
+
+std::vector<Record> records(std::size_t size, std::int32_t keys)
+{
+  std::mt19937 engine{ 7 };
+  std::vector<Record> result(size);
+  for (std::size_t i = 0; i < size; ++i)
+    result[i] = { static_cast<std::int32_t>(engine() % static_cast<std::uint32_t>(keys)) - keys / 2, i };
+
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("bubble_sort sorts without reading past the end", "[sort]") {
+  int values[]{ 5, 1, 4, 2, 3, 2 };
+  st::bubble_sort(values, 6);
+  REQUIRE(std::is_sorted(std::begin(values), std::end(values)));
+}
+
+TEST_CASE("pdqsort matches std::sort on adversarial patterns", "[sort]") {
+  for (std::size_t size: { 0, 1, 2, 23, 24, 100, 129, 1000, 100000 }) {
+    for (auto input: patterns(size)) {
+      auto expected = input;
+      std::sort(expected.begin(), expected.end());
+
+      auto ascending = input;
+      st::sort(ascending);
+      REQUIRE(ascending == expected);
+
+      // 非算术比较走有分支的分区
+      auto descending = input;
+      st::sort(descending.begin(), descending.end(), [] (int lhs, int rhs) { return lhs > rhs; });
+      REQUIRE(std::equal(descending.begin(), descending.end(), expected.rbegin()));
+    }
+  }
+
+  std::vector<std::string> words{ "pear", "apple", "fig", "banana", "apple", "cherry" };
+  st::sort(words);
+  REQUIRE(std::is_sorted(words.begin(), words.end()));
+}
+
+TEST_CASE("radix sort handles signed, floating and string keys", "[sort]") {
+  std::mt19937_64 engine{ 1 };
+
+  std::vector<std::int64_t> integers(50000);
+  for (auto& value: integers)
+    value = static_cast<std::int64_t>(engine());
+  integers.push_back(std::numeric_limits<std::int64_t>::min());
+  integers.push_back(std::numeric_limits<std::int64_t>::max());
+  auto expected_integers = integers;
+  std::sort(expected_integers.begin(), expected_integers.end());
+  st::radix_sort(integers);
+  REQUIRE(integers == expected_integers);
+
+  std::vector<double> doubles(10000);
+  for (auto& value: doubles)
+    value = std::uniform_real_distribution<double>{ -1e6, 1e6 }(engine);
+  doubles.push_back(-0.0);
+  doubles.push_back(std::numeric_limits<double>::lowest());
+  st::radix_sort(doubles);
+  REQUIRE(std::is_sorted(doubles.begin(), doubles.end()));
+
+  std::vector<std::string> strings(20000);
+  for (auto& value: strings) {
+    // 共同前缀长，有空串和前缀关系
+    value = "prefix/" + std::string(engine() % 4, 'a');
+    for (auto length = engine() % 12; length > 0; --length)
+      value.push_back(static_cast<char>('a' + engine() % 26));
+  }
+  strings.push_back("");
+  auto expected_strings = strings;
+  std::sort(expected_strings.begin(), expected_strings.end());
+  st::radix_sort(strings);
+  REQUIRE(strings == expected_strings);
+}
+
+TEST_CASE("radix sort by key is stable", "[sort]") {
+  auto input = records(100000, 1000);
+  st::radix_sort(input.begin(), input.end(), &Record::key);
+
+  REQUIRE(std::is_sorted(input.begin(), input.end(), [] (const Record& lhs, const Record& rhs) {
+    return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.order < rhs.order);
+  }));
+}
+
+TEST_CASE("parallel sorts match sequential results", "[sort]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  for (auto input: patterns(300000)) {
+    auto expected = input;
+    std::sort(expected.begin(), expected.end());
+
+    // 小粒度，归并的轮数多，最后几轮只有一两对
+    st::parallel_sort(pool, input.begin(), input.end(), std::less<>{}, 10000);
+    REQUIRE(input == expected);
+  }
+
+  auto input = records(200000, 100);
+  auto expected = input;
+  auto by_key = [] (const Record& lhs, const Record& rhs) { return lhs.key < rhs.key; };
+  std::stable_sort(expected.begin(), expected.end(), by_key);
+  st::parallel_stable_sort(pool, input.begin(), input.end(), by_key, 7000);
+  REQUIRE(std::equal(input.begin(), input.end(), expected.begin(), [] (const Record& lhs, const Record& rhs) {
+    return lhs.key == rhs.key && lhs.order == rhs.order;
+  }));
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ST/ThreadPool.h"
+
+
+TEST_CASE("submitted tasks return values through futures", "[thread_pool]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+  REQUIRE(pool.size() == 4);
+
+  auto sum = pool.submit([] (int a, int b) { return a + b; }, 1, 2);
+  REQUIRE(sum.get() == 3);
+
+  auto failed = pool.submit([] { throw std::runtime_error{ "boom" }; });
+  REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+}
+
+TEST_CASE("tasks run on pool workers", "[thread_pool]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+  REQUIRE(pool.worker_index() == -1);
+
+  std::vector<std::future<std::ptrdiff_t>> futures{};
+  for (int i = 0; i < 10000; ++i)
+    futures.push_back(pool.submit([&pool] { return pool.worker_index(); }));
+
+  std::set<std::ptrdiff_t> workers{};
+  for (auto& future: futures)
+    workers.insert(future.get());
+
+  REQUIRE(*workers.begin() >= 0);
+  REQUIRE(*workers.rbegin() < 4);
+}
+
+TEST_CASE("tasks submitted from workers are stolen by idle workers", "[thread_pool]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  // 所有子任务都压入同一个worker的队列，只能靠偷取分散到其他worker
+  std::atomic<int> count{ 0 };
+  auto parent = pool.submit([&] {
+    std::vector<std::future<void>> children{};
+    for (int i = 0; i < 1000; ++i)
+      children.push_back(pool.submit([&count] { count.fetch_add(1, std::memory_order_relaxed); }));
+    for (auto& child: children)
+      child.wait();
+  });
+  parent.get();
+
+  REQUIRE(count.load() == 1000);
+}
+
+TEST_CASE("parallel_for visits every index exactly once", "[thread_pool]") {
+  ST::ThreadPool pool{ 4, ST::Affinity::None };
+
+  std::vector<std::atomic<int>> visits(100003);
+  pool.parallel_for(std::size_t{ 0 }, visits.size(), [&] (std::size_t i) {
+    visits[i].fetch_add(1, std::memory_order_relaxed);
+  });
+
+  auto once = std::all_of(visits.begin(), visits.end(), [] (const std::atomic<int>& visit) { return visit.load() == 1; });
+  REQUIRE(once);
+
+  std::int64_t sum = 0;
+  pool.parallel_for(-10, 10, [&] (int i) { std::atomic_ref{ sum }.fetch_add(i); }, 3);
+  REQUIRE(sum == -10);
+}
+
+TEST_CASE("parallel_for nests inside workers and rethrows", "[thread_pool]") {
+  ST::ThreadPool pool{ 2, ST::Affinity::None };
+
+  std::atomic<int> count{ 0 };
+  pool.parallel_for(0, 8, [&] (int) {
+    pool.parallel_for(0, 100, [&] (int) { count.fetch_add(1, std::memory_order_relaxed); });
+  }, 1);
+  REQUIRE(count.load() == 800);
+
+  REQUIRE_THROWS_AS(pool.parallel_for(0, 100, [] (int i) {
+    if (i == 42)
+      throw std::out_of_range{ "42" };
+  }), std::out_of_range);
+}
+
+TEST_CASE("pinned workers are spread over allowed cpus", "[thread_pool]") {
+  ST::ThreadPool pool{};
+  REQUIRE(pool.size() >= 1);
+
+  auto cpus = pool.cpus();
+  REQUIRE(cpus.size() == pool.size());
+}
+
+TEST_CASE("destruction drains submitted tasks", "[thread_pool]") {
+  std::atomic<int> count{ 0 };
+  {
+    ST::ThreadPool pool{ 2, ST::Affinity::None };
+    for (int i = 0; i < 1000; ++i)
+      pool.submit([&count] { count.fetch_add(1, std::memory_order_relaxed); });
+  }
+
+  REQUIRE(count.load() == 1000);
+}